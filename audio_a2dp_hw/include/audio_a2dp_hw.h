@@ -94,6 +94,9 @@ typedef enum {
   A2DP_CTRL_GET_PRESENTATION_POSITION,
   A2DP_CTRL_CMD_STREAM_OPEN,
   A2DP_CTRL_GET_SINK_LATENCY,
+  /* Ask for a shared memory audio ring; on success the ack is followed by a
+   * uint32_t ring size carrying the ring file descriptor */
+  A2DP_CTRL_CMD_OPEN_AUDIO_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
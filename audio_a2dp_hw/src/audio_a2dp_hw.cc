@@ -59,6 +59,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
+#include "uipc_audio_ring.h"
 
 #ifdef BT_AUDIO_SYSTRACE_LOG
 #include <cutils/trace.h>
@@ -146,6 +147,7 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  tUIPC_AUDIO_RING* ring;  // shared memory audio ring, replaces audio_fd writes
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -551,6 +553,63 @@ static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
   return 0;
 }
 
+// Receives the shared memory audio ring that follows the ack of
+// A2DP_CTRL_CMD_OPEN_AUDIO_RING. Returns the ring, or NULL on failure.
+static tUIPC_AUDIO_RING* a2dp_ctrl_receive_ring(
+    struct a2dp_stream_common* common) {
+  uint32_t ring_size = 0;
+  char cmsg_buf[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {&ring_size, sizeof(ring_size)};
+  struct msghdr msg = {};
+  ssize_t ret;
+
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = sizeof(cmsg_buf);
+
+  OSI_NO_INTR(ret = recvmsg(common->ctrl_fd, &msg, MSG_NOSIGNAL));
+  if (ret != sizeof(ring_size)) {
+    ERROR("audio ring receive failed (ret %d, %s)", (int)ret, strerror(errno));
+    return NULL;
+  }
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS) {
+    ERROR("audio ring receive failed: no fd");
+    return NULL;
+  }
+
+  int fd;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_attach(fd);
+  if (ring != NULL) INFO("audio ring of %u bytes attached", ring_size);
+  return ring;
+}
+
+// Asks the stack for a shared memory audio ring. The audio socket is kept as
+// fallback when the stack doesn't offer one.
+static void a2dp_open_audio_ring(struct a2dp_stream_common* common) {
+  if (common->ring != NULL) {
+    // Only closed rings are left around, see a2dp_close_audio_ring
+    uipc_audio_ring_free(common->ring);
+    common->ring = NULL;
+  }
+
+  if (a2dp_command(common, A2DP_CTRL_CMD_OPEN_AUDIO_RING) != 0) {
+    INFO("audio ring not available, using data socket");
+    return;
+  }
+  common->ring = a2dp_ctrl_receive_ring(common);
+}
+
+// Closes the audio ring. The mapping is only released on the next start or
+// when the stream is destroyed, as out_write may still hold it unlocked.
+static void a2dp_close_audio_ring(struct a2dp_stream_common* common) {
+  if (common->ring != NULL) uipc_audio_ring_close(common->ring);
+}
+
 static int check_a2dp_stream_started(struct a2dp_stream_out *out) {
   if (a2dp_command(&out->common, A2DP_CTRL_CMD_CHECK_STREAM_STARTED) < 0) {
     INFO("Btif not in stream state");
@@ -913,6 +972,7 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->ring = NULL;
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -923,6 +983,11 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   FNLOG();
 
+  if (common->ring != NULL) {
+    uipc_audio_ring_free(common->ring);
+    common->ring = NULL;
+  }
+
   delete common->mutex;
   common->mutex = NULL;
 }
@@ -1017,6 +1082,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
+  a2dp_close_audio_ring(common);
   skt_disconnect(common->audio_fd);
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
@@ -1044,6 +1110,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
+  a2dp_close_audio_ring(common);
   skt_disconnect(common->audio_fd);
 
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
@@ -1064,6 +1131,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   char trace_buf[512];
   #endif
   size_t write_bytes = bytes;
+  tUIPC_AUDIO_RING* ring;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -1080,6 +1148,9 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
     if (start_audio_datapath(&out->common) < 0) {
       goto finish;
     }
+    /* replace the data socket writes by the shared memory ring if offered */
+    if (out->common.audio_fd != AUDIO_SKT_DISCONNECTED)
+      a2dp_open_audio_ring(&out->common);
   } else if (out->common.state != AUDIO_A2DP_STATE_STARTED) {
     ERROR("stream not in stopped or standby");
     goto finish;
@@ -1106,6 +1177,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  ring = out->common.ring;
   lock.unlock();
   #ifdef BT_AUDIO_SYSTRACE_LOG
   snprintf(trace_buf, 32, "out_write:");
@@ -1114,7 +1186,16 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ATRACE_BEGIN(trace_buf);
   }
   #endif
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (ring != NULL) {
+    if (uipc_audio_ring_write(ring, (const uint8_t*)buffer, write_bytes,
+                              SOCK_SEND_TIMEOUT_MS) == write_bytes) {
+      sent = write_bytes;
+    } else {
+      ERROR("audio ring write failed");
+    }
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   #ifdef BT_AUDIO_SYSTRACE_LOG
   if (PERF_SYSTRACE)
   {
@@ -1130,6 +1211,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ERROR("ignore data write failure");
     }
 
+    a2dp_close_audio_ring(&out->common);
     skt_disconnect(out->common.audio_fd);
     out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
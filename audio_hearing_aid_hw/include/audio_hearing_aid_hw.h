@@ -85,6 +85,9 @@ typedef enum {
   HEARING_AID_CTRL_GET_OUTPUT_AUDIO_CONFIG,
   HEARING_AID_CTRL_SET_OUTPUT_AUDIO_CONFIG,
   HEARING_AID_CTRL_CMD_OFFLOAD_START,
+  /* Ask for a shared memory audio ring; on success the ack is followed by a
+   * uint32_t ring size carrying the ring file descriptor */
+  HEARING_AID_CTRL_CMD_OPEN_AUDIO_RING,
 } tHEARING_AID_CTRL_CMD;
 
 typedef enum {
@@ -43,6 +43,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_hearing_aid_hw.h"
+#include "uipc_audio_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -109,6 +110,7 @@ struct ha_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  tUIPC_AUDIO_RING* ring;  // shared memory audio ring, replaces audio_fd writes
   size_t buffer_sz;
   struct ha_config cfg;
   ha_state_t state;
@@ -449,6 +451,63 @@ static int ha_command(struct ha_stream_common* common,
   return 0;
 }
 
+// Receives the shared memory audio ring that follows the ack of
+// HEARING_AID_CTRL_CMD_OPEN_AUDIO_RING. Returns the ring, or NULL on failure.
+static tUIPC_AUDIO_RING* ha_ctrl_receive_ring(
+    struct ha_stream_common* common) {
+  uint32_t ring_size = 0;
+  char cmsg_buf[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {&ring_size, sizeof(ring_size)};
+  struct msghdr msg = {};
+  ssize_t ret;
+
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = sizeof(cmsg_buf);
+
+  OSI_NO_INTR(ret = recvmsg(common->ctrl_fd, &msg, MSG_NOSIGNAL));
+  if (ret != sizeof(ring_size)) {
+    ERROR("audio ring receive failed (ret %d, %s)", (int)ret, strerror(errno));
+    return NULL;
+  }
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS) {
+    ERROR("audio ring receive failed: no fd");
+    return NULL;
+  }
+
+  int fd;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_attach(fd);
+  if (ring != NULL) INFO("audio ring of %u bytes attached", ring_size);
+  return ring;
+}
+
+// Asks the stack for a shared memory audio ring. The audio socket is kept as
+// fallback when the stack doesn't offer one.
+static void ha_open_audio_ring(struct ha_stream_common* common) {
+  if (common->ring != NULL) {
+    // Only closed rings are left around, see ha_close_audio_ring
+    uipc_audio_ring_free(common->ring);
+    common->ring = NULL;
+  }
+
+  if (ha_command(common, HEARING_AID_CTRL_CMD_OPEN_AUDIO_RING) != 0) {
+    INFO("audio ring not available, using data socket");
+    return;
+  }
+  common->ring = ha_ctrl_receive_ring(common);
+}
+
+// Closes the audio ring. The mapping is only released on the next start or
+// when the stream is destroyed, as out_write may still hold it unlocked.
+static void ha_close_audio_ring(struct ha_stream_common* common) {
+  if (common->ring != NULL) uipc_audio_ring_close(common->ring);
+}
+
 static int check_ha_ready(struct ha_stream_common* common) {
   if (ha_command(common, HEARING_AID_CTRL_CMD_CHECK_READY) < 0) {
     ERROR("check ha ready failed");
@@ -776,6 +835,7 @@ static void ha_stream_common_init(struct ha_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->ring = NULL;
   common->state = AUDIO_HA_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -785,6 +845,11 @@ static void ha_stream_common_init(struct ha_stream_common* common) {
 static void ha_stream_common_destroy(struct ha_stream_common* common) {
   FNLOG();
 
+  if (common->ring != NULL) {
+    uipc_audio_ring_free(common->ring);
+    common->ring = NULL;
+  }
+
   delete common->mutex;
   common->mutex = NULL;
 }
@@ -838,6 +903,7 @@ static int stop_audio_datapath(struct ha_stream_common* common) {
   common->state = (ha_state_t)AUDIO_HA_STATE_STOPPED;
 
   /* disconnect audio path */
+  ha_close_audio_ring(common);
   skt_disconnect(common->audio_fd);
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
@@ -858,6 +924,7 @@ static int suspend_audio_datapath(struct ha_stream_common* common,
     common->state = AUDIO_HA_STATE_SUSPENDED;
 
   /* disconnect audio path */
+  ha_close_audio_ring(common);
   skt_disconnect(common->audio_fd);
 
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
@@ -876,6 +943,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   struct ha_stream_out* out = (struct ha_stream_out*)stream;
   int sent = -1;
   size_t write_bytes = bytes;
+  tUIPC_AUDIO_RING* ring;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -892,6 +960,9 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
     if (start_audio_datapath(&out->common) < 0) {
       goto finish;
     }
+    /* replace the data socket writes by the shared memory ring if offered */
+    if (out->common.audio_fd != AUDIO_SKT_DISCONNECTED)
+      ha_open_audio_ring(&out->common);
   } else if (out->common.state != AUDIO_HA_STATE_STARTED) {
     ERROR("stream not in stopped or standby");
     goto finish;
@@ -910,11 +981,22 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  ring = out->common.ring;
   lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (ring != NULL) {
+    if (uipc_audio_ring_write(ring, (const uint8_t*)buffer, write_bytes,
+                              SOCK_SEND_TIMEOUT_MS) == write_bytes) {
+      sent = write_bytes;
+    } else {
+      ERROR("audio ring write failed");
+    }
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   lock.lock();
 
   if (sent == -1) {
+    ha_close_audio_ring(&out->common);
     skt_disconnect(out->common.audio_fd);
     out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
     if ((out->common.state != AUDIO_HA_STATE_SUSPENDED) &&
@@ -674,6 +674,11 @@ void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
     osi_free(p_pkt);
     return;
   }
+  /* Keep the RTP timestamp ahead of the payload, in the space of the headers
+   * that were already parsed; the A2DP Sink jitter buffer schedules the
+   * playout from it */
+  if (p_pkt->offset >= sizeof(uint32_t))
+    *((uint32_t*)(p_pkt + 1)) = time_stamp;
   p_pkt->event = BTA_AV_SINK_MEDIA_DATA_EVT;
   p_scb->seps[p_scb->sep_idx].p_app_sink_data_cback(BTA_AV_SINK_MEDIA_DATA_EVT,
                                                     (tBTA_AV_MEDIA*)p_pkt, p_scb->peer_addr);
@@ -1765,11 +1770,7 @@ void bta_av_str_opened(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     (*bta_av_cb.p_cback)(BTA_AV_OPEN_EVT, &bta_av_data);
 
     APPL_TRACE_DEBUG("%s: Free Audio list from previous stream", __func__);
-    while (!list_is_empty(p_scb->a2dp_list)) {
-      BT_HDR* p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-      list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
-    }
+    bta_av_flush_a2dp_list(p_scb);
 #if (TWS_ENABLED == TRUE)
     APPL_TRACE_DEBUG("%s:audio count  = %d ",__func__, bta_av_cb.audio_open_cnt);
     if (p_scb->tws_device) {
@@ -2552,7 +2553,6 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   tBTA_AV_SUSPEND suspend_rsp;
   uint8_t start = p_scb->started;
   bool sus_evt = true;
-  BT_HDR* p_buf;
   uint8_t policy = HCI_ENABLE_SNIFF_MODE;
   char *codec_name = (char *)A2DP_CodecName(p_scb->cfg.codec_info);
 
@@ -2595,11 +2595,13 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
   /* if q_info.a2dp_list is not empty, drop it now */
   if (BTA_AV_CHNL_AUDIO == p_scb->chnl) {
-    while (!list_is_empty(p_scb->a2dp_list)) {
-      p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-      list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
-    }
+    bta_av_flush_a2dp_list(p_scb);
+    APPL_TRACE_DEBUG(
+        "%s: hndl:x%x fanout pkts:%u copied:%u dropped:%u max queued:%u",
+        __func__, p_scb->hndl, p_scb->fanout_stats.fanout_pkts,
+        p_scb->fanout_stats.copied_pkts, p_scb->fanout_stats.dropped_pkts,
+        p_scb->fanout_stats.max_queued);
+    memset(&p_scb->fanout_stats, 0, sizeof(p_scb->fanout_stats));
 
     /* drop the audio buffers queued in L2CAP */
     if (p_data && p_data->api_stop.flush)
@@ -2881,6 +2883,7 @@ void enc_mode_change_callback(tBTM_VSC_CMPL *param)
  *
  ******************************************************************************/
 void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
+  tBTA_AV_MEDIA_PKT* p_pkt = NULL;
   BT_HDR* p_buf = NULL;
   uint32_t timestamp;
   bool new_buf = false;
@@ -2895,10 +2898,10 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
       (uint8_t)L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_GET);
 
   if (!list_is_empty(p_scb->a2dp_list)) {
-    p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-    list_remove(p_scb->a2dp_list, p_buf);
-    /* use q_info.a2dp data, read the timestamp */
-    timestamp = *(uint32_t*)(p_buf + 1);
+    /* use q_info.a2dp data, read the timestamp. The packet stays queued
+     * until it is sent. */
+    p_pkt = (tBTA_AV_MEDIA_PKT*)list_front(p_scb->a2dp_list);
+    timestamp = *(uint32_t*)(p_pkt->p_buf + 1);
   } else {
     new_buf = true;
     /* A2DP_list empty, call co_data, dup data to other channels */
@@ -2909,13 +2912,18 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
       /* use the offset area for the time stamp */
       *(uint32_t*)(p_buf + 1) = timestamp;
 
-      /* dup the data to other channels */
-      bta_av_dup_audio_buf(p_scb, p_buf);
+      /* share the data with the other channels */
+      p_pkt = bta_av_media_pkt_new(p_buf);
+      bta_av_dup_audio_buf(p_scb, p_pkt);
     }
   }
 
-  if (p_buf) {
+  if (p_pkt) {
     if (p_scb->l2c_bufs < (BTA_AV_QUEUE_DATA_CHK_NUM)) {
+      if (!new_buf) list_remove(p_scb->a2dp_list, p_pkt);
+      /* get a buffer of our own: L2CAP writes the headers in it */
+      p_buf = bta_av_media_pkt_take(p_scb, p_pkt);
+
       /* There's a buffer, just queue it to L2CAP.
        * There's no need to increment it here, it is always read from
        * L2CAP (see above).
@@ -2980,17 +2988,13 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
       if (new_buf) {
         /* just got this buffer from co_data,
          * put it in queue */
-        list_append(p_scb->a2dp_list, p_buf);
-      } else {
-        /* just dequeue it from the a2dp_list */
-        if (list_length(p_scb->a2dp_list) < 3) {
-          /* put it back to the queue */
-          list_prepend(p_scb->a2dp_list, p_buf);
-        } else {
-          /* too many buffers in a2dp_list, drop it. */
-          bta_av_co_audio_drop(p_scb->hndl);
-          osi_free(p_buf);
-        }
+        list_append(p_scb->a2dp_list, p_pkt);
+      } else if (list_length(p_scb->a2dp_list) > 3) {
+        /* too many buffers in a2dp_list, drop the front one. */
+        list_remove(p_scb->a2dp_list, p_pkt);
+        bta_av_co_audio_drop(p_scb->hndl);
+        bta_av_media_pkt_free(p_pkt);
+        p_scb->fanout_stats.dropped_pkts++;
       }
     }
   }
@@ -3688,11 +3692,7 @@ void bta_av_rcfg_open(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
     bta_av_adjust_seps_idx(p_scb, bta_av_get_scb_handle(p_scb, AVDT_TSEP_SRC));
 
     APPL_TRACE_DEBUG("%s: Free Audio list from previous stream", __func__);
-    while (!list_is_empty(p_scb->a2dp_list)) {
-      BT_HDR* p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-      list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
-    }
+    bta_av_flush_a2dp_list(p_scb);
 
     /* open the stream with the new config */
     p_scb->sep_info_idx = p_scb->rcfg_idx;
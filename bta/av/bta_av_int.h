@@ -624,6 +624,21 @@ typedef union {
 #define BTA_AV_COLL_SETCONFIG_IND \
   0x04 /* SetConfig indication has been called by remote */
 
+/* Encoded media packet, shared by the audio channels it is fanned out to.
+ * The timestamp is stored at the start of the data area of |p_buf|. */
+typedef struct {
+  BT_HDR* p_buf;     /* the packet, not modified while shared */
+  uint8_t ref_count; /* number of channels holding the packet */
+} tBTA_AV_MEDIA_PKT;
+
+/* Media packet fan-out statistics of an audio channel */
+typedef struct {
+  uint32_t fanout_pkts;  /* packets fanned out from another channel */
+  uint32_t copied_pkts;  /* shared packets copied for transmission */
+  uint32_t dropped_pkts; /* packets dropped on queue overflow */
+  uint8_t max_queued;    /* deepest a2dp_list */
+} tBTA_AV_FANOUT_STATS;
+
 /* type for AV stream control block */
 struct tBTA_AV_SCB {
   const tBTA_AV_ACT* p_act_tbl; /* the action table for stream state machine */
@@ -631,7 +646,8 @@ struct tBTA_AV_SCB {
   bool sdp_discovery_started; /* variable to determine whether SDP is started */
   tBTA_AV_SEP seps[BTAV_A2DP_CODEC_INDEX_MAX];
   tAVDT_CFG* p_cap;  /* buffer used for get capabilities */
-  list_t* a2dp_list; /* used for audio channels only */
+  list_t* a2dp_list; /* tBTA_AV_MEDIA_PKT, used for audio channels only */
+  tBTA_AV_FANOUT_STATS fanout_stats;
   tBTA_AV_Q_INFO q_info;
   tAVDT_SEP_INFO sep_info[BTA_AV_NUM_SEPS]; /* stream discovery results */
   tAVDT_CFG cfg;                            /* local SEP configuration */
@@ -875,7 +891,12 @@ extern void bta_av_free_scb(tBTA_AV_SCB* p_scb);
 
 /* main functions */
 extern void bta_av_api_deregister(tBTA_AV_DATA* p_data);
-extern void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf);
+extern tBTA_AV_MEDIA_PKT* bta_av_media_pkt_new(BT_HDR* p_buf);
+extern BT_HDR* bta_av_media_pkt_take(tBTA_AV_SCB* p_scb,
+                                     tBTA_AV_MEDIA_PKT* p_pkt);
+extern void bta_av_media_pkt_free(tBTA_AV_MEDIA_PKT* p_pkt);
+extern void bta_av_flush_a2dp_list(tBTA_AV_SCB* p_scb);
+extern void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt);
 extern void bta_av_sm_execute(tBTA_AV_CB* p_cb, uint16_t event,
                               tBTA_AV_DATA* p_data);
 extern void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
@@ -1486,25 +1486,108 @@ uint16_t bta_av_chk_mtu(tBTA_AV_SCB* p_scb, UNUSED_ATTR uint16_t mtu) {
   return ret_mtu;
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_new
+ *
+ * Description      Wrap an encoded media packet so that it can be shared
+ *                  by several audio channels without being copied.
+ *
+ * Returns          the shared packet, held once
+ *
+ ******************************************************************************/
+tBTA_AV_MEDIA_PKT* bta_av_media_pkt_new(BT_HDR* p_buf) {
+  tBTA_AV_MEDIA_PKT* p_pkt =
+      (tBTA_AV_MEDIA_PKT*)osi_malloc(sizeof(tBTA_AV_MEDIA_PKT));
+  p_pkt->p_buf = p_buf;
+  p_pkt->ref_count = 1;
+  return p_pkt;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_take
+ *
+ * Description      Release a hold on a shared media packet and get a buffer
+ *                  owned by the caller, to be sent to L2CAP. The last holder
+ *                  gets the original buffer; the others get a copy, as L2CAP
+ *                  writes the headers in the buffer and frees it.
+ *
+ * Returns          the buffer to send
+ *
+ ******************************************************************************/
+BT_HDR* bta_av_media_pkt_take(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt) {
+  BT_HDR* p_buf = p_pkt->p_buf;
+
+  if (p_pkt->ref_count == 1) {
+    osi_free(p_pkt);
+    return p_buf;
+  }
+
+  p_pkt->ref_count--;
+  uint16_t copy_size = BT_HDR_SIZE + p_buf->offset + p_buf->len;
+  BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
+  memcpy(p_new, p_buf, copy_size);
+  p_scb->fanout_stats.copied_pkts++;
+  return p_new;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_free
+ *
+ * Description      Release a hold on a shared media packet that is not sent.
+ *                  The packet is freed with its last hold.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_media_pkt_free(tBTA_AV_MEDIA_PKT* p_pkt) {
+  if (--p_pkt->ref_count != 0) return;
+
+  osi_free(p_pkt->p_buf);
+  osi_free(p_pkt);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_flush_a2dp_list
+ *
+ * Description      Drop the media packets queued on an audio channel.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_flush_a2dp_list(tBTA_AV_SCB* p_scb) {
+  if (p_scb->a2dp_list == NULL) return;
+
+  while (!list_is_empty(p_scb->a2dp_list)) {
+    tBTA_AV_MEDIA_PKT* p_pkt =
+        (tBTA_AV_MEDIA_PKT*)list_front(p_scb->a2dp_list);
+    list_remove(p_scb->a2dp_list, p_pkt);
+    bta_av_media_pkt_free(p_pkt);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_dup_audio_buf
  *
- * Description      dup the audio data to the q_info.a2dp of other audio
- *                  channels
+ * Description      Share the audio packet with the q_info.a2dp of the other
+ *                  audio channels. The packet is only held by the channels,
+ *                  it is copied when a channel sends it.
  *
  * Returns          void
  *
  ******************************************************************************/
-void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
+void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt) {
   /* Test whether there is more than one audio channel connected */
-  if ((p_buf == NULL) || (bta_av_cb.audio_open_cnt < 2)
+  if ((p_pkt == NULL) || (bta_av_cb.audio_open_cnt < 2)
     || (!bta_av_is_multicast_enabled())) {
       APPL_TRACE_DEBUG("bta_av_dup_audio_buf: data not to dup ");
     return;
   }
 
-  uint16_t copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
   for (int i = 0; i < BTA_AV_NUM_STRS; i++) {
     tBTA_AV_SCB* p_scbi = bta_av_cb.p_scb[i];
 
@@ -1515,17 +1598,21 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
       continue; /* Audio is not connected */
 
     /* Enqueue the data */
-    BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
-    memcpy(p_new, p_buf, copy_size);
-    list_append(p_scbi->a2dp_list, p_new);
+    p_pkt->ref_count++;
+    list_append(p_scbi->a2dp_list, p_pkt);
+    p_scbi->fanout_stats.fanout_pkts++;
 
     if (list_length(p_scbi->a2dp_list) > p_bta_av_cfg->audio_mqs) {
       // Drop the oldest packet
       bta_av_co_audio_drop(p_scbi->hndl);
-      BT_HDR* p_buf_drop = static_cast<BT_HDR*>(list_front(p_scbi->a2dp_list));
-      list_remove(p_scbi->a2dp_list, p_buf_drop);
-      osi_free(p_buf_drop);
+      tBTA_AV_MEDIA_PKT* p_pkt_drop =
+          (tBTA_AV_MEDIA_PKT*)list_front(p_scbi->a2dp_list);
+      list_remove(p_scbi->a2dp_list, p_pkt_drop);
+      bta_av_media_pkt_free(p_pkt_drop);
+      p_scbi->fanout_stats.dropped_pkts++;
     }
+    if (list_length(p_scbi->a2dp_list) > p_scbi->fanout_stats.max_queued)
+      p_scbi->fanout_stats.max_queued = list_length(p_scbi->a2dp_list);
   }
 }
 
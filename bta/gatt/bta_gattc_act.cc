@@ -27,6 +27,8 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include <base/callback.h>
 #include "bt_common.h"
 #include "bt_target.h"
@@ -67,10 +69,6 @@ static void bta_gattc_conn_cback(tGATT_IF gattc_if, const RawAddress& bda,
 static void bta_gattc_cmpl_cback(uint16_t conn_id, tGATTC_OPTYPE op,
                                  tGATT_STATUS status,
                                  tGATT_CL_COMPLETE* p_data);
-static void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
-                                   tGATT_STATUS status,
-                                   tGATT_CL_COMPLETE* p_data);
-
 static void bta_gattc_deregister_cmpl(tBTA_GATTC_RCB* p_clreg);
 static void bta_gattc_enc_cmpl_cback(tGATT_IF gattc_if, const RawAddress& bda);
 static void bta_gattc_cong_cback(uint16_t conn_id, bool congested);
@@ -889,21 +887,34 @@ void bta_gattc_confirm(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
 
 /** read complete */
 void bta_gattc_read_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_OP_CMPL* p_data) {
-  GATT_READ_OP_CB cb = p_clcb->p_q_cmd->api_read.read_cb;
-  void* my_cb_data = p_clcb->p_q_cmd->api_read.read_cb_data;
+  GATT_READ_OP_CB cb;
+  void* my_cb_data;
+  uint16_t handle;
+
+  if (p_clcb->p_q_cmd->hdr.event == BTA_GATTC_API_READ_MULTI_EVT) {
+    /* read multiple returns the first handle requested */
+    cb = p_clcb->p_q_cmd->api_read_multi.read_cb;
+    my_cb_data = p_clcb->p_q_cmd->api_read_multi.read_cb_data;
+    handle = p_clcb->p_q_cmd->api_read_multi.handles[0];
+  } else {
+    cb = p_clcb->p_q_cmd->api_read.read_cb;
+    my_cb_data = p_clcb->p_q_cmd->api_read.read_cb_data;
 
-  /* if it was read by handle, return the handle requested, if read by UUID, use
-   * handle returned from remote
-   */
-  uint16_t handle = p_clcb->p_q_cmd->api_read.handle;
-  if (handle == 0) handle = p_data->p_cmpl->att_value.handle;
+    /* if it was read by handle, return the handle requested, if read by UUID,
+     * use handle returned from remote
+     */
+    handle = p_clcb->p_q_cmd->api_read.handle;
+    if (handle == 0 && p_data->p_cmpl)
+      handle = p_data->p_cmpl->att_value.handle;
+  }
+
+  uint16_t len = p_data->p_cmpl ? p_data->p_cmpl->att_value.len : 0;
+  uint8_t* value = p_data->p_cmpl ? p_data->p_cmpl->att_value.value : NULL;
 
   osi_free_and_reset((void**)&p_clcb->p_q_cmd);
 
   if (cb) {
-    cb(p_clcb->bta_conn_id, p_data->status, handle,
-       p_data->p_cmpl->att_value.len, p_data->p_cmpl->att_value.value,
-       my_cb_data);
+    cb(p_clcb->bta_conn_id, p_data->status, handle, len, value, my_cb_data);
   }
 }
 
@@ -972,8 +983,13 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
     return;
   }
 
-  if (p_clcb->p_q_cmd->hdr.event !=
-      bta_gattc_opcode_to_int_evt[op - GATTC_OPTYPE_READ]) {
+  uint16_t q_event = p_clcb->p_q_cmd->hdr.event;
+  if (op == GATTC_OPTYPE_READ && q_event == BTA_GATTC_API_READ_MULTI_EVT)
+    q_event = BTA_GATTC_API_READ_EVT;
+  else if (op == GATTC_OPTYPE_WRITE && q_event == BTA_GATTC_API_WRITE_CMDS_EVT)
+    q_event = BTA_GATTC_API_WRITE_EVT;
+
+  if (q_event != bta_gattc_opcode_to_int_evt[op - GATTC_OPTYPE_READ]) {
     mapped_op =
         p_clcb->p_q_cmd->hdr.event - BTA_GATTC_API_READ_EVT + GATTC_OPTYPE_READ;
     if (mapped_op > GATTC_OPTYPE_INDICATION) mapped_op = 0;
@@ -999,6 +1015,10 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   if (op == GATTC_OPTYPE_READ)
     bta_gattc_read_cmpl(p_clcb, &p_data->op_cmpl);
 
+  else if (op == GATTC_OPTYPE_WRITE &&
+           p_clcb->p_q_cmd->hdr.event == BTA_GATTC_API_WRITE_CMDS_EVT)
+    bta_gattc_write_cmds_cmpl(p_clcb, &p_data->op_cmpl);
+
   else if (op == GATTC_OPTYPE_WRITE)
     bta_gattc_write_cmpl(p_clcb, &p_data->op_cmpl);
 
@@ -1008,7 +1028,9 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   else if (op == GATTC_OPTYPE_CONFIG)
     bta_gattc_cfg_mtu_cmpl(p_clcb, &p_data->op_cmpl);
 
-  if (p_clcb->auto_update == BTA_GATTC_DISC_WAITING) {
+  /* a batch of write commands is rediscovered after its last command */
+  if (p_clcb->auto_update == BTA_GATTC_DISC_WAITING &&
+      p_clcb->p_q_cmd == NULL) {
     p_clcb->auto_update = BTA_GATTC_REQ_WAITING;
     bta_gattc_sm_execute(p_clcb, BTA_GATTC_INT_DISCOVER_EVT, NULL);
   }
@@ -1503,20 +1525,24 @@ static void bta_gattc_cmpl_cback(uint16_t conn_id, tGATTC_OPTYPE op,
 }
 
 /** client operation complete send message */
-static void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
-                                   tGATT_STATUS status,
-                                   tGATT_CL_COMPLETE* p_data) {
+void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
+                            tGATT_STATUS status, tGATT_CL_COMPLETE* p_data) {
   const size_t len = sizeof(tBTA_GATTC_OP_CMPL) + sizeof(tGATT_CL_COMPLETE);
-  tBTA_GATTC_OP_CMPL* p_buf = (tBTA_GATTC_OP_CMPL*)osi_calloc(len);
+  tBTA_GATTC_OP_CMPL* p_buf = (tBTA_GATTC_OP_CMPL*)osi_malloc(len);
 
   p_buf->hdr.event = BTA_GATTC_OP_CMPL_EVT;
   p_buf->hdr.layer_specific = conn_id;
   p_buf->status = status;
   p_buf->op_code = op;
+  p_buf->p_cmpl = NULL;
 
   if (p_data) {
+    /* only the value bytes in use are copied */
+    size_t value_len =
+        std::min<size_t>(p_data->att_value.len, GATT_MAX_ATTR_LEN);
     p_buf->p_cmpl = (tGATT_CL_COMPLETE*)(p_buf + 1);
-    memcpy(p_buf->p_cmpl, p_data, sizeof(tGATT_CL_COMPLETE));
+    memcpy(p_buf->p_cmpl, p_data,
+           offsetof(tGATT_CL_COMPLETE, att_value.value) + value_len);
   }
 
   bta_sys_sendmsg(p_buf);
@@ -1525,7 +1551,15 @@ static void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
 /** congestion callback for BTA GATT client */
 static void bta_gattc_cong_cback(uint16_t conn_id, bool congested) {
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
-  if (!p_clcb || !p_clcb->p_rcb->p_cback) return;
+  if (!p_clcb) return;
+
+  p_clcb->congested = congested;
+  /* resume the batch of write commands waiting for the link */
+  if (!congested && p_clcb->p_q_cmd != NULL &&
+      p_clcb->p_q_cmd->hdr.event == BTA_GATTC_API_WRITE_CMDS_EVT)
+    bta_gattc_write_cmds_send(p_clcb);
+
+  if (!p_clcb->p_rcb->p_cback) return;
 
   tBTA_GATTC cb_data;
   cb_data.congest.conn_id = conn_id;
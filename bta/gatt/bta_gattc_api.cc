@@ -322,6 +322,15 @@ const gatt::Service* BTA_GATTC_GetOwningService(uint16_t conn_id,
   return bta_gattc_get_service_for_handle(conn_id, handle);
 }
 
+/* Return the MTU of the connection, GATT_DEF_BLE_MTU_SIZE if it is unknown */
+uint16_t BTA_GATTC_GetMtu(uint16_t conn_id) {
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (p_clcb == NULL || p_clcb->p_srcb == NULL || p_clcb->p_srcb->mtu == 0)
+    return GATT_DEF_BLE_MTU_SIZE;
+
+  return p_clcb->p_srcb->mtu;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_GetGattDb
@@ -434,7 +443,8 @@ void BTA_GATTC_ReadCharDescr(uint16_t conn_id, uint16_t handle,
  *
  ******************************************************************************/
 void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
-                            tGATT_AUTH_REQ auth_req) {
+                            tGATT_AUTH_REQ auth_req, GATT_READ_OP_CB callback,
+                            void* cb_data) {
   tBTA_GATTC_API_READ_MULTI* p_buf =
       (tBTA_GATTC_API_READ_MULTI*)osi_calloc(sizeof(tBTA_GATTC_API_READ_MULTI));
 
@@ -442,6 +452,8 @@ void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
   p_buf->hdr.layer_specific = conn_id;
   p_buf->auth_req = auth_req;
   p_buf->num_attr = p_read_multi->num_attr;
+  p_buf->read_cb = callback;
+  p_buf->read_cb_data = cb_data;
 
   if (p_buf->num_attr > 0)
     memcpy(p_buf->handles, p_read_multi->handles,
@@ -489,6 +501,52 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
   bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharValueCmds
+ *
+ * Description      This function is called to send a batch of write commands.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  cmds - the write commands.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTC_WriteCharValueCmds(uint16_t conn_id,
+                                  std::vector<tBTA_GATTC_WRITE_CMD> cmds,
+                                  tGATT_AUTH_REQ auth_req) {
+  if (cmds.empty()) return;
+
+  /* the commands and their values follow the message */
+  size_t len = sizeof(tBTA_GATTC_API_WRITE_CMDS) +
+               cmds.size() * sizeof(tBTA_GATTC_WRITE_CMD_ENTRY);
+  for (const tBTA_GATTC_WRITE_CMD& cmd : cmds) len += cmd.value.size();
+
+  tBTA_GATTC_API_WRITE_CMDS* p_buf =
+      (tBTA_GATTC_API_WRITE_CMDS*)osi_calloc(len);
+
+  p_buf->hdr.event = BTA_GATTC_API_WRITE_CMDS_EVT;
+  p_buf->hdr.layer_specific = conn_id;
+  p_buf->auth_req = auth_req;
+  p_buf->num_cmds = cmds.size();
+  p_buf->p_cmds = (tBTA_GATTC_WRITE_CMD_ENTRY*)(p_buf + 1);
+
+  uint8_t* p_value = (uint8_t*)(p_buf->p_cmds + cmds.size());
+  for (size_t i = 0; i < cmds.size(); i++) {
+    tBTA_GATTC_WRITE_CMD_ENTRY* p_cmd = &p_buf->p_cmds[i];
+    p_cmd->handle = cmds[i].handle;
+    p_cmd->len = cmds[i].value.size();
+    p_cmd->p_value = p_value;
+    p_cmd->write_cb = cmds[i].callback;
+    p_cmd->write_cb_data = cmds[i].cb_data;
+    if (p_cmd->len) memcpy(p_value, cmds[i].value.data(), p_cmd->len);
+    p_value += p_cmd->len;
+  }
+
+  bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_WriteCharDescr
@@ -676,6 +734,13 @@ tGATT_STATUS BTA_GATTC_RegisterForNotifications(tGATT_IF client_if,
     LOG(ERROR) << "client_if=" << +client_if << " Not Registered";
   }
 
+  /* let the stack only deliver the notifications the app registered for */
+  if (status == GATT_SUCCESS) {
+    do_in_bta_thread(FROM_HERE,
+                     base::Bind(base::IgnoreResult(&GATTC_SubscribeNotification),
+                                client_if, bda, handle));
+  }
+
   return status;
 }
 
@@ -714,6 +779,8 @@ tGATT_STATUS BTA_GATTC_DeregisterForNotifications(tGATT_IF client_if,
         p_clreg->notif_reg[i].handle == handle) {
       VLOG(1) << __func__ << " deregistered bd_addr=" << bda;
       memset(&p_clreg->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
+      do_in_bta_thread(FROM_HERE, base::Bind(&GATTC_UnsubscribeNotification,
+                                             client_if, bda, handle));
       return GATT_SUCCESS;
     }
   }
@@ -27,10 +27,16 @@
 
 #include "bt_target.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <set>
 #include <sstream>
 
 #include "bt_common.h"
@@ -43,6 +49,8 @@
 #include "database_builder.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "sdp_api.h"
 #include "sdpdefs.h"
 #include "utl.h"
@@ -75,8 +83,31 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 
 #define BTA_GATT_SDP_DB_SIZE 4096
 
-#define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 5
+/* Explore all services as one handle range instead of one by one */
+#define BTA_GATTC_WIDE_DISC_PROPERTY "persist.bluetooth.gatt.wide_discovery"
+
+namespace {
+const Uuid PRIMARY_SERVICE = Uuid::From16Bit(GATT_UUID_PRI_SERVICE);
+const Uuid SECONDARY_SERVICE = Uuid::From16Bit(GATT_UUID_SEC_SERVICE);
+const Uuid INCLUDE = Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE);
+const Uuid CHARACTERISTIC = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+}  // namespace
+
+#define GATT_CACHE_DIR "/data/misc/bluetooth/"
+#define GATT_CACHE_FILE "gatt_cache_"
+#define GATT_HASH_FILE "gatt_hash_"
+#define GATT_CACHE_PREFIX GATT_CACHE_DIR GATT_CACHE_FILE
+#define GATT_HASH_PREFIX GATT_CACHE_DIR GATT_HASH_FILE
+#define GATT_CACHE_VERSION 6
+
+/* Per-device cache files only name the database a device exposes; the
+ * attributes themselves live in one file per distinct database, named after
+ * the hash of its content, so peers running the same firmware share it. */
+typedef struct {
+  uint16_t version;
+  uint16_t num_attr;
+  uint64_t hash;
+} tBTA_GATTC_CACHE_HDR;
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
                                                const RawAddress& bda) {
@@ -85,6 +116,11 @@ static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
            bda.address[4], bda.address[5]);
 }
 
+static void bta_gattc_generate_hash_file_name(char* buffer, size_t buffer_len,
+                                              uint64_t hash) {
+  snprintf(buffer, buffer_len, "%s%016" PRIx64, GATT_HASH_PREFIX, hash);
+}
+
 /*****************************************************************************
  *  Constants and data types
  ****************************************************************************/
@@ -122,6 +158,43 @@ static void bta_gattc_display_explore_record(const DatabaseBuilder& database) {
 void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->gatt_database = gatt::Database();
   p_srvc_cb->pending_discovery.Clear();
+
+  char value[PROPERTY_VALUE_MAX] = {0};
+  osi_property_get(BTA_GATTC_WIDE_DISC_PROPERTY, value, "true");
+  p_srvc_cb->pending_discovery.SetWideExploration(strcmp(value, "false") != 0);
+
+  memset(&p_srvc_cb->disc_stats, 0, sizeof(p_srvc_cb->disc_stats));
+  p_srvc_cb->disc_stats.start_ms = time_get_os_boottime_ms();
+}
+
+/** Start a GATT discovery procedure, accounting it in the discovery stats */
+static tGATT_STATUS bta_gattc_discover(uint16_t conn_id,
+                                       tBTA_GATTC_SERV* p_srvc_cb,
+                                       tGATT_DISC_TYPE disc_type,
+                                       uint16_t start_handle,
+                                       uint16_t end_handle) {
+  p_srvc_cb->disc_stats.num_proc[disc_type]++;
+  p_srvc_cb->disc_stats.proc_start_ms = time_get_os_boottime_ms();
+  return GATTC_Discover(conn_id, disc_type, start_handle, end_handle);
+}
+
+/** Log how long each discovery stage took */
+static void bta_gattc_log_disc_stats(tBTA_GATTC_SERV* p_srvc_cb) {
+  const tBTA_GATTC_DISC_STATS& stats = p_srvc_cb->disc_stats;
+
+  LOG(INFO) << __func__ << ": " << p_srvc_cb->server_bda << " discovered in "
+            << time_get_os_boottime_ms() - stats.start_ms << " ms"
+            << StringPrintf(
+                   ", services %u/%u ms, included %u/%u ms, characteristics "
+                   "%u/%u ms, descriptors %u/%u ms (procedures/time)",
+                   stats.num_proc[GATT_DISC_SRVC_ALL],
+                   stats.stage_ms[GATT_DISC_SRVC_ALL],
+                   stats.num_proc[GATT_DISC_INC_SRVC],
+                   stats.stage_ms[GATT_DISC_INC_SRVC],
+                   stats.num_proc[GATT_DISC_CHAR],
+                   stats.stage_ms[GATT_DISC_CHAR],
+                   stats.num_proc[GATT_DISC_CHAR_DSCPT],
+                   stats.stage_ms[GATT_DISC_CHAR_DSCPT]);
 }
 
 const Service* bta_gattc_find_matching_service(
@@ -142,7 +215,7 @@ tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
   if (!p_clcb) return GATT_ERROR;
 
   if (p_clcb->transport == BTA_TRANSPORT_LE) {
-    return GATTC_Discover(conn_id, disc_type, 0x0001, 0xFFFF);
+    return bta_gattc_discover(conn_id, p_server_cb, disc_type, 0x0001, 0xFFFF);
   }
 
   // only for Classic transport
@@ -168,7 +241,8 @@ static void bta_gattc_explore_next_service(uint16_t conn_id,
   VLOG(1) << "Start service discovery";
 
   /* start discovering included services */
-  GATTC_Discover(conn_id, GATT_DISC_INC_SRVC, service.first, service.second);
+  bta_gattc_discover(conn_id, p_srvc_cb, GATT_DISC_INC_SRVC, service.first,
+                     service.second);
 }
 
 static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
@@ -181,6 +255,7 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 
   /* no service found at all, the end of server discovery*/
   LOG(INFO) << __func__ << ": service discovery finished";
+  bta_gattc_log_disc_stats(p_srvc_cb);
 
   p_srvc_cb->gatt_database = p_srvc_cb->pending_discovery.Build();
 
@@ -214,8 +289,8 @@ void bta_gattc_start_disc_char_dscp(uint16_t conn_id,
     goto descriptor_discovery_done;
   }
 
-  if (GATTC_Discover(conn_id, GATT_DISC_CHAR_DSCPT, range.first,
-                     range.second) != 0) {
+  if (bta_gattc_discover(conn_id, p_srvc_cb, GATT_DISC_CHAR_DSCPT, range.first,
+                         range.second) != 0) {
     goto descriptor_discovery_done;
   }
   return;
@@ -380,6 +455,11 @@ void bta_gattc_disc_cmpl_cback(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
   tBTA_GATTC_SERV* p_srvc_cb = bta_gattc_find_scb_by_cid(conn_id);
   if (!p_srvc_cb) return;
 
+  if (disc_type < GATT_DISC_MAX) {
+    p_srvc_cb->disc_stats.stage_ms[disc_type] +=
+        time_get_os_boottime_ms() - p_srvc_cb->disc_stats.proc_start_ms;
+  }
+
   switch (disc_type) {
     case GATT_DISC_SRVC_ALL:
     case GATT_DISC_SRVC_BY_UUID:
@@ -393,7 +473,8 @@ void bta_gattc_disc_cmpl_cback(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
     case GATT_DISC_INC_SRVC: {
       auto& service = p_srvc_cb->pending_discovery.CurrentlyExploredService();
       /* start discovering characteristic */
-      GATTC_Discover(conn_id, GATT_DISC_CHAR, service.first, service.second);
+      bta_gattc_discover(conn_id, p_srvc_cb, GATT_DISC_CHAR, service.first,
+                         service.second);
       break;
     }
 
@@ -712,6 +793,114 @@ void bta_gattc_get_gatt_db(uint16_t conn_id, uint16_t start_handle,
                              count);
 }
 
+/* FNV-1a over the stored fields only, so that union padding never changes
+ * the hash of otherwise identical databases */
+static uint64_t bta_gattc_hash_bytes(uint64_t hash, const void* p, size_t len) {
+  const uint8_t* p_byte = (const uint8_t*)p;
+  while (len--) {
+    hash ^= *p_byte++;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint64_t bta_gattc_hash_uuid(uint64_t hash, const Uuid& uuid) {
+  return bta_gattc_hash_bytes(hash, uuid.To128BitBE().data(), Uuid::kNumBytes128);
+}
+
+static uint64_t bta_gattc_hash_attr(uint64_t hash, const StoredAttribute& a) {
+  hash = bta_gattc_hash_bytes(hash, &a.handle, sizeof(a.handle));
+  hash = bta_gattc_hash_uuid(hash, a.type);
+
+  if (a.type == PRIMARY_SERVICE || a.type == SECONDARY_SERVICE) {
+    hash = bta_gattc_hash_uuid(hash, a.value.service.uuid);
+    hash = bta_gattc_hash_bytes(hash, &a.value.service.end_handle,
+                                sizeof(a.value.service.end_handle));
+  } else if (a.type == INCLUDE) {
+    hash = bta_gattc_hash_bytes(hash, &a.value.included_service.handle,
+                                sizeof(a.value.included_service.handle));
+    hash = bta_gattc_hash_bytes(hash, &a.value.included_service.end_handle,
+                                sizeof(a.value.included_service.end_handle));
+    hash = bta_gattc_hash_uuid(hash, a.value.included_service.uuid);
+  } else if (a.type == CHARACTERISTIC) {
+    hash = bta_gattc_hash_bytes(hash, &a.value.characteristic.properties,
+                                sizeof(a.value.characteristic.properties));
+    hash = bta_gattc_hash_bytes(hash, &a.value.characteristic.value_handle,
+                                sizeof(a.value.characteristic.value_handle));
+    hash = bta_gattc_hash_uuid(hash, a.value.characteristic.uuid);
+  }
+  return hash;
+}
+
+static uint64_t bta_gattc_hash_attrs(const StoredAttribute* p_attr,
+                                     size_t num_attr) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < num_attr; i++)
+    hash = bta_gattc_hash_attr(hash, p_attr[i]);
+  return hash;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_cache_map
+ *
+ * Description      Map the shared GATT database file with the given hash
+ *                  read-only and check its header.
+ *
+ * Parameter        hash: content hash of the database
+ *                  p_len: length of the mapping, for munmap()
+ *                  p_num_attr: number of attributes in the mapping
+ *
+ * Returns          pointer to the first attribute, or NULL on failure
+ *
+ ******************************************************************************/
+static const StoredAttribute* bta_gattc_cache_map(uint64_t hash, size_t* p_len,
+                                                  uint16_t* p_num_attr) {
+  char fname[255] = {0};
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
+
+  int fd = open(fname, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << __func__ << ": can't open GATT database " << fname
+               << ", error: " << strerror(errno);
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      st.st_size < (off_t)sizeof(tBTA_GATTC_CACHE_HDR)) {
+    LOG(ERROR) << __func__ << ": truncated GATT database: " << fname;
+    close(fd);
+    return NULL;
+  }
+
+  size_t len = st.st_size;
+  void* p_map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p_map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT database " << fname
+               << ", error: " << strerror(errno);
+    return NULL;
+  }
+
+  tBTA_GATTC_CACHE_HDR hdr;
+  memcpy(&hdr, p_map, sizeof(hdr));
+  if (hdr.version != GATT_CACHE_VERSION || hdr.hash != hash ||
+      len != sizeof(hdr) + hdr.num_attr * sizeof(StoredAttribute)) {
+    LOG(ERROR) << __func__ << ": malformed GATT database: " << fname;
+    munmap(p_map, len);
+    return NULL;
+  }
+
+  *p_len = len;
+  *p_num_attr = hdr.num_attr;
+  return (const StoredAttribute*)((const uint8_t*)p_map + sizeof(hdr));
+}
+
+static void bta_gattc_cache_unmap(const StoredAttribute* p_attr, size_t len) {
+  munmap((uint8_t*)p_attr - sizeof(tBTA_GATTC_CACHE_HDR), len);
+}
+
 /*******************************************************************************
  *
  * Function         bta_gattc_cache_load
@@ -735,40 +924,119 @@ bool bta_gattc_cache_load(tBTA_GATTC_CLCB* p_clcb) {
     return false;
   }
 
-  uint16_t cache_ver = 0;
-  bool success = false;
-  uint16_t num_attr = 0;
+  tBTA_GATTC_CACHE_HDR hdr;
+  size_t read = fread(&hdr, sizeof(hdr), 1, fd);
+  fclose(fd);
 
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
+  if (read != 1) {
+    LOG(ERROR) << __func__ << ": can't read GATT cache header from: " << fname;
+    return false;
   }
 
-  if (cache_ver != GATT_CACHE_VERSION) {
+  if (hdr.version != GATT_CACHE_VERSION) {
     LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
+    return false;
   }
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+  size_t len = 0;
+  uint16_t num_attr = 0;
+  const StoredAttribute* p_attr = bta_gattc_cache_map(hdr.hash, &len, &num_attr);
+  if (!p_attr) return false;
+
+  bool success = false;
+  if (num_attr == hdr.num_attr) {
+    p_clcb->p_srcb->gatt_database =
+        gatt::Database::Deserialize(p_attr, num_attr, &success);
+  } else {
+    LOG(ERROR) << __func__ << ": GATT cache doesn't match database: " << fname;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
+  bta_gattc_cache_unmap(p_attr, len);
+  return success;
+}
 
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
+static bool bta_gattc_attr_equal(const StoredAttribute& a,
+                                 const StoredAttribute& b) {
+  if (a.handle != b.handle || a.type != b.type) return false;
+
+  if (a.type == PRIMARY_SERVICE || a.type == SECONDARY_SERVICE) {
+    return a.value.service.uuid == b.value.service.uuid &&
+           a.value.service.end_handle == b.value.service.end_handle;
+  } else if (a.type == INCLUDE) {
+    return a.value.included_service.handle == b.value.included_service.handle &&
+           a.value.included_service.end_handle ==
+               b.value.included_service.end_handle &&
+           a.value.included_service.uuid == b.value.included_service.uuid;
+  } else if (a.type == CHARACTERISTIC) {
+    return a.value.characteristic.properties ==
+               b.value.characteristic.properties &&
+           a.value.characteristic.value_handle ==
+               b.value.characteristic.value_handle &&
+           a.value.characteristic.uuid == b.value.characteristic.uuid;
+  }
+  return true;
+}
+
+/* Return true if the shared database file for |hash| already holds exactly
+ * |attr|; false if it is missing or, on a hash collision, holds another one */
+static bool bta_gattc_cache_shared_matches(
+    uint64_t hash, const std::vector<StoredAttribute>& attr, bool* p_exists) {
+  size_t len = 0;
+  uint16_t num_attr = 0;
+  const StoredAttribute* p_attr = bta_gattc_cache_map(hash, &len, &num_attr);
+  *p_exists = (p_attr != NULL);
+  if (!p_attr) return false;
 
-    p_clcb->p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
+  bool match = (num_attr == attr.size());
+  for (size_t i = 0; match && i < num_attr; i++) {
+    match = bta_gattc_attr_equal(p_attr[i], attr[i]);
   }
 
-done:
-  fclose(fd);
-  return success;
+  bta_gattc_cache_unmap(p_attr, len);
+  return match;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_cache_write_shared
+ *
+ * Description      Store a GATT database under its content hash. The file is
+ *                  written aside and renamed, so peers that already reference
+ *                  the hash never see it half written.
+ *
+ * Returns          true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool bta_gattc_cache_write_shared(
+    const tBTA_GATTC_CACHE_HDR& hdr, const std::vector<StoredAttribute>& attr) {
+  char fname[255] = {0};
+  char tmp_fname[260] = {0};
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hdr.hash);
+  snprintf(tmp_fname, sizeof(tmp_fname), "%s.new", fname);
+
+  FILE* fd = fopen(tmp_fname, "wb");
+  if (!fd) {
+    LOG(ERROR) << __func__
+               << ": can't open GATT database for writing: " << tmp_fname;
+    return false;
+  }
+
+  if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1 ||
+      fwrite(attr.data(), sizeof(StoredAttribute), hdr.num_attr, fd) !=
+          hdr.num_attr) {
+    LOG(ERROR) << __func__ << ": can't write GATT database: " << tmp_fname;
+    fclose(fd);
+    unlink(tmp_fname);
+    return false;
+  }
+
+  if (fclose(fd) != 0 || rename(tmp_fname, fname) != 0) {
+    LOG(ERROR) << __func__ << ": can't store GATT database: " << fname;
+    unlink(tmp_fname);
+    return false;
+  }
+
+  return true;
 }
 
 /*******************************************************************************
@@ -788,35 +1056,109 @@ static void bta_gattc_cache_write(const RawAddress& server_bda,
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
 
+  tBTA_GATTC_CACHE_HDR hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.version = GATT_CACHE_VERSION;
+  hdr.num_attr = attr.size();
+  hdr.hash = bta_gattc_hash_attrs(attr.data(), attr.size());
+
+  bool exists = false;
+  if (!bta_gattc_cache_shared_matches(hdr.hash, attr, &exists)) {
+    if (exists) {
+      /* Another database owns this hash; don't cache rather than alias it */
+      LOG(ERROR) << __func__ << ": GATT database hash collision for "
+                 << server_bda;
+      unlink(fname);
+      return;
+    }
+
+    if (!bta_gattc_cache_write_shared(hdr, attr)) {
+      /* Don't leave the previous database behind for the next load */
+      unlink(fname);
+      return;
+    }
+  } else {
+    VLOG(1) << __func__ << ": reusing GATT database "
+            << StringPrintf("%016" PRIx64, hdr.hash) << " for " << server_bda;
+  }
+
   FILE* fd = fopen(fname, "wb");
   if (!fd) {
     LOG(ERROR) << __func__
                << ": can't open GATT cache file for writing: " << fname;
+    unlink(fname);
     return;
   }
 
-  uint16_t cache_ver = GATT_CACHE_VERSION;
-  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << fname;
+  if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache header: " << fname;
     fclose(fd);
+    unlink(fname);
     return;
   }
 
-  uint16_t num_attr = attr.size();
-  if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't write GATT cache attribute count: " << fname;
-    fclose(fd);
-    return;
-  }
+  fclose(fd);
+}
 
-  if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << fname;
-    fclose(fd);
-    return;
+/*******************************************************************************
+ *
+ * Function         bta_gattc_cache_gc
+ *
+ * Description      Remove shared GATT databases that no device cache file
+ *                  refers to any more, and the temporary files of the
+ *                  databases whose write was interrupted.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+static void bta_gattc_cache_gc(void) {
+  DIR* p_dir = opendir(GATT_CACHE_DIR);
+  if (!p_dir) return;
+
+  std::set<uint64_t> in_use;
+  std::vector<uint64_t> stored;
+  struct dirent* p_ent;
+  while ((p_ent = readdir(p_dir)) != NULL) {
+    if (!strncmp(p_ent->d_name, GATT_CACHE_FILE, strlen(GATT_CACHE_FILE))) {
+      char fname[255] = {0};
+      snprintf(fname, sizeof(fname), "%s%s", GATT_CACHE_DIR, p_ent->d_name);
+      FILE* fd = fopen(fname, "rb");
+      if (!fd) continue;
+
+      tBTA_GATTC_CACHE_HDR hdr;
+      if (fread(&hdr, sizeof(hdr), 1, fd) == 1 &&
+          hdr.version == GATT_CACHE_VERSION)
+        in_use.insert(hdr.hash);
+      fclose(fd);
+    } else if (!strncmp(p_ent->d_name, GATT_HASH_FILE,
+                        strlen(GATT_HASH_FILE))) {
+      const char* p_hash = p_ent->d_name + strlen(GATT_HASH_FILE);
+      uint64_t hash;
+      int end = 0;
+      if (sscanf(p_hash, "%16" SCNx64 "%n", &hash, &end) != 1 || end != 16)
+        continue;
+      if (p_hash[end] == '\0') {
+        stored.push_back(hash);
+      } else if (!strcmp(p_hash + end, ".new")) {
+        /* Left by an interrupted bta_gattc_cache_write_shared: the writes
+         * run on this thread, so none is in progress */
+        char fname[255] = {0};
+        snprintf(fname, sizeof(fname), "%s%s", GATT_CACHE_DIR, p_ent->d_name);
+        VLOG(1) << __func__ << ": removing stale GATT database " << fname;
+        unlink(fname);
+      }
+    }
   }
+  closedir(p_dir);
 
-  fclose(fd);
+  for (uint64_t hash : stored) {
+    if (in_use.count(hash)) continue;
+
+    char fname[255] = {0};
+    bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
+    VLOG(1) << __func__ << ": removing unused GATT database " << fname;
+    unlink(fname);
+  }
 }
 
 /*******************************************************************************
@@ -836,4 +1178,5 @@ void bta_gattc_cache_reset(const RawAddress& server_bda) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
   unlink(fname);
+  bta_gattc_cache_gc();
 }
@@ -57,6 +57,7 @@ enum {
   BTA_GATTC_API_SEARCH_EVT,
   BTA_GATTC_API_CONFIRM_EVT,
   BTA_GATTC_API_READ_MULTI_EVT,
+  BTA_GATTC_API_WRITE_CMDS_EVT,
 
   BTA_GATTC_INT_CONN_EVT,
   BTA_GATTC_INT_DISCOVER_EVT,
@@ -86,6 +87,11 @@ typedef uint16_t tBTA_GATTC_INT_EVT;
 
 #define BTA_GATTC_WRITE_PREPARE GATT_WRITE_PREPARE
 
+/* max write commands of a batch sent to the stack before their completion */
+#ifndef BTA_GATTC_WRITE_CMDS_WINDOW
+#define BTA_GATTC_WRITE_CMDS_WINDOW 8
+#endif
+
 #define BTA_GATTC_NATIVE_ACCESS_SOCKET "/dev/socket/qvrservice_controller"
 
 /* internal strucutre for GATTC register API  */
@@ -159,8 +165,27 @@ typedef struct {
   tGATT_AUTH_REQ auth_req;
   uint8_t num_attr;
   uint16_t handles[GATT_MAX_READ_MULTI_HANDLES];
+  GATT_READ_OP_CB read_cb;
+  void* read_cb_data;
 } tBTA_GATTC_API_READ_MULTI;
 
+typedef struct {
+  uint16_t handle;
+  uint16_t len;
+  uint8_t* p_value;
+  GATT_WRITE_OP_CB write_cb;
+  void* write_cb_data;
+} tBTA_GATTC_WRITE_CMD_ENTRY;
+
+typedef struct {
+  BT_HDR hdr;
+  tGATT_AUTH_REQ auth_req;
+  uint16_t num_cmds;
+  tBTA_GATTC_WRITE_CMD_ENTRY* p_cmds;
+  uint16_t next; /* next command to send */
+  uint16_t done; /* commands completed */
+} tBTA_GATTC_API_WRITE_CMDS;
+
 typedef struct {
   BT_HDR hdr;
   uint16_t mtu;
@@ -185,6 +210,7 @@ typedef union {
   tBTA_GATTC_API_CONFIRM api_confirm;
   tBTA_GATTC_API_EXEC api_exec;
   tBTA_GATTC_API_READ_MULTI api_read_multi;
+  tBTA_GATTC_API_WRITE_CMDS api_write_cmds;
   tBTA_GATTC_API_CFG_MTU api_mtu;
   tBTA_GATTC_OP_CMPL op_cmpl;
   tBTA_GATTC_INT_CONN int_conn;
@@ -198,6 +224,14 @@ enum {
 };
 typedef uint8_t tBTA_GATTC_STATE;
 
+/* Timing of the GATT discovery procedures of one server, per discovery type */
+typedef struct {
+  uint32_t start_ms;      /* start of the whole discovery */
+  uint32_t proc_start_ms; /* start of the procedure in progress */
+  uint32_t stage_ms[GATT_DISC_MAX];
+  uint16_t num_proc[GATT_DISC_MAX];
+} tBTA_GATTC_DISC_STATS;
+
 typedef struct {
   bool in_use;
   RawAddress server_bda;
@@ -216,6 +250,7 @@ typedef struct {
   uint8_t num_clcb;     /* number of associated CLCB */
 
   gatt::DatabaseBuilder pending_discovery;
+  tBTA_GATTC_DISC_STATS disc_stats;
 
   uint8_t srvc_hdl_chg; /* service handle change indication pending */
   uint16_t attr_index;  /* cahce NV saving/loading attribute index */
@@ -259,6 +294,7 @@ typedef struct {
 
   uint8_t auto_update; /* auto update is waiting */
   bool disc_active;
+  bool congested; /* the link reported congestion */
   bool in_use;
   tBTA_GATTC_STATE state;
   tGATT_STATUS status;
@@ -368,6 +404,14 @@ extern void bta_gattc_confirm(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_execute(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_read_multi(tBTA_GATTC_CLCB* p_clcb,
                                  tBTA_GATTC_DATA* p_data);
+extern void bta_gattc_write_cmds(tBTA_GATTC_CLCB* p_clcb,
+                                 tBTA_GATTC_DATA* p_data);
+extern void bta_gattc_write_cmds_send(tBTA_GATTC_CLCB* p_clcb);
+extern void bta_gattc_write_cmds_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                      tBTA_GATTC_OP_CMPL* p_data);
+extern void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
+                                   tGATT_STATUS status,
+                                   tGATT_CL_COMPLETE* p_data);
 extern void bta_gattc_ci_open(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_ci_close(tBTA_GATTC_CLCB* p_clcb,
                                tBTA_GATTC_DATA* p_data);
@@ -20,6 +20,8 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "osi/include/time.h"
+
 using gatt_operation = BtaGattQueue::gatt_operation;
 
 constexpr uint8_t GATT_READ_CHAR = 1;
@@ -27,19 +29,47 @@ constexpr uint8_t GATT_READ_DESC = 2;
 constexpr uint8_t GATT_WRITE_CHAR = 3;
 constexpr uint8_t GATT_WRITE_DESC = 4;
 
+/* Max write commands streamed in one batch */
+constexpr size_t GATT_WRITE_CMDS_MAX = 32;
+
 struct gatt_read_op_data {
   GATT_READ_OP_CB cb;
   void* cb_data;
 };
 
+struct gatt_read_multi_op_data {
+  uint8_t num_ops;
+  struct {
+    uint8_t type;
+    uint16_t handle;
+    uint16_t value_len;
+    GATT_READ_OP_CB cb;
+    void* cb_data;
+  } ops[BTA_GATTC_MULTI_MAX];
+};
+
 std::unordered_map<uint16_t, std::list<gatt_operation>>
     BtaGattQueue::gatt_op_queue;
 std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_executing;
+std::unordered_map<uint16_t, BtaGattQueue::gatt_queue_stats>
+    BtaGattQueue::gatt_op_queue_stats;
 
 void BtaGattQueue::mark_as_not_executing(uint16_t conn_id) {
   gatt_op_queue_executing.erase(conn_id);
 }
 
+void BtaGattQueue::gatt_op_started(uint16_t conn_id, uint32_t num_ops) {
+  gatt_queue_stats& stats = gatt_op_queue_stats[conn_id];
+  if (stats.ops == 0) stats.first_op_us = time_get_os_boottime_us();
+  stats.ops += num_ops;
+}
+
+void BtaGattQueue::gatt_op_completed(uint16_t conn_id) {
+  auto it = gatt_op_queue_stats.find(conn_id);
+  if (it != gatt_op_queue_stats.end())
+    it->second.last_op_us = time_get_os_boottime_us();
+}
+
 void BtaGattQueue::gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                          uint16_t handle, uint16_t len,
                                          uint8_t* value, void* data) {
@@ -53,6 +83,7 @@ void BtaGattQueue::gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
   osi_free(data);
 
   mark_as_not_executing(conn_id);
+  gatt_op_completed(conn_id);
   gatt_execute_next_op(conn_id);
 
   if (tmp_cb) {
@@ -61,6 +92,55 @@ void BtaGattQueue::gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
   }
 }
 
+void BtaGattQueue::gatt_read_multi_op_finished(uint16_t conn_id,
+                                               tGATT_STATUS status,
+                                               uint16_t handle, uint16_t len,
+                                               uint8_t* value, void* data) {
+  gatt_read_multi_op_data tmp = *(gatt_read_multi_op_data*)data;
+  osi_free(data);
+
+  APPL_TRACE_DEBUG("%s: conn_id=0x%x handle=%d status=%d len=%d", __func__,
+                   conn_id, handle, status, len);
+
+  uint32_t expected_len = 0;
+  for (uint8_t i = 0; i < tmp.num_ops; i++)
+    expected_len += tmp.ops[i].value_len;
+
+  mark_as_not_executing(conn_id);
+  gatt_op_completed(conn_id);
+
+  if (status != GATT_SUCCESS || len != expected_len) {
+    /* One of the values can't be read, or has another length: read them one
+     * by one, so that each gets its own status and value */
+    APPL_TRACE_WARNING(
+        "%s: conn_id=0x%x read multiple status=%d len=%d expected=%d, "
+        "retrying the %d reads",
+        __func__, conn_id, status, len, expected_len, tmp.num_ops);
+    std::list<gatt_operation>& gatt_ops = gatt_op_queue[conn_id];
+    for (int i = tmp.num_ops - 1; i >= 0; i--) {
+      gatt_ops.push_front({.type = tmp.ops[i].type,
+                           .handle = tmp.ops[i].handle,
+                           .read_cb = tmp.ops[i].cb,
+                           .read_cb_data = tmp.ops[i].cb_data,
+                           .value_len = 0});
+    }
+    gatt_op_queue_stats[conn_id].ops -= tmp.num_ops;
+    gatt_execute_next_op(conn_id);
+    return;
+  }
+
+  gatt_op_queue_stats[conn_id].reads_coalesced += tmp.num_ops;
+  gatt_execute_next_op(conn_id);
+
+  for (uint8_t i = 0; i < tmp.num_ops; i++) {
+    if (tmp.ops[i].cb) {
+      tmp.ops[i].cb(conn_id, status, tmp.ops[i].handle, tmp.ops[i].value_len,
+                    value, tmp.ops[i].cb_data);
+    }
+    value += tmp.ops[i].value_len;
+  }
+}
+
 struct gatt_write_op_data {
   GATT_WRITE_OP_CB cb;
   void* cb_data;
@@ -78,6 +158,7 @@ void BtaGattQueue::gatt_write_op_finished(uint16_t conn_id, tGATT_STATUS status,
   osi_free(data);
 
   mark_as_not_executing(conn_id);
+  gatt_op_completed(conn_id);
   gatt_execute_next_op(conn_id);
 
   if (tmp_cb) {
@@ -86,6 +167,87 @@ void BtaGattQueue::gatt_write_op_finished(uint16_t conn_id, tGATT_STATUS status,
   }
 }
 
+/* Stream the write commands at the front of |gatt_ops| in one batch. The
+ * callback of the last command completes the batch. Returns false if there
+ * is only one write command. */
+bool BtaGattQueue::gatt_execute_write_cmds(
+    uint16_t conn_id, std::list<gatt_operation>& gatt_ops) {
+  size_t num_cmds = 0;
+  for (const gatt_operation& op : gatt_ops) {
+    if (op.type != GATT_WRITE_CHAR || op.write_type != GATT_WRITE_NO_RSP ||
+        num_cmds == GATT_WRITE_CMDS_MAX)
+      break;
+    num_cmds++;
+  }
+  if (num_cmds < 2) return false;
+
+  std::vector<tBTA_GATTC_WRITE_CMD> cmds(num_cmds);
+  for (size_t i = 0; i < num_cmds; i++) {
+    gatt_operation& op = gatt_ops.front();
+    cmds[i].handle = op.handle;
+    cmds[i].value = std::move(op.value);
+    cmds[i].callback = op.write_cb;
+    cmds[i].cb_data = op.write_cb_data;
+    if (i == num_cmds - 1) {
+      gatt_write_op_data* data =
+          (gatt_write_op_data*)osi_malloc(sizeof(gatt_write_op_data));
+      data->cb = op.write_cb;
+      data->cb_data = op.write_cb_data;
+      cmds[i].callback = gatt_write_op_finished;
+      cmds[i].cb_data = data;
+    }
+    gatt_ops.pop_front();
+  }
+
+  APPL_TRACE_DEBUG("%s: conn_id=0x%x streaming %zu write commands", __func__,
+                   conn_id, num_cmds);
+  gatt_op_started(conn_id, num_cmds);
+  gatt_op_queue_stats[conn_id].write_cmds_streamed += num_cmds;
+  BTA_GATTC_WriteCharValueCmds(conn_id, std::move(cmds), GATT_AUTH_REQ_NONE);
+  return true;
+}
+
+/* Coalesce the reads of known length at the front of |gatt_ops| into one Read
+ * Multiple request, as long as the values fit in the response. Returns false
+ * if there is only one such read. */
+bool BtaGattQueue::gatt_execute_read_multi(
+    uint16_t conn_id, std::list<gatt_operation>& gatt_ops) {
+  uint16_t mtu = BTA_GATTC_GetMtu(conn_id);
+
+  tBTA_GATTC_MULTI read_multi;
+  uint32_t total_len = 0;
+  read_multi.num_attr = 0;
+  for (const gatt_operation& op : gatt_ops) {
+    if ((op.type != GATT_READ_CHAR && op.type != GATT_READ_DESC) ||
+        op.value_len == 0 || total_len + op.value_len > (uint32_t)(mtu - 1) ||
+        read_multi.num_attr == BTA_GATTC_MULTI_MAX)
+      break;
+    total_len += op.value_len;
+    read_multi.handles[read_multi.num_attr++] = op.handle;
+  }
+  if (read_multi.num_attr < 2) return false;
+
+  gatt_read_multi_op_data* data =
+      (gatt_read_multi_op_data*)osi_malloc(sizeof(gatt_read_multi_op_data));
+  data->num_ops = read_multi.num_attr;
+  for (uint8_t i = 0; i < read_multi.num_attr; i++) {
+    gatt_operation& op = gatt_ops.front();
+    data->ops[i].type = op.type;
+    data->ops[i].handle = op.handle;
+    data->ops[i].value_len = op.value_len;
+    data->ops[i].cb = op.read_cb;
+    data->ops[i].cb_data = op.read_cb_data;
+    gatt_ops.pop_front();
+  }
+
+  APPL_TRACE_DEBUG("%s: conn_id=0x%x coalescing %d reads, %d bytes", __func__,
+                   conn_id, read_multi.num_attr, total_len);
+  gatt_op_started(conn_id, read_multi.num_attr);
+  BTA_GATTC_ReadMultiple(conn_id, &read_multi, GATT_AUTH_REQ_NONE,
+                         gatt_read_multi_op_finished, data);
+  return true;
+}
+
 void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
   APPL_TRACE_DEBUG("%s: conn_id=0x%x", __func__, conn_id);
   if (gatt_op_queue.empty()) {
@@ -113,6 +275,13 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
 
   APPL_TRACE_DEBUG("%s: op.type=%d, handle=%d", __func__, op.type,
     op.handle);
+  if (op.type == GATT_WRITE_CHAR && op.write_type == GATT_WRITE_NO_RSP &&
+      gatt_execute_write_cmds(conn_id, gatt_ops))
+    return;
+
+  if (op.value_len != 0 && gatt_execute_read_multi(conn_id, gatt_ops)) return;
+
+  gatt_op_started(conn_id, 1);
   if (op.type == GATT_READ_CHAR) {
     gatt_read_op_data* data =
         (gatt_read_op_data*)osi_malloc(sizeof(gatt_read_op_data));
@@ -153,25 +322,46 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
 void BtaGattQueue::Clean(uint16_t conn_id) {
   APPL_TRACE_DEBUG("%s: conn_id=0x%x", __func__, conn_id);
 
+  auto it = gatt_op_queue_stats.find(conn_id);
+  if (it != gatt_op_queue_stats.end()) {
+    const gatt_queue_stats& stats = it->second;
+    uint64_t duration_us = stats.last_op_us > stats.first_op_us
+                               ? stats.last_op_us - stats.first_op_us
+                               : 0;
+    APPL_TRACE_DEBUG(
+        "%s: conn_id=0x%x %u ops in %llu ms (%llu ops/s), %u write commands "
+        "streamed, %u reads coalesced",
+        __func__, conn_id, stats.ops,
+        (unsigned long long)(duration_us / 1000),
+        (unsigned long long)(duration_us ? stats.ops * 1000000ULL / duration_us
+                                         : 0),
+        stats.write_cmds_streamed, stats.reads_coalesced);
+    gatt_op_queue_stats.erase(it);
+  }
+
   gatt_op_queue.erase(conn_id);
   gatt_op_queue_executing.erase(conn_id);
 }
 
 void BtaGattQueue::ReadCharacteristic(uint16_t conn_id, uint16_t handle,
-                                      GATT_READ_OP_CB cb, void* cb_data) {
+                                      GATT_READ_OP_CB cb, void* cb_data,
+                                      uint16_t value_len) {
   gatt_op_queue[conn_id].push_back({.type = GATT_READ_CHAR,
                                     .handle = handle,
                                     .read_cb = cb,
-                                    .read_cb_data = cb_data});
+                                    .read_cb_data = cb_data,
+                                    .value_len = value_len});
   gatt_execute_next_op(conn_id);
 }
 
 void BtaGattQueue::ReadDescriptor(uint16_t conn_id, uint16_t handle,
-                                  GATT_READ_OP_CB cb, void* cb_data) {
+                                  GATT_READ_OP_CB cb, void* cb_data,
+                                  uint16_t value_len) {
   gatt_op_queue[conn_id].push_back({.type = GATT_READ_DESC,
                                     .handle = handle,
                                     .read_cb = cb,
-                                    .read_cb_data = cb_data});
+                                    .read_cb_data = cb_data,
+                                    .value_len = value_len});
   gatt_execute_next_op(conn_id);
 }
 
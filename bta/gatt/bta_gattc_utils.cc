@@ -372,6 +372,7 @@ void bta_gattc_clear_notif_reg_on_disc(tBTA_GATTC_RCB *p_clreg, RawAddress bda)
           memset(&p_clreg->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
         }
     }
+    GATTC_UnsubscribeNotification(p_clreg->client_if, bda, 0);
 }
 
 /*******************************************************************************
@@ -407,8 +408,10 @@ void bta_gattc_clear_notif_registration(tBTA_GATTC_SERV* p_srcb,
            * clear boundaries are always around service.
            */
           handle = p_clrcb->notif_reg[i].handle;
-          if (handle >= start_handle && handle <= end_handle)
+          if (handle >= start_handle && handle <= end_handle) {
             memset(&p_clrcb->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
+            GATTC_UnsubscribeNotification(gatt_if, remote_bda, handle);
+          }
         }
       }
     }
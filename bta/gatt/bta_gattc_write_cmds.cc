@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the streaming of a batch of write commands by the GATT
+ *  client.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_bta_gattc"
+
+#include <base/logging.h>
+#include <string.h>
+
+#include "bt_common.h"
+#include "bta_gattc_int.h"
+#include "osi/include/allocator.h"
+
+/** send the write commands of a batch, up to the window and while the link
+ * is not congested */
+void bta_gattc_write_cmds_send(tBTA_GATTC_CLCB* p_clcb) {
+  tBTA_GATTC_API_WRITE_CMDS* p_cmds = &p_clcb->p_q_cmd->api_write_cmds;
+
+  while (!p_clcb->congested && p_cmds->next < p_cmds->num_cmds &&
+         p_cmds->next - p_cmds->done < BTA_GATTC_WRITE_CMDS_WINDOW) {
+    tBTA_GATTC_WRITE_CMD_ENTRY* p_cmd = &p_cmds->p_cmds[p_cmds->next];
+    tGATT_STATUS status = GATT_INVALID_ATTR_LEN;
+    if (p_cmd->len <= GATT_MAX_ATTR_LEN) {
+      tGATT_VALUE attr;
+
+      attr.conn_id = p_clcb->bta_conn_id;
+      attr.handle = p_cmd->handle;
+      attr.offset = 0;
+      attr.len = p_cmd->len;
+      attr.auth_req = p_cmds->auth_req;
+      if (p_cmd->len) memcpy(attr.value, p_cmd->p_value, p_cmd->len);
+
+      status = GATTC_Write(p_clcb->bta_conn_id, GATT_WRITE_NO_RSP, &attr);
+    }
+
+    if (status == GATT_SUCCESS) {
+      p_cmds->next++;
+      continue;
+    }
+
+    /* GATT answers busy while it still holds a previous command, queued
+     * behind a pending request or waiting for the link security. The
+     * completions are matched to the commands in order: retry on the next
+     * completion, and report a failure only once no command is pending. */
+    if (p_cmds->next > p_cmds->done) return;
+
+    p_cmds->next++;
+    bta_gattc_cmpl_sendmsg(p_clcb->bta_conn_id, GATTC_OPTYPE_WRITE, status,
+                           NULL);
+  }
+}
+
+/** stream a batch of write commands */
+void bta_gattc_write_cmds(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
+  if (!bta_gattc_enqueue(p_clcb, p_data)) return;
+
+  bta_gattc_write_cmds_send(p_clcb);
+}
+
+/** write command of a batch complete */
+void bta_gattc_write_cmds_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                               tBTA_GATTC_OP_CMPL* p_data) {
+  tBTA_GATTC_API_WRITE_CMDS* p_cmds = &p_clcb->p_q_cmd->api_write_cmds;
+  if (p_cmds->done >= p_cmds->next) {
+    LOG(ERROR) << __func__ << ": no write command pending";
+    return;
+  }
+
+  /* the command was sent on a congested link */
+  tGATT_STATUS status = p_data->status;
+  if (status == GATT_CONGESTED) status = GATT_SUCCESS;
+
+  tBTA_GATTC_WRITE_CMD_ENTRY cmd = p_cmds->p_cmds[p_cmds->done++];
+  if (p_cmds->done == p_cmds->num_cmds)
+    osi_free_and_reset((void**)&p_clcb->p_q_cmd);
+  else
+    bta_gattc_write_cmds_send(p_clcb);
+
+  if (cmd.write_cb)
+    cmd.write_cb(p_clcb->bta_conn_id, status, cmd.handle, cmd.write_cb_data);
+}
@@ -113,6 +113,11 @@ class Database {
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
                               bool* success);
 
+  /* Same as above, but reads |count| attributes straight from |nv_attr|, i.e.
+   * from a read-only mapping of a cache file, without copying them first */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t count, bool* success);
+
   friend class DatabaseBuilder;
 
  private:
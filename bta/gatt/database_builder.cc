@@ -57,24 +57,56 @@ void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
 void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
                                          uint16_t start_handle,
                                          uint16_t end_handle) {
-  Service* service = FindService(database.services, handle);
-  if (!service) {
+  if (!FindService(database.services, handle)) {
+    /* A wide exploration returns the includes in handle order: the include of
+     * a secondary service can come before the include that reveals it */
+    if (wide_exploration && explored_range.first <= explored_range.second) {
+      pending_includes.push_back(IncludedService{
+          .handle = handle,
+          .uuid = uuid,
+          .start_handle = start_handle,
+          .end_handle = end_handle,
+      });
+      return;
+    }
+
     LOG(ERROR) << "Illegal action to add to non-existing service!";
     return;
   }
 
   /* We discover all Primary Services first. If included service was not seen
    * before, it must be a Secondary Service */
+  bool new_service = false;
   if (!FindService(database.services, start_handle)) {
     AddService(start_handle, end_handle, uuid, false /* not primary */);
+    new_service = true;
   }
 
+  /* AddService might have moved the services */
+  Service* service = FindService(database.services, handle);
   service->included_services.push_back(IncludedService{
       .handle = handle,
       .uuid = uuid,
       .start_handle = start_handle,
       .end_handle = end_handle,
   });
+
+  if (new_service) AddPendingIncludes();
+}
+
+void DatabaseBuilder::AddPendingIncludes() {
+  for (auto it = pending_includes.begin(); it != pending_includes.end(); it++) {
+    if (!FindService(database.services, it->handle)) continue;
+
+    IncludedService included = *it;
+    pending_includes.erase(it);
+    /* Might add another secondary service, and resolve the remaining pending
+     * includes recursively */
+    AddIncludedService(included.handle, included.uuid, included.start_handle,
+                       included.end_handle);
+    AddPendingIncludes();
+    return;
+  }
 }
 
 void DatabaseBuilder::AddCharacteristic(uint16_t handle, uint16_t value_handle,
@@ -111,6 +143,9 @@ void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
     return;
   }
 
+  /* Merged descriptor ranges also span the declarations between them */
+  if (IsDeclarationHandle(handle)) return;
+
   Characteristic* char_node = &service->characteristics.front();
   for (auto it = service->characteristics.begin();
        it != service->characteristics.end(); it++) {
@@ -123,6 +158,18 @@ void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
 }
 
 bool DatabaseBuilder::StartNextServiceExploration() {
+  if (wide_exploration && !services_to_discover.empty() &&
+      explored_range.first > explored_range.second) {
+    /* services are sorted by start handle; they never overlap, so the last one
+     * ends the range */
+    pending_service = {services_to_discover.begin()->first,
+                       services_to_discover.rbegin()->second};
+    services_to_discover.clear();
+    explored_range = pending_service;
+    pending_characteristic = HANDLE_MIN;
+    return true;
+  }
+
   while (!services_to_discover.empty()) {
     auto handle_range = services_to_discover.begin();
     pending_service = *handle_range;
@@ -131,6 +178,11 @@ bool DatabaseBuilder::StartNextServiceExploration() {
     // Empty service declaration, nothing to explore, skip to next.
     if (pending_service.first == pending_service.second) continue;
 
+    // Secondary service found while exploring a wide range it is part of
+    if (pending_service.first >= explored_range.first &&
+        pending_service.second <= explored_range.second)
+      continue;
+
     pending_characteristic = HANDLE_MIN;
     return true;
   }
@@ -143,14 +195,17 @@ DatabaseBuilder::CurrentlyExploredService() {
 }
 
 std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
-  Service* service = FindService(database.services, pending_service.first);
-  if (!service || service->characteristics.empty()) {
-    return {HANDLE_MAX, HANDLE_MAX};
-  }
+  std::pair<uint16_t, uint16_t> range = {HANDLE_MAX, HANDLE_MAX};
+
+  for (const Service& service : database.services) {
+    if (service.handle < pending_service.first ||
+        service.end_handle > pending_service.second)
+      continue;
+
+    for (auto it = service.characteristics.cbegin();
+         it != service.characteristics.cend(); it++) {
+      if (it->declaration_handle <= pending_characteristic) continue;
 
-  for (auto it = service->characteristics.cbegin();
-       it != service->characteristics.cend(); it++) {
-    if (it->declaration_handle > pending_characteristic) {
       auto next = std::next(it);
 
       /* Characteristic Declaration is followed by Characteristic Value
@@ -158,32 +213,70 @@ std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
        * Part G 3.3.2 and 3.3.3 */
       uint16_t start = it->declaration_handle + 2;
       uint16_t end;
-      if (next != service->characteristics.end())
+      if (next != service.characteristics.end())
         end = next->declaration_handle - 1;
       else
-        end = service->end_handle;
+        end = service.end_handle;
 
       // No place for descriptor - skip to next characteristic
       if (start > end) continue;
 
+      if (range.first != HANDLE_MAX) {
+        /* Extend the range only if everything in between is a known
+         * declaration, AddDescriptor() drops those from the response */
+        if (!wide_exploration) return range;
+        for (uint16_t handle = range.second + 1; handle < start; handle++) {
+          if (!IsDeclarationHandle(handle)) return range;
+        }
+        range.second = end;
+      } else {
+        range = {start, end};
+      }
+
       pending_characteristic = start;
-      return {start, end};
+      if (!wide_exploration) return range;
     }
   }
 
-  pending_characteristic = HANDLE_MAX;
-  return {HANDLE_MAX, HANDLE_MAX};
+  if (range.first == HANDLE_MAX) pending_characteristic = HANDLE_MAX;
+  return range;
+}
+
+bool DatabaseBuilder::IsDeclarationHandle(uint16_t handle) {
+  Service* service = FindService(database.services, handle);
+  if (!service) return false;
+  if (service->handle == handle) return true;
+
+  for (const IncludedService& included : service->included_services) {
+    if (included.handle == handle) return true;
+  }
+
+  for (const Characteristic& charac : service->characteristics) {
+    if (charac.declaration_handle == handle || charac.value_handle == handle)
+      return true;
+  }
+  return false;
 }
 
 bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 
 Database DatabaseBuilder::Build() {
+  for (const IncludedService& included : pending_includes) {
+    LOG(ERROR) << "Included service declaration 0x" << std::hex
+               << included.handle << " is not inside any service";
+  }
+  pending_includes.clear();
+
   Database tmp = database;
   database.Clear();
   return tmp;
 }
 
-void DatabaseBuilder::Clear() { database.Clear(); }
+void DatabaseBuilder::Clear() {
+  database.Clear();
+  explored_range = {HANDLE_MAX, HANDLE_MIN};
+  pending_includes.clear();
+}
 
 std::string DatabaseBuilder::ToString() const { return database.ToString(); }
 
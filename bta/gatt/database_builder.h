@@ -38,6 +38,13 @@ class DatabaseBuilder {
                          const bluetooth::Uuid& uuid, uint8_t properties);
   void AddDescriptor(uint16_t handle, const bluetooth::Uuid& uuid);
 
+  /* When enabled, all services found so far are explored as one handle range:
+   * included services and characteristics are discovered with a single Read By
+   * Type procedure each, and neighbouring descriptor ranges are merged into
+   * one Find Information procedure. bta_gattc_init_cache() enables it unless
+   * persist.bluetooth.gatt.wide_discovery is set to "false". */
+  void SetWideExploration(bool wide) { wide_exploration = wide; }
+
   /* Returns true if next service exploration started, false if there are no
    * more services to explore. */
   bool StartNextServiceExploration();
@@ -76,6 +83,21 @@ class DatabaseBuilder {
   /* Characteristic inside pending_service that is currently being explored */
   uint16_t pending_characteristic;
 
+  bool wide_exploration = false;
+  /* Handle range already covered by a wide exploration, services inside it
+   * need no exploration of their own */
+  std::pair<uint16_t, uint16_t> explored_range = {HANDLE_MAX, HANDLE_MIN};
+  /* Included services found by a wide exploration inside a secondary service
+   * that was not revealed yet */
+  std::vector<IncludedService> pending_includes;
+
+  /* Add the pending included services whose service is now known */
+  void AddPendingIncludes();
+
+  /* Return true if |handle| is a service, included service, characteristic or
+   * characteristic value declaration, i.e. can't be a descriptor */
+  bool IsDeclarationHandle(uint16_t handle);
+
   /* sorted, unique set of start_handle, end_handle pair of all services that
    * have not yet been discovered */
   std::set<std::pair<uint16_t, uint16_t>> services_to_discover;
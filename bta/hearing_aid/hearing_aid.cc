@@ -1207,20 +1207,37 @@ class HearingAidImpl : public HearingAid {
     // TODO: make those buffers static and global to prevent constant
     // reallocations
     // TODO: this should basically fit the encoded data, tune the size later
+    // TODO: instead of a magic number, we need to figure out the correct
+    // buffer size
     std::vector<uint8_t> encoded_data_left;
-    if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
+    std::vector<uint8_t> encoded_data_right;
+    if (chan_left.size() == 0) {
+      LOG(ERROR) << "Error: No audio data to encode";
+    } else if (left && right) {
+      // Binaural: encode both sides in one pass
+      encoded_data_left.resize(4000);
+      encoded_data_right.resize(4000);
+      int encoded_size = g722_encode_stereo(
+          encoder_state_left, encoder_state_right, encoded_data_left.data(),
+          encoded_data_right.data(), (const int16_t*)chan_left.data(),
+          (const int16_t*)chan_right.data(), chan_left.size());
+      encoded_data_left.resize(encoded_size);
+      encoded_data_right.resize(encoded_size);
+    } else if (left) {
       encoded_data_left.resize(4000);
-      int encoded_size = 0;
-      if (chan_left.size() > 0) {
-          encoded_size = g722_encode(encoder_state_left, encoded_data_left.data(),
+      int encoded_size =
+          g722_encode(encoder_state_left, encoded_data_left.data(),
                       (const int16_t*)chan_left.data(), chan_left.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_left data to encode";
-      }
       encoded_data_left.resize(encoded_size);
+    } else if (right) {
+      encoded_data_right.resize(4000);
+      int encoded_size =
+          g722_encode(encoder_state_right, encoded_data_right.data(),
+                      (const int16_t*)chan_right.data(), chan_right.size());
+      encoded_data_right.resize(encoded_size);
+    }
 
+    if (left) {
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1235,20 +1252,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size = 0;
-      if (chan_right.size() > 0) {
-          encoded_size = g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_right data to encode";
-      }
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -21,7 +21,9 @@
 #include "bta_hearing_aid_api.h"
 #include "btu.h"
 #include "osi/include/alarm.h"
+#include "osi/include/properties.h"
 #include "uipc.h"
+#include "uipc_audio_ring.h"
 
 #include <base/files/file_util.h>
 #include <include/hardware/bt_av.h>
@@ -34,6 +36,10 @@ extern void do_in_bta_thread(const base::Location& from_here,
                       const base::Closure& task);
 extern thread_t* get_worker_thread();
 
+/* Offer the audio HAL a shared memory ring instead of the audio socket */
+#define HEARING_AID_AUDIO_RING_PROPERTY \
+  "persist.bluetooth.hearing_aid.audio_ring"
+
 namespace {
 int bit_rate = -1;
 int sample_rate = -1;
@@ -96,6 +102,35 @@ void hearing_aid_send_ack(tHEARING_AID_CTRL_ACK status) {
   UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
 }
 
+// Creates a shared memory ring for the audio channel and passes it to the
+// audio HAL; the HAL keeps writing to the audio socket if this fails
+void hearing_aid_recv_open_audio_ring() {
+  char value[PROPERTY_VALUE_MAX] = {0};
+  tUIPC_AUDIO_RING* ring = nullptr;
+
+  osi_property_get(HEARING_AID_AUDIO_RING_PROPERTY, value, "false");
+  if (!strcmp(value, "true"))
+    ring = uipc_audio_ring_create(AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+
+  hearing_aid_send_ack(ring ? HEARING_AID_CTRL_ACK_SUCCESS
+                            : HEARING_AID_CTRL_ACK_UNSUPPORTED);
+  if (ring == nullptr) return;
+
+  tUIPC_AUDIO_RING_STATS ring_stats;
+  uipc_audio_ring_get_stats(ring, &ring_stats);
+  if (!UIPC_SendFd(UIPC_CH_ID_AV_CTRL, uipc_audio_ring_fd(ring),
+                   reinterpret_cast<const uint8_t*>(&ring_stats.size),
+                   sizeof(ring_stats.size))) {
+    LOG(ERROR) << __func__ << ": failed to pass audio ring to HAL";
+    uipc_audio_ring_free(ring);
+    return;
+  }
+
+  LOG(INFO) << __func__ << ": audio ring of " << ring_stats.size
+            << " bytes attached";
+  UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_SET_AUDIO_RING, ring);
+}
+
 void hearing_aid_data_cb(tUIPC_CH_ID, tUIPC_EVENT event) {
   DVLOG(2) << "Hearing Aid audio data event: " << event;
   switch (event) {
@@ -264,6 +299,10 @@ void hearing_aid_recv_ctrl_data() {
       break;
     }
 
+    case HEARING_AID_CTRL_CMD_OPEN_AUDIO_RING:
+      hearing_aid_recv_open_audio_ring();
+      break;
+
     default:
       LOG(ERROR) << __func__ << "UNSUPPORTED CMD: " << cmd;
       hearing_aid_send_ack(HEARING_AID_CTRL_ACK_FAILURE);
@@ -415,5 +454,21 @@ void HearingAidAudioSource::DebugDump(int fd) {
                        1000
                  : 0)
          << std::endl;
+
+  tUIPC_AUDIO_RING_STATS ring_stats;
+  if (UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_GET_AUDIO_RING_STATS,
+                 &ring_stats)) {
+    stream << "    Audio ring:"
+           << "\n    Fill in bytes (size/now/max/ave)                        : "
+           << ring_stats.size << " / " << ring_stats.fill << " / "
+           << ring_stats.max_fill << " / "
+           << (ring_stats.num_reads ? ring_stats.fill_sum / ring_stats.num_reads
+                                    : 0)
+           << "\n    Counts (reads/underruns)                                : "
+           << ring_stats.num_reads << " / " << ring_stats.underruns
+           << "\n    Counts (producer waits/wakeups/timeouts)                : "
+           << ring_stats.producer_waits << " / " << ring_stats.wakeups << " / "
+           << ring_stats.timeouts << std::endl;
+  }
   dprintf(fd, "%s", stream.str().c_str());
 }
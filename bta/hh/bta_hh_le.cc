@@ -56,6 +56,11 @@ using std::vector;
 #define BTA_HH_LE_PROTO_BOOT_MODE 0x00
 #define BTA_HH_LE_PROTO_REPORT_MODE 0x01
 
+/* Length of the fixed size values, to coalesce their reads */
+#define BTA_HH_LE_HID_INFO_LEN 4
+#define BTA_HH_LE_RPT_REF_LEN 2
+#define BTA_HH_LE_CCC_LEN 2
+
 #define BTA_LE_HID_RTP_UUID_MAX 5
 static const uint16_t bta_hh_uuid_to_rtp_type[BTA_LE_HID_RTP_UUID_MAX][2] = {
     {GATT_UUID_HID_REPORT, BTA_HH_RPTT_INPUT},
@@ -482,19 +487,22 @@ static const gatt::Descriptor* find_descriptor_by_short_uuid(
  *
  * Function         bta_hh_le_read_char_descriptor
  *
- * Description      read characteristic descriptor
+ * Description      read characteristic descriptor, whose value is |value_len|
+ *                  long, or of unknown length if 0
  *
  ******************************************************************************/
 static tBTA_HH_STATUS bta_hh_le_read_char_descriptor(tBTA_HH_DEV_CB* p_cb,
                                                      uint16_t char_handle,
                                                      uint16_t short_uuid,
                                                      GATT_READ_OP_CB cb,
-                                                     void* cb_data) {
+                                                     void* cb_data,
+                                                     uint16_t value_len) {
   const gatt::Descriptor* p_desc =
       find_descriptor_by_short_uuid(p_cb->conn_id, char_handle, short_uuid);
   if (!p_desc) return BTA_HH_ERR;
 
-  BtaGattQueue::ReadDescriptor(p_cb->conn_id, p_desc->handle, cb, cb_data);
+  BtaGattQueue::ReadDescriptor(p_cb->conn_id, p_desc->handle, cb, cb_data,
+                               value_len);
   return BTA_HH_OK;
 }
 
@@ -1284,7 +1292,7 @@ static void read_hid_info_cb(uint16_t conn_id, tGATT_STATUS status,
     return;
   }
 
-  if (len != 4) {
+  if (len != BTA_HH_LE_HID_INFO_LEN) {
     APPL_TRACE_ERROR("%s: wrong length: %d", __func__, len);
     return;
   }
@@ -1481,7 +1489,8 @@ static void bta_hh_le_search_hid_chars(tBTA_HH_DEV_CB* p_dev_cb,
       case GATT_UUID_HID_INFORMATION:
         /* only one instance per HID service */
         BtaGattQueue::ReadCharacteristic(p_dev_cb->conn_id, charac.value_handle,
-                                         read_hid_info_cb, p_dev_cb);
+                                         read_hid_info_cb, p_dev_cb,
+                                         BTA_HH_LE_HID_INFO_LEN);
         break;
       case GATT_UUID_HID_REPORT_MAP:
         /* only one instance per HID service */
@@ -1490,7 +1499,7 @@ static void bta_hh_le_search_hid_chars(tBTA_HH_DEV_CB* p_dev_cb,
         /* descriptor is optional */
         bta_hh_le_read_char_descriptor(p_dev_cb, charac.value_handle,
                                        GATT_UUID_EXT_RPT_REF_DESCR,
-                                       read_ext_rpt_ref_desc_cb, p_dev_cb);
+                                       read_ext_rpt_ref_desc_cb, p_dev_cb, 0);
         break;
 
       case GATT_UUID_HID_REPORT:
@@ -1506,7 +1515,8 @@ static void bta_hh_le_search_hid_chars(tBTA_HH_DEV_CB* p_dev_cb,
 
         bta_hh_le_read_char_descriptor(p_dev_cb, charac.value_handle,
                                        GATT_UUID_RPT_REF_DESCR,
-                                       read_report_ref_desc_cb, p_dev_cb);
+                                       read_report_ref_desc_cb, p_dev_cb,
+                                       BTA_HH_LE_RPT_REF_LEN);
         break;
 
       /* found boot mode report types */
@@ -1597,7 +1607,8 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
             if (p_rpt)
               bta_hh_le_read_char_descriptor(p_dev_cb, p_char.value_handle,
                            GATT_UUID_CHAR_CLIENT_CONFIG,
-                           read_report_descriptor_ccc_cb, p_rpt);
+                           read_report_descriptor_ccc_cb, p_rpt,
+                           BTA_HH_LE_CCC_LEN);
           }
       }
     } else if (service.uuid == Uuid::From16Bit(UUID_SERVCLASS_SCAN_PARAM)) {
@@ -2366,7 +2377,8 @@ void bta_hh_le_hid_read_rpt_clt_cfg(const RawAddress& bd_addr, uint8_t srvc_inst
           APPL_TRACE_DEBUG("char_inst_id =%d ", p_rpt->char_inst_id);
           bta_hh_le_read_char_descriptor(p_cb, p_rpt->char_inst_id,
                         GATT_UUID_CHAR_CLIENT_CONFIG,
-                       read_report_descriptor_ccc_cb, p_rpt);
+                       read_report_descriptor_ccc_cb, p_rpt,
+                       BTA_HH_LE_CCC_LEN);
           break;
        }
     }
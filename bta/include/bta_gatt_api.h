@@ -536,6 +536,9 @@ extern const gatt::Characteristic* BTA_GATTC_GetOwningCharacteristic(
 extern const gatt::Service* BTA_GATTC_GetOwningService(uint16_t conn_id,
                                                        uint16_t handle);
 
+/* Return the MTU of the connection, GATT_DEF_BLE_MTU_SIZE if it is unknown */
+extern uint16_t BTA_GATTC_GetMtu(uint16_t conn_id);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_GetGattDb
@@ -558,6 +561,14 @@ typedef void (*GATT_READ_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
 typedef void (*GATT_WRITE_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
                                  uint16_t handle, void* data);
 
+/* Write command (write without response) of a batch */
+typedef struct {
+  uint16_t handle;
+  std::vector<uint8_t> value;
+  GATT_WRITE_OP_CB callback;
+  void* cb_data;
+} tBTA_GATTC_WRITE_CMD;
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_ReadCharacteristic
@@ -729,13 +740,36 @@ extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
  *
  * Parameters       conn_id - connectino ID.
  *                    p_read_multi - read multiple parameters.
+ *                    callback - called with the concatenated values and the
+ *                               first handle read.
  *
  * Returns          None
  *
  ******************************************************************************/
 extern void BTA_GATTC_ReadMultiple(uint16_t conn_id,
                                    tBTA_GATTC_MULTI* p_read_multi,
-                                   tGATT_AUTH_REQ auth_req);
+                                   tGATT_AUTH_REQ auth_req,
+                                   GATT_READ_OP_CB callback, void* cb_data);
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharValueCmds
+ *
+ * Description      This function is called to send a batch of write commands
+ *                  (write without response). The commands are sent in order,
+ *                  without waiting for each one to complete, as long as the
+ *                  link is not congested. The callback of each command is
+ *                  called once it is sent.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  cmds - the write commands.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+extern void BTA_GATTC_WriteCharValueCmds(uint16_t conn_id,
+                                         std::vector<tBTA_GATTC_WRITE_CMD> cmds,
+                                         tGATT_AUTH_REQ auth_req);
 
 /*******************************************************************************
  *
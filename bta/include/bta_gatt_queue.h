@@ -31,14 +31,23 @@
  *
  * If you decide to use those methods in your app, make sure to not mix it with
  * existing BTA_GATTC_* API.
+ *
+ * Adjacent write commands (GATT_WRITE_NO_RSP) to characteristics are streamed
+ * in one batch, up to the link congestion, instead of one at a time. Adjacent
+ * reads whose value length is given are coalesced into one Read Multiple
+ * request, as long as the values fit in the MTU; if the response doesn't
+ * match the lengths, the reads are retried one by one.
  */
 class BtaGattQueue {
  public:
   static void Clean(uint16_t conn_id);
+  /* |value_len| is the length of the value if known, 0 otherwise */
   static void ReadCharacteristic(uint16_t conn_id, uint16_t handle,
-                                 GATT_READ_OP_CB cb, void* cb_data);
+                                 GATT_READ_OP_CB cb, void* cb_data,
+                                 uint16_t value_len = 0);
   static void ReadDescriptor(uint16_t conn_id, uint16_t handle,
-                             GATT_READ_OP_CB cb, void* cb_data);
+                             GATT_READ_OP_CB cb, void* cb_data,
+                             uint16_t value_len = 0);
   static void WriteCharacteristic(uint16_t conn_id, uint16_t handle,
                                   std::vector<uint8_t> value,
                                   tGATT_WRITE_TYPE write_type,
@@ -54,6 +63,8 @@ class BtaGattQueue {
     uint16_t handle;
     GATT_READ_OP_CB read_cb;
     void* read_cb_data;
+    /* read-specific field, 0 if the value length is unknown */
+    uint16_t value_len;
     GATT_WRITE_OP_CB write_cb;
     void* write_cb_data;
 
@@ -62,17 +73,38 @@ class BtaGattQueue {
     std::vector<uint8_t> value;
   };
 
+  /* Per connection statistics, logged when the queue is cleaned */
+  struct gatt_queue_stats {
+    uint64_t first_op_us;
+    uint64_t last_op_us;
+    uint32_t ops;
+    uint32_t write_cmds_streamed;
+    uint32_t reads_coalesced;
+  };
+
  private:
   static void mark_as_not_executing(uint16_t conn_id);
   static void gatt_execute_next_op(uint16_t conn_id);
+  static bool gatt_execute_write_cmds(uint16_t conn_id,
+                                      std::list<gatt_operation>& gatt_ops);
+  static bool gatt_execute_read_multi(uint16_t conn_id,
+                                      std::list<gatt_operation>& gatt_ops);
+  static void gatt_op_started(uint16_t conn_id, uint32_t num_ops);
+  static void gatt_op_completed(uint16_t conn_id);
   static void gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                     uint16_t handle, uint16_t len,
                                     uint8_t* value, void* data);
   static void gatt_write_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                      uint16_t handle, void* data);
+  static void gatt_read_multi_op_finished(uint16_t conn_id,
+                                          tGATT_STATUS status, uint16_t handle,
+                                          uint16_t len, uint8_t* value,
+                                          void* data);
 
   // maps connection id to operations waiting for execution
   static std::unordered_map<uint16_t, std::list<gatt_operation>> gatt_op_queue;
   // contain connection ids that currently execute operations
   static std::unordered_set<uint16_t> gatt_op_queue_executing;
+  // maps connection id to its statistics
+  static std::unordered_map<uint16_t, gatt_queue_stats> gatt_op_queue_stats;
 };
\ No newline at end of file
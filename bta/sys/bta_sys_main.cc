@@ -36,6 +36,7 @@
 #include "bta_sys_int.h"
 #include "btm_api.h"
 #include "btu.h"
+#include "common/task_latency.h"
 #include "osi/include/alarm.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
@@ -538,8 +539,13 @@ void bta_sys_sendmsg(void* p_msg) {
     return;
   }
 
+  /* All the messages share this location: track them by event, whose upper
+   * byte is the id of the subsystem handling it */
+  BT_HDR* p_hdr = static_cast<BT_HDR*>(p_msg);
   bta_message_loop->task_runner()->PostTask(
-      FROM_HERE, base::Bind(&bta_sys_event, static_cast<BT_HDR*>(p_msg)));
+      FROM_HERE, bluetooth::common::TrackTaskLatency(
+                     FROM_HERE, "bta", nullptr, p_hdr->event,
+                     base::Bind(&bta_sys_event, p_hdr)));
 }
 
 /*******************************************************************************
@@ -560,7 +566,8 @@ void do_in_bta_thread(const base::Location& from_here,
     return;
   }
 
-  bta_message_loop->task_runner()->PostTask(from_here, task);
+  bta_message_loop->task_runner()->PostTask(
+      from_here, bluetooth::common::TrackTaskLatency(from_here, "bta", task));
 }
 
 /*******************************************************************************
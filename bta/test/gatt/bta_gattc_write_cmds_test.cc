@@ -0,0 +1,201 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "bta/gatt/bta_gattc_int.h"
+#include "osi/include/allocator.h"
+
+namespace {
+
+constexpr uint16_t kConnId = 0x0105;
+
+// GATT client of one connection: like the stack, it holds one operation at a
+// time, and queues a command behind a request waiting for its response.
+struct FakeGatt {
+  bool request_pending = false;
+  bool holds_command = false;
+  uint16_t held_handle = 0;
+  std::vector<uint16_t> sent;
+  // Completions posted to BTA, in order
+  std::deque<tGATT_STATUS> completions;
+
+  void Send(uint16_t handle) {
+    sent.push_back(handle);
+    completions.push_back(GATT_SUCCESS);
+  }
+
+  // The response to the pending request was received
+  void ReceiveResponse() {
+    request_pending = false;
+    if (!holds_command) return;
+    holds_command = false;
+    Send(held_handle);
+  }
+};
+
+FakeGatt* fake_gatt;
+
+}  // namespace
+
+tGATT_STATUS GATTC_Write(uint16_t conn_id, tGATT_WRITE_TYPE type,
+                         tGATT_VALUE* p_write) {
+  EXPECT_EQ(kConnId, conn_id);
+  EXPECT_EQ(GATT_WRITE_NO_RSP, type);
+  if (fake_gatt->holds_command) return GATT_BUSY;
+
+  if (fake_gatt->request_pending) {
+    fake_gatt->holds_command = true;
+    fake_gatt->held_handle = p_write->handle;
+  } else {
+    fake_gatt->Send(p_write->handle);
+  }
+  return GATT_SUCCESS;
+}
+
+bool bta_gattc_enqueue(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
+  p_clcb->p_q_cmd = p_data;
+  return true;
+}
+
+void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
+                            tGATT_STATUS status, tGATT_CL_COMPLETE* p_data) {
+  EXPECT_EQ(kConnId, conn_id);
+  EXPECT_EQ(GATTC_OPTYPE_WRITE, op);
+  fake_gatt->completions.push_back(status);
+}
+
+class BtaGattcWriteCmdsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fake_gatt = &gatt_;
+    memset(&clcb_, 0, sizeof(clcb_));
+    clcb_.bta_conn_id = kConnId;
+  }
+
+  void TearDown() override {
+    osi_free_and_reset((void**)&clcb_.p_q_cmd);
+    fake_gatt = nullptr;
+  }
+
+  static void WriteCallback(uint16_t conn_id, tGATT_STATUS status,
+                            uint16_t handle, void* data) {
+    auto* results = (std::vector<std::pair<uint16_t, tGATT_STATUS>>*)data;
+    results->push_back(std::make_pair(handle, status));
+  }
+
+  // Start a batch of write commands to |handles|. The value written to
+  // |long_handle| is too long.
+  void WriteCmds(const std::vector<uint16_t>& handles,
+                 uint16_t long_handle = 0) {
+    tBTA_GATTC_API_WRITE_CMDS* p_buf = (tBTA_GATTC_API_WRITE_CMDS*)osi_calloc(
+        sizeof(tBTA_GATTC_API_WRITE_CMDS) +
+        handles.size() * sizeof(tBTA_GATTC_WRITE_CMD_ENTRY));
+    p_buf->hdr.event = BTA_GATTC_API_WRITE_CMDS_EVT;
+    p_buf->num_cmds = handles.size();
+    p_buf->p_cmds = (tBTA_GATTC_WRITE_CMD_ENTRY*)(p_buf + 1);
+    for (size_t i = 0; i < handles.size(); i++) {
+      p_buf->p_cmds[i].handle = handles[i];
+      p_buf->p_cmds[i].len =
+          handles[i] == long_handle ? GATT_MAX_ATTR_LEN + 1 : 4;
+      p_buf->p_cmds[i].p_value = value_;
+      p_buf->p_cmds[i].write_cb = WriteCallback;
+      p_buf->p_cmds[i].write_cb_data = &results_;
+    }
+    bta_gattc_write_cmds(&clcb_, (tBTA_GATTC_DATA*)p_buf);
+  }
+
+  // Process the completions posted to BTA, like its message loop would
+  void DispatchCompletions() {
+    while (!gatt_.completions.empty()) {
+      tBTA_GATTC_OP_CMPL op_cmpl;
+      memset(&op_cmpl, 0, sizeof(op_cmpl));
+      op_cmpl.op_code = GATTC_OPTYPE_WRITE;
+      op_cmpl.status = gatt_.completions.front();
+      gatt_.completions.pop_front();
+      ASSERT_NE(nullptr, clcb_.p_q_cmd);
+      bta_gattc_write_cmds_cmpl(&clcb_, &op_cmpl);
+    }
+  }
+
+  FakeGatt gatt_;
+  tBTA_GATTC_CLCB clcb_;
+  uint8_t value_[GATT_MAX_ATTR_LEN + 1] = {};
+  std::vector<std::pair<uint16_t, tGATT_STATUS>> results_;
+};
+
+TEST_F(BtaGattcWriteCmdsTest, test_window) {
+  std::vector<uint16_t> handles;
+  for (uint16_t handle = 1; handle <= 3 * BTA_GATTC_WRITE_CMDS_WINDOW; handle++)
+    handles.push_back(handle);
+  WriteCmds(handles);
+  EXPECT_EQ((size_t)BTA_GATTC_WRITE_CMDS_WINDOW, gatt_.sent.size());
+
+  DispatchCompletions();
+  EXPECT_EQ(handles, gatt_.sent);
+  ASSERT_EQ(handles.size(), results_.size());
+  for (size_t i = 0; i < handles.size(); i++) {
+    EXPECT_EQ(handles[i], results_[i].first);
+    EXPECT_EQ(GATT_SUCCESS, results_[i].second);
+  }
+  EXPECT_EQ(nullptr, clcb_.p_q_cmd);
+}
+
+TEST_F(BtaGattcWriteCmdsTest, test_behind_pre_queued_request) {
+  // GATT queues the first command behind a request of the connection: the
+  // following ones must wait instead of failing as busy
+  gatt_.request_pending = true;
+  WriteCmds({0x10, 0x11, 0x12, 0x13});
+  EXPECT_TRUE(gatt_.sent.empty());
+  EXPECT_TRUE(gatt_.completions.empty());
+
+  gatt_.ReceiveResponse();
+  DispatchCompletions();
+
+  std::vector<uint16_t> expected_sent = {0x10, 0x11, 0x12, 0x13};
+  EXPECT_EQ(expected_sent, gatt_.sent);
+  ASSERT_EQ(4u, results_.size());
+  for (size_t i = 0; i < results_.size(); i++) {
+    EXPECT_EQ(expected_sent[i], results_[i].first);
+    EXPECT_EQ(GATT_SUCCESS, results_[i].second);
+  }
+  EXPECT_EQ(nullptr, clcb_.p_q_cmd);
+}
+
+TEST_F(BtaGattcWriteCmdsTest, test_failure_reported_in_order) {
+  // The invalid command must not be reported before the queued one completes
+  gatt_.request_pending = true;
+  WriteCmds({0x20, 0x21, 0x22}, 0x21);
+  EXPECT_TRUE(gatt_.completions.empty());
+
+  gatt_.ReceiveResponse();
+  DispatchCompletions();
+
+  ASSERT_EQ(3u, results_.size());
+  EXPECT_EQ(0x20, results_[0].first);
+  EXPECT_EQ(GATT_SUCCESS, results_[0].second);
+  EXPECT_EQ(0x21, results_[1].first);
+  EXPECT_EQ(GATT_INVALID_ATTR_LEN, results_[1].second);
+  EXPECT_EQ(0x22, results_[2].first);
+  EXPECT_EQ(GATT_SUCCESS, results_[2].second);
+  EXPECT_EQ(nullptr, clcb_.p_q_cmd);
+}
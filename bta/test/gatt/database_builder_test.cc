@@ -162,4 +162,79 @@ TEST(DatabaseBuilderTest, SecondaryServiceOutOfOrderTest) {
   EXPECT_EQ(result.Services()[4].is_primary, true);
 }
 
+/* This test verifies that wide exploration covers all services with a single
+ * range, and merges descriptor ranges separated only by declarations. */
+TEST(DatabaseBuilderTest, WideExplorationTest) {
+  DatabaseBuilder builder;
+  builder.SetWideExploration(true);
+
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0030, 0x003f, SERVICE_3_UUID, true);
+
+  EXPECT_TRUE(builder.StartNextServiceExploration());
+  EXPECT_EQ(builder.CurrentlyExploredService(), make_pair_u16(0x0001, 0x003f));
+
+  // Secondary service inside the explored range needs no exploration
+  builder.AddIncludedService(0x0031, SERVICE_2_UUID, 0x0020, 0x002f);
+
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0005, 0x0006, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0032, 0x0033, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0036, 0x0037, SERVICE_1_CHAR_1_UUID, 0x02);
+
+  // 0x0004 and 0x0007-0x000f are merged over the declarations in between,
+  // 0x0010-0x0031 holds unknown attributes, so 0x0034 starts a new range
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(),
+            make_pair_u16(0x0004, 0x000f));
+
+  // Declarations returned by Find Information are not descriptors
+  builder.AddDescriptor(0x0004, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_UUID);
+  builder.AddDescriptor(0x0006, SERVICE_1_CHAR_1_UUID);
+
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(),
+            make_pair_u16(0x0034, 0x003f));
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(),
+            make_pair_u16(0xffff, 0xffff));
+
+  EXPECT_FALSE(builder.StartNextServiceExploration());
+
+  Database result = builder.Build();
+  EXPECT_EQ(result.Services()[0].characteristics[0].descriptors.size(), 1u);
+  EXPECT_EQ(result.Services()[0].characteristics[1].descriptors.size(), 0u);
+}
+
+/* This test verifies that wide exploration keeps the includes of a secondary
+ * service that come before the include revealing that service. */
+TEST(DatabaseBuilderTest, WideExplorationNestedIncludeTest) {
+  DatabaseBuilder builder;
+  builder.SetWideExploration(true);
+
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0030, 0x003f, SERVICE_3_UUID, true);
+
+  EXPECT_TRUE(builder.StartNextServiceExploration());
+  EXPECT_EQ(builder.CurrentlyExploredService(), make_pair_u16(0x0001, 0x003f));
+
+  // Includes are returned in handle order: 0x0021 belongs to the secondary
+  // service 0x0020-0x002f, revealed only by the include at 0x0031, and itself
+  // includes the secondary service 0x0010-0x001f
+  builder.AddIncludedService(0x0021, SERVICE_4_UUID, 0x0010, 0x001f);
+  builder.AddIncludedService(0x0031, SERVICE_2_UUID, 0x0020, 0x002f);
+
+  EXPECT_FALSE(builder.StartNextServiceExploration());
+
+  Database result = builder.Build();
+  ASSERT_EQ(result.Services().size(), 4u);
+  EXPECT_EQ(result.Services()[1].handle, 0x0010);
+  EXPECT_EQ(result.Services()[1].uuid, SERVICE_4_UUID);
+  EXPECT_FALSE(result.Services()[1].is_primary);
+  EXPECT_EQ(result.Services()[2].handle, 0x0020);
+  ASSERT_EQ(result.Services()[2].included_services.size(), 1u);
+  EXPECT_EQ(result.Services()[2].included_services[0].handle, 0x0021);
+  EXPECT_EQ(result.Services()[2].included_services[0].start_handle, 0x0010);
+  ASSERT_EQ(result.Services()[3].included_services.size(), 1u);
+  EXPECT_EQ(result.Services()[3].included_services[0].start_handle, 0x0020);
+}
+
 }  // namespace gatt
\ No newline at end of file
@@ -84,6 +84,37 @@ TEST(GattDatabaseTest, serialize_deserialize_binary_test) {
   EXPECT_EQ(serialized[4].type, SERVICE_1_CHAR_1_DESC_1_UUID);
 }
 
+/* This test makes sure that a database can be rebuilt from a flat attribute
+ * buffer, as done when loading a memory mapped GATT cache file */
+TEST(GattDatabaseTest, deserialize_from_buffer_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, false);
+  builder.AddIncludedService(0x0002, SERVICE_2_UUID, 0x0010, 0x001f);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+  std::vector<StoredAttribute> serialized = db.Serialize();
+
+  std::vector<uint8_t> buffer(serialized.size() * sizeof(StoredAttribute));
+  memcpy(buffer.data(), serialized.data(), buffer.size());
+
+  bool success = false;
+  Database result = Database::Deserialize(
+      reinterpret_cast<const StoredAttribute*>(buffer.data()),
+      serialized.size(), &success);
+
+  EXPECT_TRUE(success);
+  EXPECT_EQ(result.ToString(), db.ToString());
+
+  // a truncated buffer must still be parsed up to its end only
+  result = Database::Deserialize(
+      reinterpret_cast<const StoredAttribute*>(buffer.data()), 2, &success);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(result.Services().size(), 2u);
+}
+
 /* This test makes sure that Service represented in StoredAttribute have proper
  * binary format. */
 TEST(GattCacheTest, stored_attribute_to_binary_service_test) {
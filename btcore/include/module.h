@@ -50,6 +50,8 @@ bool module_init(const module_t* module);
 // Start up the provided module. |module| may not be NULL
 // and must be initialized or have no init function.
 bool module_start_up(const module_t* module);
+// Returns true if |module| is started up.
+bool module_is_started(const module_t* module);
 // Shut down the provided module. |module| may not be NULL.
 // If not started, does nothing.
 void module_shut_down(const module_t* module);
@@ -57,6 +59,20 @@ void module_shut_down(const module_t* module);
 // If not initialized, does nothing.
 void module_clean_up(const module_t* module);
 
+// Initialize |modules|, a NULL terminated array, in parallel on a pool of
+// worker threads. Each module is initialized once the modules it depends on
+// among |modules| are; the other dependencies must be initialized already.
+// The modules that depend on a module that failed are not initialized.
+// Returns true if all the modules were initialized.
+bool module_init_parallel(const module_t* const* modules);
+// Start up |modules|, a NULL terminated array, in parallel with the same
+// dependency rules as |module_init_parallel|. Returns true if all the
+// modules were started up.
+bool module_start_up_parallel(const module_t* const* modules);
+
+// Dump the init and start up timeline of the modules to |fd|.
+void module_debug_dump(int fd);
+
 // Temporary callbacked wrapper for module start up, so real modules can be
 // spliced into the current janky startup sequence. Runs on a separate thread,
 // which terminates when the module start up has finished. When module startup
@@ -20,15 +20,22 @@
 
 #include <base/logging.h>
 #include <dlfcn.h>
+#include <stdio.h>
 #include <string.h>
 
+#include <condition_variable>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+// Maximum number of worker threads running lifecycle functions in parallel
+#define MODULE_PARALLEL_MAX_THREADS 4
 
 typedef enum {
   MODULE_STATE_NONE = 0,
@@ -41,14 +48,28 @@ typedef enum {
 
 static std::unordered_map<const module_t*, module_state_t> metadata;
 
+// Timeline of the last init and start up of each module, for the debug dump
+typedef struct {
+  uint64_t init_begin_us;
+  uint64_t init_end_us;
+  uint64_t start_up_begin_us;
+  uint64_t start_up_end_us;
+} module_timeline_t;
+
+static std::unordered_map<const module_t*, module_timeline_t> timeline;
+
 // TODO(jamuraa): remove this lock after the startup sequence is clean
 static std::mutex metadata_mutex;
 
 static bool call_lifecycle_function(module_lifecycle_fn function);
 static module_state_t get_module_state(const module_t* module);
 static void set_module_state(const module_t* module, module_state_t state);
+static module_timeline_t* get_module_timeline(const module_t* module);
 
-void module_management_start(void) {}
+void module_management_start(void) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  timeline.clear();
+}
 
 void module_management_stop(void) {
   metadata.clear();
@@ -64,7 +85,15 @@ bool module_init(const module_t* module) {
   CHECK(module != NULL);
   CHECK(get_module_state(module) == MODULE_STATE_NONE);
 
-  if (!call_lifecycle_function(module->init)) {
+  uint64_t begin_us = time_get_os_boottime_us();
+  bool success = call_lifecycle_function(module->init);
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    module_timeline_t* module_timeline = get_module_timeline(module);
+    module_timeline->init_begin_us = begin_us;
+    module_timeline->init_end_us = time_get_os_boottime_us();
+  }
+  if (!success) {
     LOG_ERROR(LOG_TAG, "%s Failed to initialize module \"%s\"", __func__,
               module->name);
     return false;
@@ -86,7 +115,15 @@ bool module_start_up(const module_t* module) {
 
   LOG_INFO(LOG_TAG, "%s Starting module \"%s\"", __func__, module->name);
   set_module_state(module, MODULE_STATE_STARTING);
-  if (!call_lifecycle_function(module->start_up)) {
+  uint64_t begin_us = time_get_os_boottime_us();
+  bool success = call_lifecycle_function(module->start_up);
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    module_timeline_t* module_timeline = get_module_timeline(module);
+    module_timeline->start_up_begin_us = begin_us;
+    module_timeline->start_up_end_us = time_get_os_boottime_us();
+  }
+  if (!success) {
     LOG_ERROR(LOG_TAG, "%s Failed to start up module \"%s\"", __func__,
               module->name);
     set_module_state(module, MODULE_STATE_STARTUP_ERROR);
@@ -98,6 +135,10 @@ bool module_start_up(const module_t* module) {
   return true;
 }
 
+bool module_is_started(const module_t* module) {
+  return get_module_state(module) == MODULE_STATE_STARTED;
+}
+
 void module_shut_down(const module_t* module) {
   CHECK(module != NULL);
   module_state_t state = get_module_state(module);
@@ -164,6 +205,185 @@ static void set_module_state(const module_t* module, module_state_t state) {
   metadata[module] = state;
 }
 
+// Must be called with |metadata_mutex| held
+static module_timeline_t* get_module_timeline(const module_t* module) {
+  auto map_ptr = timeline.find(module);
+  if (map_ptr == timeline.end())
+    map_ptr = timeline.emplace(module, module_timeline_t{0, 0, 0, 0}).first;
+  return &map_ptr->second;
+}
+
+// Parallel lifecycle scheduler
+
+typedef bool (*module_step_fn)(const module_t* module);
+
+struct parallel_run_t;
+
+typedef struct {
+  const module_t* module;
+  struct parallel_run_t* run;
+  thread_t* thread;  // worker running the module, once launched
+  bool launched;
+  bool done;
+  bool success;
+} parallel_entry_t;
+
+typedef struct parallel_run_t {
+  module_step_fn step;
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  std::vector<parallel_entry_t> entries;
+  std::vector<thread_t*> idle_threads;
+} parallel_run_t;
+
+static void run_parallel_entry(void* context) {
+  parallel_entry_t* entry = (parallel_entry_t*)context;
+  parallel_run_t* run = entry->run;
+  bool success = run->step(entry->module);
+
+  std::lock_guard<std::mutex> lock(run->mutex);
+  entry->success = success;
+  entry->done = true;
+  run->idle_threads.push_back(entry->thread);
+  run->done_cv.notify_one();
+}
+
+// Returns the entry of the module named |name| in |run|, or NULL
+static parallel_entry_t* find_parallel_entry(parallel_run_t* run,
+                                             const char* name) {
+  for (parallel_entry_t& entry : run->entries) {
+    if (!strcmp(entry.module->name, name)) return &entry;
+  }
+  return NULL;
+}
+
+static bool run_parallel(const module_t* const* modules, module_step_fn step) {
+  CHECK(modules != NULL);
+
+  parallel_run_t run;
+  run.step = step;
+  for (const module_t* const* module = modules; *module != NULL; module++) {
+    run.entries.push_back(
+        parallel_entry_t{*module, &run, NULL, false, false, false});
+  }
+  if (run.entries.empty()) return true;
+
+  std::vector<thread_t*> threads;
+  size_t threads_n = run.entries.size() < MODULE_PARALLEL_MAX_THREADS
+                         ? run.entries.size()
+                         : MODULE_PARALLEL_MAX_THREADS;
+  for (size_t i = 0; i < threads_n; i++) {
+    thread_t* thread = thread_new("module_worker");
+    CHECK(thread != NULL);
+    threads.push_back(thread);
+    run.idle_threads.push_back(thread);
+  }
+
+  bool success = true;
+  std::unique_lock<std::mutex> lock(run.mutex);
+  while (true) {
+    bool waiting = false;
+    bool running = false;
+    bool skipped = false;
+    for (parallel_entry_t& entry : run.entries) {
+      if (entry.launched) {
+        if (!entry.done) running = true;
+        continue;
+      }
+
+      // Only the dependencies in |modules| are waited for
+      bool ready = true;
+      bool failed = false;
+      for (const char* const* name = entry.module->dependencies; *name != NULL;
+           name++) {
+        parallel_entry_t* dependency = find_parallel_entry(&run, *name);
+        if (dependency == NULL) continue;
+        if (!dependency->done) ready = false;
+        if (dependency->done && !dependency->success) failed = true;
+      }
+
+      if (failed) {
+        LOG_ERROR(LOG_TAG, "%s Not running module \"%s\": dependency failed",
+                  __func__, entry.module->name);
+        entry.launched = true;
+        entry.done = true;
+        skipped = true;
+      } else if (ready && !run.idle_threads.empty()) {
+        entry.launched = true;
+        entry.thread = run.idle_threads.back();
+        run.idle_threads.pop_back();
+        thread_post(entry.thread, run_parallel_entry, &entry);
+        running = true;
+      } else {
+        waiting = true;
+      }
+    }
+
+    // A skipped module fails the modules depending on it, which may have been
+    // looked at earlier in this pass: look again before waiting
+    if (skipped) continue;
+
+    if (!running) {
+      // Nothing left to wait for: either all done, or a dependency cycle
+      if (waiting)
+        LOG(FATAL) << __func__ << ": module dependency cycle";
+      break;
+    }
+    run.done_cv.wait(lock);
+  }
+  lock.unlock();
+
+  for (thread_t* thread : threads) thread_free(thread);
+
+  for (const parallel_entry_t& entry : run.entries) {
+    if (!entry.success) success = false;
+  }
+  return success;
+}
+
+bool module_init_parallel(const module_t* const* modules) {
+  return run_parallel(modules, module_init);
+}
+
+bool module_start_up_parallel(const module_t* const* modules) {
+  return run_parallel(modules, module_start_up);
+}
+
+void module_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  uint64_t init_origin_us = UINT64_MAX;
+  uint64_t start_up_origin_us = UINT64_MAX;
+  for (const auto& entry : timeline) {
+    const module_timeline_t& t = entry.second;
+    if (t.init_end_us != 0 && t.init_begin_us < init_origin_us)
+      init_origin_us = t.init_begin_us;
+    if (t.start_up_end_us != 0 && t.start_up_begin_us < start_up_origin_us)
+      start_up_origin_us = t.start_up_begin_us;
+  }
+
+  dprintf(fd, "\nModule timeline (us, from the first init / start up):\n");
+  dprintf(fd, "  %-28s %10s %10s %10s %10s\n", "Module", "Init at", "Took",
+          "Start at", "Took");
+  for (const auto& entry : timeline) {
+    const module_timeline_t& t = entry.second;
+    dprintf(fd, "  %-28s", entry.first->name);
+    if (t.init_end_us != 0) {
+      dprintf(fd, " %10llu %10llu",
+              (unsigned long long)(t.init_begin_us - init_origin_us),
+              (unsigned long long)(t.init_end_us - t.init_begin_us));
+    } else {
+      dprintf(fd, " %10s %10s", "-", "-");
+    }
+    if (t.start_up_end_us != 0) {
+      dprintf(fd, " %10llu %10llu\n",
+              (unsigned long long)(t.start_up_begin_us - start_up_origin_us),
+              (unsigned long long)(t.start_up_end_us - t.start_up_begin_us));
+    } else {
+      dprintf(fd, " %10s %10s\n", "-", "-");
+    }
+  }
+}
+
 // TODO(zachoverflow): remove when everything modulized
 // Temporary callback-wrapper-related code
 
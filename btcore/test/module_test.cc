@@ -0,0 +1,145 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "btcore/include/module.h"
+
+namespace {
+
+std::mutex order_mutex;
+std::string order;
+std::atomic<int> running;
+std::atomic<int> max_running;
+
+void record(char c) {
+  std::lock_guard<std::mutex> lock(order_mutex);
+  order += c;
+}
+
+// Runs for a while, so independent modules overlap
+future_t* run(char c) {
+  int now = ++running;
+  int max = max_running;
+  while (now > max && !max_running.compare_exchange_weak(max, now)) {
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  record(c);
+  running--;
+  return NULL;
+}
+
+future_t* init_a() { return run('a'); }
+future_t* init_b() { return run('b'); }
+future_t* init_c() { return run('c'); }
+future_t* init_d() { return run('d'); }
+future_t* init_fail() { return future_new_immediate(FUTURE_FAIL); }
+
+const module_t module_a = {.name = "module_a",
+                           .init = init_a,
+                           .start_up = init_a,
+                           .dependencies = {NULL}};
+const module_t module_b = {.name = "module_b",
+                           .init = init_b,
+                           .start_up = init_b,
+                           .dependencies = {NULL}};
+// c depends on a and b, d on c and on a module not in the run
+const module_t module_c = {.name = "module_c",
+                           .init = init_c,
+                           .start_up = init_c,
+                           .dependencies = {"module_a", "module_b", NULL}};
+const module_t module_d = {.name = "module_d",
+                           .init = init_d,
+                           .dependencies = {"module_c", "other", NULL}};
+const module_t module_fail = {.name = "module_fail",
+                              .init = init_fail,
+                              .dependencies = {NULL}};
+const module_t module_after_fail = {.name = "module_after_fail",
+                                    .init = init_a,
+                                    .dependencies = {"module_fail", NULL}};
+const module_t module_after_after_fail = {
+    .name = "module_after_after_fail",
+    .init = init_b,
+    .dependencies = {"module_after_fail", NULL}};
+
+}  // namespace
+
+class ModuleTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    module_management_start();
+    order.clear();
+    running = 0;
+    max_running = 0;
+  }
+
+  void TearDown() override { module_management_stop(); }
+};
+
+TEST_F(ModuleTest, test_init_parallel_respects_dependencies) {
+  const module_t* modules[] = {&module_d, &module_c, &module_b, &module_a,
+                               NULL};
+  EXPECT_TRUE(module_init_parallel(modules));
+
+  ASSERT_EQ(4u, order.size());
+  EXPECT_EQ(std::string("cd"), order.substr(2));
+  // a and b are independent and ran at the same time
+  EXPECT_EQ(2, max_running);
+}
+
+TEST_F(ModuleTest, test_start_up_parallel) {
+  const module_t* modules[] = {&module_a, &module_b, &module_c, NULL};
+  EXPECT_TRUE(module_init_parallel(modules));
+  order.clear();
+  max_running = 0;
+
+  EXPECT_TRUE(module_start_up_parallel(modules));
+  ASSERT_EQ(3u, order.size());
+  EXPECT_EQ('c', order[2]);
+  EXPECT_EQ(2, max_running);
+
+  for (const module_t** module = modules; *module != NULL; module++)
+    module_shut_down(*module);
+}
+
+TEST_F(ModuleTest, test_failure_skips_dependents) {
+  const module_t* modules[] = {&module_after_fail, &module_fail, &module_b,
+                               NULL};
+  EXPECT_FALSE(module_init_parallel(modules));
+  // Only the independent module ran
+  EXPECT_EQ(std::string("b"), order);
+}
+
+TEST_F(ModuleTest, test_failure_skips_dependents_transitively) {
+  // Dependents listed before their dependency are skipped in a later pass
+  const module_t* modules[] = {&module_after_after_fail, &module_after_fail,
+                               &module_fail, NULL};
+  EXPECT_FALSE(module_init_parallel(modules));
+  EXPECT_EQ(std::string(), order);
+}
+
+TEST_F(ModuleTest, test_empty) {
+  const module_t* modules[] = {NULL};
+  EXPECT_TRUE(module_init_parallel(modules));
+}
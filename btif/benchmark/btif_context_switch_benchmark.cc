@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of the context switches into the btif thread.
+//
+// Each iteration does what btif_transfer_context() does for one event: it
+// takes an envelope for the context switch header and a copy of the event
+// parameters, and posts it to a worker thread, which runs the event
+// callback and frees the envelope. The envelopes come either from the heap
+// or from the btif message pool; the worker thread queue is bounded, so the
+// rate is the number of events per second that get through the thread.
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include "btif/include/btif_common.h"
+#include "btif/include/btif_msg_pool.h"
+#include "osi/include/allocator.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/thread.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+namespace {
+
+typedef void* (*envelope_alloc_t)(size_t size);
+typedef void (*envelope_free_t)(void* ptr);
+
+thread_t* worker_thread;
+semaphore_t* drained;
+envelope_free_t envelope_free;
+uint64_t events_handled;
+
+void event_callback(uint16_t event, char* p_param) {
+  events_handled += event + (p_param ? p_param[0] : 0);
+}
+
+void run_event(void* context) {
+  tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)context;
+  p_msg->p_cb(p_msg->event, p_msg->len ? p_msg->p_param : NULL);
+  envelope_free(p_msg);
+}
+
+void signal_drained(void* /* context */) { semaphore_post(drained); }
+
+void bm_context_switch(State& state, envelope_alloc_t alloc,
+                       envelope_free_t free_fn) {
+  size_t param_len = (size_t)state.range(0);
+  char params[4096];
+  memset(params, 1, sizeof(params));
+
+  worker_thread = thread_new("bm_btif_worker");
+  drained = semaphore_new(0);
+  envelope_free = free_fn;
+  events_handled = 0;
+
+  for (auto _ : state) {
+    tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)alloc(
+        sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len + 1);
+    p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT;
+    p_msg->p_cb = event_callback;
+    p_msg->event = 1;
+    memcpy(p_msg->p_param, params, param_len);
+    p_msg->len = param_len;
+    thread_post(worker_thread, run_event, p_msg);
+  }
+
+  thread_post(worker_thread, signal_drained, NULL);
+  semaphore_wait(drained);
+  thread_free(worker_thread);
+  semaphore_free(drained);
+  btif_msg_pool_flush();
+
+  state.counters["events"] = Counter(state.iterations(), Counter::kIsRate);
+}
+
+}  // namespace
+
+// Argument: event parameter length
+static void BM_ContextSwitchHeap(State& state) {
+  bm_context_switch(state, osi_malloc, osi_free);
+}
+BENCHMARK(BM_ContextSwitchHeap)->Arg(16)->Arg(300)->Arg(1500)->UseRealTime();
+
+static void BM_ContextSwitchPool(State& state) {
+  bm_context_switch(state, btif_msg_pool_alloc, btif_msg_pool_free);
+}
+BENCHMARK(BM_ContextSwitchPool)->Arg(16)->Arg(300)->Arg(1500)->UseRealTime();
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_A2DP_SINK_JITTER_H
+#define BTIF_A2DP_SINK_JITTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Adaptive jitter buffer control for the A2DP Sink.
+//
+// The A2DP Sink module keeps the received media packets in its queue; this
+// module decides how deep that queue should be and how to keep it there:
+//  - The RTP timestamps and arrival times of the media packets give the
+//    network jitter (RFC 3550) and the late packets, which set the target
+//    depth of the queue.
+//  - The difference between the queue depth and its target is turned into
+//    a small playout rate correction, applied on the decoded PCM by
+//    dropping or inserting one interpolated sample frame at a time. This
+//    absorbs the clock drift between the source and the audio track.
+//
+
+// Limits of the target depth, in milliseconds
+#define BTIF_A2DP_SINK_JITTER_MIN_TARGET_MS 60
+#define BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS 300
+
+// Largest playout rate correction, in parts per million
+#define BTIF_A2DP_SINK_JITTER_MAX_CORRECTION_PPM 2000
+
+typedef struct {
+  uint32_t sample_rate; /* RTP clock rate */
+  uint32_t tick_ms;     /* decoding period */
+
+  // Playout
+  bool anchored;            /* a packet was received since the last reset */
+  uint32_t last_rtp_ts;     /* RTP timestamp of the last packet */
+  int64_t media_samples;    /* unwrapped media time of the last packet */
+  int64_t last_transit_us;  /* arrival time minus media time, last packet */
+  int64_t base_transit_us;  /* shortest recent transit time */
+  uint32_t jitter_x16_us;   /* interarrival jitter, scaled by 16 */
+  uint32_t target_ms;       /* target queue depth */
+  uint32_t max_target_ms;   /* highest target the queue can hold */
+  uint32_t decay_ticks;     /* ticks since the target was last lowered */
+  uint32_t avg_depth_x8_ms; /* smoothed queue depth, scaled by 8 */
+  bool prebuffering;        /* waiting for the target depth to be reached */
+
+  // Drift compensation
+  int32_t correction_ppm; /* > 0 plays faster, < 0 plays slower */
+  int64_t correction_acc; /* pending correction, in samples * 1e6 */
+
+  // Statistics
+  uint32_t depth_ms;
+  uint32_t max_depth_ms;
+  uint32_t packets;
+  uint32_t late_packets;
+  uint32_t concealment_events;
+  uint32_t samples_inserted;
+  uint32_t samples_dropped;
+} tBTIF_A2DP_SINK_JITTER;
+
+// Initialize |jb| for a stream with RTP clock |sample_rate| that is decoded
+// every |tick_ms| milliseconds. Clears the statistics.
+void btif_a2dp_sink_jitter_init(tBTIF_A2DP_SINK_JITTER* jb,
+                                uint32_t sample_rate, uint32_t tick_ms);
+
+// Restart the playout after the queue was flushed. The target depth and the
+// statistics are kept.
+void btif_a2dp_sink_jitter_reset(tBTIF_A2DP_SINK_JITTER* jb);
+
+// Account for a media packet with RTP timestamp |rtp_ts| that was received
+// at |arrival_us|. Returns true if the packet arrived later than the current
+// target depth can absorb; the target is raised in that case.
+bool btif_a2dp_sink_jitter_on_packet(tBTIF_A2DP_SINK_JITTER* jb,
+                                     uint32_t rtp_ts, uint64_t arrival_us);
+
+// Limit the target depth to what the queue can hold: |capacity_ms| is the
+// duration of a full queue. One tick of room is kept for the packets received
+// while the queue sits at its target.
+void btif_a2dp_sink_jitter_set_capacity(tBTIF_A2DP_SINK_JITTER* jb,
+                                        uint32_t capacity_ms);
+
+// Update the controller with the queue depth |depth_ms| at a decoding tick
+// and return the number of frames to decode in this tick, based on the
+// nominal |frames_per_tick|. Returns 0 while prebuffering.
+int btif_a2dp_sink_jitter_on_tick(tBTIF_A2DP_SINK_JITTER* jb,
+                                  uint32_t depth_ms, int frames_per_tick);
+
+// Report that the queue ran dry during a tick. Playout resumes once the
+// target depth is reached again.
+void btif_a2dp_sink_jitter_on_underrun(tBTIF_A2DP_SINK_JITTER* jb);
+
+// Apply the playout rate correction on |frames| interleaved 16-bit sample
+// frames of |channels| channels in |pcm|. |pcm| must have room for one more
+// sample frame. Returns the new number of sample frames.
+size_t btif_a2dp_sink_jitter_compensate(tBTIF_A2DP_SINK_JITTER* jb,
+                                        int16_t* pcm, size_t frames,
+                                        uint8_t channels);
+
+#endif /* BTIF_A2DP_SINK_JITTER_H */
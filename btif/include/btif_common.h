@@ -28,6 +28,7 @@
 
 #include "bt_types.h"
 #include "bta_api.h"
+#include "btcore/include/module.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 
@@ -210,7 +211,7 @@ void btif_remote_properties_evt(bt_status_t status, RawAddress* remote_addr,
 
 void bte_load_did_conf(const char* p_path);
 void bte_main_boot_entry(void);
-void bte_main_enable(void);
+void bte_main_enable(const module_t* const* modules);
 void bte_main_disable(void);
 void bte_main_hci_close(void);
 void bte_main_cleanup(void);
@@ -34,6 +34,7 @@
 #define PNP_VENDOR_ID_CONFIG_KEY "VendorID"
 #define PNP_PRODUCT_ID_CONFIG_KEY "ProductID"
 #define PNP_PRODUCT_VERSION_CONFIG_KEY "ProductVersion"
+#define SDP_CACHE_CONFIG_KEY "SdpCache"
 
 static const char BTIF_CONFIG_MODULE[] = "btif_config_module";
 
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_MSG_POOL_H
+#define BTIF_MSG_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Pool of the message envelopes that carry events into the btif thread.
+//
+// Every btif_transfer_context() call needs a buffer for the context switch
+// header and a copy of the event parameters; the buffer is freed on the btif
+// thread once the event is handled. The pool keeps the freed buffers in a
+// few size classes and hands them out again, so a steady stream of events
+// doesn't go through the heap. Requests larger than the biggest class, or
+// made while a class has no free buffer, fall back to osi_malloc(); buffers
+// are returned to the heap when their class already caches enough of them.
+//
+
+// Buffer sizes of the size classes, in bytes
+#define BTIF_MSG_POOL_CLASS_SIZES \
+  { 128, 512, 2048 }
+#define BTIF_MSG_POOL_NUM_CLASSES 3
+
+typedef struct {
+  size_t size;           /* buffer size of the class, 0 for the heap */
+  uint64_t hits;         /* allocations served from the free buffers */
+  uint64_t misses;       /* allocations that grew the class */
+  uint64_t releases;     /* frees returned to the heap, class full */
+  uint32_t in_use;       /* buffers handed out and not freed yet */
+  uint32_t max_in_use;   /* largest |in_use| */
+  uint32_t free_buffers; /* buffers cached for reuse */
+} tBTIF_MSG_POOL_STATS;
+
+// Allocate a buffer of at least |size| bytes. The buffer must be freed with
+// btif_msg_pool_free(). Like osi_malloc(), never returns NULL and doesn't
+// clear the buffer.
+void* btif_msg_pool_alloc(size_t size);
+
+// Free |ptr|, allocated by btif_msg_pool_alloc(). |ptr| may be NULL.
+void btif_msg_pool_free(void* ptr);
+
+// Return the buffers cached by the pool to the heap.
+void btif_msg_pool_flush(void);
+
+// Copy the statistics of the size class |class_index| to |stats|; the class
+// after the last pooled one holds the allocations made on the heap.
+void btif_msg_pool_get_stats(size_t class_index, tBTIF_MSG_POOL_STATS* stats);
+
+// Dump the pool statistics to the file descriptor |fd|.
+void btif_msg_pool_debug_dump(int fd);
+
+#endif  // BTIF_MSG_POOL_H
@@ -201,6 +201,16 @@ bt_status_t btif_storage_is_device_bonded(RawAddress *remote_bd_addr);
  ******************************************************************************/
 bt_status_t btif_storage_load_bonded_devices(void);
 
+/*******************************************************************************
+ *
+ * Function         btif_storage_debug_dump
+ *
+ * Description      BTIF storage API - Dumps the timing of the last bonded
+ *                  devices load to the file descriptor |fd|
+ *
+ ******************************************************************************/
+void btif_storage_debug_dump(int fd);
+
 /*******************************************************************************
  *
  * Function         btif_storage_add_hid_device_info
@@ -56,6 +56,7 @@
 #include "bt_utils.h"
 #include "bta/include/bta_hearing_aid_api.h"
 #include "bta/include/bta_hf_client_api.h"
+#include "btcore/include/module.h"
 #include "btif/include/btif_debug_btsnoop.h"
 #include "btif/include/btif_debug_conn.h"
 #include "btif_a2dp.h"
@@ -63,6 +64,7 @@
 #include "btif_api.h"
 #include "btif_bqr.h"
 #include "btif_config.h"
+#include "btif_msg_pool.h"
 #include "device/include/controller.h"
 #include "btif_debug.h"
 #include "btif_storage.h"
@@ -70,14 +72,17 @@
 #include "btsnoop.h"
 #include "btsnoop_mem.h"
 #include "common/address_obfuscator.h"
+#include "common/task_latency.h"
 #include "device/include/interop.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/trace.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
+#include "stack/include/sdp_api.h"
 #include "stack_manager.h"
 
 
@@ -340,20 +345,31 @@ static void dump(int fd, const char** arguments) {
                                                                         true);
       return;
     }
+    if (strncmp(arguments[0], "--trace", 7) == 0) {
+      osi_trace_dump_json(fd);
+      return;
+    }
   }
   btif_debug_conn_dump(fd);
   btif_debug_bond_event_dump(fd);
   btif_debug_a2dp_dump(fd);
   btif_debug_config_dump(fd);
+  btif_storage_debug_dump(fd);
+  btif_msg_pool_debug_dump(fd);
+  controller_debug_dump(fd);
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
   device_debug_iot_config_dump(fd);
 #endif
   BTA_HfClientDumpStatistics(fd);
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
+  module_debug_dump(fd);
+  bluetooth::common::TaskLatencyDebugDump(fd);
+  osi_trace_debug_dump(fd);
   alarm_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
+  SDP_CacheDump(fd);
   bluetooth::bqr::DebugDump(fd);
 #if (BTSNOOP_MEM == TRUE)
   btif_debug_btsnoop_dump(fd);
@@ -41,6 +41,7 @@
 #include "btif_hf.h"
 #include "osi/include/osi.h"
 #include "uipc.h"
+#include "uipc_audio_ring.h"
 #include "btif_a2dp_audio_interface.h"
 
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
@@ -51,6 +52,10 @@
 #endif
 
 #define A2DP_DATA_READ_POLL_MS 10
+
+/* Offer the audio HAL a shared memory ring instead of the audio socket */
+#define A2DP_AUDIO_RING_PROPERTY "persist.bluetooth.a2dp.audio_ring"
+
 #define A2DP_NUM_STRS 5
 
 struct {
@@ -69,6 +74,7 @@ extern bool btif_av_is_state_opened(int i);
 static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_snd_ctrl_cmd(tA2DP_CTRL_CMD cmd);
+static void btif_a2dp_recv_open_audio_ring(bool hal_imp);
 
 /* We can have max one command pending */
 static tA2DP_CTRL_CMD a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
@@ -282,6 +288,10 @@ static void btif_a2dp_recv_ctrl_data(void) {
         UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &local_ack, sizeof(local_ack));
         break;
 
+      case A2DP_CTRL_CMD_OPEN_AUDIO_RING:
+        btif_a2dp_recv_open_audio_ring(true);
+        break;
+
       case A2DP_CTRL_GET_PRESENTATION_POSITION: {
         local_ack = A2DP_CTRL_ACK_SUCCESS;
         UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &local_ack, sizeof(local_ack));
@@ -638,6 +648,10 @@ static void btif_a2dp_recv_ctrl_data(void) {
         btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
         break;
 
+      case A2DP_CTRL_CMD_OPEN_AUDIO_RING:
+        btif_a2dp_recv_open_audio_ring(false);
+        break;
+
       case A2DP_CTRL_GET_PRESENTATION_POSITION: {
         btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
         int idx = btif_av_get_current_playing_dev_idx();
@@ -667,6 +681,38 @@ static void btif_a2dp_recv_ctrl_data(void) {
   }
 }
 
+/* Create a shared memory ring for the audio channel and pass it to the audio
+ * HAL; the HAL keeps writing to the audio socket if this fails */
+static void btif_a2dp_recv_open_audio_ring(bool hal_imp) {
+  char value[PROPERTY_VALUE_MAX] = {0};
+  tUIPC_AUDIO_RING* ring = NULL;
+
+  property_get(A2DP_AUDIO_RING_PROPERTY, value, "false");
+  if (!strcmp(value, "true"))
+    ring = uipc_audio_ring_create(AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+
+  uint8_t ack = ring ? A2DP_CTRL_ACK_SUCCESS : A2DP_CTRL_ACK_UNSUPPORTED;
+  if (hal_imp)
+    UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
+  else
+    btif_a2dp_command_ack(static_cast<tA2DP_CTRL_ACK>(ack));
+
+  if (!ring) return;
+
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  if (!UIPC_SendFd(UIPC_CH_ID_AV_CTRL, uipc_audio_ring_fd(ring),
+                   reinterpret_cast<const uint8_t*>(&stats.size),
+                   sizeof(stats.size))) {
+    APPL_TRACE_ERROR("%s: failed to pass audio ring to HAL", __func__);
+    uipc_audio_ring_free(ring);
+    return;
+  }
+
+  APPL_TRACE_IMP("%s: audio ring of %u bytes attached", __func__, stats.size);
+  UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_SET_AUDIO_RING, ring);
+}
+
 void btif_a2dp_snd_ctrl_cmd(tA2DP_CTRL_CMD cmd) {
   int rs_idx, cur_idx;
 
@@ -25,9 +25,12 @@
 
 #include <string.h>
 
+#include <atomic>
+
 #include "bt_common.h"
 #include "btif_a2dp.h"
 #include "btif_a2dp_sink.h"
+#include "btif_a2dp_sink_jitter.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_avrcp_audio_track.h"
@@ -36,6 +39,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/thread.h"
+#include "osi/include/time.h"
 
 #include "oi_codec_sbc.h"
 #include "oi_status.h"
@@ -89,6 +93,8 @@ typedef struct {
   uint16_t offset;
   uint16_t layer_specific;
   uint64_t enque_ns;
+  uint32_t rtp_ts;     /* RTP timestamp of the media packet */
+  uint64_t arrival_us; /* time the media packet was queued */
 } tBT_SBC_HDR;
 
 extern uint64_t btif_update_reported_delay(uint64_t inst_delay);
@@ -107,17 +113,27 @@ typedef struct {
   btif_a2dp_sink_focus_state_t rx_focus_state; /* audio focus state */
   void* audio_track;
   uint32_t latency; /* latency of rendering Audio samples at MMAudio */
+  tBTIF_A2DP_SINK_JITTER jitter; /* owned by the worker thread */
+  uint32_t rx_overflow_drops;    /* packets dropped because of a full queue */
 } tBTIF_A2DP_SINK_CB;
 
 static tBTIF_A2DP_SINK_CB btif_a2dp_sink_cb;
 
+/* Number of frames in rx_audio_queue; updated by both the receiving and the
+ * worker thread */
+static std::atomic_int btif_a2dp_sink_rx_frames{0};
+
 static int btif_a2dp_sink_state = BTIF_A2DP_SINK_STATE_OFF;
 
 static OI_CODEC_SBC_DECODER_CONTEXT btif_a2dp_sink_context;
 static uint32_t btif_a2dp_sink_context_data[CODEC_DATA_WORDS(
     2, SBC_CODEC_FAST_FILTER_BUFFERS)];
+/* Decoded samples per media packet, plus one sample frame of room for the
+ * drift compensation */
+#define BTIF_A2DP_SINK_PCM_SAMPLES \
+  (15 * SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS)
 static int16_t
-    btif_a2dp_sink_pcm_data[15 * SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS];
+    btif_a2dp_sink_pcm_data[BTIF_A2DP_SINK_PCM_SAMPLES + SBC_MAX_CHANNELS];
 
 static void btif_a2dp_sink_startup_delayed(void* context);
 static void btif_a2dp_sink_shutdown_delayed(void* context);
@@ -136,6 +152,8 @@ static void btif_a2dp_sink_set_focus_state_event(
     btif_a2dp_sink_focus_state_t state);
 static void btif_a2dp_sink_audio_rx_flush_event(void);
 static void btif_a2dp_sink_clear_track_event_req(void);
+static void btif_a2dp_sink_rx_queue_flush(void);
+static uint32_t btif_a2dp_sink_rx_depth_ms(void);
 
 UNUSED_ATTR static const char* dump_media_event(uint16_t event) {
   switch (event) {
@@ -358,7 +376,7 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
   OI_STATUS status;
   int num_sbc_frames = p_msg->num_frames_to_be_processed;
   uint32_t sbc_frame_len = p_msg->len - 1;
-  availPcmBytes = sizeof(btif_a2dp_sink_pcm_data);
+  availPcmBytes = BTIF_A2DP_SINK_PCM_SAMPLES * sizeof(int16_t);
 
   if ((btif_av_get_peer_sep() == AVDT_TSEP_SNK) ||
       (btif_a2dp_sink_cb.rx_flush)) {
@@ -385,10 +403,22 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
     p_msg->len = sbc_frame_len + 1;
   }
 
+  uint8_t channels = btif_a2dp_sink_cb.channel_count;
+  size_t pcm_frames = 0;
+  if (channels != 0) {
+    pcm_frames =
+        (BTIF_A2DP_SINK_PCM_SAMPLES - availPcmBytes / sizeof(int16_t)) /
+        channels;
+    /* Play slightly faster or slower to hold the target queue depth */
+    pcm_frames = btif_a2dp_sink_jitter_compensate(
+        &btif_a2dp_sink_cb.jitter, btif_a2dp_sink_pcm_data, pcm_frames,
+        channels);
+  }
+
 #ifndef OS_GENERIC
-  BtifAvrcpAudioTrackWriteData(
-      btif_a2dp_sink_cb.audio_track, (void*)btif_a2dp_sink_pcm_data,
-      (sizeof(btif_a2dp_sink_pcm_data) - availPcmBytes));
+  BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
+                               (void*)btif_a2dp_sink_pcm_data,
+                               pcm_frames * channels * sizeof(int16_t));
 #endif
 }
 
@@ -401,6 +431,11 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
 
   if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
     APPL_TRACE_DEBUG("%s: empty queue", __func__);
+    if (!btif_a2dp_sink_cb.jitter.prebuffering &&
+        btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED &&
+        !btif_a2dp_sink_cb.rx_flush) {
+      btif_a2dp_sink_jitter_on_underrun(&btif_a2dp_sink_cb.jitter);
+    }
     return;
   }
 
@@ -412,17 +447,36 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   }
   /* Play only in BTIF_A2DP_SINK_FOCUS_GRANTED case */
   if (btif_a2dp_sink_cb.rx_flush) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_rx_queue_flush();
     return;
   }
 
   num_frames_to_process = btif_a2dp_sink_cb.frames_to_process;
+  if (num_frames_to_process != 0) {
+    uint32_t depth_ms = btif_a2dp_sink_rx_depth_ms();
+    size_t queued = fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+    /* The queue holds MAX_INPUT_A2DP_FRAME_QUEUE_SZ packets of the observed
+     * duration */
+    if (queued > 0 && depth_ms > 0) {
+      btif_a2dp_sink_jitter_set_capacity(
+          &btif_a2dp_sink_cb.jitter,
+          depth_ms * MAX_INPUT_A2DP_FRAME_QUEUE_SZ / queued);
+    }
+    num_frames_to_process = btif_a2dp_sink_jitter_on_tick(
+        &btif_a2dp_sink_cb.jitter, depth_ms, num_frames_to_process);
+    if (num_frames_to_process == 0) {
+      APPL_TRACE_DEBUG("%s: prebuffering, %u of %u ms queued", __func__,
+                       btif_a2dp_sink_cb.jitter.depth_ms,
+                       btif_a2dp_sink_cb.jitter.target_ms);
+      return;
+    }
+  }
   APPL_TRACE_DEBUG(" Process Frames + ");
 
   do {
     p_msg = (tBT_SBC_HDR*)fixed_queue_try_peek_first(
         btif_a2dp_sink_cb.rx_audio_queue);
-    if (p_msg == NULL) return;
+    if (p_msg == NULL) break;
     /* Number of frames in queue packets */
     num_sbc_frames = p_msg->num_frames_to_be_processed;
     APPL_TRACE_DEBUG("Frames left in topmost packet %d", num_sbc_frames);
@@ -446,6 +500,7 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
       }
       p_msg->num_frames_to_be_processed =
           num_sbc_frames - num_frames_to_process;
+      btif_a2dp_sink_rx_frames -= num_frames_to_process;
       num_frames_to_process = 0;
       break;
     }
@@ -457,12 +512,20 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
       APPL_TRACE_ERROR("Insufficient data in queue");
       break;
     }
+    btif_a2dp_sink_jitter_on_packet(&btif_a2dp_sink_cb.jitter, p_msg->rtp_ts,
+                                    p_msg->arrival_us);
     num_frames_to_process =
         num_frames_to_process - p_msg->num_frames_to_be_processed;
+    btif_a2dp_sink_rx_frames -= num_sbc_frames;
     osi_free(p_msg);
   } while (num_frames_to_process > 0);
 
-  if (btif_is_sink_delay_report_supported()) {
+  /* The queue ran dry in the middle of the tick */
+  if (num_frames_to_process > 0)
+    btif_a2dp_sink_jitter_on_underrun(&btif_a2dp_sink_cb.jitter);
+
+  if (btif_is_sink_delay_report_supported() &&
+      btif_a2dp_sink_cb.frames_to_process != 0) {
     inst_delay = inst_delay_total / btif_a2dp_sink_cb.frames_to_process;
     btif_update_reported_delay(inst_delay);
   }
@@ -470,6 +533,21 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   APPL_TRACE_DEBUG("Process Frames - ");
 }
 
+/* Drop all received media packets and restart the playout */
+static void btif_a2dp_sink_rx_queue_flush(void) {
+  fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_sink_rx_frames = 0;
+  btif_a2dp_sink_jitter_reset(&btif_a2dp_sink_cb.jitter);
+}
+
+/* Duration of the queued media packets */
+static uint32_t btif_a2dp_sink_rx_depth_ms(void) {
+  int frames = btif_a2dp_sink_rx_frames;
+  if (frames <= 0 || btif_a2dp_sink_cb.frames_to_process == 0) return 0;
+  return (uint32_t)frames * BTIF_SINK_MEDIA_TIME_TICK_MS /
+         btif_a2dp_sink_cb.frames_to_process;
+}
+
 /* when true media task discards any rx frames */
 void btif_a2dp_sink_set_rx_flush(bool enable) {
   APPL_TRACE_EVENT("## DROP RX %d ##", enable);
@@ -480,7 +558,7 @@ static void btif_a2dp_sink_audio_rx_flush_event(void) {
   /* Flush all received SBC buffers (encoded) */
   APPL_TRACE_DEBUG("%s", __func__);
 
-  fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_sink_rx_queue_flush();
 }
 
 static void btif_a2dp_sink_decoder_update_event(
@@ -515,6 +593,8 @@ static void btif_a2dp_sink_decoder_update_event(
   }
   btif_a2dp_sink_cb.sample_rate = sample_rate;
   btif_a2dp_sink_cb.channel_count = channel_count;
+  btif_a2dp_sink_jitter_init(&btif_a2dp_sink_cb.jitter, sample_rate,
+                             BTIF_SINK_MEDIA_TIME_TICK_MS);
 
   btif_a2dp_sink_cb.rx_flush = false;
   APPL_TRACE_DEBUG("%s: Reset to Sink role", __func__);
@@ -564,7 +644,13 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
       MAX_INPUT_A2DP_FRAME_QUEUE_SZ) {
     uint8_t ret = fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
-    osi_free(fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue));
+    tBT_SBC_HDR* p_old =
+        (tBT_SBC_HDR*)fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue);
+    if (p_old != NULL) {
+      btif_a2dp_sink_rx_frames -= p_old->num_frames_to_be_processed;
+      btif_a2dp_sink_cb.rx_overflow_drops++;
+      osi_free(p_old);
+    }
     return ret;
   }
 
@@ -579,6 +665,12 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   p_msg->len = p_pkt->len;
   p_msg->offset = 0;
   p_msg->layer_specific = p_pkt->layer_specific;
+  /* The RTP timestamp is stored ahead of the payload, see
+   * bta_av_sink_data_cback() */
+  p_msg->rtp_ts = (p_pkt->offset >= sizeof(uint32_t))
+                      ? *((uint32_t*)(p_pkt + 1))
+                      : 0;
+  p_msg->arrival_us = time_get_os_boottime_us();
 
   if (btif_is_sink_delay_report_supported()) {
     struct timespec ts_now;
@@ -588,6 +680,7 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
 
   BTIF_TRACE_VERBOSE("%s: frames to process %d, len %d", __func__,
                      p_msg->num_frames_to_be_processed, p_msg->len);
+  btif_a2dp_sink_rx_frames += p_msg->num_frames_to_be_processed;
   fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
   if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
       MAX_A2DP_DELAYED_START_FRAME_COUNT) {
@@ -609,8 +702,37 @@ void btif_a2dp_sink_audio_rx_flush_req(void) {
   fixed_queue_enqueue(btif_a2dp_sink_cb.cmd_msg_queue, p_buf);
 }
 
-void btif_a2dp_sink_debug_dump(UNUSED_ATTR int fd) {
-  // Nothing to do
+void btif_a2dp_sink_debug_dump(int fd) {
+  const tBTIF_A2DP_SINK_JITTER* jb = &btif_a2dp_sink_cb.jitter;
+
+  dprintf(fd, "\nA2DP Sink State: %s\n",
+          (btif_a2dp_sink_state == BTIF_A2DP_SINK_STATE_RUNNING)
+              ? "RUNNING"
+              : "NOT RUNNING");
+  if (btif_a2dp_sink_state != BTIF_A2DP_SINK_STATE_RUNNING) return;
+
+  dprintf(fd,
+          "  Jitter buffer depth in ms (now/target/max)              : %u / "
+          "%u / %u%s\n",
+          jb->depth_ms, jb->target_ms, jb->max_depth_ms,
+          jb->prebuffering ? " (prebuffering)" : "");
+  dprintf(fd,
+          "  Interarrival jitter in us                               : %u\n",
+          jb->jitter_x16_us / 16);
+  dprintf(fd,
+          "  Counts (packets/late/overflow drops)                    : %u / "
+          "%u / %u\n",
+          jb->packets, jb->late_packets, btif_a2dp_sink_cb.rx_overflow_drops);
+  dprintf(fd,
+          "  Concealment events                                      : %u\n",
+          jb->concealment_events);
+  dprintf(fd,
+          "  Drift correction in ppm                                 : %d\n",
+          jb->correction_ppm);
+  dprintf(fd,
+          "  Sample frames (inserted/dropped)                        : %u / "
+          "%u\n",
+          jb->samples_inserted, jb->samples_dropped);
 }
 
 void btif_a2dp_sink_set_focus_state_req(btif_a2dp_sink_focus_state_t state) {
@@ -631,7 +753,7 @@ static void btif_a2dp_sink_set_focus_state_event(
   APPL_TRACE_DEBUG("%s: setting focus state to %d", __func__, state);
   btif_a2dp_sink_cb.rx_focus_state = state;
   if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_rx_queue_flush();
     btif_a2dp_sink_cb.rx_flush = true;
   } else if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
     btif_a2dp_sink_cb.rx_flush = false;
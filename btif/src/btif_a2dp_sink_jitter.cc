@@ -0,0 +1,210 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btif_a2dp_sink_jitter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Transit time changes above this are a discontinuity of the stream (e.g. the
+ * source paused), not jitter */
+#define JITTER_DISCONTINUITY_US 1000000
+
+/* The shortest transit time follows increasing transit times (a source clock
+ * slower than ours) by 1/256 of the difference per packet */
+#define JITTER_BASE_TRANSIT_LEAK_SHIFT 8
+
+/* Ticks between two 1 ms decreases of the target depth */
+#define JITTER_TARGET_DECAY_TICKS 50
+
+/* Rate correction per millisecond of depth error, in parts per million */
+#define JITTER_CORRECTION_GAIN_PPM 50
+
+static uint32_t jitter_clamp(uint32_t value, uint32_t min, uint32_t max) {
+  if (value < min) return min;
+  if (value > max) return max;
+  return value;
+}
+
+void btif_a2dp_sink_jitter_init(tBTIF_A2DP_SINK_JITTER* jb,
+                                uint32_t sample_rate, uint32_t tick_ms) {
+  memset(jb, 0, sizeof(*jb));
+  jb->sample_rate = sample_rate;
+  jb->tick_ms = tick_ms;
+  jb->target_ms = BTIF_A2DP_SINK_JITTER_MIN_TARGET_MS;
+  jb->max_target_ms = BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS;
+  jb->prebuffering = true;
+}
+
+void btif_a2dp_sink_jitter_reset(tBTIF_A2DP_SINK_JITTER* jb) {
+  jb->anchored = false;
+  jb->avg_depth_x8_ms = 0;
+  jb->depth_ms = 0;
+  jb->prebuffering = true;
+  jb->correction_ppm = 0;
+  jb->correction_acc = 0;
+}
+
+bool btif_a2dp_sink_jitter_on_packet(tBTIF_A2DP_SINK_JITTER* jb,
+                                     uint32_t rtp_ts, uint64_t arrival_us) {
+  if (jb->sample_rate == 0) return false;
+
+  jb->packets++;
+  if (jb->anchored) {
+    jb->media_samples += (int32_t)(rtp_ts - jb->last_rtp_ts);
+  } else {
+    jb->media_samples = 0;
+  }
+  jb->last_rtp_ts = rtp_ts;
+
+  int64_t transit_us =
+      (int64_t)arrival_us - jb->media_samples * 1000000 / jb->sample_rate;
+
+  if (!jb->anchored ||
+      llabs(transit_us - jb->last_transit_us) > JITTER_DISCONTINUITY_US) {
+    jb->anchored = true;
+    jb->last_transit_us = transit_us;
+    jb->base_transit_us = transit_us;
+    return false;
+  }
+
+  /* RFC 3550, 6.4.1: J += (|D| - J) / 16 */
+  uint32_t d_us = (uint32_t)llabs(transit_us - jb->last_transit_us);
+  jb->jitter_x16_us += d_us - ((jb->jitter_x16_us + 8) >> 4);
+  jb->last_transit_us = transit_us;
+
+  if (transit_us < jb->base_transit_us) {
+    jb->base_transit_us = transit_us;
+  } else {
+    jb->base_transit_us +=
+        (transit_us - jb->base_transit_us) >> JITTER_BASE_TRANSIT_LEAK_SHIFT;
+  }
+
+  /* A packet delayed by more than the buffered audio would have played out
+   * after the queue ran dry */
+  uint32_t delay_ms = (uint32_t)((transit_us - jb->base_transit_us) / 1000);
+  if (delay_ms <= jb->target_ms) return false;
+
+  jb->late_packets++;
+  jb->target_ms =
+      jitter_clamp(delay_ms + jb->tick_ms, jb->target_ms, jb->max_target_ms);
+  jb->decay_ticks = 0;
+  return true;
+}
+
+void btif_a2dp_sink_jitter_set_capacity(tBTIF_A2DP_SINK_JITTER* jb,
+                                        uint32_t capacity_ms) {
+  /* A target above the capacity would never end the prebuffering, since the
+   * full queue drops its oldest packets */
+  uint32_t max_ms = capacity_ms > 2 * jb->tick_ms ? capacity_ms - jb->tick_ms
+                                                  : jb->tick_ms;
+  if (max_ms > BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS)
+    max_ms = BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS;
+  jb->max_target_ms = max_ms;
+  if (jb->target_ms > max_ms) jb->target_ms = max_ms;
+}
+
+int btif_a2dp_sink_jitter_on_tick(tBTIF_A2DP_SINK_JITTER* jb,
+                                  uint32_t depth_ms, int frames_per_tick) {
+  jb->depth_ms = depth_ms;
+  if (depth_ms > jb->max_depth_ms) jb->max_depth_ms = depth_ms;
+
+  /* Two ticks of decoding plus four times the jitter covers nearly all the
+   * interarrival variation; lower the target slowly to avoid oscillating */
+  uint32_t jitter_ms = jb->jitter_x16_us / 16 / 1000;
+  uint32_t want_ms = jitter_clamp(2 * jb->tick_ms + 4 * jitter_ms,
+                                  BTIF_A2DP_SINK_JITTER_MIN_TARGET_MS,
+                                  BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS);
+  if (want_ms > jb->max_target_ms) want_ms = jb->max_target_ms;
+  if (want_ms > jb->target_ms) {
+    jb->target_ms = want_ms;
+    jb->decay_ticks = 0;
+  } else if (want_ms < jb->target_ms &&
+             ++jb->decay_ticks >= JITTER_TARGET_DECAY_TICKS) {
+    jb->target_ms--;
+    jb->decay_ticks = 0;
+  }
+
+  if (jb->prebuffering) {
+    if (depth_ms < jb->target_ms) return 0;
+    jb->prebuffering = false;
+    jb->avg_depth_x8_ms = depth_ms * 8;
+  }
+
+  jb->avg_depth_x8_ms += depth_ms - (jb->avg_depth_x8_ms >> 3);
+  int32_t error_ms =
+      (int32_t)(jb->avg_depth_x8_ms >> 3) - (int32_t)jb->target_ms;
+  if ((uint32_t)abs(error_ms) <= jb->tick_ms / 4) {
+    jb->correction_ppm = 0;
+  } else {
+    int32_t ppm = error_ms * JITTER_CORRECTION_GAIN_PPM;
+    if (ppm > BTIF_A2DP_SINK_JITTER_MAX_CORRECTION_PPM)
+      ppm = BTIF_A2DP_SINK_JITTER_MAX_CORRECTION_PPM;
+    if (ppm < -BTIF_A2DP_SINK_JITTER_MAX_CORRECTION_PPM)
+      ppm = -BTIF_A2DP_SINK_JITTER_MAX_CORRECTION_PPM;
+    jb->correction_ppm = ppm;
+  }
+
+  /* Far above the target, e.g. after a burst: catch up a frame per tick
+   * instead of waiting for the rate correction */
+  if (depth_ms > jb->target_ms + 4 * jb->tick_ms) return frames_per_tick + 1;
+  return frames_per_tick;
+}
+
+void btif_a2dp_sink_jitter_on_underrun(tBTIF_A2DP_SINK_JITTER* jb) {
+  jb->concealment_events++;
+  jb->prebuffering = true;
+  jb->correction_ppm = 0;
+  jb->correction_acc = 0;
+}
+
+size_t btif_a2dp_sink_jitter_compensate(tBTIF_A2DP_SINK_JITTER* jb,
+                                        int16_t* pcm, size_t frames,
+                                        uint8_t channels) {
+  if (frames < 3 || channels == 0) return frames;
+
+  jb->correction_acc += (int64_t)jb->correction_ppm * (int64_t)frames;
+  if (jb->correction_acc > 2000000) jb->correction_acc = 2000000;
+  if (jb->correction_acc < -2000000) jb->correction_acc = -2000000;
+
+  size_t mid = frames / 2;
+  int16_t* p = pcm + mid * channels;
+
+  if (jb->correction_acc >= 1000000) {
+    /* Merge sample frames |mid| and |mid| + 1 */
+    for (uint8_t ch = 0; ch < channels; ch++)
+      p[ch] = (int16_t)(((int32_t)p[ch] + p[channels + ch]) / 2);
+    memmove(p + channels, p + 2 * channels,
+            (frames - mid - 2) * channels * sizeof(int16_t));
+    jb->correction_acc -= 1000000;
+    jb->samples_dropped++;
+    return frames - 1;
+  }
+
+  if (jb->correction_acc <= -1000000) {
+    /* Insert the average of sample frames |mid| - 1 and |mid| before |mid| */
+    memmove(p + channels, p, (frames - mid) * channels * sizeof(int16_t));
+    for (uint8_t ch = 0; ch < channels; ch++)
+      p[ch] = (int16_t)(((int32_t)p[ch - channels] + p[channels + ch]) / 2);
+    jb->correction_acc += 1000000;
+    jb->samples_inserted++;
+    return frames + 1;
+  }
+
+  return frames;
+}
@@ -60,7 +60,9 @@ using ::bluetooth::audio::a2dp::SessionType;
 #include "osi/include/osi.h"
 #include "osi/include/thread.h"
 #include "osi/include/time.h"
+#include "osi/include/trace.h"
 #include "uipc.h"
+#include "uipc_audio_ring.h"
 #include "btif_a2dp_audio_interface.h"
 #include "btif_bat.h"
 #include "btif_hf.h"
@@ -992,6 +994,7 @@ static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
   uint64_t timestamp_us = time_get_os_boottime_us();
   int curr_idx = btif_av_get_latest_device_idx_to_start();
   log_tstamps_us("A2DP Source tx timer", timestamp_us);
+  OSI_TRACE_BEGIN("btif_a2dp_source_audio_handle_timer");
 
   if (alarm_is_scheduled(btif_a2dp_source_cb.media_alarm)) {
     CHECK(btif_a2dp_source_cb.encoder_interface != NULL);
@@ -1000,6 +1003,7 @@ static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
 #ifndef OS_GENERIC
     ATRACE_INT("btif TX queue", transmit_queue_length);
 #endif
+    OSI_TRACE_COUNTER("btif TX queue", transmit_queue_length);
     if (btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length !=
         NULL) {
       btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
@@ -1017,6 +1021,7 @@ static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
   } else {
     APPL_TRACE_ERROR("ERROR Media task Scheduled after Suspend");
   }
+  OSI_TRACE_END("btif_a2dp_source_audio_handle_timer");
 }
 
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
@@ -1399,6 +1404,29 @@ void btif_a2dp_source_debug_dump(int fd) {
           1000,
       (unsigned long long)ave_time_us / 1000);
 
+  tUIPC_AUDIO_RING_STATS ring_stats;
+  if (UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_GET_AUDIO_RING_STATS,
+                 &ring_stats)) {
+    dprintf(fd, "  Audio ring:\n");
+    dprintf(fd,
+            "  Fill in bytes (size/now/max/ave)                        : %u / "
+            "%u / %u / %llu\n",
+            ring_stats.size, ring_stats.fill, ring_stats.max_fill,
+            ring_stats.num_reads
+                ? (unsigned long long)(ring_stats.fill_sum /
+                                       ring_stats.num_reads)
+                : 0);
+    dprintf(fd,
+            "  Counts (reads/underruns)                                : %u / "
+            "%u\n",
+            ring_stats.num_reads, ring_stats.underruns);
+    dprintf(fd,
+            "  Counts (producer waits/wakeups/timeouts)                : %u / "
+            "%u / %u\n",
+            ring_stats.producer_waits, ring_stats.wakeups,
+            ring_stats.timeouts);
+  }
+
   //
   // Codec-specific stats
   //
@@ -50,6 +50,7 @@
 #include "btif_api.h"
 #include "btif_av.h"
 #include "btif_config.h"
+#include "btif_msg_pool.h"
 #include "btif_pan.h"
 #include "btif_profile_queue.h"
 #include "btif_sock.h"
@@ -57,6 +58,7 @@
 #include "btif_uid.h"
 #include "btif_util.h"
 #include "btu.h"
+#include "common/task_latency.h"
 #include "device/include/controller.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/future.h"
@@ -64,6 +66,7 @@
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
 #include "osi/include/thread.h"
+#include "osi/include/trace.h"
 #include "stack_manager.h"
 #include "device/include/device_iot_config.h"
 
@@ -128,6 +131,15 @@ static uint8_t btif_dut_mode = 0;
 
 thread_t* bt_jni_workqueue_thread;
 static const char* BT_JNI_WORKQUEUE_NAME = "bt_jni_workqueue";
+
+/* Threshold of the slow task reports, in ms; 0 disables the task latency
+ * tracking of the stack message loops */
+#define BTIF_TASK_LATENCY_PROPERTY "persist.bluetooth.tasklatency_ms"
+
+/* Non zero enables the event tracing of HCI, L2CAP, GATT and A2DP; the
+ * events are exported with "dumpsys bluetooth_manager --trace" */
+#define BTIF_TRACE_PROPERTY "persist.bluetooth.trace"
+
 static uid_set_t* uid_set = NULL;
 base::MessageLoop* message_loop_ = NULL;
 base::RunLoop* jni_run_loop = NULL;
@@ -139,7 +151,7 @@ static void btif_jni_associate();
 static void btif_jni_disassociate();
 
 /* sends message to btif task */
-static void btif_sendmsg(void* p_msg);
+static void btif_sendmsg(tBTIF_CONTEXT_SWITCH_CBACK* p_msg);
 
 /*******************************************************************************
  *  Externs
@@ -193,6 +205,9 @@ static void btif_context_switched(void* p_msg) {
  *                  p_copy_cback : If set this function will be invoked for deep
  *                                 copy
  *
+ *                  The message is taken from the btif message pool, so
+ *                  frequent events don't go through the heap.
+ *
  * Returns          void
  *
  ******************************************************************************/
@@ -200,8 +215,9 @@ static void btif_context_switched(void* p_msg) {
 bt_status_t btif_transfer_context(tBTIF_CBACK* p_cback, uint16_t event,
                                   char* p_params, int param_len,
                                   tBTIF_COPY_CBACK* p_copy_cback) {
-  tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)osi_malloc(
-      sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len + 1);
+  tBTIF_CONTEXT_SWITCH_CBACK* p_msg =
+      (tBTIF_CONTEXT_SWITCH_CBACK*)btif_msg_pool_alloc(
+          sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len + 1);
 
   BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event,
                      param_len);
@@ -225,12 +241,8 @@ bt_status_t btif_transfer_context(tBTIF_CBACK* p_cback, uint16_t event,
   return BT_STATUS_SUCCESS;
 }
 
-/**
- * This function posts a task into the btif message loop, that executes it in
- * the JNI message loop.
- **/
-bt_status_t do_in_jni_thread(const base::Location& from_here,
-                             const base::Closure& task) {
+static bt_status_t btif_post_task(const base::Location& from_here,
+                                  const base::Closure& task) {
   if (!message_loop_ || !message_loop_->task_runner().get()) {
     BTIF_TRACE_WARNING("%s: Dropped message, message_loop not initialized yet!",
                        __func__);
@@ -244,6 +256,16 @@ bt_status_t do_in_jni_thread(const base::Location& from_here,
   return BT_STATUS_FAIL;
 }
 
+/**
+ * This function posts a task into the btif message loop, that executes it in
+ * the JNI message loop.
+ **/
+bt_status_t do_in_jni_thread(const base::Location& from_here,
+                             const base::Closure& task) {
+  return btif_post_task(
+      from_here, bluetooth::common::TrackTaskLatency(from_here, "jni", task));
+}
+
 bt_status_t do_in_jni_thread(const base::Closure& task) {
   return do_in_jni_thread(FROM_HERE, task);
 }
@@ -304,7 +326,7 @@ static void bt_jni_msg_ready(void* context) {
       BTIF_TRACE_ERROR("unhandled btif event (%d)", p_msg->event & BT_EVT_MASK);
       break;
   }
-  osi_free(p_msg);
+  btif_msg_pool_free(p_msg);
 }
 
 /*******************************************************************************
@@ -317,8 +339,13 @@ static void bt_jni_msg_ready(void* context) {
  *
  ******************************************************************************/
 
-void btif_sendmsg(void* p_msg) {
-  do_in_jni_thread(base::Bind(&bt_jni_msg_ready, p_msg));
+void btif_sendmsg(tBTIF_CONTEXT_SWITCH_CBACK* p_msg) {
+  /* All the context switches share this location: track them by callback and
+   * event */
+  btif_post_task(FROM_HERE, bluetooth::common::TrackTaskLatency(
+                                FROM_HERE, "jni", (const void*)p_msg->p_cb,
+                                p_msg->event,
+                                base::Bind(&bt_jni_msg_ready, p_msg)));
 }
 
 void btif_thread_post(thread_fn func, void* context) {
@@ -364,6 +391,11 @@ void run_message_loop(UNUSED_ATTR void* context) {
 bt_status_t btif_init_bluetooth() {
   LOG_INFO(LOG_TAG, "%s entered", __func__);
 
+  int32_t slow_task_ms = osi_property_get_int32(BTIF_TASK_LATENCY_PROPERTY, 0);
+  bluetooth::common::TaskLatencySetSlowThreshold(
+      slow_task_ms > 0 ? slow_task_ms : 0);
+  osi_trace_set_enabled(osi_property_get_int32(BTIF_TRACE_PROPERTY, 0) != 0);
+
   bte_main_boot_entry();
 
   char twsplus_prop[PROPERTY_VALUE_MAX] = "false";
@@ -569,6 +601,7 @@ bt_status_t btif_cleanup_bluetooth(void) {
 
   thread_free(bt_jni_workqueue_thread);
   bt_jni_workqueue_thread = NULL;
+  btif_msg_pool_flush();
 
   bte_main_cleanup();
 
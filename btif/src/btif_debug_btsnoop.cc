@@ -16,7 +16,10 @@
  *
  ******************************************************************************/
 
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <base/logging.h>
 #include <resolv.h>
@@ -26,7 +29,6 @@
 #include "btif/include/btif_debug_btsnoop.h"
 #include "hci/include/btsnoop_mem.h"
 #include "internal_include/bt_target.h"
-#include "osi/include/ringbuffer.h"
 #include "osi/include/time.h"
 
 #define REDUCE_HCI_TYPE_TO_SIGNIFICANT_BITS(type) ((type) >> 8)
@@ -36,20 +38,90 @@
 static const size_t BTSNOOP_MEM_BUFFER_SIZE = (256 * 1024);
 #endif
 
-// Block size for copying buffers (for compression/encoding etc.)
-static const size_t BLOCK_SIZE = 16384;
+// The packets are compressed as they are logged, in chunks of at least
+// CHUNK_SIZE bytes of packet data. Each chunk is a raw deflate stream of its
+// own, ended on a byte boundary, so chunks can be dropped from the front of
+// the log and the remaining ones still concatenate into one valid deflate
+// stream. The dump only wraps them in a zlib header and trailer.
+static const size_t CHUNK_SIZE = 16384;
+
+// The compressed chunks and the chunk being filled share the buffer size
+static const size_t CHUNKS_MAX_SIZE = BTSNOOP_MEM_BUFFER_SIZE - CHUNK_SIZE;
+
+// Compression parameters: fastest level, and a small window since chunks
+// never refer to each other
+static const int DEFLATE_LEVEL = Z_BEST_SPEED;
+static const int DEFLATE_WINDOW_BITS = 12;
+static const int DEFLATE_MEM_LEVEL = 6;
 
 // Maximum line length in bugreport (should be multiple of 4 for base64 output)
 static const uint8_t MAX_LINE_LENGTH = 128;
 
+typedef struct {
+  std::vector<uint8_t> data; /* raw deflate blocks */
+  uint32_t adler;            /* Adler-32 of the packet data */
+  size_t raw_length;         /* length of the packet data */
+} btsnoop_chunk_t;
+
+typedef std::shared_ptr<const btsnoop_chunk_t> btsnoop_chunk_ptr;
+
 static std::mutex buffer_mutex;
-static ringbuffer_t* buffer = NULL;
+static bool deflate_ready = false;
+static z_stream deflate_stream;
+static std::vector<uint8_t> pending;  // packet data not compressed yet
+static std::deque<btsnoop_chunk_ptr> chunks;
+static size_t chunks_size = 0;  // compressed size of |chunks|
+static size_t chunks_raw_size = 0;
 static uint64_t last_timestamp_ms = 0;
 
 static size_t btsnoop_calculate_packet_length(uint16_t type,
                                               const uint8_t* data,
                                               size_t length);
 
+// Compress |length| bytes of |data| into a new chunk.
+// Must be called with |buffer_mutex| held.
+static btsnoop_chunk_ptr btsnoop_compress_chunk(const uint8_t* data,
+                                                size_t length) {
+  std::shared_ptr<btsnoop_chunk_t> chunk = std::make_shared<btsnoop_chunk_t>();
+  chunk->adler = adler32(adler32(0L, Z_NULL, 0), data, length);
+  chunk->raw_length = length;
+  if (!deflate_ready || deflateReset(&deflate_stream) != Z_OK) return nullptr;
+
+  // Room for the compressed data and the sync flush marker
+  chunk->data.resize(deflateBound(&deflate_stream, length) + 16);
+  deflate_stream.next_in = const_cast<uint8_t*>(data);
+  deflate_stream.avail_in = length;
+  deflate_stream.next_out = chunk->data.data();
+  deflate_stream.avail_out = chunk->data.size();
+  int err = deflate(&deflate_stream, Z_SYNC_FLUSH);
+  if (err != Z_OK || deflate_stream.avail_in != 0 ||
+      deflate_stream.avail_out == 0) {
+    LOG(ERROR) << __func__ << ": compression failed: " << err;
+    return nullptr;
+  }
+  chunk->data.resize(chunk->data.size() - deflate_stream.avail_out);
+  chunk->data.shrink_to_fit();
+  return chunk;
+}
+
+// Compress the pending packet data into a chunk, and drop the oldest chunks
+// that no longer fit. Must be called with |buffer_mutex| held.
+static void btsnoop_seal_chunk(void) {
+  btsnoop_chunk_ptr chunk = btsnoop_compress_chunk(pending.data(),
+                                                   pending.size());
+  pending.clear();
+  if (chunk == nullptr) return;
+
+  chunks.push_back(chunk);
+  chunks_size += chunk->data.size();
+  chunks_raw_size += chunk->raw_length;
+  while (chunks_size > CHUNKS_MAX_SIZE) {
+    chunks_size -= chunks.front()->data.size();
+    chunks_raw_size -= chunks.front()->raw_length;
+    chunks.pop_front();
+  }
+}
+
 __attribute__((no_sanitize("integer")))
 static void btsnoop_cb(const uint16_t type, const uint8_t* data,
                        const size_t length, const uint64_t timestamp_us) {
@@ -60,14 +132,6 @@ static void btsnoop_cb(const uint16_t type, const uint8_t* data,
 
   std::lock_guard<std::mutex> lock(buffer_mutex);
 
-  // Make room in the ring buffer
-
-  while (ringbuffer_available(buffer) <
-         (included_length + sizeof(btsnooz_header_t))) {
-    ringbuffer_pop(buffer, (uint8_t*)&header, sizeof(btsnooz_header_t));
-    ringbuffer_delete(buffer, header.length - 1);
-  }
-
   // Insert data
   header.type = REDUCE_HCI_TYPE_TO_SIGNIFICANT_BITS(type);
   header.length = included_length + 1;  // +1 for type byte
@@ -76,8 +140,11 @@ static void btsnoop_cb(const uint16_t type, const uint8_t* data,
       last_timestamp_ms ? timestamp_us - last_timestamp_ms : 0;
   last_timestamp_ms = timestamp_us;
 
-  ringbuffer_insert(buffer, (uint8_t*)&header, sizeof(btsnooz_header_t));
-  ringbuffer_insert(buffer, data, included_length);
+  const uint8_t* p_header = (const uint8_t*)&header;
+  pending.insert(pending.end(), p_header, p_header + sizeof(header));
+  pending.insert(pending.end(), data, data + included_length);
+
+  if (pending.size() >= CHUNK_SIZE) btsnoop_seal_chunk();
 }
 
 static size_t btsnoop_calculate_packet_length(uint16_t type,
@@ -132,101 +199,99 @@ static size_t btsnoop_calculate_packet_length(uint16_t type,
   }
 }
 
-static bool btsnoop_compress(ringbuffer_t* rb_dst, ringbuffer_t* rb_src) {
-  CHECK(rb_dst != NULL);
-  CHECK(rb_src != NULL);
-
-  z_stream zs;
-  zs.zalloc = Z_NULL;
-  zs.zfree = Z_NULL;
-  zs.opaque = Z_NULL;
-
-  if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) return false;
-
-  bool rc = true;
-  uint8_t block_src[BLOCK_SIZE];
-  uint8_t block_dst[BLOCK_SIZE];
-
-  const size_t num_blocks =
-      (ringbuffer_size(rb_src) + BLOCK_SIZE - 1) / BLOCK_SIZE;
-  for (size_t i = 0; i < num_blocks; ++i) {
-    zs.avail_in =
-        ringbuffer_peek(rb_src, i * BLOCK_SIZE, block_src, BLOCK_SIZE);
-    zs.next_in = block_src;
-
-    do {
-      zs.avail_out = BLOCK_SIZE;
-      zs.next_out = block_dst;
-
-      int err = deflate(&zs, (i == num_blocks - 1) ? Z_FINISH : Z_NO_FLUSH);
-      if (err == Z_STREAM_ERROR) {
-        rc = false;
-        break;
-      }
-
-      const size_t length = BLOCK_SIZE - zs.avail_out;
-      ringbuffer_insert(rb_dst, block_dst, length);
-    } while (zs.avail_out == 0);
+// Base64 encoder writing lines of at most MAX_LINE_LENGTH characters
+typedef struct {
+  int fd;
+  uint8_t in[3];
+  size_t in_length;
+  size_t line_length;
+} btsnoop_b64_writer_t;
+
+static void btsnoop_b64_flush(btsnoop_b64_writer_t* writer) {
+  char out[5] = {0};
+  if (writer->in_length == 0) return;
+  if (writer->line_length >= MAX_LINE_LENGTH) {
+    dprintf(writer->fd, "\n");
+    writer->line_length = 0;
   }
+  writer->line_length += b64_ntop(writer->in, writer->in_length, out, 5);
+  dprintf(writer->fd, "%s", out);
+  writer->in_length = 0;
+}
 
-  deflateEnd(&zs);
-  return rc;
+static void btsnoop_b64_write(btsnoop_b64_writer_t* writer,
+                              const uint8_t* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    writer->in[writer->in_length++] = data[i];
+    if (writer->in_length == 3) btsnoop_b64_flush(writer);
+  }
 }
 
 void btif_debug_btsnoop_init(void) {
-  if (buffer == NULL) buffer = ringbuffer_init(BTSNOOP_MEM_BUFFER_SIZE);
+  {
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    if (!deflate_ready) {
+      deflate_stream.zalloc = Z_NULL;
+      deflate_stream.zfree = Z_NULL;
+      deflate_stream.opaque = Z_NULL;
+      deflate_ready =
+          deflateInit2(&deflate_stream, DEFLATE_LEVEL, Z_DEFLATED,
+                       -DEFLATE_WINDOW_BITS, DEFLATE_MEM_LEVEL,
+                       Z_DEFAULT_STRATEGY) == Z_OK;
+      if (!deflate_ready) LOG(ERROR) << __func__ << ": deflateInit2 failed";
+      pending.reserve(CHUNK_SIZE + sizeof(btsnooz_header_t));
+    }
+  }
   btsnoop_mem_set_callback(btsnoop_cb);
 }
 
 void btif_debug_btsnoop_dump(int fd) {
-  ringbuffer_t* ringbuffer = ringbuffer_init(BTSNOOP_MEM_BUFFER_SIZE);
-  if (ringbuffer == NULL) {
-    dprintf(fd, "%s Unable to allocate memory for compression", __func__);
-    return;
-  }
-
-  // Prepend preamble
-
+  // Preamble, stored in a chunk of its own
   btsnooz_preamble_t preamble;
   preamble.version = BTSNOOZ_CURRENT_VERSION;
-  preamble.last_timestamp_ms = last_timestamp_ms;
-  ringbuffer_insert(ringbuffer, (uint8_t*)&preamble,
-                    sizeof(btsnooz_preamble_t));
-
-  // Compress data
-
-  uint8_t b64_in[3] = {0};
-  char b64_out[5] = {0};
-
-  size_t line_length = 0;
 
-  bool rc;
+  std::vector<btsnoop_chunk_ptr> snapshot;
+  size_t raw_size;
   {
     std::lock_guard<std::mutex> lock(buffer_mutex);
-    dprintf(fd, "--- BEGIN:BTSNOOP_LOG_SUMMARY (%zu bytes in) ---\n",
-            ringbuffer_size(buffer));
-    rc = btsnoop_compress(ringbuffer, buffer);
+    preamble.last_timestamp_ms = last_timestamp_ms;
+    snapshot.push_back(btsnoop_compress_chunk((const uint8_t*)&preamble,
+                                              sizeof(preamble)));
+    snapshot.insert(snapshot.end(), chunks.begin(), chunks.end());
+    // The pending data is compressed for the dump only, so the next packets
+    // still fill the same chunk
+    if (!pending.empty())
+      snapshot.push_back(btsnoop_compress_chunk(pending.data(),
+                                                pending.size()));
+    raw_size = chunks_raw_size + pending.size();
   }
 
-  if (rc == false) {
-    dprintf(fd, "%s Log compression failed", __func__);
-    goto error;
+  for (const btsnoop_chunk_ptr& chunk : snapshot) {
+    if (chunk == nullptr) {
+      dprintf(fd, "%s Log compression failed", __func__);
+      return;
+    }
   }
 
-  // Base64 encode & output
+  dprintf(fd, "--- BEGIN:BTSNOOP_LOG_SUMMARY (%zu bytes in) ---\n", raw_size);
 
-  while (ringbuffer_size(ringbuffer) > 0) {
-    size_t read = ringbuffer_pop(ringbuffer, b64_in, 3);
-    if (line_length >= MAX_LINE_LENGTH) {
-      dprintf(fd, "\n");
-      line_length = 0;
-    }
-    line_length += b64_ntop(b64_in, read, b64_out, 5);
-    dprintf(fd, "%s", b64_out);
+  // zlib stream: header, the chunks, an empty final block and the Adler-32
+  // of all the data
+  btsnoop_b64_writer_t writer = {fd, {0}, 0, 0};
+  static const uint8_t zlib_header[] = {0x78, 0x01};
+  static const uint8_t final_block[] = {0x03, 0x00};
+  uLong adler = adler32(0L, Z_NULL, 0);
+
+  btsnoop_b64_write(&writer, zlib_header, sizeof(zlib_header));
+  for (const btsnoop_chunk_ptr& chunk : snapshot) {
+    btsnoop_b64_write(&writer, chunk->data.data(), chunk->data.size());
+    adler = adler32_combine(adler, chunk->adler, chunk->raw_length);
   }
+  btsnoop_b64_write(&writer, final_block, sizeof(final_block));
+  uint8_t trailer[4] = {(uint8_t)(adler >> 24), (uint8_t)(adler >> 16),
+                        (uint8_t)(adler >> 8), (uint8_t)adler};
+  btsnoop_b64_write(&writer, trailer, sizeof(trailer));
+  btsnoop_b64_flush(&writer);
 
   dprintf(fd, "\n--- END:BTSNOOP_LOG_SUMMARY ---\n");
-
-error:
-  ringbuffer_free(ringbuffer);
 }
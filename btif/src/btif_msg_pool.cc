@@ -0,0 +1,168 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_msg_pool"
+
+#include "btif_msg_pool.h"
+
+#include <base/logging.h>
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+
+#include "osi/include/allocator.h"
+
+// Free buffers kept per size class
+static const uint32_t btif_msg_pool_max_free[BTIF_MSG_POOL_NUM_CLASSES] = {
+    64, 32, 8};
+
+// Index of the heap "class"
+#define BTIF_MSG_POOL_HEAP BTIF_MSG_POOL_NUM_CLASSES
+
+// Header in front of every buffer; its size keeps the buffer aligned like a
+// malloc() result.
+typedef union {
+  uint32_t class_index;
+  max_align_t align;
+} btif_msg_pool_header_t;
+
+typedef struct btif_msg_pool_free_t {
+  struct btif_msg_pool_free_t* next;
+} btif_msg_pool_free_t;
+
+typedef struct {
+  std::mutex lock;
+  btif_msg_pool_free_t* free_list;
+  tBTIF_MSG_POOL_STATS stats;
+} btif_msg_pool_class_t;
+
+static btif_msg_pool_class_t btif_msg_pool_classes[BTIF_MSG_POOL_NUM_CLASSES +
+                                                   1];
+static const size_t btif_msg_pool_sizes[BTIF_MSG_POOL_NUM_CLASSES] =
+    BTIF_MSG_POOL_CLASS_SIZES;
+
+static size_t btif_msg_pool_class_of(size_t size) {
+  size_t i = 0;
+  while (i < BTIF_MSG_POOL_NUM_CLASSES && size > btif_msg_pool_sizes[i]) i++;
+  return i;
+}
+
+void* btif_msg_pool_alloc(size_t size) {
+  size_t class_index = btif_msg_pool_class_of(size);
+  btif_msg_pool_class_t* pool_class = &btif_msg_pool_classes[class_index];
+  btif_msg_pool_header_t* header = NULL;
+
+  {
+    std::lock_guard<std::mutex> lock(pool_class->lock);
+    if (pool_class->free_list != NULL) {
+      header = (btif_msg_pool_header_t*)pool_class->free_list;
+      pool_class->free_list = pool_class->free_list->next;
+      pool_class->stats.free_buffers--;
+      pool_class->stats.hits++;
+    } else {
+      pool_class->stats.misses++;
+    }
+    pool_class->stats.in_use++;
+    if (pool_class->stats.in_use > pool_class->stats.max_in_use)
+      pool_class->stats.max_in_use = pool_class->stats.in_use;
+  }
+
+  if (header == NULL) {
+    size_t buffer_size = (class_index == BTIF_MSG_POOL_HEAP)
+                             ? size
+                             : btif_msg_pool_sizes[class_index];
+    header = (btif_msg_pool_header_t*)osi_malloc(
+        sizeof(btif_msg_pool_header_t) + buffer_size);
+  }
+  header->class_index = class_index;
+  return header + 1;
+}
+
+void btif_msg_pool_free(void* ptr) {
+  if (ptr == NULL) return;
+
+  btif_msg_pool_header_t* header = (btif_msg_pool_header_t*)ptr - 1;
+  size_t class_index = header->class_index;
+  CHECK(class_index <= BTIF_MSG_POOL_HEAP);
+  btif_msg_pool_class_t* pool_class = &btif_msg_pool_classes[class_index];
+
+  {
+    std::lock_guard<std::mutex> lock(pool_class->lock);
+    pool_class->stats.in_use--;
+    if (class_index != BTIF_MSG_POOL_HEAP &&
+        pool_class->stats.free_buffers < btif_msg_pool_max_free[class_index]) {
+      // The free list link overwrites the class index
+      btif_msg_pool_free_t* entry = (btif_msg_pool_free_t*)header;
+      entry->next = pool_class->free_list;
+      pool_class->free_list = entry;
+      pool_class->stats.free_buffers++;
+      return;
+    }
+    if (class_index != BTIF_MSG_POOL_HEAP) pool_class->stats.releases++;
+  }
+
+  osi_free(header);
+}
+
+void btif_msg_pool_flush(void) {
+  for (size_t i = 0; i < BTIF_MSG_POOL_NUM_CLASSES; i++) {
+    btif_msg_pool_class_t* pool_class = &btif_msg_pool_classes[i];
+    btif_msg_pool_free_t* free_list;
+    {
+      std::lock_guard<std::mutex> lock(pool_class->lock);
+      free_list = pool_class->free_list;
+      pool_class->free_list = NULL;
+      pool_class->stats.free_buffers = 0;
+    }
+    while (free_list != NULL) {
+      btif_msg_pool_free_t* next = free_list->next;
+      osi_free(free_list);
+      free_list = next;
+    }
+  }
+}
+
+void btif_msg_pool_get_stats(size_t class_index, tBTIF_MSG_POOL_STATS* stats) {
+  CHECK(class_index <= BTIF_MSG_POOL_HEAP);
+  btif_msg_pool_class_t* pool_class = &btif_msg_pool_classes[class_index];
+  std::lock_guard<std::mutex> lock(pool_class->lock);
+  *stats = pool_class->stats;
+  stats->size =
+      (class_index == BTIF_MSG_POOL_HEAP) ? 0 : btif_msg_pool_sizes[class_index];
+}
+
+void btif_msg_pool_debug_dump(int fd) {
+  dprintf(fd, "\nBTIF Message Pool:\n");
+  for (size_t i = 0; i <= BTIF_MSG_POOL_HEAP; i++) {
+    tBTIF_MSG_POOL_STATS stats;
+    btif_msg_pool_get_stats(i, &stats);
+    if (i == BTIF_MSG_POOL_HEAP) {
+      dprintf(fd, "  Heap fallbacks: %llu, in use: %u (max %u)\n",
+              (unsigned long long)stats.misses, stats.in_use,
+              stats.max_in_use);
+      continue;
+    }
+    dprintf(fd,
+            "  Class %4zu bytes: hits %llu, misses %llu, releases %llu, "
+            "in use %u (max %u), free %u\n",
+            stats.size, (unsigned long long)stats.hits,
+            (unsigned long long)stats.misses,
+            (unsigned long long)stats.releases, stats.in_use,
+            stats.max_in_use, stats.free_buffers);
+  }
+}
@@ -56,7 +56,12 @@
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include <inttypes.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
 
 using base::Bind;
 using bluetooth::Uuid;
@@ -88,6 +93,11 @@ using bluetooth::Uuid;
 #define BTIF_STORAGE_KEY_LOCAL_IO_CAPS_BLE "LocalIOCapsBLE"
 #define BTIF_STORAGE_KEY_ADAPTER_DISC_TIMEOUT "DiscoveryTimeout"
 
+/* When true, the BR/EDR only bonded devices are added to the stack on first
+ * use instead of at enable, and their remote properties are reported after
+ * the enable completes */
+#define BTIF_STORAGE_LAZY_LOAD_PROPERTY "persist.bluetooth.lazybondedload"
+
 /* This is a local property to add a device found */
 #define BT_PROPERTY_REMOTE_DEVICE_TIMESTAMP 0xFF
 
@@ -174,6 +184,27 @@ static bt_status_t btif_in_fetch_bonded_device(const char* bdstr, int *dev_type)
 
 static bool btif_has_ble_keys(const char* bdstr);
 
+/*******************************************************************************
+ *  Static variables
+ ******************************************************************************/
+
+/* Index of the bonded devices found at the last load, and of those not added
+ * to the stack yet. Both are accessed from the BTIF and the stack contexts. */
+static std::mutex bonded_devices_mutex;
+static std::unordered_set<RawAddress> bonded_devices_index;
+static std::unordered_set<RawAddress> pending_bonded_devices;
+
+/* Timing of the last btif_storage_load_bonded_devices(), for the debug dump */
+static struct {
+  bool lazy;
+  size_t devices;
+  size_t deferred;
+  size_t loaded_on_demand;
+  uint64_t fetch_us;      /* config scan and stack adds */
+  uint64_t adapter_us;    /* adapter properties callback */
+  uint64_t remote_us;     /* remote properties callbacks, 0 when deferred */
+} load_stats;
+
 static bool prop_upd(const RawAddress* remote_bd_addr, bt_property_t *prop);
 /*******************************************************************************
  *  Static functions
@@ -505,7 +536,7 @@ static bt_status_t btif_in_fetch_bonded_device(const char* bdstr, int *p_dev_typ
  *
  ******************************************************************************/
 static bt_status_t btif_in_fetch_bonded_devices(
-    list_t** p_bonded_devices, int add) {
+    list_t** p_bonded_devices, int add, bool defer_bredr) {
 
   bool bt_linkkey_file_found = false;
   int device_type;
@@ -524,7 +555,14 @@ static bt_status_t btif_in_fetch_bonded_devices(
       if (btif_config_get_int(name, "LinkKeyType", &linkkey_type)) {
         RawAddress bd_addr;
         RawAddress::FromString(name, bd_addr);
-        if (add) {
+        device_type = 0;
+        btif_config_get_int(name, "DevType", &device_type);
+        if (add && defer_bredr && device_type == BT_DEVICE_TYPE_BREDR &&
+            !btif_has_ble_keys(name)) {
+          /* Added by btif_in_load_pending_device() on first use */
+          std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+          pending_bonded_devices.insert(bd_addr);
+        } else if (add) {
           DEV_CLASS dev_class = {0, 0, 0};
           int cod;
           int pin_length = 0;
@@ -534,8 +572,7 @@ static bt_status_t btif_in_fetch_bonded_devices(
           BTA_DmAddDevice(bd_addr, dev_class, link_key, 0, 0,
                           (uint8_t)linkkey_type, 0, pin_length);
 
-          if (btif_config_get_int(name, "DevType", &device_type) &&
-              (device_type == BT_DEVICE_TYPE_DUMO)) {
+          if (device_type == BT_DEVICE_TYPE_DUMO) {
             btif_gatts_add_bonded_dev_from_nv(bd_addr);
           }
         }
@@ -555,6 +592,70 @@ static bt_status_t btif_in_fetch_bonded_devices(
   return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_in_is_bonded_device
+ *
+ * Description      Internal helper function to check if a device is bonded,
+ *                  using the index of the last load before reading NVRAM
+ *
+ * Returns          true if the device is bonded, false otherwise
+ *
+ ******************************************************************************/
+static bool btif_in_is_bonded_device(const char* bdstr, int* p_dev_type) {
+  RawAddress bd_addr;
+  RawAddress::FromString(bdstr, bd_addr);
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    if (bonded_devices_index.count(bd_addr) != 0) {
+      btif_config_get_int(bdstr, "DevType", p_dev_type);
+      return true;
+    }
+  }
+  return btif_in_fetch_bonded_device(bdstr, p_dev_type) == BT_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_in_load_pending_device
+ *
+ * Description      Adds a bonded device deferred at enable to the security
+ *                  database. Called by the stack the first time it looks the
+ *                  device up, e.g. on a connection or a link key request.
+ *
+ * Returns          true if the device was added, false otherwise
+ *
+ ******************************************************************************/
+static bool btif_in_load_pending_device(const RawAddress& bd_addr) {
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    if (pending_bonded_devices.erase(bd_addr) == 0) return false;
+    load_stats.loaded_on_demand++;
+  }
+
+  std::string addrstr = bd_addr.ToString();
+  const char* name = addrstr.c_str();
+  LinkKey link_key;
+  size_t size = link_key.size();
+  int linkkey_type;
+  if (!btif_config_get_bin(name, "LinkKey", link_key.data(), &size) ||
+      !btif_config_get_int(name, "LinkKeyType", &linkkey_type))
+    return false;
+
+  DEV_CLASS dev_class = {0, 0, 0};
+  int cod;
+  int pin_length = 0;
+  if (btif_config_get_int(name, "DevClass", &cod))
+    uint2devclass((uint32_t)cod, dev_class);
+  btif_config_get_int(name, "PinLength", &pin_length);
+
+  BTIF_TRACE_DEBUG("%s: %s", __func__, name);
+  uint32_t trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE] = {0};
+  return BTM_SecAddDevice(bd_addr, dev_class, NULL, NULL, trusted_mask,
+                          &link_key, (uint8_t)linkkey_type, 0,
+                          (uint8_t)pin_length);
+}
+
 static void btif_read_le_key(const uint8_t key_type, const size_t key_len,
                              RawAddress bd_addr, const uint8_t addr_type,
                              const bool add_key, bool* device_added,
@@ -713,7 +814,7 @@ bt_status_t btif_storage_get_adapter_property(bt_property_t* property) {
     int i = 0;
     property->len = 0;
 
-    btif_in_fetch_bonded_devices(&bonded_devices, 0);
+    btif_in_fetch_bonded_devices(&bonded_devices, 0, false);
 
     BTIF_TRACE_DEBUG(
         "%s: Number of bonded devices: %zu "
@@ -940,6 +1041,12 @@ bt_status_t btif_storage_remove_bonded_device(
   const char* bdstr = addrstr.c_str();
   BTIF_TRACE_DEBUG("in bd addr:%s", bdstr);
 
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    bonded_devices_index.erase(*remote_bd_addr);
+    pending_bonded_devices.erase(*remote_bd_addr);
+  }
+
   btif_storage_remove_ble_bonding_keys(remote_bd_addr);
 
   int ret = 1;
@@ -983,6 +1090,8 @@ bt_status_t btif_storage_remove_bonded_device(
     ret &= btif_config_remove(bdstr, "ProductVersion");
   if (btif_config_exist(bdstr, MAP_MCE_VERSION_CONFIG_KEY))
     ret &= btif_config_remove(bdstr, MAP_MCE_VERSION_CONFIG_KEY);
+  if (btif_config_exist(bdstr, SDP_CACHE_CONFIG_KEY))
+    ret &= btif_config_remove(bdstr, SDP_CACHE_CONFIG_KEY);
   /* Retaining TwsPlusPeerAddr , AvrcpCtVersion and AvrcpFeatures
      as these are needed even after unpair */
   /* write bonded info immediately */
@@ -1059,6 +1168,60 @@ bt_status_t btif_storage_is_device_bonded(RawAddress *remote_bd_addr) {
     return BT_STATUS_FAIL;
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_in_report_bonded_remote_properties
+ *
+ * Description      Internal helper function to invoke the
+ *                  remote_device_properties_cb for each of |bonded_devices|
+ *
+ ******************************************************************************/
+static void btif_in_report_bonded_remote_properties(
+    const std::vector<RawAddress>& bonded_devices) {
+  bt_property_t remote_properties[8];
+  bt_bdname_t name, alias;
+  Uuid remote_uuids[BT_MAX_NUM_UUIDS];
+
+  for (const RawAddress& bd_addr : bonded_devices) {
+    RawAddress* p_remote_addr = const_cast<RawAddress*>(&bd_addr);
+
+    /*
+     * TODO: improve handling of missing fields in NVRAM.
+     */
+    uint32_t cod = 0;
+    uint32_t devtype = 0;
+    uint32_t num_props = 0;
+
+    memset(remote_properties, 0, sizeof(remote_properties));
+    BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_BDNAME, &name,
+                                 sizeof(name), remote_properties[num_props]);
+    num_props++;
+
+    BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr,
+                                 BT_PROPERTY_REMOTE_FRIENDLY_NAME, &alias,
+                                 sizeof(alias), remote_properties[num_props]);
+    num_props++;
+
+    BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_CLASS_OF_DEVICE,
+                                 &cod, sizeof(cod),
+                                 remote_properties[num_props]);
+    num_props++;
+
+    BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_TYPE_OF_DEVICE,
+                                 &devtype, sizeof(devtype),
+                                 remote_properties[num_props]);
+    num_props++;
+
+    BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_UUIDS,
+                                 remote_uuids, sizeof(remote_uuids),
+                                 remote_properties[num_props]);
+    num_props++;
+
+    btif_remote_properties_evt(BT_STATUS_SUCCESS, p_remote_addr, num_props,
+                               remote_properties);
+  }
+}
+
 /*******************************************************************************
 **
  * Function         btif_storage_load_bonded_devices
@@ -1068,6 +1231,10 @@ bt_status_t btif_storage_is_device_bonded(RawAddress *remote_bd_addr) {
  *                  Additionally, this API also invokes the adaper_properties_cb
  *                  and remote_device_properties_cb for each of the bonded
  *                  devices.
+ *                  With lazy loading enabled, the BR/EDR only devices are
+ *                  added to the BTA on first use, and the
+ *                  remote_device_properties_cb are invoked after the enable
+ *                  completes.
  *
  * Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
  *
@@ -1077,18 +1244,44 @@ bt_status_t btif_storage_load_bonded_devices(void) {
   uint32_t i = 0;
   bt_property_t adapter_props[6];
   uint32_t num_props = 0;
-  bt_property_t remote_properties[8];
   RawAddress addr;
-  bt_bdname_t name, alias;
+  bt_bdname_t name;
   bt_scan_mode_t mode;
   uint32_t disc_timeout;
   Uuid local_uuids[BT_MAX_NUM_UUIDS];
-  Uuid remote_uuids[BT_MAX_NUM_UUIDS];
   bt_status_t status;
+  char lazy_prop[PROPERTY_VALUE_MAX] = "false";
+
+  osi_property_get(BTIF_STORAGE_LAZY_LOAD_PROPERTY, lazy_prop, "false");
+  bool lazy = !strcmp(lazy_prop, "true");
+  uint64_t start_us = time_get_os_boottime_us();
 
   remove_devices_with_sample_ltk();
 
-  btif_in_fetch_bonded_devices(&bonded_devices, 1);
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    bonded_devices_index.clear();
+    pending_bonded_devices.clear();
+    memset(&load_stats, 0, sizeof(load_stats));
+    load_stats.lazy = lazy;
+  }
+  BTM_SecRegisterDevLoadCallback(lazy ? btif_in_load_pending_device : NULL);
+
+  btif_in_fetch_bonded_devices(&bonded_devices, 1, lazy);
+
+  std::vector<RawAddress> remote_devices;
+  remote_devices.reserve(list_length(bonded_devices));
+  for (list_node_t* node = list_begin(bonded_devices);
+       node != list_end(bonded_devices); node = list_next(node)) {
+    remote_devices.push_back(*(RawAddress*)list_node(node));
+  }
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    bonded_devices_index.insert(remote_devices.begin(), remote_devices.end());
+    load_stats.devices = remote_devices.size();
+    load_stats.deferred = pending_bonded_devices.size();
+  }
+  uint64_t fetch_done_us = time_get_os_boottime_us();
 
   /* Now send the adapter_properties_cb with all adapter_properties */
   {
@@ -1148,56 +1341,60 @@ bt_status_t btif_storage_load_bonded_devices(void) {
 
     osi_free(devices_list);
   }
+  uint64_t adapter_done_us = time_get_os_boottime_us();
 
   BTIF_TRACE_EVENT("%s: %zu bonded devices found", __func__,
                    list_length(bonded_devices));
+  list_free(bonded_devices);
 
-  {
-    for (list_node_t* node = list_begin(bonded_devices);
-         node != list_end(bonded_devices); node = list_next(node)) {
-      RawAddress* p_remote_addr;
-
-      /*
-       * TODO: improve handling of missing fields in NVRAM.
-       */
-      uint32_t cod = 0;
-      uint32_t devtype = 0;
-
-      num_props = 0;
-      p_remote_addr = (RawAddress *)list_node(node);
-      memset(remote_properties, 0, sizeof(remote_properties));
-      BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_BDNAME, &name,
-                                   sizeof(name), remote_properties[num_props]);
-      num_props++;
-
-      BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr,
-                                   BT_PROPERTY_REMOTE_FRIENDLY_NAME, &alias,
-                                   sizeof(alias), remote_properties[num_props]);
-      num_props++;
-
-      BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_CLASS_OF_DEVICE,
-                                   &cod, sizeof(cod),
-                                   remote_properties[num_props]);
-      num_props++;
-
-      BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_TYPE_OF_DEVICE,
-                                   &devtype, sizeof(devtype),
-                                   remote_properties[num_props]);
-      num_props++;
-
-      BTIF_STORAGE_GET_REMOTE_PROP(p_remote_addr, BT_PROPERTY_UUIDS,
-                                   remote_uuids, sizeof(remote_uuids),
-                                   remote_properties[num_props]);
-      num_props++;
+  if (lazy) {
+    /* Runs in this context once the enable has completed */
+    do_in_jni_thread(FROM_HERE,
+                     Bind(&btif_in_report_bonded_remote_properties,
+                          std::move(remote_devices)));
+  } else {
+    btif_in_report_bonded_remote_properties(remote_devices);
+  }
+  uint64_t remote_done_us = time_get_os_boottime_us();
 
-      btif_remote_properties_evt(BT_STATUS_SUCCESS, p_remote_addr, num_props,
-                                 remote_properties);
-    }
+  {
+    std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+    load_stats.fetch_us = fetch_done_us - start_us;
+    load_stats.adapter_us = adapter_done_us - fetch_done_us;
+    load_stats.remote_us = lazy ? 0 : remote_done_us - adapter_done_us;
+    LOG_INFO(LOG_TAG,
+             "%s: %zu devices (%zu deferred) in %llu ms: fetch %llu us, "
+             "adapter properties %llu us, remote properties %llu us",
+             __func__, load_stats.devices, load_stats.deferred,
+             (unsigned long long)((remote_done_us - start_us) / 1000),
+             (unsigned long long)load_stats.fetch_us,
+             (unsigned long long)load_stats.adapter_us,
+             (unsigned long long)load_stats.remote_us);
   }
-  list_free(bonded_devices);
   return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_storage_debug_dump
+ *
+ * Description      BTIF storage API - Dumps the bonded devices load timing
+ *
+ ******************************************************************************/
+void btif_storage_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(bonded_devices_mutex);
+  dprintf(fd, "\nBonded devices load:\n");
+  dprintf(fd, "  Lazy loading                            : %s\n",
+          load_stats.lazy ? "true" : "false");
+  dprintf(fd, "  Devices (total/deferred/loaded on use)  : %zu / %zu / %zu\n",
+          load_stats.devices, load_stats.deferred,
+          load_stats.loaded_on_demand);
+  dprintf(fd, "  Fetch, adapter, remote properties (us)  : %llu, %llu, %llu\n",
+          (unsigned long long)load_stats.fetch_us,
+          (unsigned long long)load_stats.adapter_us,
+          (unsigned long long)load_stats.remote_us);
+}
+
 /*******************************************************************************
  *
  * Function         btif_storage_add_ble_bonding_key
@@ -1547,7 +1744,7 @@ bt_status_t btif_storage_load_bonded_hid_info(void) {
 
     BTIF_TRACE_DEBUG("Remote device:%s", name);
     int value;
-    if (btif_in_fetch_bonded_device(name, &dev_type) == BT_STATUS_SUCCESS) {
+    if (btif_in_is_bonded_device(name, &dev_type)) {
       if (btif_config_get_int(name, "HidAttrMask", &value)) {
         attr_mask = (uint16_t)value;
 
@@ -1715,7 +1912,7 @@ void btif_storage_load_bonded_hearing_aids() {
 
     BTIF_TRACE_DEBUG("Remote device:%s", name);
 
-    if (btif_in_fetch_bonded_device(name, &device_type) != BT_STATUS_SUCCESS) {
+    if (!btif_in_is_bonded_device(name, &device_type)) {
       RawAddress bd_addr;
       RawAddress::FromString(name, bd_addr);
       btif_storage_remove_hearing_aid(bd_addr);
@@ -1893,7 +2090,7 @@ bt_status_t btif_storage_load_hidd(void) {
 
     BTIF_TRACE_DEBUG("Remote device:%s", name);
     int value;
-    if (btif_in_fetch_bonded_device(name, &dev_type) == BT_STATUS_SUCCESS) {
+    if (btif_in_is_bonded_device(name, &dev_type)) {
       if (btif_config_get_int(name, "HidDeviceCabled", &value)) {
         RawAddress bd_addr;
         RawAddress::FromString(name, bd_addr);
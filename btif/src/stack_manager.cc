@@ -114,10 +114,14 @@ static void event_init_stack(void* context) {
 
     module_init(get_module(OSI_MODULE));
     module_init(get_module(BT_UTILS_MODULE));
+
+    // The config files are independent: parse them in parallel
+    const module_t* config_modules[] = {
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-    module_init(get_module(DEVICE_IOT_CONFIG_MODULE));
+        get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
-    module_init(get_module(BTIF_CONFIG_MODULE));
+        get_module(BTIF_CONFIG_MODULE), NULL};
+    module_init_parallel(config_modules);
 
     future_t* local_hack_future = future_new();
     hack_future = local_hack_future;
@@ -156,12 +160,15 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   future_t* local_hack_future = future_new();
   hack_future = local_hack_future;
 
-  // Include this for now to put btif config into a shutdown-able state
-  module_start_up(get_module(BTIF_CONFIG_MODULE));
+  // Include this for now to put btif config into a shutdown-able state.
+  // The config modules start up alongside the HCI bring-up.
+  const module_t* config_modules[] = {
+      get_module(BTIF_CONFIG_MODULE),
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-  module_start_up(get_module(DEVICE_IOT_CONFIG_MODULE));
+      get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
-  bte_main_enable();
+      NULL};
+  bte_main_enable(config_modules);
 
   if (future_await(local_hack_future) != FUTURE_SUCCESS) {
     LOG_ERROR(LOG_TAG, "%s failed to start up the stack", __func__);
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include "btif/include/btif_a2dp_sink_jitter.h"
+
+namespace {
+
+constexpr uint32_t kSampleRate = 44100;
+constexpr uint32_t kTickMs = 20;
+constexpr int kFramesPerTick = 7;
+// 7 SBC frames of 128 samples per media packet
+constexpr uint32_t kSamplesPerPacket = 7 * 128;
+
+}  // namespace
+
+class BtifA2dpSinkJitterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    btif_a2dp_sink_jitter_init(&jb_, kSampleRate, kTickMs);
+  }
+
+  // Receive a packet |late_us| after its nominal arrival time
+  bool Receive(uint32_t index, uint64_t late_us) {
+    uint64_t nominal_us =
+        1000000 + (uint64_t)index * kSamplesPerPacket * 1000000 / kSampleRate;
+    return btif_a2dp_sink_jitter_on_packet(
+        &jb_, 1000 + index * kSamplesPerPacket, nominal_us + late_us);
+  }
+
+  tBTIF_A2DP_SINK_JITTER jb_;
+};
+
+TEST_F(BtifA2dpSinkJitterTest, test_prebuffers_to_target) {
+  EXPECT_EQ(0, btif_a2dp_sink_jitter_on_tick(&jb_, 20, kFramesPerTick));
+  EXPECT_TRUE(jb_.prebuffering);
+  EXPECT_EQ(kFramesPerTick,
+            btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick));
+  EXPECT_FALSE(jb_.prebuffering);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_underrun_restarts_prebuffering) {
+  btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick);
+  btif_a2dp_sink_jitter_on_underrun(&jb_);
+  EXPECT_TRUE(jb_.prebuffering);
+  EXPECT_EQ(1u, jb_.concealment_events);
+  EXPECT_EQ(0, btif_a2dp_sink_jitter_on_tick(&jb_, 0, kFramesPerTick));
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_steady_stream_has_no_jitter) {
+  for (uint32_t i = 0; i < 100; i++) EXPECT_FALSE(Receive(i, 0));
+  EXPECT_EQ(100u, jb_.packets);
+  EXPECT_EQ(0u, jb_.late_packets);
+  // Only the rounding of the media time to microseconds remains
+  EXPECT_LT(jb_.jitter_x16_us / 16, 2u);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_late_packet_raises_target) {
+  for (uint32_t i = 0; i < 10; i++) Receive(i, 0);
+  uint32_t target_ms = jb_.target_ms;
+  EXPECT_TRUE(Receive(10, (target_ms + 40) * 1000));
+  EXPECT_EQ(1u, jb_.late_packets);
+  EXPECT_GT(jb_.target_ms, target_ms + 40);
+  EXPECT_LE(jb_.target_ms, (uint32_t)BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_jitter_raises_target) {
+  for (uint32_t i = 0; i < 200; i++) Receive(i, (i % 2) ? 30000 : 0);
+  EXPECT_GT(jb_.jitter_x16_us / 16, 20000u);
+  btif_a2dp_sink_jitter_on_tick(&jb_, 0, kFramesPerTick);
+  EXPECT_GT(jb_.target_ms, (uint32_t)BTIF_A2DP_SINK_JITTER_MIN_TARGET_MS);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_rtp_timestamp_wraps) {
+  btif_a2dp_sink_jitter_on_packet(&jb_, 0xFFFFFF00, 1000000);
+  uint64_t next_us =
+      1000000 + (uint64_t)kSamplesPerPacket * 1000000 / kSampleRate;
+  EXPECT_FALSE(btif_a2dp_sink_jitter_on_packet(
+      &jb_, 0xFFFFFF00 + kSamplesPerPacket, next_us));
+  EXPECT_EQ(0u, jb_.late_packets);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_deep_queue_plays_faster) {
+  btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick);
+  for (int i = 0; i < 20; i++)
+    btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms + 30, kFramesPerTick);
+  EXPECT_GT(jb_.correction_ppm, 0);
+
+  int16_t pcm[2 * 1000 + 2];
+  size_t frames = 0;
+  for (int i = 0; i < 100 && frames != 999; i++) {
+    for (size_t j = 0; j < 2 * 1000; j++) pcm[j] = 100;
+    frames = btif_a2dp_sink_jitter_compensate(&jb_, pcm, 1000, 2);
+  }
+  EXPECT_EQ(999u, frames);
+  EXPECT_EQ(1u, jb_.samples_dropped);
+  for (size_t j = 0; j < 2 * frames; j++) EXPECT_EQ(100, pcm[j]);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_shallow_queue_plays_slower) {
+  btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick);
+  for (int i = 0; i < 20; i++)
+    btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms - 30, kFramesPerTick);
+  EXPECT_LT(jb_.correction_ppm, 0);
+
+  int16_t pcm[2 * 1000 + 2];
+  size_t frames = 0;
+  for (int i = 0; i < 100 && frames != 1001; i++) {
+    for (size_t j = 0; j < 2 * 1000; j++) pcm[j] = (int16_t)(j / 2);
+    frames = btif_a2dp_sink_jitter_compensate(&jb_, pcm, 1000, 2);
+  }
+  EXPECT_EQ(1001u, frames);
+  EXPECT_EQ(1u, jb_.samples_inserted);
+  // The inserted frame interpolates its neighbours
+  EXPECT_EQ(pcm[2 * 499], 499);
+  EXPECT_EQ(pcm[2 * 500], 499);
+  EXPECT_EQ(pcm[2 * 501], 500);
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_on_target_no_correction) {
+  btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick);
+  for (int i = 0; i < 20; i++)
+    btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms + 2, kFramesPerTick);
+  EXPECT_EQ(0, jb_.correction_ppm);
+
+  int16_t pcm[2 * 1000 + 2] = {};
+  EXPECT_EQ(1000u, btif_a2dp_sink_jitter_compensate(&jb_, pcm, 1000, 2));
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_far_above_target_catches_up) {
+  btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms, kFramesPerTick);
+  EXPECT_EQ(kFramesPerTick + 1,
+            btif_a2dp_sink_jitter_on_tick(&jb_, jb_.target_ms + 5 * kTickMs,
+                                          kFramesPerTick));
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_target_clamped_to_queue_capacity) {
+  // 56 packets of 20 ms hold 1120 ms: the fixed limit still applies
+  btif_a2dp_sink_jitter_set_capacity(&jb_, 56 * 20);
+  EXPECT_EQ((uint32_t)BTIF_A2DP_SINK_JITTER_MAX_TARGET_MS, jb_.max_target_ms);
+
+  // 56 packets of 2 ms only hold 112 ms
+  btif_a2dp_sink_jitter_set_capacity(&jb_, 56 * 2);
+  EXPECT_EQ(56u * 2 - kTickMs, jb_.max_target_ms);
+
+  for (uint32_t i = 0; i < 10; i++) Receive(i, 0);
+  EXPECT_TRUE(Receive(10, 250 * 1000));
+  EXPECT_EQ(jb_.max_target_ms, jb_.target_ms);
+
+  for (uint32_t i = 11; i < 200; i++) Receive(i, (i % 2) ? 80000 : 0);
+  btif_a2dp_sink_jitter_on_tick(&jb_, 0, kFramesPerTick);
+  EXPECT_EQ(jb_.max_target_ms, jb_.target_ms);
+
+  // A full queue ends the prebuffering
+  EXPECT_EQ(kFramesPerTick,
+            btif_a2dp_sink_jitter_on_tick(&jb_, 56 * 2, kFramesPerTick));
+}
+
+TEST_F(BtifA2dpSinkJitterTest, test_small_capacity_lowers_target) {
+  // The queue can't even hold the minimum target
+  btif_a2dp_sink_jitter_set_capacity(&jb_, 40);
+  EXPECT_EQ(kTickMs, jb_.target_ms);
+  EXPECT_EQ(kFramesPerTick,
+            btif_a2dp_sink_jitter_on_tick(&jb_, 40, kFramesPerTick));
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "btif/include/btif_msg_pool.h"
+
+namespace {
+
+tBTIF_MSG_POOL_STATS Stats(size_t class_index) {
+  tBTIF_MSG_POOL_STATS stats;
+  btif_msg_pool_get_stats(class_index, &stats);
+  return stats;
+}
+
+}  // namespace
+
+class BtifMsgPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    btif_msg_pool_flush();
+    for (size_t i = 0; i <= BTIF_MSG_POOL_NUM_CLASSES; i++) {
+      start_[i] = Stats(i);
+    }
+  }
+
+  void TearDown() override { btif_msg_pool_flush(); }
+
+  tBTIF_MSG_POOL_STATS start_[BTIF_MSG_POOL_NUM_CLASSES + 1];
+};
+
+TEST_F(BtifMsgPoolTest, test_reuses_freed_buffer) {
+  void* first = btif_msg_pool_alloc(100);
+  memset(first, 0xaa, 100);
+  btif_msg_pool_free(first);
+  void* second = btif_msg_pool_alloc(60);
+  EXPECT_EQ(first, second);
+  btif_msg_pool_free(second);
+
+  tBTIF_MSG_POOL_STATS stats = Stats(0);
+  EXPECT_EQ(128u, stats.size);
+  EXPECT_EQ(start_[0].misses + 1, stats.misses);
+  EXPECT_EQ(start_[0].hits + 1, stats.hits);
+  EXPECT_EQ(0u, stats.in_use);
+  EXPECT_EQ(1u, stats.free_buffers);
+}
+
+TEST_F(BtifMsgPoolTest, test_size_classes) {
+  void* small = btif_msg_pool_alloc(128);
+  void* medium = btif_msg_pool_alloc(129);
+  void* large = btif_msg_pool_alloc(2048);
+  void* huge = btif_msg_pool_alloc(2049);
+  EXPECT_EQ(1u, Stats(0).in_use);
+  EXPECT_EQ(1u, Stats(1).in_use);
+  EXPECT_EQ(1u, Stats(2).in_use);
+  EXPECT_EQ(1u, Stats(BTIF_MSG_POOL_NUM_CLASSES).in_use);
+  // The whole buffers are usable and aligned
+  memset(small, 0, 128);
+  memset(medium, 0, 512);
+  memset(large, 0, 2048);
+  memset(huge, 0, 2049);
+  EXPECT_EQ(0u, (uintptr_t)medium % alignof(max_align_t));
+
+  btif_msg_pool_free(small);
+  btif_msg_pool_free(medium);
+  btif_msg_pool_free(large);
+  btif_msg_pool_free(huge);
+  // Heap fallbacks are not cached
+  EXPECT_EQ(0u, Stats(BTIF_MSG_POOL_NUM_CLASSES).in_use);
+  EXPECT_EQ(0u, Stats(BTIF_MSG_POOL_NUM_CLASSES).free_buffers);
+  EXPECT_EQ(1u, Stats(2).free_buffers);
+}
+
+TEST_F(BtifMsgPoolTest, test_full_class_releases_to_heap) {
+  // More buffers in flight than the largest class caches
+  void* buffers[16];
+  for (void*& buffer : buffers) buffer = btif_msg_pool_alloc(1000);
+  EXPECT_EQ(16u, Stats(2).max_in_use);
+  for (void* buffer : buffers) btif_msg_pool_free(buffer);
+
+  tBTIF_MSG_POOL_STATS stats = Stats(2);
+  EXPECT_EQ(8u, stats.free_buffers);
+  EXPECT_EQ(start_[2].releases + 8, stats.releases);
+}
+
+TEST_F(BtifMsgPoolTest, test_free_null) { btif_msg_pool_free(NULL); }
@@ -21,6 +21,7 @@
 #include <base/strings/stringprintf.h>
 
 #include "message_loop_thread.h"
+#include "task_latency.h"
 
 namespace bluetooth {
 
@@ -64,7 +65,9 @@ bool MessageLoopThread::DoInThread(const tracked_objects::Location& from_here,
                << ", from " << from_here.ToString();
     return false;
   }
-  if (!message_loop_->task_runner()->PostTask(from_here, std::move(task))) {
+  if (!message_loop_->task_runner()->PostTask(
+          from_here, TrackTaskLatency(from_here, thread_name_.c_str(),
+                                      std::move(task)))) {
     LOG(ERROR) << __func__
                << ": failed to post task to message loop for thread " << *this
                << ", from " << from_here.ToString();
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "task_latency.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <base/logging.h>
+
+namespace bluetooth {
+
+namespace common {
+
+namespace task_latency_internal {
+std::atomic<bool> enabled(false);
+}  // namespace task_latency_internal
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Upper limits of the histogram buckets; the last bucket is unbounded
+constexpr uint64_t kBucketLimitsUs[] = {100, 1000, 5000, 20000, 100000};
+constexpr size_t kBucketCount =
+    sizeof(kBucketLimitsUs) / sizeof(kBucketLimitsUs[0]) + 1;
+constexpr const char* kBucketNames[kBucketCount] = {
+    "<0.1ms", "<1ms", "<5ms", "<20ms", "<100ms", ">=100ms"};
+
+// Number of slow tasks kept for the dump
+constexpr size_t kSlowTaskHistory = 16;
+
+struct Histogram {
+  uint64_t count[kBucketCount] = {};
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+
+  void Add(uint64_t us) {
+    size_t bucket = 0;
+    while (bucket < kBucketCount - 1 && us >= kBucketLimitsUs[bucket]) bucket++;
+    count[bucket]++;
+    total_us += us;
+    max_us = std::max(max_us, us);
+  }
+};
+
+// Event of the tasks not posted as a message
+constexpr uint32_t kNoEvent = UINT32_MAX;
+
+struct SiteStats {
+  std::string loop_name;
+  const char* function_name = nullptr;
+  const char* file_name = nullptr;
+  int line_number = 0;
+  const void* handler = nullptr;
+  uint32_t event = kNoEvent;
+  uint64_t tasks = 0;
+  uint64_t slow_tasks = 0;
+  Histogram queue;
+  Histogram run;
+};
+
+struct SlowTask {
+  std::string loop_name;
+  const char* function_name;
+  const char* file_name;
+  int line_number;
+  const void* handler;
+  uint32_t event;
+  uint64_t queue_us;
+  uint64_t run_us;
+  time_t end_time;
+};
+
+// Call sites are keyed by the loop name, the location, and for messages the
+// handler and the event; the file name of a location is a static string,
+// compared by address
+using SiteKey =
+    std::tuple<std::string, const char*, int, const void*, uint32_t>;
+
+std::atomic<uint64_t> slow_task_us(0);
+std::mutex stats_mutex;
+std::map<SiteKey, SiteStats> site_stats;
+std::vector<SlowTask> slow_task_history;
+size_t slow_task_next = 0;
+
+uint64_t ElapsedUs(Clock::time_point from, Clock::time_point to) {
+  if (to <= from) return 0;
+  return std::chrono::duration_cast<std::chrono::microseconds>(to - from)
+      .count();
+}
+
+// Describe the handler and the event of a message, empty for a plain task
+std::string MessageName(const void* handler, uint32_t event) {
+  if (event == kNoEvent) return "";
+  char name[48];
+  if (handler != nullptr) {
+    snprintf(name, sizeof(name), " handler %p event 0x%04x", handler, event);
+  } else {
+    snprintf(name, sizeof(name), " event 0x%04x", event);
+  }
+  return name;
+}
+
+void Record(const base::Location& from_here, const char* loop_name,
+            const void* handler, uint32_t event, Clock::time_point posted,
+            Clock::time_point start, Clock::time_point end) {
+  uint64_t queue_us = ElapsedUs(posted, start);
+  uint64_t run_us = ElapsedUs(start, end);
+  uint64_t threshold_us = slow_task_us.load(std::memory_order_relaxed);
+  bool slow = threshold_us != 0 && run_us > threshold_us;
+
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    SiteStats& stats =
+        site_stats[SiteKey(loop_name, from_here.file_name(),
+                           from_here.line_number(), handler, event)];
+    if (stats.tasks == 0) {
+      stats.loop_name = loop_name;
+      stats.function_name = from_here.function_name();
+      stats.file_name = from_here.file_name();
+      stats.line_number = from_here.line_number();
+      stats.handler = handler;
+      stats.event = event;
+    }
+    stats.tasks++;
+    stats.queue.Add(queue_us);
+    stats.run.Add(run_us);
+    if (!slow) return;
+
+    stats.slow_tasks++;
+    SlowTask task = {loop_name, from_here.function_name(),
+                     from_here.file_name(), from_here.line_number(),
+                     handler, event, queue_us, run_us, time(nullptr)};
+    if (slow_task_history.size() < kSlowTaskHistory) {
+      slow_task_history.push_back(task);
+    } else {
+      slow_task_history[slow_task_next] = task;
+    }
+    slow_task_next = (slow_task_next + 1) % kSlowTaskHistory;
+  }
+
+  LOG(WARNING) << "Slow task on " << loop_name << " from "
+               << from_here.ToString() << MessageName(handler, event)
+               << ": ran " << run_us / 1000
+               << " ms after waiting " << queue_us / 1000 << " ms";
+}
+
+void RunTracked(const base::Location& from_here, const char* loop_name,
+                const void* handler, uint32_t event, Clock::time_point posted,
+                const base::Closure& task) {
+  Clock::time_point start = Clock::now();
+  task.Run();
+  Record(from_here, loop_name, handler, event, posted, start, Clock::now());
+}
+
+void RunTrackedOnce(const base::Location& from_here, const char* loop_name,
+                    Clock::time_point posted, base::OnceClosure task) {
+  Clock::time_point start = Clock::now();
+  std::move(task).Run();
+  Record(from_here, loop_name, nullptr, kNoEvent, posted, start,
+         Clock::now());
+}
+
+void DumpHistogram(int fd, const char* name, const Histogram& histogram,
+                   uint64_t tasks) {
+  dprintf(fd, "      %-5s avg %6.2f ms, max %7.2f ms :", name,
+          tasks ? histogram.total_us / 1000.0 / tasks : 0.0,
+          histogram.max_us / 1000.0);
+  for (size_t i = 0; i < kBucketCount; i++) {
+    dprintf(fd, " %s %llu", kBucketNames[i],
+            (unsigned long long)histogram.count[i]);
+  }
+  dprintf(fd, "\n");
+}
+
+}  // namespace
+
+void TaskLatencySetSlowThreshold(uint32_t slow_task_ms) {
+  slow_task_us = (uint64_t)slow_task_ms * 1000;
+  task_latency_internal::enabled = slow_task_ms != 0;
+}
+
+base::Closure TrackTaskLatency(const base::Location& from_here,
+                               const char* loop_name, base::Closure task) {
+  if (!TaskLatencyIsEnabled()) return task;
+  return base::Bind(&RunTracked, from_here, loop_name, nullptr, kNoEvent,
+                    Clock::now(), std::move(task));
+}
+
+base::OnceClosure TrackTaskLatency(const base::Location& from_here,
+                                   const char* loop_name,
+                                   base::OnceClosure task) {
+  if (!TaskLatencyIsEnabled()) return task;
+  return base::BindOnce(&RunTrackedOnce, from_here, loop_name, Clock::now(),
+                        std::move(task));
+}
+
+base::Closure TrackTaskLatency(const base::Location& from_here,
+                               const char* loop_name, const void* handler,
+                               uint32_t event, base::Closure task) {
+  if (!TaskLatencyIsEnabled()) return task;
+  return base::Bind(&RunTracked, from_here, loop_name, handler, event,
+                    Clock::now(), std::move(task));
+}
+
+void TaskLatencyReset() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  site_stats.clear();
+  slow_task_history.clear();
+  slow_task_next = 0;
+}
+
+void TaskLatencyDebugDump(int fd) {
+  dprintf(fd, "\nTask Latency:\n");
+  if (!TaskLatencyIsEnabled()) {
+    dprintf(fd, "  Disabled\n");
+    return;
+  }
+  dprintf(fd, "  Slow task threshold: %llu ms\n",
+          (unsigned long long)(slow_task_us / 1000));
+
+  std::lock_guard<std::mutex> lock(stats_mutex);
+
+  // Busiest call sites first
+  std::vector<const SiteStats*> sites;
+  for (const auto& entry : site_stats) sites.push_back(&entry.second);
+  std::sort(sites.begin(), sites.end(),
+            [](const SiteStats* a, const SiteStats* b) {
+              return a->run.total_us > b->run.total_us;
+            });
+
+  dprintf(fd, "  Call sites: %zu\n", sites.size());
+  for (const SiteStats* stats : sites) {
+    dprintf(fd, "    %s: %s@%s:%d%s tasks %llu, slow %llu\n",
+            stats->loop_name.c_str(), stats->function_name, stats->file_name,
+            stats->line_number,
+            MessageName(stats->handler, stats->event).c_str(),
+            (unsigned long long)stats->tasks,
+            (unsigned long long)stats->slow_tasks);
+    DumpHistogram(fd, "queue", stats->queue, stats->tasks);
+    DumpHistogram(fd, "run", stats->run, stats->tasks);
+  }
+
+  dprintf(fd, "  Last slow tasks: %zu\n", slow_task_history.size());
+  for (size_t i = 0; i < slow_task_history.size(); i++) {
+    // Oldest first
+    size_t index = slow_task_history.size() < kSlowTaskHistory
+                       ? i
+                       : (slow_task_next + i) % kSlowTaskHistory;
+    const SlowTask& task = slow_task_history[index];
+    struct tm tm;
+    char time_str[32];
+    localtime_r(&task.end_time, &tm);
+    strftime(time_str, sizeof(time_str), "%m-%d %H:%M:%S", &tm);
+    dprintf(fd, "    %s %s: %s@%s:%d%s queue %.2f ms, run %.2f ms\n",
+            time_str, task.loop_name.c_str(), task.function_name,
+            task.file_name, task.line_number,
+            MessageName(task.handler, task.event).c_str(),
+            task.queue_us / 1000.0, task.run_us / 1000.0);
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
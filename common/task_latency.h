@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <base/bind.h>
+#include <base/callback.h>
+#include <base/location.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * Opt-in latency tracking of the tasks posted to the stack message loops.
+ *
+ * When enabled, a posted task is wrapped so that the time it waits in the
+ * queue and the time it runs are recorded, aggregated per call site (the
+ * posting location) and per message loop. Tasks that run longer than the
+ * slow threshold are logged and kept in a short history for the dump.
+ *
+ * When disabled, TrackTaskLatency() returns the task unchanged, so the only
+ * cost is one relaxed atomic load per post.
+ */
+
+namespace task_latency_internal {
+extern std::atomic<bool> enabled;
+}  // namespace task_latency_internal
+
+/**
+ * Enable or disable the tracking. Tasks already posted are not affected.
+ *
+ * @param slow_task_ms tasks running longer than this are flagged; 0 disables
+ * the tracking
+ */
+void TaskLatencySetSlowThreshold(uint32_t slow_task_ms);
+
+/**
+ * Return true if the tracking is enabled
+ */
+inline bool TaskLatencyIsEnabled() {
+  return task_latency_internal::enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Wrap |task|, posted from |from_here| to the message loop |loop_name|, so
+ * its latency is recorded when it runs. Returns |task| unchanged when the
+ * tracking is disabled.
+ */
+base::Closure TrackTaskLatency(const base::Location& from_here,
+                               const char* loop_name, base::Closure task);
+base::OnceClosure TrackTaskLatency(const base::Location& from_here,
+                                   const char* loop_name,
+                                   base::OnceClosure task);
+
+/**
+ * Wrap |task|, a message posted by a dispatch function such as
+ * bta_sys_sendmsg(), so its latency is recorded per |handler| and |event|
+ * rather than per |from_here|, the location of the dispatch function shared by
+ * all its messages.
+ *
+ * @param handler the function the message is dispatched to, or nullptr when
+ * |event| alone identifies the message
+ * @param event the event id of the message
+ */
+base::Closure TrackTaskLatency(const base::Location& from_here,
+                               const char* loop_name, const void* handler,
+                               uint32_t event, base::Closure task);
+
+/**
+ * Clear the recorded statistics
+ */
+void TaskLatencyReset();
+
+/**
+ * Dump the per call site statistics to the file descriptor |fd|
+ */
+void TaskLatencyDebugDump(int fd);
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "task_latency.h"
+
+using bluetooth::common::TaskLatencyDebugDump;
+using bluetooth::common::TaskLatencyIsEnabled;
+using bluetooth::common::TaskLatencyReset;
+using bluetooth::common::TaskLatencySetSlowThreshold;
+using bluetooth::common::TrackTaskLatency;
+
+static constexpr char kLoopName[] = "test_loop";
+
+static void Increment(int* counter) { (*counter)++; }
+
+static void SleepAndIncrement(int* counter) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  (*counter)++;
+}
+
+static std::string Dump() {
+  FILE* file = tmpfile();
+  TaskLatencyDebugDump(fileno(file));
+  rewind(file);
+  std::string output;
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), file) != nullptr) output += buffer;
+  fclose(file);
+  return output;
+}
+
+class TaskLatencyTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    TaskLatencySetSlowThreshold(0);
+    TaskLatencyReset();
+  }
+};
+
+TEST_F(TaskLatencyTest, test_disabled_runs_task_untracked) {
+  EXPECT_FALSE(TaskLatencyIsEnabled());
+  int counter = 0;
+  base::Closure task =
+      TrackTaskLatency(FROM_HERE, kLoopName, base::Bind(&Increment, &counter));
+  task.Run();
+  EXPECT_EQ(1, counter);
+  EXPECT_NE(std::string::npos, Dump().find("Disabled"));
+}
+
+TEST_F(TaskLatencyTest, test_records_call_site) {
+  TaskLatencySetSlowThreshold(1000);
+  EXPECT_TRUE(TaskLatencyIsEnabled());
+  int counter = 0;
+  for (int i = 0; i < 3; i++) {
+    TrackTaskLatency(FROM_HERE, kLoopName,
+                     base::BindOnce(&Increment, &counter))
+        .Run();
+  }
+  EXPECT_EQ(3, counter);
+  std::string dump = Dump();
+  EXPECT_NE(std::string::npos, dump.find("Call sites: 1"));
+  EXPECT_NE(std::string::npos, dump.find("tasks 3, slow 0"));
+}
+
+TEST_F(TaskLatencyTest, test_flags_slow_task) {
+  TaskLatencySetSlowThreshold(5);
+  int counter = 0;
+  TrackTaskLatency(FROM_HERE, kLoopName,
+                   base::Bind(&SleepAndIncrement, &counter))
+      .Run();
+  EXPECT_EQ(1, counter);
+  std::string dump = Dump();
+  EXPECT_NE(std::string::npos, dump.find("tasks 1, slow 1"));
+  EXPECT_NE(std::string::npos, dump.find("Last slow tasks: 1"));
+}
+
+TEST_F(TaskLatencyTest, test_messages_tracked_by_event) {
+  TaskLatencySetSlowThreshold(1000);
+  int counter = 0;
+  int handler = 0;
+  // Messages posted from the same location are told apart by their handler
+  // and event
+  for (uint32_t event : {0x1201u, 0x1202u, 0x1201u}) {
+    TrackTaskLatency(FROM_HERE, kLoopName, nullptr, event,
+                     base::Bind(&Increment, &counter))
+        .Run();
+    TrackTaskLatency(FROM_HERE, kLoopName, &handler, event,
+                     base::Bind(&Increment, &counter))
+        .Run();
+  }
+  EXPECT_EQ(6, counter);
+  std::string dump = Dump();
+  EXPECT_NE(std::string::npos, dump.find("Call sites: 4"));
+  EXPECT_NE(std::string::npos, dump.find(" event 0x1201 tasks 2, slow 0"));
+  EXPECT_NE(std::string::npos, dump.find(" event 0x1202 tasks 1, slow 0"));
+  EXPECT_NE(std::string::npos, dump.find(" handler "));
+}
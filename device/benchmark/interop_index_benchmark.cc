@@ -0,0 +1,156 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Lookups in the interop workaround databases: linear scan of the entries,
+// as done before the index, against the compiled interop index.
+//
+// The name lookups run over the whole interop_name_database. The address
+// database of the tree is small, so the address lookups run over a
+// synthetic database of OUI and 4-byte prefixes spread over the features,
+// of the size given as argument.
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <vector>
+
+#include "device/include/interop_database.h"
+#include "device/include/interop_index.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Features the synthetic address entries are spread over
+constexpr int kNumAddrFeatures = 32;
+
+std::vector<interop_addr_entry_t> make_addr_database(size_t size) {
+  std::vector<interop_addr_entry_t> database(size);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    interop_addr_entry_t& entry = database[i];
+    memset(&entry.addr, 0, sizeof(entry.addr));
+    entry.addr.address[0] = (uint8_t)(seed >> 24);
+    entry.addr.address[1] = (uint8_t)(seed >> 16);
+    entry.addr.address[2] = (uint8_t)(seed >> 8);
+    entry.addr.address[3] = (uint8_t)i;
+    entry.length = (i % 4 == 0) ? 4 : 3;
+    entry.feature = (interop_feature_t)(i % kNumAddrFeatures);
+  }
+  return database;
+}
+
+bool linear_match_addr(const std::vector<interop_addr_entry_t>& database,
+                       interop_feature_t feature, const RawAddress* addr) {
+  for (const interop_addr_entry_t& entry : database) {
+    if (feature == entry.feature &&
+        memcmp(addr, &entry.addr, entry.length) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool linear_match_name(interop_feature_t feature, const char* name) {
+  for (const interop_name_entry_t& entry : interop_name_database) {
+    if (feature == entry.feature && strlen(name) >= entry.length &&
+        strncmp(name, entry.name, entry.length) == 0)
+      return true;
+  }
+  return false;
+}
+
+// Lookup addresses: one hit in the last entry, then misses
+std::vector<RawAddress> make_lookups(
+    const std::vector<interop_addr_entry_t>& database) {
+  std::vector<RawAddress> lookups;
+  RawAddress hit = database.back().addr;
+  hit.address[5] = 0x42;
+  lookups.push_back(hit);
+  for (uint8_t i = 0; i < 7; i++) {
+    RawAddress miss = hit;
+    miss.address[1] ^= 0x5a + i;
+    lookups.push_back(miss);
+  }
+  return lookups;
+}
+
+const char* const kNames[] = {"Microsoft Sculpt Touch Mouse", "Caramel",
+                              "Pixel 3", "KMM-BT518HD", "JBL Flip 4"};
+
+}  // namespace
+
+// Argument: number of address entries
+static void BM_MatchAddrLinear(State& state) {
+  std::vector<interop_addr_entry_t> database =
+      make_addr_database(state.range(0));
+  std::vector<RawAddress> lookups = make_lookups(database);
+  interop_feature_t feature = database.back().feature;
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        linear_match_addr(database, feature, &lookups[i++ % lookups.size()]));
+  }
+}
+BENCHMARK(BM_MatchAddrLinear)->Arg(64)->Arg(512)->Arg(2048);
+
+static void BM_MatchAddrIndex(State& state) {
+  std::vector<interop_addr_entry_t> database =
+      make_addr_database(state.range(0));
+  std::vector<RawAddress> lookups = make_lookups(database);
+  interop_feature_t feature = database.back().feature;
+  interop_index_t* index = interop_index_new();
+  for (const interop_addr_entry_t& entry : database)
+    interop_index_add_addr(index, entry.feature, &entry.addr, entry.length);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interop_index_match_addr(
+        index, feature, &lookups[i++ % lookups.size()]));
+  }
+  interop_index_free(index);
+}
+BENCHMARK(BM_MatchAddrIndex)->Arg(64)->Arg(512)->Arg(2048);
+
+static void BM_MatchNameLinear(State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(linear_match_name(
+        INTEROP_DISABLE_SDP_AFTER_PAIRING,
+        kNames[i++ % (sizeof(kNames) / sizeof(kNames[0]))]));
+  }
+}
+BENCHMARK(BM_MatchNameLinear);
+
+static void BM_MatchNameIndex(State& state) {
+  interop_index_t* index = interop_index_new();
+  for (const interop_name_entry_t& entry : interop_name_database)
+    interop_index_add_name(index, entry.feature, entry.name, entry.length);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interop_index_match_name(
+        index, INTEROP_DISABLE_SDP_AFTER_PAIRING,
+        kNames[i++ % (sizeof(kNames) / sizeof(kNames[0]))]));
+  }
+  interop_index_free(index);
+}
+BENCHMARK(BM_MatchNameIndex);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
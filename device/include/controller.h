@@ -114,3 +114,6 @@ const controller_t* controller_get_test_interface(
     const hci_packet_parser_t* packet_parser_interface);
 
 bool is_soc_lpa_enh_pwr_enabled();
+
+// Dump the controller start-up command timings to the file descriptor |fd|.
+void controller_debug_dump(int fd);
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "device/include/interop.h"
+#include "raw_address.h"
+
+// Compiled index of interoperability workarounds.
+//
+// Address and name entries match by prefix: an entry applies to every
+// address or name that starts with its bytes. They are kept in prefix
+// tries, one per feature, so a lookup walks at most one node per byte of
+// the address or name, whatever the number of entries. Manufacturer entries
+// are kept in a hash set.
+//
+// An index isn't thread safe: it is meant to be built once, then only
+// looked up, or to be updated and looked up from the same thread.
+
+typedef struct interop_index_t interop_index_t;
+
+// Create an empty index. Free it with |interop_index_free|.
+interop_index_t* interop_index_new(void);
+
+// Free |index|; |index| may be NULL.
+void interop_index_free(interop_index_t* index);
+
+// Remove all the entries of |index|.
+void interop_index_clear(interop_index_t* index);
+
+// Add the workaround |feature| for the devices whose address starts with the
+// first |length| bytes of |addr|. |length| must be at most
+// RawAddress::kLength.
+void interop_index_add_addr(interop_index_t* index,
+                            const interop_feature_t feature,
+                            const RawAddress* addr, size_t length);
+
+// Add the workaround |feature| for the devices whose name starts with the
+// first |length| characters of |name|.
+void interop_index_add_name(interop_index_t* index,
+                            const interop_feature_t feature, const char* name,
+                            size_t length);
+
+// Add the workaround |feature| for the devices of |manufacturer|.
+void interop_index_add_manufacturer(interop_index_t* index,
+                                    const interop_feature_t feature,
+                                    uint16_t manufacturer);
+
+// Return true if an address entry of |index| for |feature| matches |addr|.
+bool interop_index_match_addr(const interop_index_t* index,
+                              const interop_feature_t feature,
+                              const RawAddress* addr);
+
+// Return true if a name entry of |index| for |feature| matches |name|,
+// a null terminated string.
+bool interop_index_match_name(const interop_index_t* index,
+                              const interop_feature_t feature,
+                              const char* name);
+
+// Return true if |index| has the workaround |feature| for |manufacturer|.
+bool interop_index_match_manufacturer(const interop_index_t* index,
+                                      const interop_feature_t feature,
+                                      uint16_t manufacturer);
+
+// Return the number of entries in |index|.
+size_t interop_index_size(const interop_index_t* index);
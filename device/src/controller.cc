@@ -29,6 +29,7 @@
 #include "hcimsgs.h"
 #include "osi/include/future.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "stack/include/btm_ble_api.h"
 #include "osi/include/log.h"
 #include "utils/include/bt_utils.h"
@@ -114,8 +115,46 @@ static void *bt_configstore_lib_handle = NULL;
 
 static int load_bt_configstore_lib();
 
-#define AWAIT_COMMAND(command) \
-  static_cast<BT_HDR*>(future_await(hci->transmit_command_futured(command)))
+// Start-up commands, timed for the debug dump. Commands issued back to back
+// are pipelined: the HCI layer sends each of them as soon as the controller
+// has a command credit for it, and the responses are awaited afterwards.
+#define START_UP_MAX_STEPS 32
+
+typedef struct {
+  const char* name;
+  future_t* future;
+  uint64_t issued_us; /* since the beginning of start_up */
+  uint64_t done_us;   /* since the beginning of start_up */
+} start_up_step_t;
+
+static start_up_step_t start_up_steps[START_UP_MAX_STEPS];
+static size_t start_up_steps_n;
+static size_t start_up_in_flight;
+static size_t start_up_max_in_flight;
+static uint64_t start_up_begin_us;
+static uint64_t start_up_total_us;
+
+static start_up_step_t* issue_command(const char* name, BT_HDR* command) {
+  CHECK(start_up_steps_n < START_UP_MAX_STEPS);
+  start_up_step_t* step = &start_up_steps[start_up_steps_n++];
+  step->name = name;
+  step->issued_us = time_get_os_boottime_us() - start_up_begin_us;
+  step->done_us = 0;
+  step->future = hci->transmit_command_futured(command);
+  if (++start_up_in_flight > start_up_max_in_flight)
+    start_up_max_in_flight = start_up_in_flight;
+  return step;
+}
+
+static BT_HDR* await_command(start_up_step_t* step) {
+  BT_HDR* response = static_cast<BT_HDR*>(future_await(step->future));
+  step->future = NULL;
+  step->done_us = time_get_os_boottime_us() - start_up_begin_us;
+  start_up_in_flight--;
+  return response;
+}
+
+#define AWAIT_COMMAND(name, command) await_command(issue_command(name, command))
 
 // Module lifecycle functions
 
@@ -184,6 +223,12 @@ static future_t* start_up(void) {
   soc_add_on_features_length = 0;
   host_add_on_features_length = 0;
 
+  start_up_begin_us = time_get_os_boottime_us();
+  start_up_total_us = 0;
+  start_up_steps_n = 0;
+  start_up_in_flight = 0;
+  start_up_max_in_flight = 0;
+
 // read properties  for offtarget test setup
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
    char bt_soc_type[PROPERTY_VALUE_MAX];
@@ -277,58 +322,63 @@ static future_t* start_up(void) {
   }
 #endif  /* OFF_TARGET_TEST_ENABLED */
   // Send the initial reset command
-  response = AWAIT_COMMAND(packet_factory->make_reset());
+  response = AWAIT_COMMAND("reset", packet_factory->make_reset());
   packet_parser->parse_generic_command_complete(response);
 
-  // Request the classic buffer size next
-  response = AWAIT_COMMAND(packet_factory->make_read_buffer_size());
-  packet_parser->parse_read_buffer_size_response(
-      response, &acl_data_size_classic, &acl_buffer_count_classic);
-
-  // Tell the controller about our buffer sizes and buffer counts next
+  // The local information reads only depend on the reset: send them, and the
+  // host buffer size, in one batch
   // TODO(zachoverflow): factor this out. eww l2cap contamination. And why just
   // a hardcoded 10?
-  response = AWAIT_COMMAND(packet_factory->make_host_buffer_size(
-      L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
-
-  packet_parser->parse_generic_command_complete(response);
+  start_up_step_t* buffer_size_step = issue_command(
+      "read_buffer_size", packet_factory->make_read_buffer_size());
+  start_up_step_t* host_buffer_size_step =
+      issue_command("host_buffer_size",
+                    packet_factory->make_host_buffer_size(
+                        L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE,
+                        L2CAP_HOST_FC_ACL_BUFS, 10));
+  start_up_step_t* version_step =
+      issue_command("read_local_version_info",
+                    packet_factory->make_read_local_version_info());
+  start_up_step_t* bd_addr_step =
+      issue_command("read_bd_addr", packet_factory->make_read_bd_addr());
+  start_up_step_t* supported_commands_step =
+      issue_command("read_local_supported_commands",
+                    packet_factory->make_read_local_supported_commands());
+  uint8_t page_number = 0;
+  start_up_step_t* features_page_0_step =
+      issue_command("read_local_extended_features",
+                    packet_factory->make_read_local_extended_features(0));
 
-  if (is_soc_logging_enabled()) {
-    LOG_INFO(LOG_TAG, "%s Send command to enable soc logging ", __func__);
-    send_soc_log_command(true);
+  char donglemode_prop[PROPERTY_VALUE_MAX] = "false";
+  start_up_step_t* offload_features_step = NULL;
+  if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
+      !strcmp(donglemode_prop, "false")) {
+    // read BLE offload features support from controller
+    offload_features_step =
+        issue_command("ble_read_offload_features_support",
+                      packet_factory->make_ble_read_offload_features_support());
   }
 
-  if (soc_type == BT_SOC_TYPE_SMD || soc_type == BT_SOC_TYPE_CHEROKEE) {
-    char donglemode_prop[PROPERTY_VALUE_MAX] = "false";
-    if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
-        !strcmp(donglemode_prop, "false")) {
-      btm_enable_soc_iot_info_report(is_iot_info_report_enabled());
-    }
-  }
+  response = await_command(buffer_size_step);
+  packet_parser->parse_read_buffer_size_response(
+      response, &acl_data_size_classic, &acl_buffer_count_classic);
 
-  if (is_soc_lpa_enh_pwr_enabled()) {
-    btm_enable_link_lpa_enh_pwr_ctrl((uint16_t)HCI_INVALID_HANDLE, true);
-  }
+  response = await_command(host_buffer_size_step);
+  packet_parser->parse_generic_command_complete(response);
 
-  // Read the local version info off the controller next, including
-  // information such as manufacturer and supported HCI version
-  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
+  // Read the local version info, including information such as manufacturer
+  // and supported HCI version
+  response = await_command(version_step);
   packet_parser->parse_read_local_version_info_response(response, &bt_version);
 
-  // Read the bluetooth address off the controller next
-  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
+  response = await_command(bd_addr_step);
   packet_parser->parse_read_bd_addr_response(response, &address);
 
-  // Request the controller's supported commands next
-  response =
-      AWAIT_COMMAND(packet_factory->make_read_local_supported_commands());
+  response = await_command(supported_commands_step);
   packet_parser->parse_read_local_supported_commands_response(
       response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
 
-  // Read page 0 of the controller features next
-  uint8_t page_number = 0;
-  response = AWAIT_COMMAND(
-      packet_factory->make_read_local_extended_features(page_number));
+  response = await_command(features_page_0_step);
   packet_parser->parse_read_local_extended_features_response(
       response, &page_number, &last_features_classic_page_index,
       features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
@@ -336,34 +386,69 @@ static future_t* start_up(void) {
   CHECK(page_number == 0);
   page_number++;
 
+  if (offload_features_step != NULL) {
+    response = await_command(offload_features_step);
+    packet_parser->parse_ble_read_offload_features_response(
+        response, &ble_offload_features_supported);
+  }
+
+  if (is_soc_logging_enabled()) {
+    LOG_INFO(LOG_TAG, "%s Send command to enable soc logging ", __func__);
+    send_soc_log_command(true);
+  }
+
+  if (soc_type == BT_SOC_TYPE_SMD || soc_type == BT_SOC_TYPE_CHEROKEE) {
+    if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
+        !strcmp(donglemode_prop, "false")) {
+      btm_enable_soc_iot_info_report(is_iot_info_report_enabled());
+    }
+  }
+
+  if (is_soc_lpa_enh_pwr_enabled()) {
+    btm_enable_link_lpa_enh_pwr_ctrl((uint16_t)HCI_INVALID_HANDLE, true);
+  }
+
   // Inform the controller what page 0 features we support, based on what
   // it told us it supports. We need to do this first before we request the
   // next page, because the controller's response for page 1 may be
   // dependent on what we configure from page 0
   simple_pairing_supported =
       HCI_SIMPLE_PAIRING_SUPPORTED(features_classic[0].as_array);
+  start_up_step_t* simple_pairing_mode_step = NULL;
   if (simple_pairing_supported) {
-    response = AWAIT_COMMAND(
+    simple_pairing_mode_step = issue_command(
+        "write_simple_pairing_mode",
         packet_factory->make_write_simple_pairing_mode(HCI_SP_MODE_ENABLED));
-    packet_parser->parse_generic_command_complete(response);
   }
 
+  start_up_step_t* le_host_support_step = NULL;
   if (HCI_LE_SPT_SUPPORTED(features_classic[0].as_array)) {
-    response = AWAIT_COMMAND(packet_factory->make_ble_write_host_support(
-        BTM_BLE_HOST_SUPPORT, BTM_BLE_SIMULTANEOUS_HOST));
-
-    packet_parser->parse_generic_command_complete(response);
+    le_host_support_step =
+        issue_command("ble_write_host_support",
+                      packet_factory->make_ble_write_host_support(
+                          BTM_BLE_HOST_SUPPORT, BTM_BLE_SIMULTANEOUS_HOST));
 
     // If we modified the BT_HOST_SUPPORT, we will need ext. feat. page 1
     if (last_features_classic_page_index < 1)
       last_features_classic_page_index = 1;
   }
 
+  if (simple_pairing_mode_step != NULL) {
+    response = await_command(simple_pairing_mode_step);
+    packet_parser->parse_generic_command_complete(response);
+  }
+
+  if (le_host_support_step != NULL) {
+    response = await_command(le_host_support_step);
+    packet_parser->parse_generic_command_complete(response);
+  }
+
   // Done telling the controller about what page 0 features we support
   // Request the remaining feature pages
   while (page_number <= last_features_classic_page_index &&
          page_number < MAX_FEATURES_CLASSIC_PAGE_COUNT) {
     response = AWAIT_COMMAND(
+        "read_local_extended_features",
         packet_factory->make_read_local_extended_features(page_number));
     packet_parser->parse_read_local_extended_features_response(
         response, &page_number, &last_features_classic_page_index,
@@ -372,14 +457,6 @@ static future_t* start_up(void) {
     page_number++;
   }
 
-  char donglemode_prop[PROPERTY_VALUE_MAX] = "false";
-  if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
-      !strcmp(donglemode_prop, "false")) {
-    // read BLE offload features support from controller
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_offload_features_support());
-    packet_parser->parse_ble_read_offload_features_response(response, &ble_offload_features_supported);
-  }
-
 #if (SC_MODE_INCLUDED == TRUE)
   if(ble_offload_features_supported) {
     secure_connections_supported =
@@ -391,6 +468,7 @@ static future_t* start_up(void) {
     }
     if (secure_connections_supported && !pts_secure_connections_host_supported_disabled) {
       response = AWAIT_COMMAND(
+          "write_secure_connections_host_support",
           packet_factory->make_write_secure_connections_host_support(
               HCI_SC_MODE_ENABLED));
       packet_parser->parse_generic_command_complete(response);
@@ -398,94 +476,154 @@ static future_t* start_up(void) {
   }
 #endif
 
+  // The LE reads depend on the feature pages, the codecs and the simple
+  // pairing options only on the supported commands: send them in one batch
   ble_supported = last_features_classic_page_index >= 1 &&
                   HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
+  start_up_step_t* white_list_size_step = NULL;
+  start_up_step_t* ble_buffer_size_step = NULL;
+  start_up_step_t* supported_states_step = NULL;
+  start_up_step_t* ble_features_step = NULL;
+  if (ble_supported) {
+    white_list_size_step =
+        issue_command("ble_read_white_list_size",
+                      packet_factory->make_ble_read_white_list_size());
+    ble_buffer_size_step = issue_command(
+        "ble_read_buffer_size", packet_factory->make_ble_read_buffer_size());
+    supported_states_step =
+        issue_command("ble_read_supported_states",
+                      packet_factory->make_ble_read_supported_states());
+    ble_features_step =
+        issue_command("ble_read_local_supported_features",
+                      packet_factory->make_ble_read_local_supported_features());
+  }
+
+  start_up_step_t* codecs_step = NULL;
+  if (HCI_READ_LOCAL_CODECS_SUPPORTED(supported_commands)) {
+    codecs_step =
+        issue_command("read_local_supported_codecs",
+                      packet_factory->make_read_local_supported_codecs());
+  }
+
+  read_simple_pairing_options_supported =
+      HCI_READ_LOCAL_SIMPLE_PAIRING_OPTIONS_SUPPORTED(supported_commands);
+  start_up_step_t* simple_pairing_options_step = NULL;
+  if (read_simple_pairing_options_supported) {
+    LOG_DEBUG(LOG_TAG, "%s read local simple pairing options", __func__);
+    simple_pairing_options_step =
+        issue_command("read_local_simple_pairing_options",
+                      packet_factory->make_read_local_simple_pairing_options());
+  }
+
   if (ble_supported) {
-    // Request the ble white list size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_white_list_size());
+    response = await_command(white_list_size_step);
     packet_parser->parse_ble_read_white_list_size_response(
         response, &ble_white_list_size);
 
-    // Request the ble buffer size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size());
+    response = await_command(ble_buffer_size_step);
     packet_parser->parse_ble_read_buffer_size_response(
         response, &acl_data_size_ble, &acl_buffer_count_ble);
 
     // Response of 0 indicates ble has the same buffer size as classic
     if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
 
-    // Request the ble supported states next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_supported_states());
+    response = await_command(supported_states_step);
     packet_parser->parse_ble_read_supported_states_response(
         response, ble_supported_states, sizeof(ble_supported_states));
 
-    // Request the ble supported features next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_read_local_supported_features());
+    response = await_command(ble_features_step);
     packet_parser->parse_ble_read_local_supported_features_response(
         response, &features_ble);
+  }
+
+  if (codecs_step != NULL) {
+    response = await_command(codecs_step);
+    packet_parser->parse_read_local_supported_codecs_response(
+        response, &number_of_local_supported_codecs, local_supported_codecs);
+  }
 
+  if (simple_pairing_options_step != NULL) {
+    response = await_command(simple_pairing_options_step);
+    packet_parser->parse_read_local_simple_paring_options_response(
+        response, &simple_pairing_options, &maximum_encryption_key_size);
+    LOG_DEBUG(LOG_TAG, "%s simple pairing options is 0x%x", __func__,
+        simple_pairing_options);
+  }
+
+  // The reads that depend on the LE features, and the event masks, go in
+  // the last batch
+  start_up_step_t* resolving_list_size_step = NULL;
+  start_up_step_t* data_length_step = NULL;
+  start_up_step_t* max_adv_data_length_step = NULL;
+  start_up_step_t* adv_sets_step = NULL;
+  start_up_step_t* ble_event_mask_step = NULL;
+  if (ble_supported) {
     if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
-      response =
-          AWAIT_COMMAND(packet_factory->make_ble_read_resolving_list_size());
-      packet_parser->parse_ble_read_resolving_list_size_response(
-          response, &ble_resolving_list_max_size);
+      resolving_list_size_step =
+          issue_command("ble_read_resolving_list_size",
+                        packet_factory->make_ble_read_resolving_list_size());
     }
 
     if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
+      data_length_step = issue_command(
+          "ble_read_suggested_default_data_length",
           packet_factory->make_ble_read_suggested_default_data_length());
-      packet_parser->parse_ble_read_suggested_default_data_length_response(
-          response, &ble_suggested_default_data_length);
     }
 
     if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
+      max_adv_data_length_step = issue_command(
+          "ble_read_maximum_advertising_data_length",
           packet_factory->make_ble_read_maximum_advertising_data_length());
-      packet_parser->parse_ble_read_maximum_advertising_data_length(
-          response, &ble_maxium_advertising_data_length);
-
-      response = AWAIT_COMMAND(
+      adv_sets_step = issue_command(
+          "ble_read_number_of_supported_advertising_sets",
           packet_factory->make_ble_read_number_of_supported_advertising_sets());
-      packet_parser->parse_ble_read_number_of_supported_advertising_sets(
-          response, &ble_number_of_supported_advertising_sets);
     } else {
       /* If LE Excended Advertising is not supported, use the default value */
       ble_maxium_advertising_data_length = 31;
     }
 
-    // Set the ble event mask next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_set_event_mask(&BLE_EVENT_MASK));
-    packet_parser->parse_generic_command_complete(response);
+    ble_event_mask_step =
+        issue_command("ble_set_event_mask",
+                      packet_factory->make_ble_set_event_mask(&BLE_EVENT_MASK));
   }
 
+  start_up_step_t* event_mask_step = NULL;
   if (simple_pairing_supported) {
-    response =
-        AWAIT_COMMAND(packet_factory->make_set_event_mask(&CLASSIC_EVENT_MASK));
-    packet_parser->parse_generic_command_complete(response);
+    event_mask_step = issue_command(
+        "set_event_mask",
+        packet_factory->make_set_event_mask(&CLASSIC_EVENT_MASK));
   }
 
-  // read local supported codecs
-  if (HCI_READ_LOCAL_CODECS_SUPPORTED(supported_commands)) {
-    response =
-        AWAIT_COMMAND(packet_factory->make_read_local_supported_codecs());
-    packet_parser->parse_read_local_supported_codecs_response(
-        response, &number_of_local_supported_codecs, local_supported_codecs);
+  if (resolving_list_size_step != NULL) {
+    response = await_command(resolving_list_size_step);
+    packet_parser->parse_ble_read_resolving_list_size_response(
+        response, &ble_resolving_list_max_size);
   }
 
-  read_simple_pairing_options_supported =
-      HCI_READ_LOCAL_SIMPLE_PAIRING_OPTIONS_SUPPORTED(supported_commands);
+  if (data_length_step != NULL) {
+    response = await_command(data_length_step);
+    packet_parser->parse_ble_read_suggested_default_data_length_response(
+        response, &ble_suggested_default_data_length);
+  }
 
-  // read local simple pairing options
-  if (read_simple_pairing_options_supported) {
-    LOG_DEBUG(LOG_TAG, "%s read local simple pairing options", __func__);
-    response =
-        AWAIT_COMMAND(packet_factory->make_read_local_simple_pairing_options());
-    packet_parser->parse_read_local_simple_paring_options_response(
-        response, &simple_pairing_options, &maximum_encryption_key_size);
-    LOG_DEBUG(LOG_TAG, "%s simple pairing options is 0x%x", __func__,
-        simple_pairing_options);
+  if (max_adv_data_length_step != NULL) {
+    response = await_command(max_adv_data_length_step);
+    packet_parser->parse_ble_read_maximum_advertising_data_length(
+        response, &ble_maxium_advertising_data_length);
+
+    response = await_command(adv_sets_step);
+    packet_parser->parse_ble_read_number_of_supported_advertising_sets(
+        response, &ble_number_of_supported_advertising_sets);
+  }
+
+  if (ble_event_mask_step != NULL) {
+    response = await_command(ble_event_mask_step);
+    packet_parser->parse_generic_command_complete(response);
+  }
+
+  if (event_mask_step != NULL) {
+    response = await_command(event_mask_step);
+    packet_parser->parse_generic_command_complete(response);
   }
 
   if (bt_configstore_intf != NULL) {
@@ -523,8 +661,9 @@ static future_t* start_up(void) {
     }
 
     if (!soc_add_on_features_length) {
-      response =
-            AWAIT_COMMAND(packet_factory->make_read_add_on_features_supported());
+      response = AWAIT_COMMAND(
+          "read_add_on_features_supported",
+          packet_factory->make_read_add_on_features_supported());
       if (response) {
 
         LOG_DEBUG(LOG_TAG, "%s sending add-on features supported VSC", __func__);
@@ -535,8 +674,9 @@ static future_t* start_up(void) {
     }
     if (!soc_add_on_features_length) {
       // read scrambling support from controller incase of cherokee
-      response =
-            AWAIT_COMMAND(packet_factory->make_read_scrambling_supported_freqs());
+      response = AWAIT_COMMAND(
+          "read_scrambling_supported_freqs",
+          packet_factory->make_read_scrambling_supported_freqs());
       if (response) {
 
         LOG_DEBUG(LOG_TAG, "%s sending scrambling support VSC", __func__);
@@ -570,6 +710,12 @@ static future_t* start_up(void) {
     LOG(FATAL) << " Controller must support Read Encryption Key Size command";
   }
 
+  start_up_total_us = time_get_os_boottime_us() - start_up_begin_us;
+  LOG_INFO(LOG_TAG, "%s: %zu commands in %llu ms, up to %zu in flight",
+           __func__, start_up_steps_n,
+           (unsigned long long)(start_up_total_us / 1000),
+           start_up_max_in_flight);
+
   readable = true;
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -987,6 +1133,27 @@ const controller_t* controller_get_interface() {
   return &interface;
 }
 
+void controller_debug_dump(int fd) {
+  dprintf(fd, "\nController start-up:\n");
+  if (start_up_steps_n == 0) {
+    dprintf(fd, "  Not started\n");
+    return;
+  }
+  dprintf(fd, "  Total time (ms)                   : %llu\n",
+          (unsigned long long)(start_up_total_us / 1000));
+  dprintf(fd, "  Commands (total/max in flight)    : %zu / %zu\n",
+          start_up_steps_n, start_up_max_in_flight);
+  dprintf(fd, "  %-46s %10s %10s %10s\n", "Command", "Issued(us)",
+          "Done(us)", "Took(us)");
+  for (size_t i = 0; i < start_up_steps_n; i++) {
+    const start_up_step_t* step = &start_up_steps[i];
+    dprintf(fd, "  %-46s %10llu %10llu %10llu\n", step->name,
+            (unsigned long long)step->issued_us,
+            (unsigned long long)step->done_us,
+            (unsigned long long)(step->done_us - step->issued_us));
+  }
+}
+
 const controller_t* controller_get_test_interface(
     const hci_t* hci_interface,
     const hci_packet_factory_t* packet_factory_interface,
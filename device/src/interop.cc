@@ -19,28 +19,29 @@
 #define LOG_TAG "bt_device_interop"
 
 #include <base/logging.h>
-#include <string.h>  // For memcmp
+#include <mutex>
 
 #include "btcore/include/module.h"
 #include "device/include/interop.h"
 #include "device/include/interop_database.h"
-#include "osi/include/allocator.h"
-#include "osi/include/list.h"
+#include "device/include/interop_index.h"
 #include "osi/include/log.h"
 
 #define CASE_RETURN_STR(const) \
   case const:                  \
     return #const;
 
-static list_t* interop_list = NULL;
+// Index of the static databases, built once on first use
+static interop_index_t* interop_fixed_index = NULL;
+static std::once_flag interop_fixed_index_once;
+
+// Entries added at run time
+static interop_index_t* interop_dynamic_index = NULL;
 
 static const char* interop_feature_string_(const interop_feature_t feature);
-static void interop_free_entry_(void* data);
+static const interop_index_t* interop_get_fixed_index_(void);
+static void interop_build_fixed_index_(void);
 static void interop_lazy_init_(void);
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr);
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr);
 
 // Interface functions
 
@@ -48,8 +49,9 @@ bool interop_match_addr(const interop_feature_t feature,
                         const RawAddress* addr) {
   CHECK(addr);
 
-  if (interop_match_fixed_(feature, addr) ||
-      interop_match_dynamic_(feature, addr)) {
+  if (interop_index_match_addr(interop_get_fixed_index_(), feature, addr) ||
+      (interop_dynamic_index != NULL &&
+       interop_index_match_addr(interop_dynamic_index, feature, addr))) {
     LOG_WARN(LOG_TAG, "%s() Device %s is a match for interop workaround %s.",
              __func__, addr->ToString().c_str(),
              interop_feature_string_(feature));
@@ -62,18 +64,11 @@ bool interop_match_addr(const interop_feature_t feature,
 bool interop_match_name(const interop_feature_t feature, const char* name) {
   CHECK(name);
 
-  const size_t db_size =
-      sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name,
-                interop_name_database[i].length) == 0) {
-      LOG_WARN(LOG_TAG,
-               "%s() Device with name: %s is a match for interop workaround %s",
-               __func__, name, interop_feature_string_(feature));
-      return true;
-    }
+  if (interop_index_match_name(interop_get_fixed_index_(), feature, name)) {
+    LOG_WARN(LOG_TAG,
+             "%s() Device with name: %s is a match for interop workaround %s",
+             __func__, name, interop_feature_string_(feature));
+    return true;
   }
 
   return false;
@@ -81,18 +76,13 @@ bool interop_match_name(const interop_feature_t feature, const char* name) {
 
 bool interop_match_manufacturer(const interop_feature_t feature,
                                 uint16_t manufacturer) {
-  const size_t db_size =
-      sizeof(interop_manufacturer_database) / sizeof(interop_manufacturer_t);
-
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_manufacturer_database[i].feature &&
-        manufacturer == interop_manufacturer_database[i].manufacturer) {
-      LOG_WARN(LOG_TAG,
-               "%s() Device with manufacturer id: %d is a match for interop "
-               "workaround %s",
-               __func__, manufacturer, interop_feature_string_(feature));
-      return true;
-    }
+  if (interop_index_match_manufacturer(interop_get_fixed_index_(), feature,
+                                       manufacturer)) {
+    LOG_WARN(LOG_TAG,
+             "%s() Device with manufacturer id: %d is a match for interop "
+             "workaround %s",
+             __func__, manufacturer, interop_feature_string_(feature));
+    return true;
   }
 
   return false;
@@ -124,34 +114,35 @@ void interop_database_add(const uint16_t feature, const RawAddress* addr,
   CHECK(length > 0);
   CHECK(length < RawAddress::kLength);
 
-  interop_addr_entry_t* entry = static_cast<interop_addr_entry_t*>(
-      osi_calloc(sizeof(interop_addr_entry_t)));
-  memcpy(&entry->addr, addr, length);
-  entry->feature = static_cast<interop_feature_t>(feature);
-  entry->length = length;
-
   interop_lazy_init_();
-  list_append(interop_list, entry);
+  interop_index_add_addr(interop_dynamic_index,
+                         static_cast<interop_feature_t>(feature), addr, length);
 }
 
 void interop_database_clear() {
-  if (interop_list) list_clear(interop_list);
+  if (interop_dynamic_index) interop_index_clear(interop_dynamic_index);
 }
 
 // Module life-cycle functions
 
+static future_t* interop_init(void) {
+  // Build the index now rather than on the first lookup
+  interop_get_fixed_index_();
+  return future_new_immediate(FUTURE_SUCCESS);
+}
+
 static future_t* interop_clean_up(void) {
-  list_free(interop_list);
-  interop_list = NULL;
+  interop_index_free(interop_dynamic_index);
+  interop_dynamic_index = NULL;
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
 EXPORT_SYMBOL module_t interop_module = {
     .name = INTEROP_MODULE,
-    .init = NULL,
+    .init = interop_init,
     .start_up = NULL,
     .shut_down = NULL,
-    .clean_up = interop_clean_up
+    .clean_up = interop_clean_up,
     .dependencies = {NULL},
 };
 
@@ -178,49 +169,30 @@ static const char* interop_feature_string_(const interop_feature_t feature) {
   return "UNKNOWN";
 }
 
-static void interop_free_entry_(void* data) {
-  interop_addr_entry_t* entry = (interop_addr_entry_t*)data;
-  osi_free(entry);
-}
-
-static void interop_lazy_init_(void) {
-  if (interop_list == NULL) {
-    interop_list = list_new(interop_free_entry_);
-  }
+static const interop_index_t* interop_get_fixed_index_(void) {
+  std::call_once(interop_fixed_index_once, interop_build_fixed_index_);
+  return interop_fixed_index;
 }
 
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0) return false;
-
-  const list_node_t* node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t* entry =
-        static_cast<interop_addr_entry_t*>(list_node(node));
-    CHECK(entry);
-
-    if (feature == entry->feature &&
-        memcmp(addr, &entry->addr, entry->length) == 0)
-      return true;
-
-    node = list_next(node);
-  }
-  return false;
+static void interop_build_fixed_index_(void) {
+  interop_fixed_index = interop_index_new();
+
+  for (const interop_addr_entry_t& entry : interop_addr_database)
+    interop_index_add_addr(interop_fixed_index, entry.feature, &entry.addr,
+                           entry.length);
+  for (const interop_name_entry_t& entry : interop_name_database)
+    interop_index_add_name(interop_fixed_index, entry.feature, entry.name,
+                           entry.length);
+  for (const interop_manufacturer_t& entry : interop_manufacturer_database)
+    interop_index_add_manufacturer(interop_fixed_index, entry.feature,
+                                   entry.manufacturer);
+
+  LOG_INFO(LOG_TAG, "%s: %zu interop entries indexed", __func__,
+           interop_index_size(interop_fixed_index));
 }
 
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr) {
-  CHECK(addr);
-
-  const size_t db_size =
-      sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr,
-               interop_addr_database[i].length) == 0) {
-      return true;
-    }
+static void interop_lazy_init_(void) {
+  if (interop_dynamic_index == NULL) {
+    interop_dynamic_index = interop_index_new();
   }
-
-  return false;
 }
@@ -0,0 +1,223 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_device_interop_index"
+
+#include "device/include/interop_index.h"
+
+#include <base/logging.h>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Kinds of the trie entries
+#define INTEROP_INDEX_KIND_ADDR 0
+#define INTEROP_INDEX_KIND_NAME 1
+#define INTEROP_INDEX_NUM_KINDS 2
+
+typedef std::pair<uint8_t, uint32_t> interop_trie_child_t;
+
+typedef struct {
+  bool terminal; /* an entry ends at this node */
+  std::vector<interop_trie_child_t> children; /* sorted by byte */
+} interop_trie_node_t;
+
+struct interop_index_t {
+  std::vector<interop_trie_node_t> nodes; /* nodes[0] is unused */
+  /* Root node of the entries of each kind and feature, 0 if none */
+  std::vector<uint32_t> roots[INTEROP_INDEX_NUM_KINDS];
+  std::unordered_set<uint32_t> manufacturers;
+  size_t size;
+};
+
+static uint32_t interop_index_manufacturer_key(const interop_feature_t feature,
+                                               uint16_t manufacturer) {
+  return ((uint32_t)(uint16_t)feature << 16) | manufacturer;
+}
+
+static bool interop_child_less(const interop_trie_child_t& child,
+                               uint8_t byte) {
+  return child.first < byte;
+}
+
+// Return the child of |node| for |byte|, or 0 if there is none.
+static uint32_t interop_trie_find_child(const interop_trie_node_t& node,
+                                        uint8_t byte) {
+  auto it = std::lower_bound(node.children.begin(), node.children.end(), byte,
+                             interop_child_less);
+  if (it == node.children.end() || it->first != byte) return 0;
+  return it->second;
+}
+
+static uint32_t interop_trie_new_node(interop_index_t* index) {
+  uint32_t node = index->nodes.size();
+  index->nodes.emplace_back();
+  index->nodes[node].terminal = false;
+  return node;
+}
+
+static uint32_t interop_trie_add_child(interop_index_t* index, uint32_t node,
+                                       uint8_t byte) {
+  uint32_t child = interop_trie_find_child(index->nodes[node], byte);
+  if (child != 0) return child;
+
+  child = interop_trie_new_node(index);
+  std::vector<interop_trie_child_t>& children = index->nodes[node].children;
+  children.insert(std::lower_bound(children.begin(), children.end(), byte,
+                                   interop_child_less),
+                  interop_trie_child_t(byte, child));
+  return child;
+}
+
+static void interop_trie_add(interop_index_t* index, int kind,
+                             const interop_feature_t feature,
+                             const uint8_t* prefix, size_t length) {
+  std::vector<uint32_t>& roots = index->roots[kind];
+  if ((size_t)feature >= roots.size()) roots.resize((size_t)feature + 1, 0);
+  if (roots[feature] == 0) roots[feature] = interop_trie_new_node(index);
+
+  uint32_t node = roots[feature];
+  for (size_t i = 0; i < length; i++)
+    node = interop_trie_add_child(index, node, prefix[i]);
+
+  if (!index->nodes[node].terminal) {
+    index->nodes[node].terminal = true;
+    index->size++;
+  }
+}
+
+// Return the root node of the entries of |kind| for |feature|, or 0 if there
+// is none.
+static uint32_t interop_trie_root(const interop_index_t* index, int kind,
+                                  const interop_feature_t feature) {
+  const std::vector<uint32_t>& roots = index->roots[kind];
+  return ((size_t)feature < roots.size()) ? roots[feature] : 0;
+}
+
+// Return true if an entry of |kind| for |feature| is a prefix of the
+// |length| bytes of |data|.
+static bool interop_trie_match(const interop_index_t* index, int kind,
+                               const interop_feature_t feature,
+                               const uint8_t* data, size_t length) {
+  uint32_t node = interop_trie_root(index, kind, feature);
+  if (node == 0) return false;
+  for (size_t i = 0;; i++) {
+    if (index->nodes[node].terminal) return true;
+    if (i == length) return false;
+    node = interop_trie_find_child(index->nodes[node], data[i]);
+    if (node == 0) return false;
+  }
+}
+
+// Same as |interop_trie_match| for the null terminated string |str|.
+static bool interop_trie_match_str(const interop_index_t* index, int kind,
+                                   const interop_feature_t feature,
+                                   const char* str) {
+  uint32_t node = interop_trie_root(index, kind, feature);
+  if (node == 0) return false;
+  for (;; str++) {
+    if (index->nodes[node].terminal) return true;
+    if (*str == '\0') return false;
+    node = interop_trie_find_child(index->nodes[node], (uint8_t)*str);
+    if (node == 0) return false;
+  }
+}
+
+interop_index_t* interop_index_new(void) {
+  interop_index_t* index = new interop_index_t;
+  interop_index_clear(index);
+  return index;
+}
+
+void interop_index_free(interop_index_t* index) { delete index; }
+
+void interop_index_clear(interop_index_t* index) {
+  CHECK(index);
+  index->nodes.clear();
+  interop_trie_new_node(index);
+  for (std::vector<uint32_t>& roots : index->roots) roots.clear();
+  index->manufacturers.clear();
+  index->size = 0;
+}
+
+void interop_index_add_addr(interop_index_t* index,
+                            const interop_feature_t feature,
+                            const RawAddress* addr, size_t length) {
+  CHECK(index);
+  CHECK(addr);
+  CHECK(length <= RawAddress::kLength);
+
+  interop_trie_add(index, INTEROP_INDEX_KIND_ADDR, feature, addr->address,
+                   length);
+}
+
+void interop_index_add_name(interop_index_t* index,
+                            const interop_feature_t feature, const char* name,
+                            size_t length) {
+  CHECK(index);
+  CHECK(name);
+
+  interop_trie_add(index, INTEROP_INDEX_KIND_NAME, feature,
+                   (const uint8_t*)name, length);
+}
+
+void interop_index_add_manufacturer(interop_index_t* index,
+                                    const interop_feature_t feature,
+                                    uint16_t manufacturer) {
+  CHECK(index);
+
+  if (index->manufacturers
+          .insert(interop_index_manufacturer_key(feature, manufacturer))
+          .second)
+    index->size++;
+}
+
+bool interop_index_match_addr(const interop_index_t* index,
+                              const interop_feature_t feature,
+                              const RawAddress* addr) {
+  CHECK(index);
+  CHECK(addr);
+
+  return interop_trie_match(index, INTEROP_INDEX_KIND_ADDR, feature,
+                            addr->address, RawAddress::kLength);
+}
+
+bool interop_index_match_name(const interop_index_t* index,
+                              const interop_feature_t feature,
+                              const char* name) {
+  CHECK(index);
+  CHECK(name);
+
+  return interop_trie_match_str(index, INTEROP_INDEX_KIND_NAME, feature,
+                                name);
+}
+
+bool interop_index_match_manufacturer(const interop_index_t* index,
+                                      const interop_feature_t feature,
+                                      uint16_t manufacturer) {
+  CHECK(index);
+
+  return index->manufacturers.count(
+             interop_index_manufacturer_key(feature, manufacturer)) != 0;
+}
+
+size_t interop_index_size(const interop_index_t* index) {
+  CHECK(index);
+  return index->size;
+}
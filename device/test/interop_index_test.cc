@@ -0,0 +1,129 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "device/include/interop_index.h"
+
+class InteropIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override { index_ = interop_index_new(); }
+  void TearDown() override { interop_index_free(index_); }
+
+  void AddAddr(interop_feature_t feature, const char* addr, size_t length) {
+    RawAddress address;
+    RawAddress::FromString(addr, address);
+    interop_index_add_addr(index_, feature, &address, length);
+  }
+
+  bool MatchAddr(interop_feature_t feature, const char* addr) {
+    RawAddress address;
+    RawAddress::FromString(addr, address);
+    return interop_index_match_addr(index_, feature, &address);
+  }
+
+  interop_index_t* index_;
+};
+
+TEST_F(InteropIndexTest, test_addr_prefixes) {
+  AddAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS, "38:2c:4a:e6:00:00", 4);
+  AddAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS, "08:62:66:00:00:00", 3);
+  AddAddr(INTEROP_AUTO_RETRY_PAIRING, "9c:df:03:00:00:00", 3);
+
+  EXPECT_TRUE(MatchAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS,
+                        "38:2c:4a:e6:67:89"));
+  EXPECT_TRUE(MatchAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS,
+                        "08:62:66:12:34:56"));
+  EXPECT_TRUE(MatchAddr(INTEROP_AUTO_RETRY_PAIRING, "9c:df:03:12:34:56"));
+
+  // Shorter than the prefix, other feature, other address
+  EXPECT_FALSE(MatchAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS,
+                         "38:2c:4a:59:67:89"));
+  EXPECT_FALSE(MatchAddr(INTEROP_AUTO_RETRY_PAIRING, "38:2c:4a:e6:67:89"));
+  EXPECT_FALSE(MatchAddr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS,
+                         "00:00:00:00:00:00"));
+  EXPECT_EQ(3u, interop_index_size(index_));
+}
+
+TEST_F(InteropIndexTest, test_nested_addr_prefixes) {
+  AddAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:54:af:12:00:00", 4);
+  AddAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:54:00:00:00:00", 2);
+  // Duplicates are counted once
+  AddAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:54:00:00:00:00", 2);
+
+  EXPECT_TRUE(MatchAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:54:af:12:34:56"));
+  EXPECT_TRUE(MatchAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:54:01:02:03:04"));
+  EXPECT_FALSE(MatchAddr(INTEROP_DISABLE_ROLE_SWITCH, "00:55:af:12:34:56"));
+  EXPECT_EQ(2u, interop_index_size(index_));
+}
+
+TEST_F(InteropIndexTest, test_names) {
+  interop_index_add_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "Car", 3);
+  interop_index_add_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "BMW", 3);
+  interop_index_add_name(index_, INTEROP_DISABLE_AVDTP_RECONFIGURE,
+                         "KMM-BT51*HD", 11);
+
+  EXPECT_TRUE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "Car"));
+  EXPECT_TRUE(interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING,
+                                       "Caramel"));
+  EXPECT_TRUE(interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING,
+                                       "BMW M3"));
+  EXPECT_TRUE(interop_index_match_name(
+      index_, INTEROP_DISABLE_AVDTP_RECONFIGURE, "KMM-BT51*HD"));
+
+  EXPECT_FALSE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "Ca"));
+  EXPECT_FALSE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "car"));
+  EXPECT_FALSE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, ""));
+  EXPECT_FALSE(interop_index_match_name(
+      index_, INTEROP_DISABLE_AVDTP_RECONFIGURE, "KMM-BT518HD"));
+  EXPECT_FALSE(interop_index_match_name(
+      index_, INTEROP_DISABLE_SDP_AFTER_PAIRING, "Car"));
+}
+
+TEST_F(InteropIndexTest, test_addr_and_name_are_separate) {
+  // The bytes of "AB" as an address prefix
+  AddAddr(INTEROP_DISABLE_AUTO_PAIRING, "41:42:00:00:00:00", 2);
+  EXPECT_FALSE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "ABC"));
+}
+
+TEST_F(InteropIndexTest, test_manufacturer) {
+  interop_index_add_manufacturer(index_, INTEROP_DISABLE_SDP_AFTER_PAIRING,
+                                 76);
+  EXPECT_TRUE(interop_index_match_manufacturer(
+      index_, INTEROP_DISABLE_SDP_AFTER_PAIRING, 76));
+  EXPECT_FALSE(interop_index_match_manufacturer(
+      index_, INTEROP_DISABLE_SNIFF_DURING_SCO, 76));
+  EXPECT_FALSE(interop_index_match_manufacturer(
+      index_, INTEROP_DISABLE_SDP_AFTER_PAIRING, 77));
+}
+
+TEST_F(InteropIndexTest, test_clear) {
+  AddAddr(INTEROP_AUTO_RETRY_PAIRING, "9c:df:03:00:00:00", 3);
+  interop_index_add_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "Car", 3);
+  interop_index_clear(index_);
+
+  EXPECT_EQ(0u, interop_index_size(index_));
+  EXPECT_FALSE(MatchAddr(INTEROP_AUTO_RETRY_PAIRING, "9c:df:03:12:34:56"));
+  EXPECT_FALSE(
+      interop_index_match_name(index_, INTEROP_DISABLE_AUTO_PAIRING, "Car"));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the G.722 encoder used for hearing aid streaming.
+//
+// Each iteration encodes one audio interval of 16 kHz PCM: one channel, both
+// channels with two g722_encode() calls, or both channels with
+// g722_encode_stereo(). The stereo benchmark checks that its output matches
+// the one of the mono encoder.
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "embdrv/g722/g722_enc_dec.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+
+// 1 kHz tone on the left channel, 440 Hz tone on the right channel, at half
+// scale as the hearing aid input is.
+void bm_make_pcm(std::vector<int16_t>* left, std::vector<int16_t>* right,
+                 int len) {
+  left->resize(len);
+  right->resize(len);
+  for (int i = 0; i < len; i++) {
+    double t = (double)i / kSampleRate;
+    (*left)[i] = (int16_t)(0x3fff * sin(2 * M_PI * 1000 * t));
+    (*right)[i] = (int16_t)(0x3fff * sin(2 * M_PI * 440 * t));
+  }
+}
+
+}  // namespace
+
+// Argument: samples per channel per interval
+static void BM_G722EncodeMono(State& state) {
+  int len = state.range(0);
+  std::vector<int16_t> left, right;
+  bm_make_pcm(&left, &right, len);
+  std::vector<uint8_t> out(len);
+  g722_encode_state_t enc;
+  g722_encode_init(&enc, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(g722_encode(&enc, out.data(), left.data(), len));
+  }
+  state.SetItemsProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_G722EncodeMono)->Arg(160)->Arg(320);
+
+// Argument: samples per channel per interval
+static void BM_G722EncodeTwoMono(State& state) {
+  int len = state.range(0);
+  std::vector<int16_t> left, right;
+  bm_make_pcm(&left, &right, len);
+  std::vector<uint8_t> out_left(len), out_right(len);
+  g722_encode_state_t enc_left, enc_right;
+  g722_encode_init(&enc_left, 64000, G722_PACKED);
+  g722_encode_init(&enc_right, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        g722_encode(&enc_left, out_left.data(), left.data(), len));
+    benchmark::DoNotOptimize(
+        g722_encode(&enc_right, out_right.data(), right.data(), len));
+  }
+  state.SetItemsProcessed(state.iterations() * len * 2);
+}
+BENCHMARK(BM_G722EncodeTwoMono)->Arg(160)->Arg(320);
+
+// Argument: samples per channel per interval
+static void BM_G722EncodeStereo(State& state) {
+  int len = state.range(0);
+  std::vector<int16_t> left, right;
+  bm_make_pcm(&left, &right, len);
+  std::vector<uint8_t> out_left(len), out_right(len);
+  std::vector<uint8_t> ref_left(len), ref_right(len);
+  g722_encode_state_t enc_left, enc_right, ref_enc_left, ref_enc_right;
+  g722_encode_init(&enc_left, 64000, G722_PACKED);
+  g722_encode_init(&enc_right, 64000, G722_PACKED);
+  g722_encode_init(&ref_enc_left, 64000, G722_PACKED);
+  g722_encode_init(&ref_enc_right, 64000, G722_PACKED);
+
+  g722_encode_stereo(&enc_left, &enc_right, out_left.data(), out_right.data(),
+                     left.data(), right.data(), len);
+  g722_encode(&ref_enc_left, ref_left.data(), left.data(), len);
+  g722_encode(&ref_enc_right, ref_right.data(), right.data(), len);
+  if (out_left != ref_left || out_right != ref_right) {
+    state.SkipWithError("stereo output differs from the mono encoder");
+    return;
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        g722_encode_stereo(&enc_left, &enc_right, out_left.data(),
+                           out_right.data(), left.data(), right.data(), len));
+  }
+  state.SetItemsProcessed(state.iterations() * len * 2);
+}
+BENCHMARK(BM_G722EncodeStereo)->Arg(160)->Arg(320);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
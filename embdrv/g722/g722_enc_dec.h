@@ -136,6 +136,14 @@ extern "C" {
 g722_encode_state_t *g722_encode_init(g722_encode_state_t *s, unsigned int rate, int options);
 int g722_encode_release(g722_encode_state_t *s);
 int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[], int len);
+/* Encode the two channels |amp_left| and |amp_right| of |len| samples each,
+   with the encoders |left| and |right|, in one pass. The output is the same
+   as with g722_encode() on each channel. Returns the number of bytes written
+   to each of |g722_data_left| and |g722_data_right|. */
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t g722_data_left[], uint8_t g722_data_right[],
+                       const int16_t amp_left[], const int16_t amp_right[],
+                       int len);
 
 g722_decode_state_t *g722_decode_init(g722_decode_state_t *s, unsigned int rate, int options);
 int g722_decode_release(g722_decode_state_t *s);
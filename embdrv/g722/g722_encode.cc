@@ -32,6 +32,10 @@
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -268,8 +272,101 @@ static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Number of sample pairs run through the QMF in one block */
+#define QMF_BLOCK_PAIRS 64
+
+/* Apply the transmit QMF to a block of |n| sample pairs.
+   The even and odd input samples are split: |even[11 + k]| and |odd[11 + k]|
+   are the samples of pair |k|, preceded by the 11 previous even and odd
+   samples. Only every other QMF output is computed, as in the reference
+   code. The taps are independent for successive pairs, so several pairs are
+   filtered at once with SIMD when it is available. */
+static void qmf_analysis(const int16_t *even, const int16_t *odd, int n,
+                         int *xlow, int *xhigh)
+{
+    int i;
+    int k;
+    /* Even and odd tap accumulators */
+    int sumeven;
+    int sumodd;
+
+    k = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (  ;  k + 4 <= n;  k += 4)
+    {
+        int32x4_t vsumodd = vdupq_n_s32(0);
+        int32x4_t vsumeven = vdupq_n_s32(0);
+
+        for (i = 0;  i < 12;  i++)
+        {
+            vsumodd = vmlal_n_s16(vsumodd, vld1_s16(even + k + i), qmf_coeffs[i]);
+            vsumeven = vmlal_n_s16(vsumeven, vld1_s16(odd + k + i), qmf_coeffs[11 - i]);
+        }
+        vst1q_s32(xlow + k, vshrq_n_s32(vaddq_s32(vsumeven, vsumodd), 14));
+        vst1q_s32(xhigh + k, vshrq_n_s32(vsubq_s32(vsumeven, vsumodd), 14));
+    }
+#endif
+    for (  ;  k < n;  k++)
+    {
+        sumeven = 0;
+        sumodd = 0;
+        for (i = 0;  i < 12;  i++)
+        {
+            sumodd += even[k + i]*qmf_coeffs[i];
+            sumeven += odd[k + i]*qmf_coeffs[11 - i];
+        }
+        /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
+           to allow for us summing two filters, plus 1 to allow for the 15 bit
+           input to the G.722 algorithm. */
+        xlow[k] = (sumeven + sumodd) >> 14;
+        xhigh[k] = (sumeven - sumodd) >> 14;
+    }
+#ifdef RUN_LIKE_REFERENCE_G722
+    /* The following lines are only used to verify bit-exactness
+     * with reference implementation of G.722. Higher precision
+     * is achieved without limiting the values.
+     */
+    for (k = 0;  k < n;  k++)
+    {
+        xlow[k] = limitValues(xlow[k]);
+        xhigh[k] = limitValues(xhigh[k]);
+    }
+#endif
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Run the transmit QMF of |s| on the |2*n| samples of |amp|, n being at most
+   QMF_BLOCK_PAIRS, and update the QMF signal history. */
+static void qmf_block(g722_encode_state_t *s, const int16_t amp[], int n,
+                      int *xlow, int *xhigh)
+{
+    int16_t even[QMF_BLOCK_PAIRS + 11];
+    int16_t odd[QMF_BLOCK_PAIRS + 11];
+    int i;
+
+    /* The oldest pair of the history is shifted out by the first pair */
+    for (i = 0;  i < 11;  i++)
+    {
+        even[i] = (int16_t) s->x[2*i + 2];
+        odd[i] = (int16_t) s->x[2*i + 3];
+    }
+    for (i = 0;  i < n;  i++)
+    {
+        even[11 + i] = amp[2*i];
+        odd[11 + i] = amp[2*i + 1];
+    }
+    qmf_analysis(even, odd, n, xlow, xhigh);
+    for (i = 0;  i < 12;  i++)
+    {
+        s->x[2*i] = even[n - 1 + i];
+        s->x[2*i + 1] = odd[n - 1 + i];
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Encode the low and high band samples |xlow| and |xhigh|.
+   Returns the G.722 code. */
+static __inline int encode_bands(g722_encode_state_t *s, int xlow, int xhigh)
 {
     int dlow;
     int dhigh;
@@ -284,155 +381,202 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     int eh;
     int mih;
     int i;
-    int j;
-    /* Low and high band PCM from the QMF */
-    int xlow;
-    int xhigh;
-    int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
+    int lo;
+    int hi;
     int ihigh;
     int ilow;
     int code;
 
-    g722_bytes = 0;
-    xhigh = 0;
-    for (j = 0;  j < len;  )
-    {
-        if (s->itu_test_mode)
-        {
-            xlow =
-            xhigh = amp[j++] >> 1;
-        }
-        else
-        {
-            {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                //TODO: if len is odd, then this can be a buffer overrun
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
-                /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
-                   to allow for us summing two filters, plus 1 to allow for the 15 bit
-                   input to the G.722 algorithm. */
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
-
-#ifdef RUN_LIKE_REFERENCE_G722
-                /* The following lines are only used to verify bit-exactness
-                 * with reference implementation of G.722. Higher precision
-                 * is achieved without limiting the values.
-                 */
-                xlow = limitValues(xlow);
-                xhigh = limitValues(xhigh);
-#endif
-            }
-        }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
+    /* Block 1L, SUBTRA */
+    el = saturate(xlow - s->band[0].s);
 
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
 
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
+    /* The decision levels grow with i: binary search for the first one
+       above wd, 30 if there is none */
+    lo = 1;
+    hi = 30;
+    while (lo < hi)
+    {
+        i = (lo + hi) >> 1;
+        wd1 = (q6[i]*s->band[0].det) >> 12;
+        if (wd < wd1)
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    i = lo;
+    ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = ilow >> 2;
+    wd2 = qm4[ril];
+    dlow = (s->band[0].det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (s->band[0].nb*127) >> 7;
+    s->band[0].nb = wd + wl[il4];
+    if (s->band[0].nb < 0)
+        s->band[0].nb = 0;
+    else if (s->band[0].nb > 18432)
+        s->band[0].nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (s->band[0].nb >> 6) & 31;
+    wd2 = 8 - (s->band[0].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[0].det = wd3 << 2;
+
+    block4(&s->band[0], dlow);
+    {
+        int nb;
+
+        /* Block 1H, SUBTRA */
+        eh = saturate(xhigh - s->band[1].s);
+
+        /* Block 1H, QUANTH */
+        wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+        wd1 = (564*s->band[1].det) >> 12;
+        mih = (wd >= wd1)  ?  2  :  1;
+        ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+        /* Block 2H, INVQAH */
+        wd2 = qm2[ihigh];
+        dhigh = (s->band[1].det*wd2) >> 15;
+
+        /* Block 3H, LOGSCH */
+        ih2 = rh2[ihigh];
+        wd = (s->band[1].nb*127) >> 7;
+
+        nb = wd + wh[ih2];
+        if (nb < 0)
+            nb = 0;
+        else if (nb > 22528)
+            nb = 22528;
+        s->band[1].nb = nb;
+
+        /* Block 3H, SCALEH */
+        wd1 = (s->band[1].nb >> 6) & 31;
+        wd2 = 10 - (s->band[1].nb >> 11);
         wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
+        s->band[1].det = wd3 << 2;
 
-        block4(&s->band[0], dlow);
-        {
-            int nb;
-
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-            s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(&s->band[1], dhigh);
+        block4(&s->band[1], dhigh);
 #if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
+        code = ((ihigh << 6) | ilow);
 #elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
+        code = ((ihigh << 6) | ilow) >> 1;
 #elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
+        code = ((ihigh << 6) | ilow) >> 2;
 #endif
-        }
+    }
+    return code;
+}
+/*- End of function --------------------------------------------------------*/
 
+/* Write the G.722 |code| to |g722_data| at |*g722_bytes| */
+static __inline void output_code(g722_encode_state_t *s, uint8_t g722_data[],
+                                 int *g722_bytes, int code)
+{
 #if PACKED_OUTPUT == 1
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
-            {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
-            }
+    /* Pack the code bits */
+    s->out_buffer |= (code << s->out_bits);
+    s->out_bits += s->bits_per_sample;
+    if (s->out_bits >= 8)
+    {
+        g722_data[(*g722_bytes)++] = (uint8_t) (s->out_buffer & 0xFF);
+        s->out_bits -= 8;
+        s->out_buffer >>= 8;
+    }
 #else
-            g722_data[g722_bytes++] = (uint8_t) code;
+    (void) s;
+    g722_data[(*g722_bytes)++] = (uint8_t) code;
 #endif
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
+    int xlow[QMF_BLOCK_PAIRS];
+    int xhigh[QMF_BLOCK_PAIRS];
+    int g722_bytes;
+    int pairs;
+    int n;
+    int j;
+    int k;
+
+    g722_bytes = 0;
+    if (s->itu_test_mode)
+    {
+        for (j = 0;  j < len;  j++)
+        {
+            xlow[0] = amp[j] >> 1;
+            output_code(s, g722_data, &g722_bytes, encode_bands(s, xlow[0], xlow[0]));
+        }
+        return g722_bytes;
+    }
+
+    /* The QMF takes the samples in pairs: an odd last sample is ignored */
+    pairs = len/2;
+    for (j = 0;  j < pairs;  j += n)
+    {
+        n = pairs - j;
+        if (n > QMF_BLOCK_PAIRS)
+            n = QMF_BLOCK_PAIRS;
+        qmf_block(s, amp + 2*j, n, xlow, xhigh);
+        for (k = 0;  k < n;  k++)
+            output_code(s, g722_data, &g722_bytes, encode_bands(s, xlow[k], xhigh[k]));
     }
     return g722_bytes;
 }
 /*- End of function --------------------------------------------------------*/
+
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t g722_data_left[], uint8_t g722_data_right[],
+                       const int16_t amp_left[], const int16_t amp_right[],
+                       int len)
+{
+    int xlow_left[QMF_BLOCK_PAIRS];
+    int xhigh_left[QMF_BLOCK_PAIRS];
+    int xlow_right[QMF_BLOCK_PAIRS];
+    int xhigh_right[QMF_BLOCK_PAIRS];
+    int g722_bytes_left;
+    int g722_bytes_right;
+    int pairs;
+    int n;
+    int j;
+    int k;
+
+    if (left->itu_test_mode  ||  right->itu_test_mode)
+    {
+        g722_encode(right, g722_data_right, amp_right, len);
+        return g722_encode(left, g722_data_left, amp_left, len);
+    }
+
+    g722_bytes_left = 0;
+    g722_bytes_right = 0;
+    pairs = len/2;
+    for (j = 0;  j < pairs;  j += n)
+    {
+        n = pairs - j;
+        if (n > QMF_BLOCK_PAIRS)
+            n = QMF_BLOCK_PAIRS;
+        qmf_block(left, amp_left + 2*j, n, xlow_left, xhigh_left);
+        qmf_block(right, amp_right + 2*j, n, xlow_right, xhigh_right);
+        /* The two channels are independent: interleaving them gives the CPU
+           two dependency chains to work on at each sample. */
+        for (k = 0;  k < n;  k++)
+        {
+            output_code(left, g722_data_left, &g722_bytes_left,
+                        encode_bands(left, xlow_left[k], xhigh_left[k]));
+            output_code(right, g722_data_right, &g722_bytes_right,
+                        encode_bands(right, xlow_right[k], xhigh_right[k]));
+        }
+    }
+    return g722_bytes_left;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Bit-exactness tests of the G.722 encoder. The golden vectors were produced
+// by the per-sample reference encoder this block encoder replaced.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <vector>
+
+#include "embdrv/g722/g722_enc_dec.h"
+
+namespace {
+
+constexpr int kLen = 8000;
+
+// Triangle sweep with noise, and every fourth 1000 samples full-scale
+// square noise to exercise the saturation paths.
+std::vector<int16_t> make_pcm(int len, uint32_t seed) {
+  std::vector<int16_t> pcm(len);
+  uint32_t lcg = seed;
+  int32_t phase = 0;
+  for (int i = 0; i < len; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    phase += 64 + i / 4;
+    int32_t tri = (phase & 0xffff) < 0x8000 ? (phase & 0x7fff)
+                                            : 0x7fff - (phase & 0x7fff);
+    int32_t v = (tri - 0x4000) + ((int32_t)(lcg >> 16) - 0x8000) / 4;
+    if ((i / 1000) % 4 == 3) v = (lcg & 0x10000) ? 32767 : -32768;
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    pcm[i] = (int16_t)v;
+  }
+  return pcm;
+}
+
+// FNV-1a hash of the encoded bytes
+uint32_t hash(const std::vector<uint8_t>& data) {
+  uint32_t h = 2166136261u;
+  for (uint8_t byte : data) {
+    h ^= byte;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+const uint8_t kGoldenStart[] = {
+    0x27, 0x84, 0x20, 0x84, 0x20, 0x84, 0x04, 0x86, 0x07, 0x87, 0x87, 0x0b,
+    0x8d, 0x92, 0x0d, 0x8a, 0x07, 0x8b, 0x99, 0x8d, 0x1d, 0x0e, 0x99, 0x90,
+    0x9e, 0x1f, 0x8e, 0x0f, 0x10, 0x18, 0x98, 0x12, 0x3f, 0x0e, 0x4f, 0x3b,
+    0xd2, 0xf3, 0x92, 0x17, 0xf9, 0xd2, 0xf4, 0x4d, 0x1b, 0xf9, 0x54, 0x4d,
+};
+constexpr uint32_t kGoldenHashLeft = 0xe5489246;
+constexpr uint32_t kGoldenHashRight = 0xbc12d5f6;
+
+}  // namespace
+
+TEST(G722EncodeTest, test_golden_vector) {
+  std::vector<int16_t> pcm = make_pcm(kLen, 1);
+  std::vector<uint8_t> out(kLen / 2);
+  g722_encode_state_t enc;
+  g722_encode_init(&enc, 64000, G722_PACKED);
+
+  EXPECT_EQ(kLen / 2, g722_encode(&enc, out.data(), pcm.data(), kLen));
+  for (size_t i = 0; i < sizeof(kGoldenStart); i++)
+    EXPECT_EQ(kGoldenStart[i], out[i]) << "at byte " << i;
+  EXPECT_EQ(kGoldenHashLeft, hash(out));
+}
+
+TEST(G722EncodeTest, test_golden_vector_any_block_length) {
+  std::vector<int16_t> pcm = make_pcm(kLen, 1);
+  std::vector<uint8_t> out(kLen / 2);
+  g722_encode_state_t enc;
+  g722_encode_init(&enc, 64000, G722_PACKED);
+
+  // Even lengths from 2 to 300 samples, across the QMF block boundaries
+  int pos = 0;
+  int bytes = 0;
+  int len = 2;
+  while (pos < kLen) {
+    if (len > kLen - pos) len = kLen - pos;
+    bytes += g722_encode(&enc, out.data() + bytes, pcm.data() + pos, len);
+    pos += len;
+    len = ((len * 7 + 6) % 300 + 2) & ~1;
+  }
+  EXPECT_EQ(kLen / 2, bytes);
+  EXPECT_EQ(kGoldenHashLeft, hash(out));
+}
+
+TEST(G722EncodeTest, test_golden_vector_stereo) {
+  std::vector<int16_t> left = make_pcm(kLen, 1);
+  std::vector<int16_t> right = make_pcm(kLen, 2);
+  std::vector<uint8_t> out_left(kLen / 2);
+  std::vector<uint8_t> out_right(kLen / 2);
+  g722_encode_state_t enc_left;
+  g722_encode_state_t enc_right;
+  g722_encode_init(&enc_left, 64000, G722_PACKED);
+  g722_encode_init(&enc_right, 64000, G722_PACKED);
+
+  EXPECT_EQ(kLen / 2,
+            g722_encode_stereo(&enc_left, &enc_right, out_left.data(),
+                               out_right.data(), left.data(), right.data(),
+                               kLen));
+  EXPECT_EQ(kGoldenHashLeft, hash(out_left));
+  EXPECT_EQ(kGoldenHashRight, hash(out_right));
+}
@@ -47,6 +47,7 @@
 #include "osi/include/log.h"
 #include "osi/include/properties.h"
 #include "osi/include/reactor.h"
+#include "osi/include/trace.h"
 #include "packet_fragmenter.h"
 #include "controller.h"
 
@@ -155,6 +156,7 @@ void initialization_complete() {
 
 void hci_event_received(const base::Location& from_here,
                         BT_HDR* packet) {
+  OSI_TRACE_INSTANT("hci_event_received", packet->data[0]);
   btsnoop->capture(packet, true);
 
   if (!filter_incoming_event(packet)) {
@@ -163,6 +165,7 @@ void hci_event_received(const base::Location& from_here,
 }
 
 void acl_event_received(BT_HDR* packet) {
+  OSI_TRACE_INSTANT("acl_event_received", packet->len);
   btsnoop->capture(packet, true);
   packet_fragmenter->reassemble_and_dispatch(packet);
 }
@@ -473,6 +476,7 @@ static void event_packet_ready(void* pkt) {
 
 // Callback for the fragmenter to send a fragment
 static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
+  OSI_TRACE_BEGIN("hci_transmit_fragment");
   btsnoop->capture(packet, false);
 
   /* Parse packet event before transmitting it.
@@ -492,6 +496,7 @@ static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
 
   if (event != MSG_STACK_TO_HC_HCI_CMD && send_transmit_finished)
     buffer_allocator->free(packet);
+  OSI_TRACE_END("hci_transmit_fragment");
 }
 
 static void fragmenter_transmit_finished(BT_HDR* packet,
@@ -605,6 +610,7 @@ void process_command_credits(int credits) {
     command_queue.pop();
     command_credits--;
   }
+  OSI_TRACE_COUNTER("hci command credits", command_credits);
 }
 
 // Returns true if the event was intercepted and should not proceed to
@@ -708,6 +714,7 @@ static void dispatch_reassembled(BT_HDR* packet) {
   CHECK((packet->event & MSG_EVT_MASK) != MSG_HC_TO_STACK_HCI_EVT);
   CHECK(!send_data_upwards.is_null());
 
+  OSI_TRACE_INSTANT("hci_dispatch_reassembled", packet->len);
   send_data_upwards.Run(FROM_HERE, packet);
 }
 
@@ -817,6 +817,12 @@
 #define GATT_MAX_PHY_CHANNEL 7
 #endif
 
+/* Notifications queued on a congested link by
+ * GATTS_HandleValueNotificationMulti(); the oldest are dropped above it */
+#ifndef GATT_MAX_PENDING_NOTIF
+#define GATT_MAX_PENDING_NOTIF 8
+#endif
+
 /* Used for conformance testing ONLY */
 #ifndef GATT_CONFORMANCE_TESTING
 #define GATT_CONFORMANCE_TESTING FALSE
@@ -875,6 +881,12 @@
 #define SDP_MAX_PAD_LEN 600
 #endif
 
+/* The maximum number of UUIDs indexed per record for service searches.
+ * Records holding more UUIDs than this are searched attribute by attribute. */
+#ifndef SDP_MAX_REC_UUIDS
+#define SDP_MAX_REC_UUIDS 24
+#endif
+
 /* The maximum length, in bytes, of an attribute. */
 #ifndef SDP_MAX_ATTR_LEN
 #define SDP_MAX_ATTR_LEN 400
@@ -33,6 +33,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <time.h>
+#include <vector>
 
 #include <hardware/bluetooth.h>
 #include <hardware/vendor.h>
@@ -122,18 +123,21 @@ void post_to_hci_message_loop(const base::Location& from_here,
  *
  *****************************************************************************/
 void bte_main_boot_entry(void) {
-  module_init(get_module(INTEROP_MODULE));
-  module_init(get_module(PROFILE_CONFIG_MODULE));
-
   hci = hci_layer_get_interface();
   if (!hci) {
     LOG_ERROR(LOG_TAG, "%s could not get hci layer interface.", __func__);
+    module_init(get_module(INTEROP_MODULE));
+    module_init(get_module(PROFILE_CONFIG_MODULE));
     return;
   }
 
   hci->set_data_cb(base::Bind(&post_to_hci_message_loop));
 
-  module_init(get_module(STACK_CONFIG_MODULE));
+  // The interop database and the configuration files are independent
+  const module_t* modules[] = {get_module(INTEROP_MODULE),
+                               get_module(PROFILE_CONFIG_MODULE),
+                               get_module(STACK_CONFIG_MODULE), NULL};
+  module_init_parallel(modules);
 }
 
 /******************************************************************************
@@ -157,16 +161,25 @@ void bte_main_cleanup() {
  * Function         bte_main_enable
  *
  * Description      BTE MAIN API - Creates all the BTE tasks. Should be called
- *                  part of the Bluetooth stack enable sequence
+ *                  part of the Bluetooth stack enable sequence. |modules|,
+ *                  a NULL terminated array, are started up in parallel with
+ *                  the HCI layer.
  *
  * Returns          None
  *
  *****************************************************************************/
-void bte_main_enable() {
+void bte_main_enable(const module_t* const* modules) {
   APPL_TRACE_DEBUG("%s", __func__);
 
-  module_start_up(get_module(BTSNOOP_MODULE));
-  if (!module_start_up(get_module(HCI_MODULE))) {
+  std::vector<const module_t*> start_up_modules = {
+      get_module(BTSNOOP_MODULE), get_module(HCI_MODULE)};
+  for (const module_t* const* module = modules; *module != NULL; module++)
+    start_up_modules.push_back(*module);
+  start_up_modules.push_back(NULL);
+
+  // HCI depends on btsnoop, the other modules are independent
+  module_start_up_parallel(start_up_modules.data());
+  if (!module_is_started(get_module(HCI_MODULE))) {
     LOG_ERROR(LOG_TAG,
     "%s HCI_MODULE failed to start, Killing the bluetooth process", __func__);
     /* Killing the process to force a restart as part of fault tolerance */
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of osi_malloc() and osi_free() with the allocation tracker enabled,
+// from one and from several threads at once. Each iteration allocates a
+// batch of buffers, then frees them.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
+
+using ::benchmark::State;
+
+// Buffers allocated per iteration
+static const size_t kBatchSize = 64;
+
+// Argument: size of the buffers
+static void BM_OsiMallocFree(State& state) {
+  std::vector<void*> buffers(kBatchSize);
+  for (auto _ : state) {
+    for (void*& buffer : buffers) buffer = osi_malloc(state.range(0));
+    for (void* buffer : buffers) osi_free(buffer);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_OsiMallocFree)
+    ->Arg(64)
+    ->Arg(1024)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+  allocation_tracker_init();
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
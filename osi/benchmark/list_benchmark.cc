@@ -0,0 +1,71 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Push/pop throughput of list_t used as a packet queue, the way fixed_queue
+// and the L2CAP link queues use it: each iteration appends a batch of
+// elements, then removes them from the front.
+//
+// The lists either allocate a node for every element, as they did before
+// the node reuse, keep the default number of free nodes, or have a pool of
+// preallocated nodes.
+
+#include <benchmark/benchmark.h>
+
+#include "osi/include/list.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Size of the node pool of the pooled lists
+constexpr size_t kPoolSize = 64;
+
+void run_push_pop(State& state, list_t* list) {
+  int elements[kPoolSize];
+  size_t batch = state.range(0);
+  for (auto _ : state) {
+    for (size_t i = 0; i < batch; i++) list_append(list, &elements[i]);
+    while (!list_is_empty(list)) list_remove(list, list_front(list));
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+  list_free(list);
+}
+
+}  // namespace
+
+// Argument: number of elements queued per iteration
+static void BM_ListPushPopNoReuse(State& state) {
+  run_push_pop(state, list_new_pooled(NULL, 0));
+}
+BENCHMARK(BM_ListPushPopNoReuse)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_ListPushPop(State& state) {
+  run_push_pop(state, list_new(NULL));
+}
+BENCHMARK(BM_ListPushPop)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_ListPushPopPooled(State& state) {
+  run_push_pop(state, list_new_pooled(NULL, kPoolSize));
+}
+BENCHMARK(BM_ListPushPopPooled)->Arg(1)->Arg(16)->Arg(64);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
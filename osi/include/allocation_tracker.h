@@ -47,6 +47,13 @@ size_t allocation_tracker_expect_no_allocations(void);
 void* allocation_tracker_notify_alloc(allocator_id_t allocator_id, void* ptr,
                                       size_t requested_size);
 
+// Same as |allocation_tracker_notify_alloc|, for an allocation made from the
+// code address |caller|. The allocations are aggregated by caller in the
+// debug dump.
+void* allocation_tracker_notify_alloc_from(allocator_id_t allocator_id,
+                                           void* ptr, size_t requested_size,
+                                           void* caller);
+
 // Notify the tracker of an allocation that is being freed. |ptr| must be a
 // pointer returned by a call to |allocation_tracker_notify_alloc| with the
 // same |allocator_id|. If |ptr| is NULL, this function does nothing. Returns
@@ -41,8 +41,18 @@ typedef bool (*list_iter_cb)(void* data, void* context);
 // list element is removed from the list. It can be used to release resources
 // held by the list element, e.g. memory or file descriptor. |callback| may
 // be NULL if no cleanup is necessary on element removal.
+//
+// The list keeps a few of the nodes of its removed elements to reuse them,
+// so an element doesn't cost an allocation once the list has grown to its
+// usual length.
 list_t* list_new(list_free_cb callback);
 
+// Same as |list_new|, for a list that keeps up to |pool_size| nodes for
+// reuse, all allocated at once when the list is created. Inserting an
+// element doesn't allocate while the list holds at most |pool_size|
+// elements. A |pool_size| of 0 disables the reuse of the nodes.
+list_t* list_new_pooled(list_free_cb callback, size_t pool_size);
+
 // Frees the list. This function accepts NULL as an argument, in which case it
 // behaves like a no-op.
 void list_free(list_t* list);
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lightweight event tracing.
+//
+// Tracepoints record fixed-size binary events in a ring buffer owned by the
+// calling thread, so recording takes no lock. The rings are allocated on the
+// first event of each thread while tracing is enabled, and keep the last
+// OSI_TRACE_RING_EVENTS events of their thread. The ring of a thread that
+// exited keeps its events until a new thread reuses it. The rings are exported
+// on demand in the Chrome trace event JSON format, which chrome://tracing and
+// the Perfetto UI open.
+//
+// Tracing is disabled by default; a disabled tracepoint costs one relaxed
+// load and a branch.
+
+// Events kept per thread
+#define OSI_TRACE_RING_EVENTS 4096
+
+typedef enum {
+  OSI_TRACE_BEGIN,   // start of a slice
+  OSI_TRACE_END,     // end of the last slice begun on the thread
+  OSI_TRACE_COUNTER, // value of a counter
+  OSI_TRACE_INSTANT, // single point in time, with an argument
+} osi_trace_type_t;
+
+extern bool osi_trace_enabled_;
+
+// Return true if tracing is enabled.
+static inline bool osi_trace_is_enabled(void) {
+  return __atomic_load_n(&osi_trace_enabled_, __ATOMIC_RELAXED);
+}
+
+// Enable or disable tracing. Events already recorded are kept.
+void osi_trace_set_enabled(bool enabled);
+
+// Record an event of |type| named |name| with the argument |value| on the
+// calling thread. |name| must be a string with static storage, e.g. a
+// literal. Use the OSI_TRACE_* macros rather than calling this directly.
+void osi_trace_event(osi_trace_type_t type, const char* name, int64_t value);
+
+// Drop all the recorded events.
+void osi_trace_clear(void);
+
+// Write the recorded events to |fd| as a Chrome trace event JSON document.
+void osi_trace_dump_json(int fd);
+
+// Dump the tracing state to the |fd| file descriptor.
+void osi_trace_debug_dump(int fd);
+
+#define OSI_TRACE_EVENT_(type, name, value)                \
+  do {                                                     \
+    if (osi_trace_is_enabled())                            \
+      osi_trace_event((type), (name), (int64_t)(value));   \
+  } while (0)
+
+// Mark the beginning and the end of a slice on the calling thread. Slices
+// nest; each OSI_TRACE_BEGIN must be matched by an OSI_TRACE_END on the
+// same thread.
+#define OSI_TRACE_BEGIN(name) OSI_TRACE_EVENT_(OSI_TRACE_BEGIN, name, 0)
+#define OSI_TRACE_END(name) OSI_TRACE_EVENT_(OSI_TRACE_END, name, 0)
+
+// Record the current |value| of the counter |name|.
+#define OSI_TRACE_COUNTER(name, value) \
+  OSI_TRACE_EVENT_(OSI_TRACE_COUNTER, name, value)
+
+// Record an instant event |name| with the argument |value|.
+#define OSI_TRACE_INSTANT(name, value) \
+  OSI_TRACE_EVENT_(OSI_TRACE_INSTANT, name, value)
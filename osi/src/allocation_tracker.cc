@@ -21,11 +21,16 @@
 #include "osi/include/allocation_tracker.h"
 
 #include <base/logging.h>
+#include <dlfcn.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <pthread.h>
 #include <unordered_map>
+#include <vector>
 #include <sys/time.h>
 #include <sys/types.h>
 
@@ -34,27 +39,53 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 
+// The allocations are tracked in ALLOCATION_TRACKER_SHARDS shards, picked by
+// a hash of the allocation address, each with its own lock, so threads
+// allocating at the same time rarely wait for each other. A shard keeps its
+// allocation records inline in an open addressing table, preallocated when
+// the tracker is initialized and grown when it is 3/4 full.
+#define ALLOCATION_TRACKER_SHARDS 16
+#define ALLOCATION_TRACKER_SHARD_CAPACITY 1024
+
+// Call sites aggregated per shard. The allocations of the call sites beyond
+// are aggregated together.
+#define ALLOCATION_TRACKER_SHARD_SITES 256
+
+// Call sites listed by the debug dump
+#define ALLOCATION_TRACKER_DUMP_SITES 16
+
+#define ALLOCATION_TRACKER_NUM_ALLOCATORS 256
+
 typedef struct {
-  uint8_t allocator_id;
-  void* ptr;
+  void* ptr; /* NULL if the slot is empty */
+  void* caller;
   size_t size;
-  bool freed;
+  allocator_id_t allocator_id;
 } allocation_t;
 
+typedef struct {
+  void* caller; /* NULL if the slot is empty */
+  size_t alloc_count;
+  size_t live_count;
+  size_t live_size;
+} allocation_site_t;
+
+typedef struct {
+  size_t alloc_count;
+  size_t free_count;
+  size_t alloc_size;
+  size_t free_size;
+} allocation_stats_t;
+
 static const size_t canary_size = 8;
 static char g_beginning_canary[canary_size];
 static char g_end_canary[canary_size];
-static std::unordered_map<void*, allocation_t*> allocations;
 static std::mutex tracker_lock;
-static bool enabled = false;
-
-// Memory allocation statistics
-static size_t alloc_counter = 0;
-static size_t free_counter = 0;
-static size_t alloc_total_size = 0;
-static size_t free_total_size = 0;
+static std::atomic<bool> enabled(false);
 
 #define ALLOCATION_TRACK_MAX 16384
+#define ALLOCATION_TRACK_SHARD_MAX \
+  (ALLOCATION_TRACK_MAX / ALLOCATION_TRACKER_SHARDS)
 #ifdef ALOCATION_TRACKER_DEBUG
 #define ALLOCATION_TRACK_NUM_CALLERS 2
 #else
@@ -76,11 +107,154 @@ typedef struct {
     void* ptr;
     size_t size;
     void *callers[ALLOCATION_TRACK_NUM_CALLERS];
-  } allocations_track[ALLOCATION_TRACK_MAX];
+  } allocations_track[ALLOCATION_TRACK_SHARD_MAX];
   uint32_t allocations_track_index;
 } allocation_debug_t;
 
-allocation_debug_t allocation_debug;
+typedef struct alignas(64) {
+  std::mutex lock;
+  allocation_t* allocations;
+  size_t capacity; /* power of 2 */
+  size_t count;
+  allocation_site_t sites[ALLOCATION_TRACKER_SHARD_SITES];
+  allocation_site_t other_sites;
+  allocation_stats_t stats[ALLOCATION_TRACKER_NUM_ALLOCATORS];
+  allocation_debug_t allocation_debug;
+} allocation_shard_t;
+
+static allocation_shard_t shards[ALLOCATION_TRACKER_SHARDS];
+
+static inline uint64_t allocation_hash(const void* ptr) {
+  return ((uint64_t)(uintptr_t)ptr >> 3) * 0x9e3779b97f4a7c15ULL;
+}
+
+static inline allocation_shard_t* allocation_shard(uint64_t hash) {
+  return &shards[hash >> 60];
+}
+
+static inline size_t allocation_slot(uint64_t hash, size_t capacity) {
+  return (size_t)(hash >> 24) & (capacity - 1);
+}
+
+// Return the slot of |ptr| in |shard|, or of the empty slot where it would be
+// inserted.
+static size_t allocation_find(const allocation_shard_t* shard, uint64_t hash,
+                              const void* ptr) {
+  size_t mask = shard->capacity - 1;
+  size_t slot = allocation_slot(hash, shard->capacity);
+  while (shard->allocations[slot].ptr != NULL &&
+         shard->allocations[slot].ptr != ptr)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+static void allocation_shard_alloc_table(allocation_shard_t* shard,
+                                         size_t capacity) {
+  shard->allocations = (allocation_t*)calloc(capacity, sizeof(allocation_t));
+  CHECK(shard->allocations);
+  shard->capacity = capacity;
+}
+
+static void allocation_shard_grow(allocation_shard_t* shard) {
+  allocation_t* allocations = shard->allocations;
+  size_t capacity = shard->capacity;
+
+  allocation_shard_alloc_table(shard, capacity * 2);
+  for (size_t i = 0; i < capacity; i++) {
+    if (allocations[i].ptr == NULL) continue;
+    size_t slot =
+        allocation_find(shard, allocation_hash(allocations[i].ptr),
+                        allocations[i].ptr);
+    shard->allocations[slot] = allocations[i];
+  }
+  free(allocations);
+}
+
+// Remove the record in |slot| of |shard|, shifting back the records of the
+// same probe sequence so lookups don't need tombstones.
+static void allocation_remove(allocation_shard_t* shard, size_t slot) {
+  size_t mask = shard->capacity - 1;
+  size_t hole = slot;
+  for (size_t next = (slot + 1) & mask; shard->allocations[next].ptr != NULL;
+       next = (next + 1) & mask) {
+    size_t home = allocation_slot(allocation_hash(shard->allocations[next].ptr),
+                                  shard->capacity);
+    // Move the record to the hole if its home slot isn't between the hole
+    // and its current slot, cyclically.
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      shard->allocations[hole] = shard->allocations[next];
+      hole = next;
+    }
+  }
+  shard->allocations[hole].ptr = NULL;
+  shard->count--;
+}
+
+static allocation_site_t* allocation_site(allocation_shard_t* shard,
+                                          void* caller) {
+  size_t slot = (size_t)(allocation_hash(caller) >> 24) %
+                ALLOCATION_TRACKER_SHARD_SITES;
+  for (size_t i = 0; i < ALLOCATION_TRACKER_SHARD_SITES; i++) {
+    allocation_site_t* site = &shard->sites[slot];
+    if (site->caller == caller) return site;
+    if (site->caller == NULL) {
+      site->caller = caller;
+      return site;
+    }
+    slot = (slot + 1) % ALLOCATION_TRACKER_SHARD_SITES;
+  }
+  return &shard->other_sites;
+}
+
+// Return the tid of the calling thread, without a system call after the
+// first one.
+static pid_t allocation_tid(void) {
+  static thread_local pid_t tid = 0;
+  if (tid == 0) tid = gettid();
+  return tid;
+}
+
+// Record the |event| of |ptr| in the history of |shard|. |caller| is the
+// caller of the allocator, |entry| the return address in the allocator.
+static void allocation_track(allocation_shard_t* shard,
+                             allocation_event_t event, void* ptr, size_t size,
+                             void* caller, UNUSED_ATTR void* entry) {
+  allocation_debug_t* allocation_debug = &shard->allocation_debug;
+  allocation_debug_t::allocation_track_t* track =
+      &allocation_debug->allocations_track[allocation_debug
+                                               ->allocations_track_index];
+  track->tid = allocation_tid();
+  track->allocation_event = event;
+  track->size = size;
+  track->callers[0] = caller;
+#if (ALLOCATION_TRACK_NUM_CALLERS > 1)
+  track->callers[1] = entry;
+#endif
+  {
+    struct timeval tv;
+    struct timezone tz;
+    gettimeofday(&tv, &tz);
+    track->time.hh = tv.tv_sec / 3600 % 24;
+    track->time.mm = (tv.tv_sec % 3600) / 60;
+    track->time.ss = tv.tv_sec % 60;
+    track->time.usec = tv.tv_usec;
+  }
+  track->ptr = ptr;
+  allocation_debug->allocations_track_index =
+      (allocation_debug->allocations_track_index + 1) %
+      ALLOCATION_TRACK_SHARD_MAX;
+}
+
+// Drop the allocation records and call sites of |shard|. The lock of |shard|
+// must be held.
+static void allocation_shard_clear(allocation_shard_t* shard) {
+  if (shard->allocations != NULL)
+    memset(shard->allocations, 0, shard->capacity * sizeof(allocation_t));
+  shard->count = 0;
+  memset(shard->sites, 0, sizeof(shard->sites));
+  memset(&shard->other_sites, 0, sizeof(shard->other_sites));
+  shard->allocation_debug.allocations_track_index = 0;
+}
 
 void allocation_tracker_init(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
@@ -94,9 +268,14 @@ void allocation_tracker_init(void) {
 
   LOG_DEBUG(LOG_TAG, "canary initialized");
 
-  allocation_debug.allocations_track_index = 0;
+  for (allocation_shard_t& shard : shards) {
+    std::unique_lock<std::mutex> shard_lock(shard.lock);
+    if (shard.allocations == NULL)
+      allocation_shard_alloc_table(&shard, ALLOCATION_TRACKER_SHARD_CAPACITY);
+    allocation_shard_clear(&shard);
+  }
 
-  enabled = true;
+  enabled.store(true, std::memory_order_release);
 }
 
 // Test function only. Do not call in the normal course of operations.
@@ -104,16 +283,21 @@ void allocation_tracker_uninit(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
   if (!enabled) return;
 
-  allocations.clear();
-  enabled = false;
+  enabled.store(false, std::memory_order_relaxed);
+  for (allocation_shard_t& shard : shards) {
+    std::unique_lock<std::mutex> shard_lock(shard.lock);
+    allocation_shard_clear(&shard);
+  }
 }
 
 void allocation_tracker_reset(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
   if (!enabled) return;
 
-  allocations.clear();
-  allocation_debug.allocations_track_index=0;
+  for (allocation_shard_t& shard : shards) {
+    std::unique_lock<std::mutex> shard_lock(shard.lock);
+    allocation_shard_clear(&shard);
+  }
 }
 
 size_t allocation_tracker_expect_no_allocations(void) {
@@ -122,9 +306,11 @@ size_t allocation_tracker_expect_no_allocations(void) {
 
   size_t unfreed_memory_size = 0;
 
-  for (const auto& entry : allocations) {
-    allocation_t* allocation = entry.second;
-    if (!allocation->freed) {
+  for (allocation_shard_t& shard : shards) {
+    std::unique_lock<std::mutex> shard_lock(shard.lock);
+    for (size_t i = 0; i < shard.capacity; i++) {
+      const allocation_t* allocation = &shard.allocations[i];
+      if (allocation->ptr == NULL) continue;
       unfreed_memory_size +=
           allocation->size;  // Report back the unfreed byte count
       LOG_ERROR(LOG_TAG,
@@ -138,54 +324,45 @@ size_t allocation_tracker_expect_no_allocations(void) {
 
 void* allocation_tracker_notify_alloc(uint8_t allocator_id, void* ptr,
                                       size_t requested_size) {
-  char* return_ptr;
+  return allocation_tracker_notify_alloc_from(
+      allocator_id, ptr, requested_size, __builtin_return_address(0));
+}
+
+void* allocation_tracker_notify_alloc_from(uint8_t allocator_id, void* ptr,
+                                           size_t requested_size,
+                                           void* caller) {
+  if (!enabled.load(std::memory_order_acquire) || !ptr) return ptr;
+
+  char* return_ptr = ((char*)ptr) + canary_size;
+  uint64_t hash = allocation_hash(return_ptr);
+  allocation_shard_t* shard = allocation_shard(hash);
   {
-    std::unique_lock<std::mutex> lock(tracker_lock);
-    if (!enabled || !ptr) return ptr;
+    std::unique_lock<std::mutex> lock(shard->lock);
+
+    if ((shard->count + 1) * 4 > shard->capacity * 3)
+      allocation_shard_grow(shard);
+
+    size_t slot = allocation_find(shard, hash, return_ptr);
+    allocation_t* allocation = &shard->allocations[slot];
+    CHECK(allocation->ptr == NULL);  // Must have been freed before
+    allocation->ptr = return_ptr;
+    allocation->caller = caller;
+    allocation->size = requested_size;
+    allocation->allocator_id = allocator_id;
+    shard->count++;
 
     // Keep statistics
-    alloc_counter++;
-    alloc_total_size += allocation_tracker_resize_for_canary(requested_size);
-
-    return_ptr = ((char*)ptr) + canary_size;
-
-    auto map_entry = allocations.find(return_ptr);
-    allocation_t* allocation;
-    if (map_entry != allocations.end()) {
-      allocation = map_entry->second;
-      CHECK(allocation->freed);  // Must have been freed before
-    } else {
-      allocation = (allocation_t*)calloc(1, sizeof(allocation_t));
-      allocations[return_ptr] = allocation;
-    }
+    allocation_stats_t* stats = &shard->stats[allocator_id];
+    stats->alloc_count++;
+    stats->alloc_size += allocation_tracker_resize_for_canary(requested_size);
 
-    if (allocation) {
-      allocation->allocator_id = allocator_id;
-      allocation->freed = false;
-      allocation->size = requested_size;
-      allocation->ptr = return_ptr;
-
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].tid = gettid();
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].allocation_event = ALLOCATION_TRACK_EVENT_ALLOC;
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].size = requested_size;
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].callers[0] = __builtin_return_address(0);
-#if (ALLOCATION_TRACK_NUM_CALLERS>1)
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].callers[1] = __builtin_return_address(1);
-#endif
-      {
-        struct timeval tv;
-        struct timezone tz;
-        gettimeofday(&tv, &tz);
-        allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.hh = tv.tv_sec/3600%24;
-        allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.mm = (tv.tv_sec%3600)/60;
-        allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.ss = tv.tv_sec%60;
-        allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.usec = tv.tv_usec;
-      }
-      allocation_debug.allocations_track[allocation_debug.allocations_track_index].ptr = (void *)return_ptr;
-      allocation_debug.allocations_track_index = (allocation_debug.allocations_track_index+1) % ALLOCATION_TRACK_MAX;
-    } else {
-      LOG_ERROR(LOG_TAG, "%s Memory not allocated for allocation." ,__func__);
-    }
+    allocation_site_t* site = allocation_site(shard, caller);
+    site->alloc_count++;
+    site->live_count++;
+    site->live_size += requested_size;
+
+    allocation_track(shard, ALLOCATION_TRACK_EVENT_ALLOC, return_ptr,
+                     requested_size, caller, __builtin_return_address(0));
   }
 
   // Add the canary on both sides
@@ -197,62 +374,70 @@ void* allocation_tracker_notify_alloc(uint8_t allocator_id, void* ptr,
 
 void* allocation_tracker_notify_free(UNUSED_ATTR uint8_t allocator_id,
                                      void* ptr) {
-  std::unique_lock<std::mutex> lock(tracker_lock);
+  if (!enabled.load(std::memory_order_acquire) || !ptr) return ptr;
 
-  if (!enabled || !ptr) return ptr;
+  uint64_t hash = allocation_hash(ptr);
+  allocation_shard_t* shard = allocation_shard(hash);
+  size_t size;
+  {
+    std::unique_lock<std::mutex> lock(shard->lock);
 
-  auto map_entry = allocations.find(ptr);
-  CHECK(map_entry != allocations.end());
-  allocation_t* allocation = map_entry->second;
-  CHECK(allocation);          // Must have been tracked before
-  CHECK(!allocation->freed);  // Must not be a double free
-  CHECK(allocation->allocator_id ==
-        allocator_id);  // Must be from the same allocator
+    // Double-free of memory is detected here, as the record of the
+    // allocation is removed when it is freed.
+    size_t slot = allocation_find(shard, hash, ptr);
+    allocation_t* allocation = &shard->allocations[slot];
+    CHECK(allocation->ptr != NULL);  // Must have been tracked before
+    CHECK(allocation->allocator_id ==
+          allocator_id);  // Must be from the same allocator
+    size = allocation->size;
 
-  // Keep statistics
-  free_counter++;
-  free_total_size += allocation_tracker_resize_for_canary(allocation->size);
+    // Keep statistics
+    allocation_stats_t* stats = &shard->stats[allocator_id];
+    stats->free_count++;
+    stats->free_size += allocation_tracker_resize_for_canary(size);
 
-  allocation->freed = true;
+    allocation_site_t* site = allocation_site(shard, allocation->caller);
+    site->live_count--;
+    site->live_size -= size;
 
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].tid = gettid();
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].allocation_event = ALLOCATION_TRACK_EVENT_FREE;
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].size = 0;
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].callers[0] = __builtin_return_address(0);
-#if (ALLOCATION_TRACK_NUM_CALLERS>1)
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].callers[1] = __builtin_return_address(1);
-#endif
-  {
-    struct timeval tv;
-    struct timezone tz;
-    gettimeofday(&tv, &tz);
-    allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.hh = tv.tv_sec/3600%24;
-    allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.mm = (tv.tv_sec%3600)/60;
-    allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.ss = tv.tv_sec%60;
-    allocation_debug.allocations_track[allocation_debug.allocations_track_index].time.usec = tv.tv_usec;
+    allocation_track(shard, ALLOCATION_TRACK_EVENT_FREE, ptr, 0,
+                     __builtin_return_address(0), NULL);
+    allocation_remove(shard, slot);
   }
-  allocation_debug.allocations_track[allocation_debug.allocations_track_index].ptr = (void *)ptr;
-  allocation_debug.allocations_track_index = (allocation_debug.allocations_track_index+1) % ALLOCATION_TRACK_MAX;
 
   UNUSED_ATTR const char* beginning_canary = ((char*)ptr) - canary_size;
-  UNUSED_ATTR const char* end_canary = ((char*)ptr) + allocation->size;
+  UNUSED_ATTR const char* end_canary = ((char*)ptr) + size;
 
   for (size_t i = 0; i < canary_size; i++) {
     CHECK(beginning_canary[i] == g_beginning_canary[i]);
     CHECK(end_canary[i] == g_end_canary[i]);
   }
 
-  // Free the hash map entry to avoid unlimited memory usage growth.
-  // Double-free of memory is detected with "assert(allocation)" above
-  // as the allocation entry will not be present.
-  allocations.erase(ptr);
-  free(allocation);
-
   return ((char*)ptr) - canary_size;
 }
 
 size_t allocation_tracker_resize_for_canary(size_t size) {
-  return (!enabled) ? size : size + (2 * canary_size);
+  return (!enabled.load(std::memory_order_relaxed)) ? size
+                                                     : size + (2 * canary_size);
+}
+
+// Print |site| as the module of its caller and the offset in it, which
+// addr2line resolves.
+static void allocation_site_dump(int fd, const allocation_site_t& site) {
+  Dl_info info;
+  if (site.caller != NULL && dladdr(site.caller, &info) != 0 &&
+      info.dli_fname != NULL) {
+    const char* module = strrchr(info.dli_fname, '/');
+    module = (module != NULL) ? module + 1 : info.dli_fname;
+    dprintf(fd, "    %s+0x%" PRIxPTR, module,
+            (uintptr_t)site.caller - (uintptr_t)info.dli_fbase);
+  } else if (site.caller != NULL) {
+    dprintf(fd, "    %p", site.caller);
+  } else {
+    dprintf(fd, "    (other call sites)");
+  }
+  dprintf(fd, ": %zu live / %zu octets, %zu allocations\n", site.live_count,
+          site.live_size, site.alloc_count);
 }
 
 void osi_allocator_debug_dump(int fd) {
@@ -260,9 +445,74 @@ void osi_allocator_debug_dump(int fd) {
 
   std::unique_lock<std::mutex> lock(tracker_lock);
 
+  allocation_stats_t total = {};
+  std::vector<allocation_stats_t> allocators(ALLOCATION_TRACKER_NUM_ALLOCATORS);
+  std::unordered_map<void*, allocation_site_t> sites;
+  allocation_site_t other_sites = {};
+  size_t count = 0, capacity = 0;
+
+  for (allocation_shard_t& shard : shards) {
+    std::unique_lock<std::mutex> shard_lock(shard.lock);
+    count += shard.count;
+    capacity += shard.capacity;
+    for (size_t i = 0; i < ALLOCATION_TRACKER_NUM_ALLOCATORS; i++) {
+      allocators[i].alloc_count += shard.stats[i].alloc_count;
+      allocators[i].free_count += shard.stats[i].free_count;
+      allocators[i].alloc_size += shard.stats[i].alloc_size;
+      allocators[i].free_size += shard.stats[i].free_size;
+    }
+    for (const allocation_site_t& site : shard.sites) {
+      if (site.caller == NULL) continue;
+      allocation_site_t& merged = sites[site.caller];
+      merged.caller = site.caller;
+      merged.alloc_count += site.alloc_count;
+      merged.live_count += site.live_count;
+      merged.live_size += site.live_size;
+    }
+    other_sites.alloc_count += shard.other_sites.alloc_count;
+    other_sites.live_count += shard.other_sites.live_count;
+    other_sites.live_size += shard.other_sites.live_size;
+  }
+
+  for (const allocation_stats_t& stats : allocators) {
+    total.alloc_count += stats.alloc_count;
+    total.free_count += stats.free_count;
+    total.alloc_size += stats.alloc_size;
+    total.free_size += stats.free_size;
+  }
+
   dprintf(fd, "  Total allocated/free/used counts : %zu / %zu / %zu\n",
-          alloc_counter, free_counter, alloc_counter - free_counter);
+          total.alloc_count, total.free_count,
+          total.alloc_count - total.free_count);
   dprintf(fd, "  Total allocated/free/used octets : %zu / %zu / %zu\n",
-          alloc_total_size, free_total_size,
-          alloc_total_size - free_total_size);
+          total.alloc_size, total.free_size,
+          total.alloc_size - total.free_size);
+
+  if (!enabled) return;
+
+  dprintf(fd, "  Tracked allocations / capacity   : %zu / %zu in %d shards\n",
+          count, capacity, ALLOCATION_TRACKER_SHARDS);
+  for (size_t i = 0; i < ALLOCATION_TRACKER_NUM_ALLOCATORS; i++) {
+    const allocation_stats_t& stats = allocators[i];
+    if (stats.alloc_count == 0) continue;
+    dprintf(fd, "  Allocator %3zu used counts/octets : %zu / %zu\n", i,
+            stats.alloc_count - stats.free_count,
+            stats.alloc_size - stats.free_size);
+  }
+
+  // Leak report: the call sites holding the most memory
+  std::vector<allocation_site_t> live_sites;
+  for (const auto& entry : sites)
+    if (entry.second.live_count > 0) live_sites.push_back(entry.second);
+  if (other_sites.live_count > 0) live_sites.push_back(other_sites);
+  std::sort(live_sites.begin(), live_sites.end(),
+            [](const allocation_site_t& a, const allocation_site_t& b) {
+              return a.live_size > b.live_size;
+            });
+
+  dprintf(fd, "  Live allocations by call site, largest first (%zu sites):\n",
+          live_sites.size());
+  for (size_t i = 0;
+       i < live_sites.size() && i < ALLOCATION_TRACKER_DUMP_SITES; i++)
+    allocation_site_dump(fd, live_sites[i]);
 }
@@ -31,7 +31,8 @@ char* osi_strdup(const char* str) {
   CHECK(ptr);
 
   char* new_string = static_cast<char*>(
-      allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size));
+      allocation_tracker_notify_alloc_from(alloc_allocator_id, ptr, size,
+                                           __builtin_return_address(0)));
   if (!new_string) return NULL;
 
   memcpy(new_string, str, size);
@@ -47,7 +48,8 @@ char* osi_strndup(const char* str, size_t len) {
   CHECK(ptr);
 
   char* new_string = static_cast<char*>(
-      allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size + 1));
+      allocation_tracker_notify_alloc_from(alloc_allocator_id, ptr, size + 1,
+                                           __builtin_return_address(0)));
   if (!new_string) return NULL;
 
   memcpy(new_string, str, size);
@@ -59,14 +61,16 @@ void* osi_malloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
   void* ptr = malloc(real_size);
   CHECK(ptr);
-  return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
+  return allocation_tracker_notify_alloc_from(alloc_allocator_id, ptr, size,
+                                              __builtin_return_address(0));
 }
 
 void* osi_calloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
   void* ptr = calloc(1, real_size);
   CHECK(ptr);
-  return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
+  return allocation_tracker_notify_alloc_from(alloc_allocator_id, ptr, size,
+                                              __builtin_return_address(0));
 }
 
 void osi_free(void* ptr) {
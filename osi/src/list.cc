@@ -4,6 +4,9 @@
 #include "osi/include/list.h"
 #include "osi/include/osi.h"
 
+// Free nodes kept for reuse by the lists created with |list_new|
+#define LIST_NODE_CACHE_SIZE 16
+
 struct list_node_t {
   struct list_node_t* next;
   void* data;
@@ -15,8 +18,18 @@ typedef struct list_t {
   size_t length;
   list_free_cb free_cb;
   const allocator_t* allocator;
+  // Nodes of the removed elements, reused by the next insertions. At most
+  // |free_nodes_max| nodes allocated one by one are kept; the nodes of
+  // |slab| always are.
+  list_node_t* free_nodes;
+  size_t free_nodes_count;
+  size_t free_nodes_max;
+  list_node_t* slab; /* nodes preallocated by |list_new_pooled| */
+  size_t slab_size;
 } list_t;
 
+static bool list_node_in_slab_(const list_t* list, const list_node_t* node);
+static list_node_t* list_alloc_node_(list_t* list);
 static list_node_t* list_free_node_(list_t* list, list_node_t* node);
 
 // Hidden constructor, only to be used by the hash map for the allocation
@@ -29,6 +42,7 @@ list_t* list_new_internal(list_free_cb callback,
 
   list->free_cb = callback;
   list->allocator = zeroed_allocator;
+  list->free_nodes_max = LIST_NODE_CACHE_SIZE;
   return list;
 }
 
@@ -36,10 +50,38 @@ list_t* list_new(list_free_cb callback) {
   return list_new_internal(callback, &allocator_calloc);
 }
 
+list_t* list_new_pooled(list_free_cb callback, size_t pool_size) {
+  list_t* list = list_new_internal(callback, &allocator_calloc);
+  if (!list) return NULL;
+
+  list->free_nodes_max = pool_size;
+  if (pool_size == 0) return list;
+
+  list->slab = (list_node_t*)list->allocator->alloc(pool_size *
+                                                    sizeof(list_node_t));
+  if (!list->slab) {
+    list->allocator->free(list);
+    return NULL;
+  }
+  list->slab_size = pool_size;
+  for (size_t i = 0; i < pool_size; i++) {
+    list->slab[i].next = list->free_nodes;
+    list->free_nodes = &list->slab[i];
+  }
+  list->free_nodes_count = pool_size;
+  return list;
+}
+
 void list_free(list_t* list) {
   if (!list) return;
 
   list_clear(list);
+  for (list_node_t* node = list->free_nodes; node;) {
+    list_node_t* next = node->next;
+    if (!list_node_in_slab_(list, node)) list->allocator->free(node);
+    node = next;
+  }
+  if (list->slab) list->allocator->free(list->slab);
   list->allocator->free(list);
 }
 
@@ -91,7 +133,7 @@ bool list_insert_after(list_t* list, list_node_t* prev_node, void* data) {
   CHECK(prev_node != NULL);
   CHECK(data != NULL);
 
-  list_node_t* node = (list_node_t*)list->allocator->alloc(sizeof(list_node_t));
+  list_node_t* node = list_alloc_node_(list);
   if (!node) return false;
 
   node->next = prev_node->next;
@@ -106,7 +148,7 @@ bool list_prepend(list_t* list, void* data) {
   CHECK(list != NULL);
   CHECK(data != NULL);
 
-  list_node_t* node = (list_node_t*)list->allocator->alloc(sizeof(list_node_t));
+  list_node_t* node = list_alloc_node_(list);
   if (!node) return false;
   node->next = list->head;
   node->data = data;
@@ -120,7 +162,7 @@ bool list_append(list_t* list, void* data) {
   CHECK(list != NULL);
   CHECK(data != NULL);
 
-  list_node_t* node = (list_node_t*)list->allocator->alloc(sizeof(list_node_t));
+  list_node_t* node = list_alloc_node_(list);
   if (!node) return false;
   node->next = NULL;
   node->data = data;
@@ -201,6 +243,20 @@ void* list_node(const list_node_t* node) {
   return node->data;
 }
 
+static bool list_node_in_slab_(const list_t* list, const list_node_t* node) {
+  return (uintptr_t)node - (uintptr_t)list->slab <
+         list->slab_size * sizeof(list_node_t);
+}
+
+static list_node_t* list_alloc_node_(list_t* list) {
+  list_node_t* node = list->free_nodes;
+  if (!node) return (list_node_t*)list->allocator->alloc(sizeof(list_node_t));
+
+  list->free_nodes = node->next;
+  --list->free_nodes_count;
+  return node;
+}
+
 static list_node_t* list_free_node_(list_t* list, list_node_t* node) {
   CHECK(list != NULL);
   CHECK(node != NULL);
@@ -208,7 +264,14 @@ static list_node_t* list_free_node_(list_t* list, list_node_t* node) {
   list_node_t* next = node->next;
 
   if (list->free_cb) list->free_cb(node->data);
-  list->allocator->free(node);
+  if (list->free_nodes_count < list->free_nodes_max ||
+      list_node_in_slab_(list, node)) {
+    node->next = list->free_nodes;
+    list->free_nodes = node;
+    ++list->free_nodes_count;
+  } else {
+    list->allocator->free(node);
+  }
   --list->length;
 
   return next;
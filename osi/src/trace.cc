@@ -0,0 +1,351 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_trace"
+
+#include "osi/include/trace.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "osi/include/compat.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+// Maximum number of rings. The ring of a thread that exited is reused by the
+// next thread; events of the threads started while OSI_TRACE_MAX_RINGS traced
+// threads are alive are dropped.
+#define OSI_TRACE_MAX_RINGS 16
+
+// Size of the buffer the JSON document is written through
+#define OSI_TRACE_JSON_BUFFER_SIZE 4096
+
+typedef struct {
+  uint64_t timestamp_us;
+  const char* name;
+  int64_t value;
+  osi_trace_type_t type;
+} osi_trace_event_t;
+
+typedef struct {
+  // The owner and the exit fields are guarded by |rings_mutex|
+  pid_t tid;
+  char thread_name[16];
+  // Order in which the owner thread exited, 0 while it is alive. The ring of
+  // a thread that exited keeps its events until another thread reuses it.
+  uint64_t exit_order;
+  // |write_index| when the owner thread took the ring
+  uint64_t owner_index;
+  // Number of events written to the ring since its creation. Only the
+  // owner thread writes it; the event at |write_index| % OSI_TRACE_RING_EVENTS
+  // is published by the release store of |write_index| + 1.
+  std::atomic<uint64_t> write_index;
+  // Events before |clear_index| were dropped by |osi_trace_clear|.
+  std::atomic<uint64_t> clear_index;
+  osi_trace_event_t events[OSI_TRACE_RING_EVENTS];
+} osi_trace_ring_t;
+
+bool osi_trace_enabled_ = false;
+
+static std::mutex rings_mutex;
+static osi_trace_ring_t* rings[OSI_TRACE_MAX_RINGS];
+static size_t rings_count;
+static uint64_t rings_exited;
+static std::atomic<uint64_t> dropped_events(0);
+
+// Ring of the calling thread, set on its first event. Rings are never freed,
+// so a ring is still valid when an export reads it after its thread exited.
+static thread_local osi_trace_ring_t* thread_ring;
+static thread_local bool thread_ring_failed;
+
+// Releases the ring of the calling thread when it exits. It is only touched
+// when the ring is set, so the tracepoints keep reading the plain
+// |thread_ring| pointer.
+class ThreadRingHolder {
+ public:
+  ~ThreadRingHolder() {
+    if (ring_ == NULL) return;
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring_->exit_order = ++rings_exited;
+    // The events traced by later thread_local destructors are dropped
+    thread_ring = NULL;
+    thread_ring_failed = true;
+  }
+
+  void Set(osi_trace_ring_t* ring) { ring_ = ring; }
+
+ private:
+  osi_trace_ring_t* ring_ = NULL;
+};
+
+static thread_local ThreadRingHolder thread_ring_holder;
+
+// Return the ring of the thread that exited first, or NULL if all the owner
+// threads are alive. Must be called with |rings_mutex| held.
+static osi_trace_ring_t* osi_trace_find_exited_ring(void) {
+  osi_trace_ring_t* oldest = NULL;
+  for (size_t i = 0; i < rings_count; i++) {
+    if (rings[i]->exit_order == 0) continue;
+    if (oldest == NULL || rings[i]->exit_order < oldest->exit_order)
+      oldest = rings[i];
+  }
+  return oldest;
+}
+
+static osi_trace_ring_t* osi_trace_new_ring(void) {
+  std::lock_guard<std::mutex> lock(rings_mutex);
+  osi_trace_ring_t* ring;
+  if (rings_count < OSI_TRACE_MAX_RINGS) {
+    ring = new osi_trace_ring_t();
+    rings[rings_count++] = ring;
+  } else if ((ring = osi_trace_find_exited_ring()) != NULL) {
+    // Drop the events of the previous owner
+    ring->owner_index = ring->write_index.load(std::memory_order_relaxed);
+    ring->clear_index.store(ring->owner_index, std::memory_order_relaxed);
+    ring->exit_order = 0;
+  } else {
+    LOG_WARN(LOG_TAG, "%s: too many traced threads, dropping the events of %d",
+             __func__, gettid());
+    thread_ring_failed = true;
+    return NULL;
+  }
+
+  ring->tid = gettid();
+  if (prctl(PR_GET_NAME, (unsigned long)ring->thread_name) == -1)
+    snprintf(ring->thread_name, sizeof(ring->thread_name), "%d", ring->tid);
+  ring->thread_name[sizeof(ring->thread_name) - 1] = '\0';
+
+  thread_ring_holder.Set(ring);
+  thread_ring = ring;
+  return ring;
+}
+
+void osi_trace_set_enabled(bool enabled) {
+  __atomic_store_n(&osi_trace_enabled_, enabled, __ATOMIC_RELAXED);
+}
+
+void osi_trace_event(osi_trace_type_t type, const char* name, int64_t value) {
+  osi_trace_ring_t* ring = thread_ring;
+  if (ring == NULL) {
+    if (thread_ring_failed || (ring = osi_trace_new_ring()) == NULL) {
+      dropped_events.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  uint64_t index = ring->write_index.load(std::memory_order_relaxed);
+  osi_trace_event_t* event = &ring->events[index % OSI_TRACE_RING_EVENTS];
+  event->timestamp_us = time_get_os_boottime_us();
+  event->name = name;
+  event->value = value;
+  event->type = type;
+  ring->write_index.store(index + 1, std::memory_order_release);
+}
+
+void osi_trace_clear(void) {
+  std::lock_guard<std::mutex> lock(rings_mutex);
+  for (size_t i = 0; i < rings_count; i++) {
+    rings[i]->clear_index.store(
+        rings[i]->write_index.load(std::memory_order_acquire),
+        std::memory_order_relaxed);
+  }
+  dropped_events = 0;
+}
+
+// Copy the events of |ring| to |events|, oldest first. The owner thread keeps
+// writing while the ring is copied: the events it may have overwritten during
+// the copy are discarded.
+static void osi_trace_copy_ring(const osi_trace_ring_t* ring,
+                                std::vector<osi_trace_event_t>* events) {
+  uint64_t end = ring->write_index.load(std::memory_order_acquire);
+  uint64_t start = ring->clear_index.load(std::memory_order_relaxed);
+  if (end - start > OSI_TRACE_RING_EVENTS) start = end - OSI_TRACE_RING_EVENTS;
+
+  events->clear();
+  for (uint64_t i = start; i < end; i++)
+    events->push_back(ring->events[i % OSI_TRACE_RING_EVENTS]);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t written = ring->write_index.load(std::memory_order_relaxed);
+  if (written - start > OSI_TRACE_RING_EVENTS) {
+    uint64_t overwritten = written - OSI_TRACE_RING_EVENTS - start;
+    if (overwritten > events->size()) overwritten = events->size();
+    events->erase(events->begin(), events->begin() + overwritten);
+  }
+}
+
+// Buffered writer of the JSON document
+class JsonWriter {
+ public:
+  explicit JsonWriter(int fd) : fd_(fd), length_(0) {}
+  ~JsonWriter() { Flush(); }
+
+  void Printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer_ + length_, sizeof(buffer_) - length_,
+                           format, args);
+    va_end(args);
+    if (length < 0) return;
+    if ((size_t)length >= sizeof(buffer_) - length_) {
+      // Not enough room left: flush and format again
+      Flush();
+      va_start(args, format);
+      length = vsnprintf(buffer_, sizeof(buffer_), format, args);
+      va_end(args);
+      if (length < 0) return;
+      if ((size_t)length >= sizeof(buffer_)) length = sizeof(buffer_) - 1;
+    }
+    length_ += length;
+  }
+
+  // Append |str| as a JSON string, quotes included.
+  void String(const char* str) {
+    std::string escaped = "\"";
+    for (; *str != '\0'; str++) {
+      unsigned char c = *str;
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+        escaped += c;
+      } else if (c < 0x20) {
+        char hex[8];
+        snprintf(hex, sizeof(hex), "\\u%04x", c);
+        escaped += hex;
+      } else {
+        escaped += c;
+      }
+    }
+    escaped += '"';
+    Printf("%s", escaped.c_str());
+  }
+
+  void Flush() {
+    size_t written = 0;
+    while (written < length_) {
+      ssize_t ret;
+      OSI_NO_INTR(ret = write(fd_, buffer_ + written, length_ - written));
+      if (ret <= 0) break;
+      written += ret;
+    }
+    length_ = 0;
+  }
+
+ private:
+  int fd_;
+  size_t length_;
+  char buffer_[OSI_TRACE_JSON_BUFFER_SIZE];
+};
+
+static void osi_trace_write_event(JsonWriter* writer, pid_t pid, pid_t tid,
+                                  const osi_trace_event_t& event) {
+  static const char* const phases[] = {"B", "E", "C", "i"};
+
+  writer->Printf(",\n{\"name\":");
+  writer->String(event.name);
+  writer->Printf(",\"ph\":\"%s\",\"ts\":%" PRIu64 ",\"pid\":%d,\"tid\":%d",
+                 phases[event.type], event.timestamp_us, pid, tid);
+  switch (event.type) {
+    case OSI_TRACE_COUNTER:
+      writer->Printf(",\"args\":{\"value\":%" PRId64 "}}", event.value);
+      break;
+    case OSI_TRACE_INSTANT:
+      writer->Printf(",\"s\":\"t\",\"args\":{\"value\":%" PRId64 "}}",
+                     event.value);
+      break;
+    default:
+      writer->Printf("}");
+      break;
+  }
+}
+
+void osi_trace_dump_json(int fd) {
+  pid_t pid = getpid();
+  JsonWriter writer(fd);
+  writer.Printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  writer.Printf(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+      "\"args\":{\"name\":\"bluetooth\"}}",
+      pid, pid);
+
+  std::vector<osi_trace_event_t> events;
+  events.reserve(OSI_TRACE_RING_EVENTS);
+  for (size_t i = 0;; i++) {
+    // A ring is copied with its owner under the lock, so it is not reused
+    // during the copy; it is written out without the lock
+    pid_t tid;
+    char thread_name[sizeof(rings[0]->thread_name)];
+    {
+      std::lock_guard<std::mutex> lock(rings_mutex);
+      if (i >= rings_count) break;
+      tid = rings[i]->tid;
+      memcpy(thread_name, rings[i]->thread_name, sizeof(thread_name));
+      osi_trace_copy_ring(rings[i], &events);
+    }
+
+    writer.Printf(
+        ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"name\":",
+        pid, tid);
+    writer.String(thread_name);
+    writer.Printf("}}");
+
+    for (const osi_trace_event_t& event : events)
+      osi_trace_write_event(&writer, pid, tid, event);
+  }
+
+  writer.Printf("\n]}\n");
+}
+
+void osi_trace_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(rings_mutex);
+
+  dprintf(fd, "\nBluetooth Event Tracing:\n");
+  dprintf(fd, "  Enabled: %s\n", osi_trace_is_enabled() ? "true" : "false");
+  size_t rings_live = 0;
+  for (size_t i = 0; i < rings_count; i++) {
+    if (rings[i]->exit_order == 0) rings_live++;
+  }
+  dprintf(fd, "  Threads traced: %zu alive, %zu exited / %d rings\n",
+          rings_live, rings_count - rings_live, OSI_TRACE_MAX_RINGS);
+  dprintf(fd, "  Events dropped: %" PRIu64 "\n",
+          dropped_events.load(std::memory_order_relaxed));
+
+  for (size_t i = 0; i < rings_count; i++) {
+    const osi_trace_ring_t* ring = rings[i];
+    uint64_t end = ring->write_index.load(std::memory_order_relaxed);
+    uint64_t start = ring->clear_index.load(std::memory_order_relaxed);
+    uint64_t kept = end - start;
+    if (kept > OSI_TRACE_RING_EVENTS) kept = OSI_TRACE_RING_EVENTS;
+    dprintf(fd, "  %-16s (tid %d%s): %" PRIu64 " events, %" PRIu64 " kept\n",
+            ring->thread_name, ring->tid,
+            ring->exit_order != 0 ? ", exited" : "", end - ring->owner_index,
+            kept);
+  }
+  if (rings_count > 0)
+    dprintf(fd, "  Use --trace to export the events as Chrome trace JSON\n");
+}
@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
 #include "osi/include/allocation_tracker.h"
 
 void allocation_tracker_uninit(void);
@@ -62,3 +65,53 @@ TEST(AllocationTrackerTest, test_canaries_on) {
 
   free(dummy_allocation);
 }
+
+TEST(AllocationTrackerTest, test_many_allocations) {
+  allocation_tracker_uninit();
+  allocation_tracker_init();
+
+  // Enough allocations to grow the tables of the tracker
+  const size_t num_allocations = 20000;
+  size_t with_canary_size = allocation_tracker_resize_for_canary(4);
+  std::vector<void*> allocations;
+  for (size_t i = 0; i < num_allocations; i++) {
+    allocations.push_back(allocation_tracker_notify_alloc(
+        allocator_id, malloc(with_canary_size), 4));
+  }
+
+  // Free in another order than allocated, all but the first 10
+  for (size_t i = num_allocations - 1; i >= 10; i--)
+    free(allocation_tracker_notify_free(allocator_id, allocations[i]));
+  EXPECT_EQ(40U, allocation_tracker_expect_no_allocations());
+
+  for (size_t i = 0; i < 10; i++)
+    free(allocation_tracker_notify_free(allocator_id, allocations[i]));
+  EXPECT_EQ(0U, allocation_tracker_expect_no_allocations());
+}
+
+TEST(AllocationTrackerTest, test_concurrent_allocations) {
+  allocation_tracker_uninit();
+  allocation_tracker_init();
+
+  size_t with_canary_size = allocation_tracker_resize_for_canary(16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([with_canary_size]() {
+      std::vector<void*> allocations;
+      for (int i = 0; i < 10000; i++) {
+        allocations.push_back(allocation_tracker_notify_alloc(
+            allocator_id, malloc(with_canary_size), 16));
+        if (i % 3 == 0) {
+          free(allocation_tracker_notify_free(allocator_id,
+                                              allocations.back()));
+          allocations.pop_back();
+        }
+      }
+      for (void* allocation : allocations)
+        free(allocation_tracker_notify_free(allocator_id, allocation));
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(0U, allocation_tracker_expect_no_allocations());
+}
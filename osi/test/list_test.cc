@@ -4,6 +4,7 @@
 
 #include "AllocationTestHarness.h"
 
+#include "osi/include/allocator.h"
 #include "osi/include/list.h"
 #include "osi/include/osi.h"
 
@@ -209,3 +210,56 @@ TEST_F(ListTest, test_list_foreach_partial) {
 
   list_free(list);
 }
+
+TEST_F(ListTest, test_list_reuses_nodes) {
+  list_t* list = list_new(NULL);
+  int x[40];
+
+  // Grow past the nodes the list keeps, shrink, then grow again
+  for (int pass = 0; pass < 3; pass++) {
+    for (size_t i = 0; i < ARRAY_SIZE(x); ++i) list_append(list, &x[i]);
+    EXPECT_EQ(list_length(list), ARRAY_SIZE(x));
+    EXPECT_EQ(list_front(list), &x[0]);
+    EXPECT_EQ(list_back(list), &x[ARRAY_SIZE(x) - 1]);
+    for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+      EXPECT_TRUE(list_remove(list, &x[i]));
+    EXPECT_TRUE(list_is_empty(list));
+  }
+
+  list_free(list);
+}
+
+TEST_F(ListTest, test_pooled_list) {
+  list_t* list = list_new_pooled(osi_free, 4);
+  void* data[10];
+
+  // More elements than nodes in the pool
+  for (size_t i = 0; i < ARRAY_SIZE(data); ++i) {
+    data[i] = osi_malloc(4);
+    EXPECT_TRUE(list_prepend(list, data[i]));
+  }
+  EXPECT_EQ(list_length(list), ARRAY_SIZE(data));
+  EXPECT_EQ(list_front(list), data[ARRAY_SIZE(data) - 1]);
+
+  list_clear(list);
+  EXPECT_TRUE(list_is_empty(list));
+
+  for (size_t i = 0; i < 3; ++i) {
+    data[i] = osi_malloc(4);
+    EXPECT_TRUE(list_append(list, data[i]));
+  }
+  EXPECT_TRUE(list_remove(list, data[1]));
+  EXPECT_EQ(list_length(list), 2U);
+  EXPECT_EQ(list_back(list), data[2]);
+
+  list_free(list);
+}
+
+TEST_F(ListTest, test_pooled_list_without_pool) {
+  list_t* list = list_new_pooled(NULL, 0);
+  int x = 0;
+  EXPECT_TRUE(list_append(list, &x));
+  EXPECT_TRUE(list_remove(list, &x));
+  EXPECT_TRUE(list_is_empty(list));
+  list_free(list);
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/trace.h"
+
+class TraceTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    osi_trace_clear();
+  }
+
+  void TearDown() override {
+    osi_trace_set_enabled(false);
+    osi_trace_clear();
+    AllocationTestHarness::TearDown();
+  }
+
+  // Return the exported JSON document.
+  std::string DumpJson() {
+    FILE* file = tmpfile();
+    EXPECT_NE(nullptr, file);
+    osi_trace_dump_json(fileno(file));
+    rewind(file);
+    std::string json;
+    char buffer[1024];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      json.append(buffer, length);
+    fclose(file);
+    return json;
+  }
+
+  static size_t Count(const std::string& str, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = str.find(pattern); pos != std::string::npos;
+         pos = str.find(pattern, pos + 1))
+      count++;
+    return count;
+  }
+};
+
+TEST_F(TraceTest, test_disabled_records_nothing) {
+  OSI_TRACE_BEGIN("trace_test_disabled");
+  OSI_TRACE_END("trace_test_disabled");
+
+  std::string json = DumpJson();
+  EXPECT_EQ(0u, Count(json, "trace_test_disabled"));
+}
+
+TEST_F(TraceTest, test_events_exported) {
+  osi_trace_set_enabled(true);
+  OSI_TRACE_BEGIN("trace_test_slice");
+  OSI_TRACE_COUNTER("trace_test_counter", 42);
+  OSI_TRACE_INSTANT("trace_test_instant", -7);
+  OSI_TRACE_END("trace_test_slice");
+
+  std::string json = DumpJson();
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_EQ(1u, Count(json, "\"name\":\"trace_test_slice\",\"ph\":\"B\""));
+  EXPECT_EQ(1u, Count(json, "\"name\":\"trace_test_slice\",\"ph\":\"E\""));
+  EXPECT_EQ(1u, Count(json, "\"ph\":\"C\""));
+  EXPECT_EQ(1u, Count(json, "\"args\":{\"value\":42}"));
+  EXPECT_EQ(1u, Count(json, "\"s\":\"t\",\"args\":{\"value\":-7}"));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"thread_name\""));
+  EXPECT_NE(std::string::npos, json.rfind("]}"));
+
+  // Clearing drops the recorded events
+  osi_trace_clear();
+  EXPECT_EQ(0u, Count(DumpJson(), "trace_test_slice"));
+}
+
+TEST_F(TraceTest, test_ring_keeps_last_events) {
+  osi_trace_set_enabled(true);
+  for (int i = 0; i < OSI_TRACE_RING_EVENTS + 10; i++)
+    OSI_TRACE_COUNTER("trace_test_wrap", i);
+
+  std::string json = DumpJson();
+  EXPECT_EQ((size_t)OSI_TRACE_RING_EVENTS, Count(json, "trace_test_wrap"));
+  EXPECT_EQ(0u, Count(json, "\"args\":{\"value\":9}"));
+  EXPECT_EQ(1u, Count(json, "\"args\":{\"value\":10}"));
+  EXPECT_EQ(1u, Count(json, "\"args\":{\"value\":" +
+                                std::to_string(OSI_TRACE_RING_EVENTS + 9) +
+                                "}"));
+}
+
+TEST_F(TraceTest, test_threads_have_own_ring) {
+  osi_trace_set_enabled(true);
+  OSI_TRACE_INSTANT("trace_test_main_thread", 1);
+  std::thread thread([]() { OSI_TRACE_INSTANT("trace_test_other_thread", 2); });
+  thread.join();
+
+  std::string json = DumpJson();
+  EXPECT_EQ(1u, Count(json, "trace_test_main_thread"));
+  EXPECT_EQ(1u, Count(json, "trace_test_other_thread"));
+  EXPECT_LE(2u, Count(json, "\"name\":\"thread_name\""));
+}
+
+TEST_F(TraceTest, test_exited_thread_rings_are_reused) {
+  osi_trace_set_enabled(true);
+  // More short-lived threads than rings: each one gets the ring of a thread
+  // that exited before it
+  for (int i = 0; i < 40; i++) {
+    std::thread thread(
+        [i]() { OSI_TRACE_INSTANT("trace_test_short_lived", i); });
+    thread.join();
+  }
+
+  // The last threads kept their events, the older ones were dropped on reuse
+  std::string json = DumpJson();
+  EXPECT_EQ(1u, Count(json, "\"args\":{\"value\":39}"));
+  EXPECT_EQ(0u, Count(json, "\"s\":\"t\",\"args\":{\"value\":0}"));
+  EXPECT_GE(16u, Count(json, "trace_test_short_lived"));
+  EXPECT_LE(1u, Count(json, "trace_test_short_lived"));
+}
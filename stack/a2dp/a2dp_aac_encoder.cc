@@ -27,6 +27,7 @@
 #include <base/logging.h>
 
 #include "a2dp_aac.h"
+#include "a2dp_pacing.h"
 #include "bt_common.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -38,6 +39,9 @@
 // A2DP AAC encoder interval in milliseconds
 #define A2DP_AAC_ENCODER_INTERVAL_MS 20
 
+// Maximum number of late media ticks caught up at once
+#define A2DP_AAC_MAX_PENDING_TICKS 4
+
 /*
  * 2DH5 payload size of:
  * 679 bytes - (4 bytes L2CAP Header + 12 bytes AVDTP Header)
@@ -61,9 +65,7 @@ typedef struct {
 } tA2DP_AAC_ENCODER_PARAMS;
 
 typedef struct {
-  uint32_t counter;
-  uint32_t bytes_per_tick;              // pcm bytes read each media task tick
-  uint64_t last_frame_timestamp_100ns;  // values in 1/10 microseconds
+  tA2DP_PACING pacing;
 } tA2DP_AAC_FEEDING_STATE;
 
 typedef struct {
@@ -506,16 +508,17 @@ void a2dp_aac_feeding_reset(void) {
   memset(&a2dp_aac_encoder_cb.aac_feeding_state, 0,
          sizeof(a2dp_aac_encoder_cb.aac_feeding_state));
 
-  a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick =
-      (a2dp_aac_encoder_cb.feeding_params.sample_rate *
-       a2dp_aac_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_aac_encoder_cb.feeding_params.channel_count *
-       a2dp_aac_encoder_interval_ms) /
-      1000;
-
-  LOG_INFO(LOG_TAG, "%s: PCM bytes %u per tick %u ms", __func__,
-           a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick,
-           a2dp_aac_encoder_interval_ms);
+  uint32_t pcm_bytes_per_sec =
+      a2dp_aac_encoder_cb.feeding_params.sample_rate *
+      a2dp_aac_encoder_cb.feeding_params.bits_per_sample / 8 *
+      a2dp_aac_encoder_cb.feeding_params.channel_count;
+  a2dp_pacing_init(&a2dp_aac_encoder_cb.aac_feeding_state.pacing,
+                   pcm_bytes_per_sec, a2dp_aac_encoder_interval_ms * 1000,
+                   pcm_bytes_per_sec / 1000 * a2dp_aac_encoder_interval_ms *
+                       A2DP_AAC_MAX_PENDING_TICKS);
+
+  LOG_INFO(LOG_TAG, "%s: PCM bytes %u per second, tick %u ms", __func__,
+           pcm_bytes_per_sec, a2dp_aac_encoder_interval_ms);
 }
 
 void a2dp_aac_feeding_flush(void) {
@@ -524,7 +527,7 @@ void a2dp_aac_feeding_flush(void) {
                      "aac is running offload mode");
     return;
   }
-  a2dp_aac_encoder_cb.aac_feeding_state.counter = 0;
+  a2dp_pacing_flush(&a2dp_aac_encoder_cb.aac_feeding_state.pacing);
 }
 
 period_ms_t a2dp_aac_get_encoder_interval_ms(void) {
@@ -562,9 +565,7 @@ void a2dp_aac_send_frames(uint64_t timestamp_us) {
 static void a2dp_aac_get_num_frame_iteration(uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us) {
-  uint32_t result = 0;
-  uint8_t nof = 0;
-  uint8_t noi = 1;
+  tA2DP_PACING* pacing = &a2dp_aac_encoder_cb.aac_feeding_state.pacing;
 
   uint32_t pcm_bytes_per_frame =
       a2dp_aac_encoder_cb.aac_encoder_params.frame_length *
@@ -573,39 +574,15 @@ static void a2dp_aac_get_num_frame_iteration(uint8_t* num_of_iterations,
   LOG_VERBOSE(LOG_TAG, "%s: pcm_bytes_per_frame %u", __func__,
               pcm_bytes_per_frame);
 
-  uint32_t hecto_ns_this_tick = a2dp_aac_encoder_interval_ms * 10000;
-  uint64_t* last_100ns =
-      &a2dp_aac_encoder_cb.aac_feeding_state.last_frame_timestamp_100ns;
-  uint64_t now_100ns = timestamp_us * 10;
-  if (*last_100ns != 0) {
-    hecto_ns_this_tick = (now_100ns - *last_100ns);
-  }
-  *last_100ns = now_100ns;
-
-  uint32_t bytes_this_tick =
-      a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick *
-      hecto_ns_this_tick / (a2dp_aac_encoder_interval_ms * 10000);
-  a2dp_aac_encoder_cb.aac_feeding_state.counter += bytes_this_tick;
-  // Without this erratum, there was a three microseocnd shift per tick which
-  // would cause one frame mismatched after every 180 seconds
-  uint32_t erratum_100ns =
-      ceil(1.0f * bytes_this_tick * a2dp_aac_encoder_interval_ms * 10000 /
-           a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick);
-  if (erratum_100ns < hecto_ns_this_tick) {
-    LOG_VERBOSE(LOG_TAG, "%s: hecto_ns_this_tick=%d, bytes=%d, erratum_100ns=%d",
-                __func__, hecto_ns_this_tick, bytes_this_tick, erratum_100ns);
-    *last_100ns -= hecto_ns_this_tick - erratum_100ns;
-  }
-
-  result = a2dp_aac_encoder_cb.aac_feeding_state.counter / pcm_bytes_per_frame;
-  a2dp_aac_encoder_cb.aac_feeding_state.counter -= result * pcm_bytes_per_frame;
-  nof = result;
+  a2dp_pacing_tick(pacing, timestamp_us);
+  // With no frames per packet grouping, all the due frames (at most
+  // UINT8_MAX, the excess PCM is dropped) are returned in a single
+  // iteration. a2dp_aac_encode_frames() then builds one packet per frame.
+  a2dp_pacing_get_num_frame_iteration(pacing, pcm_bytes_per_frame, 0, UINT8_MAX,
+                                      1, num_of_iterations, num_of_frames);
 
   LOG_VERBOSE(LOG_TAG, "%s: effective num of frames %u, iterations %u",
-              __func__, nof, noi);
-
-  *num_of_frames = nof;
-  *num_of_iterations = noi;
+              __func__, *num_of_frames, *num_of_iterations);
 }
 
 static void a2dp_aac_encode_frames(uint8_t nb_frame) {
@@ -698,10 +675,10 @@ static void a2dp_aac_encode_frames(uint8_t nb_frame) {
         p_buf->layer_specific++;  // added a frame to the buffer
       } else {
         LOG_WARN(LOG_TAG, "%s: underflow %d", __func__, nb_frame);
-        a2dp_aac_encoder_cb.aac_feeding_state.counter +=
-            nb_frame * p_encoder_params->frame_length *
-            p_feeding_params->channel_count *
-            p_feeding_params->bits_per_sample / 8;
+        a2dp_pacing_refund(&a2dp_aac_encoder_cb.aac_feeding_state.pacing,
+                           nb_frame * p_encoder_params->frame_length *
+                               p_feeding_params->channel_count *
+                               p_feeding_params->bits_per_sample / 8);
 
         // no more pcm to read
         nb_frame = 0;
@@ -787,4 +764,6 @@ void A2dpCodecConfigAac::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_read_bytes,
           stats->media_read_total_actual_read_bytes);
+
+  a2dp_pacing_debug_dump(&a2dp_aac_encoder_cb.aac_feeding_state.pacing, fd);
 }
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "a2dp_pacing"
+
+#include "a2dp_pacing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "osi/include/log.h"
+
+#define US_PER_SEC 1000000
+
+void a2dp_pacing_init(tA2DP_PACING* pacing, uint32_t pcm_bytes_per_sec,
+                      uint32_t interval_us, uint32_t max_pending_bytes) {
+  memset(pacing, 0, sizeof(*pacing));
+  pacing->pcm_bytes_per_sec = pcm_bytes_per_sec;
+  pacing->interval_us = interval_us;
+  pacing->max_pending_bytes = max_pending_bytes;
+}
+
+void a2dp_pacing_flush(tA2DP_PACING* pacing) {
+  pacing->last_us = 0;
+  pacing->remainder = 0;
+  pacing->counter = 0;
+}
+
+static void a2dp_pacing_drop(tA2DP_PACING* pacing, uint32_t bytes) {
+  pacing->counter -= bytes;
+  pacing->total_dropped_bytes += bytes;
+}
+
+uint32_t a2dp_pacing_tick(tA2DP_PACING* pacing, uint64_t now_us) {
+  uint64_t elapsed_us = pacing->interval_us;
+  if (pacing->last_us != 0) {
+    elapsed_us = (now_us > pacing->last_us) ? now_us - pacing->last_us : 0;
+    if (elapsed_us > pacing->interval_us + pacing->interval_us / 2)
+      pacing->late_ticks++;
+    if (elapsed_us > pacing->max_tick_us) pacing->max_tick_us = elapsed_us;
+  }
+  pacing->last_us = now_us;
+  pacing->ticks++;
+
+  uint64_t scaled =
+      elapsed_us * pacing->pcm_bytes_per_sec + pacing->remainder;
+  uint64_t due = scaled / US_PER_SEC;
+  pacing->remainder = scaled % US_PER_SEC;
+  pacing->total_due_bytes += due;
+
+  uint64_t pending = pacing->counter + due;
+  uint64_t limit = pacing->max_pending_bytes ? pacing->max_pending_bytes
+                                             : UINT32_MAX;
+  if (pending > limit) {
+    LOG_VERBOSE(LOG_TAG, "%s: dropping %llu late PCM bytes", __func__,
+                (unsigned long long)(pending - limit));
+    pacing->total_dropped_bytes += pending - limit;
+    pending = limit;
+  }
+  pacing->counter = (uint32_t)pending;
+  return pacing->counter;
+}
+
+bool a2dp_pacing_consume(tA2DP_PACING* pacing, uint32_t bytes) {
+  if (pacing->counter < bytes) return false;
+  pacing->counter -= bytes;
+  return true;
+}
+
+void a2dp_pacing_refund(tA2DP_PACING* pacing, uint32_t bytes) {
+  pacing->counter += bytes;
+}
+
+uint32_t a2dp_pacing_get_num_frame_iteration(
+    tA2DP_PACING* pacing, uint32_t pcm_bytes_per_frame,
+    uint8_t frames_per_packet, uint8_t max_frames, uint8_t max_iterations,
+    uint8_t* num_of_iterations, uint8_t* num_of_frames) {
+  *num_of_iterations = 1;
+  *num_of_frames = 0;
+  if (pcm_bytes_per_frame == 0) return 0;
+
+  uint32_t due_frames = pacing->counter / pcm_bytes_per_frame;
+  uint32_t frames = due_frames;
+  if (frames > max_frames) {
+    LOG_WARN(LOG_TAG, "%s: limiting frames to be sent from %u to %u", __func__,
+             frames, max_frames);
+    a2dp_pacing_drop(pacing, (frames - max_frames) * pcm_bytes_per_frame);
+    frames = max_frames;
+  }
+
+  uint32_t noi = 1;
+  uint32_t nof = frames;
+  if (frames_per_packet != 0 && frames >= frames_per_packet) {
+    noi = frames / frames_per_packet;
+    nof = frames_per_packet;
+    if (noi > max_iterations) {
+      LOG_WARN(LOG_TAG, "%s: Audio Congestion (iterations:%u > max (%u))",
+               __func__, noi, max_iterations);
+      a2dp_pacing_drop(pacing,
+                       (noi - max_iterations) * nof * pcm_bytes_per_frame);
+      noi = max_iterations;
+    }
+  }
+
+  pacing->counter -= noi * nof * pcm_bytes_per_frame;
+  *num_of_iterations = (uint8_t)noi;
+  *num_of_frames = (uint8_t)nof;
+  return due_frames;
+}
+
+void a2dp_pacing_debug_dump(const tA2DP_PACING* pacing, int fd) {
+  dprintf(fd,
+          "  Pacing PCM bytes (due/dropped/pending)                  : %llu / "
+          "%llu / %u\n",
+          (unsigned long long)pacing->total_due_bytes,
+          (unsigned long long)pacing->total_dropped_bytes, pacing->counter);
+  dprintf(fd,
+          "  Pacing ticks (total/late), max tick interval (ms)       : %u / "
+          "%u, %u\n",
+          pacing->ticks, pacing->late_ticks, pacing->max_tick_us / 1000);
+}
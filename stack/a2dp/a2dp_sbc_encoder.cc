@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_pacing.h"
 #include "a2dp_sbc.h"
 #include "a2dp_sbc_up_sample.h"
 #include "bt_common.h"
@@ -79,9 +80,7 @@ typedef struct {
   uint32_t aa_frame_counter;
   int32_t aa_feed_counter;
   int32_t aa_feed_residue;
-  uint32_t counter;
-  uint32_t bytes_per_tick;              // pcm bytes read each media task tick
-  uint64_t last_frame_timestamp_100ns;  // values in 1/10 microseconds
+  tA2DP_PACING pacing;
 } tA2DP_SBC_FEEDING_STATE;
 
 typedef struct {
@@ -410,15 +409,16 @@ void a2dp_sbc_feeding_reset(void) {
   memset(&a2dp_sbc_encoder_cb.feeding_state, 0,
          sizeof(a2dp_sbc_encoder_cb.feeding_state));
 
-  a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick =
-      (a2dp_sbc_encoder_cb.feeding_params.sample_rate *
-       a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_sbc_encoder_cb.feeding_params.channel_count *
-       A2DP_SBC_ENCODER_INTERVAL_MS) /
-      1000;
+  uint32_t pcm_bytes_per_sec =
+      a2dp_sbc_encoder_cb.feeding_params.sample_rate *
+      a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8 *
+      a2dp_sbc_encoder_cb.feeding_params.channel_count;
+  // The number of frames per tick is limited instead of the pending bytes
+  a2dp_pacing_init(&a2dp_sbc_encoder_cb.feeding_state.pacing,
+                   pcm_bytes_per_sec, A2DP_SBC_ENCODER_INTERVAL_MS * 1000, 0);
 
-  LOG_DEBUG(LOG_TAG, "%s: PCM bytes per tick %u", __func__,
-            a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
+  LOG_DEBUG(LOG_TAG, "%s: PCM bytes per second %u", __func__,
+            pcm_bytes_per_sec);
 }
 
 void a2dp_sbc_feeding_flush(void) {
@@ -427,7 +427,7 @@ void a2dp_sbc_feeding_flush(void) {
                      "sbc is running in offload mode");
     return;
   }
-  a2dp_sbc_encoder_cb.feeding_state.counter = 0;
+  a2dp_pacing_flush(&a2dp_sbc_encoder_cb.feeding_state.pacing);
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
 }
 
@@ -466,10 +466,9 @@ void a2dp_sbc_send_frames(uint64_t timestamp_us) {
 static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us) {
-  uint8_t nof = 0;
-  uint8_t noi = 1;
+  tA2DP_PACING* pacing = &a2dp_sbc_encoder_cb.feeding_state.pacing;
+  uint8_t frames_per_packet = 0;
 
-  uint32_t projected_nof = 0;
   uint32_t pcm_bytes_per_frame =
       a2dp_sbc_encoder_cb.sbc_encoder_params.s16NumOfSubBands *
       a2dp_sbc_encoder_cb.sbc_encoder_params.s16NumOfBlocks *
@@ -478,49 +477,7 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
   LOG_VERBOSE(LOG_TAG, "%s: pcm_bytes_per_frame %u", __func__,
               pcm_bytes_per_frame);
 
-  uint32_t hecto_ns_this_tick = A2DP_SBC_ENCODER_INTERVAL_MS * 10000;
-  uint64_t* last_100ns =
-      &a2dp_sbc_encoder_cb.feeding_state.last_frame_timestamp_100ns;
-  uint64_t now_100ns = timestamp_us * 10;
-  if (*last_100ns != 0) {
-    hecto_ns_this_tick = (now_100ns - *last_100ns);
-  }
-  *last_100ns = now_100ns;
-
-  uint32_t bytes_this_tick = a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick *
-                             hecto_ns_this_tick /
-                             (A2DP_SBC_ENCODER_INTERVAL_MS * 10000);
-  a2dp_sbc_encoder_cb.feeding_state.counter += bytes_this_tick;
-  // Without this erratum, there was a three microseocnd shift per tick which
-  // would cause one SBC frame mismatched after every 20 seconds
-  uint32_t erratum_100ns =
-      ceil(1.0f * A2DP_SBC_ENCODER_INTERVAL_MS * 10000 * bytes_this_tick /
-           a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
-  if (erratum_100ns < hecto_ns_this_tick) {
-    LOG_VERBOSE(LOG_TAG, "%s: hecto_ns_this_tick=%d, bytes=%d, erratum_100ns=%d",
-                __func__, hecto_ns_this_tick, bytes_this_tick, erratum_100ns);
-    *last_100ns -= hecto_ns_this_tick - erratum_100ns;
-  }
-
-  /* Calculate the number of frames pending for this media tick */
-  projected_nof =
-      a2dp_sbc_encoder_cb.feeding_state.counter / pcm_bytes_per_frame;
-  // Update the stats
-  a2dp_sbc_encoder_cb.stats.media_read_total_expected_frames += projected_nof;
-
-  if (projected_nof > MAX_PCM_FRAME_NUM_PER_TICK) {
-    LOG_WARN(LOG_TAG, "%s: limiting frames to be sent from %d to %d", __func__,
-             projected_nof, MAX_PCM_FRAME_NUM_PER_TICK);
-
-    // Update the stats
-    size_t delta = projected_nof - MAX_PCM_FRAME_NUM_PER_TICK;
-    a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames += delta;
-
-    projected_nof = MAX_PCM_FRAME_NUM_PER_TICK;
-  }
-
-  LOG_VERBOSE(LOG_TAG, "%s: frames for available PCM data %u", __func__,
-              projected_nof);
+  a2dp_pacing_tick(pacing, timestamp_us);
 
   if (a2dp_sbc_encoder_cb.is_peer_edr) {
     if (!a2dp_sbc_encoder_cb.tx_sbc_frames) {
@@ -528,55 +485,24 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
                 __func__);
       a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
     }
+    // Send full packets, the remaining frames wait for the next tick
+    frames_per_packet = a2dp_sbc_encoder_cb.tx_sbc_frames;
+  }
 
-    nof = a2dp_sbc_encoder_cb.tx_sbc_frames;
-    if (!nof) {
-      LOG_ERROR(LOG_TAG,
-                "%s: number of frames not updated, set calculated values",
-                __func__);
-      nof = projected_nof;
-      noi = 1;
-    } else {
-      if (nof < projected_nof) {
-        noi = projected_nof / nof;  // number of iterations would vary
-        if (noi > A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK) {
-          LOG_ERROR(LOG_TAG, "%s: Audio Congestion (iterations:%d > max (%d))",
-                    __func__, noi, A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK);
-          noi = A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK;
-          a2dp_sbc_encoder_cb.feeding_state.counter =
-              noi * nof * pcm_bytes_per_frame;
-        }
-        projected_nof = nof;
-      } else {
-        noi = 1;  // number of iterations is 1
-        LOG_VERBOSE(LOG_TAG, "%s: reducing frames for available PCM data",
-                    __func__);
-        nof = projected_nof;
-      }
-    }
-  } else {
-    // For BR cases nof will be same as the value retrieved at projected_nof
-    LOG_VERBOSE(LOG_TAG, "%s: headset BR, number of frames %u", __func__, nof);
-    if (projected_nof > MAX_PCM_FRAME_NUM_PER_TICK) {
-      LOG_ERROR(LOG_TAG, "%s: Audio Congestion (frames: %d > max (%d))",
-                __func__, projected_nof, MAX_PCM_FRAME_NUM_PER_TICK);
-
-      // Update the stats
-      size_t delta = projected_nof - MAX_PCM_FRAME_NUM_PER_TICK;
-      a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames += delta;
-
-      projected_nof = MAX_PCM_FRAME_NUM_PER_TICK;
-      a2dp_sbc_encoder_cb.feeding_state.counter =
-          noi * projected_nof * pcm_bytes_per_frame;
-    }
-    nof = projected_nof;
+  // Update the stats
+  uint64_t dropped_bytes = pacing->total_dropped_bytes;
+  a2dp_sbc_encoder_cb.stats.media_read_total_expected_frames +=
+      a2dp_pacing_get_num_frame_iteration(
+          pacing, pcm_bytes_per_frame, frames_per_packet,
+          MAX_PCM_FRAME_NUM_PER_TICK, A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK,
+          num_of_iterations, num_of_frames);
+  if (pcm_bytes_per_frame != 0) {
+    a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames +=
+        (pacing->total_dropped_bytes - dropped_bytes) / pcm_bytes_per_frame;
   }
-  a2dp_sbc_encoder_cb.feeding_state.counter -= noi * nof * pcm_bytes_per_frame;
-  LOG_VERBOSE(LOG_TAG, "%s: effective num of frames %u, iterations %u",
-              __func__, nof, noi);
 
-  *num_of_frames = nof;
-  *num_of_iterations = noi;
+  LOG_VERBOSE(LOG_TAG, "%s: effective num of frames %u, iterations %u",
+              __func__, *num_of_frames, *num_of_iterations);
 }
 
 static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
@@ -617,11 +543,12 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
       } else {
         LOG_WARN(LOG_TAG, "%s: underflow %d, %d", __func__, nb_frame,
                  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
-        a2dp_sbc_encoder_cb.feeding_state.counter +=
+        a2dp_pacing_refund(
+            &a2dp_sbc_encoder_cb.feeding_state.pacing,
             nb_frame * p_encoder_params->s16NumOfSubBands *
-            p_encoder_params->s16NumOfBlocks *
-            a2dp_sbc_encoder_cb.feeding_params.channel_count *
-            a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+                p_encoder_params->s16NumOfBlocks *
+                a2dp_sbc_encoder_cb.feeding_params.channel_count *
+                a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8);
         /* no more pcm to read */
         nb_frame = 0;
       }
@@ -1160,4 +1087,6 @@ void A2dpCodecConfigSbc::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_frames,
           stats->media_read_total_dropped_frames);
+
+  a2dp_pacing_debug_dump(&a2dp_sbc_encoder_cb.feeding_state.pacing, fd);
 }
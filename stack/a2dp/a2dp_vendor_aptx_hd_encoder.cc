@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_pacing.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx_hd.h"
 #include "bt_common.h"
@@ -63,12 +64,16 @@ static tAPTX_HD_ENCODER_SIZEOF_PARAMS aptx_hd_encoder_sizeof_params_func;
 
 #define A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ 1024
 
+// Maximum number of late media ticks caught up at once
+#define A2DP_APTX_HD_MAX_PENDING_TICKS 4
+
 typedef struct {
   uint64_t sleep_time_ns;
   uint32_t pcm_reads;
   uint32_t pcm_bytes_per_read;
   uint32_t aptx_hd_bytes;
   uint32_t frame_size_counter;
+  bool packet_pending;  // the framing of the next packet is set
 } tAPTX_HD_FRAMING_PARAMS;
 
 typedef struct {
@@ -95,6 +100,7 @@ typedef struct {
 
   tA2DP_FEEDING_PARAMS feeding_params;
   tAPTX_HD_FRAMING_PARAMS framing_params;
+  tA2DP_PACING pacing;
   void* aptx_hd_encoder_state;
   a2dp_aptx_hd_encoder_stats_t stats;
 } tA2DP_APTX_HD_ENCODER_CB;
@@ -108,6 +114,7 @@ static void aptx_hd_init_framing_params(
     tAPTX_HD_FRAMING_PARAMS* framing_params);
 static void aptx_hd_update_framing_params(
     tAPTX_HD_FRAMING_PARAMS* framing_params);
+static bool aptx_hd_send_packet(tAPTX_HD_FRAMING_PARAMS* framing_params);
 static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
                                    size_t* data_out_index, uint32_t* data32_in,
                                    uint8_t* data_out);
@@ -288,11 +295,27 @@ static void aptx_hd_init_framing_params(
   framing_params->pcm_bytes_per_read = 0;
   framing_params->aptx_hd_bytes = 0;
   framing_params->frame_size_counter = 0;
+  framing_params->packet_pending = false;
 
   framing_params->sleep_time_ns = 9000000;
 
   LOG_DEBUG(LOG_TAG, "%s: sleep_time_ns = %" PRIu64, __func__,
             framing_params->sleep_time_ns);
+
+  tA2DP_FEEDING_PARAMS* p_feeding_params =
+      &a2dp_aptx_hd_encoder_cb.feeding_params;
+  uint32_t pcm_bytes_per_sec = p_feeding_params->sample_rate *
+                               p_feeding_params->bits_per_sample / 8 *
+                               p_feeding_params->channel_count;
+  uint32_t interval_us = framing_params->sleep_time_ns / 1000;
+  uint32_t pcm_bytes_per_tick =
+      (uint64_t)pcm_bytes_per_sec * interval_us / 1000000;
+  a2dp_pacing_init(&a2dp_aptx_hd_encoder_cb.pacing, pcm_bytes_per_sec,
+                   interval_us,
+                   pcm_bytes_per_tick * A2DP_APTX_HD_MAX_PENDING_TICKS);
+  // The media ticks may be late but never early: start half a tick ahead so
+  // that a packet is due at every tick.
+  a2dp_pacing_refund(&a2dp_aptx_hd_encoder_cb.pacing, pcm_bytes_per_tick / 2);
 }
 
 //
@@ -383,7 +406,27 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   }
   tAPTX_HD_FRAMING_PARAMS* framing_params =
       &a2dp_aptx_hd_encoder_cb.framing_params;
+  tA2DP_PACING* pacing = &a2dp_aptx_hd_encoder_cb.pacing;
+
+  a2dp_pacing_tick(pacing, timestamp_us);
+  for (int packets = 0; packets <= A2DP_APTX_HD_MAX_PENDING_TICKS; packets++) {
+    // Keep the framing of the next packet until it is due
+    if (!framing_params->packet_pending) {
+      aptx_hd_update_framing_params(framing_params);
+      framing_params->packet_pending = true;
+    }
+    if (!a2dp_pacing_consume(pacing, framing_params->pcm_reads *
+                                         framing_params->pcm_bytes_per_read)) {
+      break;
+    }
+    framing_params->packet_pending = false;
+    if (!aptx_hd_send_packet(framing_params)) break;
+  }
+}
 
+// Read the PCM data of one packet, encode and enqueue it.
+// Returns false if the PCM data underflowed.
+static bool aptx_hd_send_packet(tAPTX_HD_FRAMING_PARAMS* framing_params) {
   // Prepare the packet to send
   BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
   p_buf->offset = A2DP_APTX_HD_OFFSET;
@@ -393,8 +436,6 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   uint8_t* encoded_ptr = (uint8_t*)(p_buf + 1);
   encoded_ptr += p_buf->offset;
 
-  aptx_hd_update_framing_params(framing_params);
-
   //
   // Read the PCM data and encode it
   //
@@ -403,6 +444,7 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   size_t encoded_ptr_index = 0;
   size_t pcm_bytes_encoded = 0;
   uint32_t bytes_read = 0;
+  bool underflow = false;
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_expected_packets++;
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_expected_reads_count +=
       framing_params->pcm_reads;
@@ -422,6 +464,7 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
                "instead of %d",
                __func__, reads, pcm_bytes_read,
                framing_params->pcm_bytes_per_read);
+      underflow = true;
       break;
     }
     a2dp_aptx_hd_encoder_cb.stats.media_read_total_actual_reads_count++;
@@ -445,12 +488,22 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
       BYTES_PER_FRAME;
   a2dp_aptx_hd_encoder_cb.timestamp += rtp_timestamp;
 
+  if (underflow) {
+    // The unread PCM data is sent at the next tick
+    a2dp_pacing_refund(
+        &a2dp_aptx_hd_encoder_cb.pacing,
+        framing_params->pcm_reads * framing_params->pcm_bytes_per_read -
+            bytes_read);
+  }
+
   if (p_buf->len > 0) {
     a2dp_aptx_hd_encoder_cb.enqueue_callback(p_buf, 1, bytes_read);
   } else {
     a2dp_aptx_hd_encoder_cb.stats.media_read_total_dropped_packets++;
     osi_free(p_buf);
   }
+
+  return !underflow;
 }
 
 static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
@@ -520,4 +573,6 @@ void A2dpCodecConfigAptxHd::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_read_bytes,
           stats->media_read_total_actual_read_bytes);
+
+  a2dp_pacing_debug_dump(&a2dp_aptx_hd_encoder_cb.pacing, fd);
 }
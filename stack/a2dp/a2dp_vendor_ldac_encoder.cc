@@ -29,6 +29,7 @@
 
 #include <ldacBT.h>
 
+#include "a2dp_pacing.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_ldac.h"
 #include "a2dp_vendor_ldac_abr.h"
@@ -105,6 +106,8 @@ static tLDAC_GET_ERROR_CODE ldac_get_error_code_func;
 // A2DP LDAC encoder interval in milliseconds
 #define A2DP_LDAC_ENCODER_INTERVAL_MS 20
 #define A2DP_LDAC_MEDIA_BYTES_PER_FRAME 128
+// Maximum number of late media ticks caught up at once
+#define A2DP_LDAC_MAX_PENDING_TICKS 4
 
 // offset
 #if (BTA_AV_CO_CP_SCMS_T == TRUE)
@@ -123,9 +126,7 @@ typedef struct {
 } tA2DP_LDAC_ENCODER_PARAMS;
 
 typedef struct {
-  uint32_t counter;
-  uint32_t bytes_per_tick; /* pcm bytes read each media task tick */
-  uint64_t last_frame_us;
+  tA2DP_PACING pacing;
 } tA2DP_LDAC_FEEDING_STATE;
 
 typedef struct {
@@ -524,19 +525,21 @@ void a2dp_vendor_ldac_feeding_reset(void) {
   memset(&a2dp_ldac_encoder_cb.ldac_feeding_state, 0,
          sizeof(a2dp_ldac_encoder_cb.ldac_feeding_state));
 
-  a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick =
-      (a2dp_ldac_encoder_cb.feeding_params.sample_rate *
-       a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_ldac_encoder_cb.feeding_params.channel_count *
-       A2DP_LDAC_ENCODER_INTERVAL_MS) /
-      1000;
-
-  LOG_DEBUG(LOG_TAG, "%s: PCM bytes per tick %u", __func__,
-            a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick);
+  uint32_t pcm_bytes_per_sec =
+      a2dp_ldac_encoder_cb.feeding_params.sample_rate *
+      a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8 *
+      a2dp_ldac_encoder_cb.feeding_params.channel_count;
+  a2dp_pacing_init(&a2dp_ldac_encoder_cb.ldac_feeding_state.pacing,
+                   pcm_bytes_per_sec, A2DP_LDAC_ENCODER_INTERVAL_MS * 1000,
+                   pcm_bytes_per_sec / 1000 * A2DP_LDAC_ENCODER_INTERVAL_MS *
+                       A2DP_LDAC_MAX_PENDING_TICKS);
+
+  LOG_DEBUG(LOG_TAG, "%s: PCM bytes per second %u", __func__,
+            pcm_bytes_per_sec);
 }
 
 void a2dp_vendor_ldac_feeding_flush(void) {
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter = 0;
+  a2dp_pacing_flush(&a2dp_ldac_encoder_cb.ldac_feeding_state.pacing);
 }
 
 period_ms_t a2dp_vendor_ldac_get_encoder_interval_ms(void) {
@@ -582,9 +585,7 @@ void a2dp_vendor_ldac_send_frames(uint64_t timestamp_us) {
 static void a2dp_ldac_get_num_frame_iteration(uint8_t* num_of_iterations,
                                               uint8_t* num_of_frames,
                                               uint64_t timestamp_us) {
-  uint32_t result = 0;
-  uint8_t nof = 0;
-  uint8_t noi = 1;
+  tA2DP_PACING* pacing = &a2dp_ldac_encoder_cb.ldac_feeding_state.pacing;
 
   uint32_t pcm_bytes_per_frame =
       A2DP_LDAC_MEDIA_BYTES_PER_FRAME *
@@ -593,28 +594,12 @@ static void a2dp_ldac_get_num_frame_iteration(uint8_t* num_of_iterations,
   LOG_VERBOSE(LOG_TAG, "%s: pcm_bytes_per_frame %u", __func__,
               pcm_bytes_per_frame);
 
-  uint32_t us_this_tick = A2DP_LDAC_ENCODER_INTERVAL_MS * 1000;
-  uint64_t now_us = timestamp_us;
-  if (a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us != 0)
-    us_this_tick =
-        (now_us - a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us);
-  a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us = now_us;
-
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter +=
-      a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick * us_this_tick /
-      (A2DP_LDAC_ENCODER_INTERVAL_MS * 1000);
-
-  result =
-      a2dp_ldac_encoder_cb.ldac_feeding_state.counter / pcm_bytes_per_frame;
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter -=
-      result * pcm_bytes_per_frame;
-  nof = result;
+  a2dp_pacing_tick(pacing, timestamp_us);
+  a2dp_pacing_get_num_frame_iteration(pacing, pcm_bytes_per_frame, 0, UINT8_MAX,
+                                      1, num_of_iterations, num_of_frames);
 
   LOG_VERBOSE(LOG_TAG, "%s: effective num of frames %u, iterations %u",
-              __func__, nof, noi);
-
-  *num_of_frames = nof;
-  *num_of_iterations = noi;
+              __func__, *num_of_frames, *num_of_iterations);
 }
 
 static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
@@ -689,10 +674,11 @@ static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
         p_buf->layer_specific += out_frames;  // added a frame to the buffer
       } else {
         LOG_WARN(LOG_TAG, "%s: underflow %d", __func__, nb_frame);
-        a2dp_ldac_encoder_cb.ldac_feeding_state.counter +=
+        a2dp_pacing_refund(
+            &a2dp_ldac_encoder_cb.ldac_feeding_state.pacing,
             nb_frame * LDACBT_ENC_LSU *
-            a2dp_ldac_encoder_cb.feeding_params.channel_count *
-            a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8;
+                a2dp_ldac_encoder_cb.feeding_params.channel_count *
+                a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8);
 
         // no more pcm to read
         nb_frame = 0;
@@ -802,6 +788,8 @@ void A2dpCodecConfigLdac::debug_codec_dump(int fd) {
           stats->media_read_total_expected_read_bytes,
           stats->media_read_total_actual_read_bytes);
 
+  a2dp_pacing_debug_dump(&a2dp_ldac_encoder_cb.ldac_feeding_state.pacing, fd);
+
   dprintf(
       fd, "  LDAC quality mode                                       : %s\n",
       quality_mode_index_to_name(p_encoder_params->quality_mode_index).c_str());
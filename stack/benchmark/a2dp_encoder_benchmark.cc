@@ -0,0 +1,313 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Offline benchmark of the A2DP source encoders.
+//
+// Each iteration is one media tick: the encoder is driven through its
+// tA2DP_ENCODER_INTERFACE with synthetic PCM data, and the encoded packets
+// are counted and freed by a fake enqueue callback. The time per iteration
+// is the encoding CPU time per tick; the packet size and frame counters are
+// reported next to it.
+//
+// The LDAC, aptX and aptX-HD encoders are loaded from their vendor
+// libraries at run time; their benchmarks are skipped on devices without
+// them.
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <vector>
+
+#include "a2dp_aac_constants.h"
+#include "a2dp_codec_api.h"
+#include "a2dp_constants.h"
+#include "a2dp_sbc_constants.h"
+#include "a2dp_vendor_aptx_constants.h"
+#include "a2dp_vendor_aptx_encoder.h"
+#include "a2dp_vendor_aptx_hd_constants.h"
+#include "a2dp_vendor_aptx_hd_encoder.h"
+#include "a2dp_vendor_ldac_constants.h"
+#include "a2dp_vendor_ldac_encoder.h"
+#include "osi/include/allocator.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+namespace {
+
+// Synthetic PCM input: a 1 kHz tone on the left channel, a 440 Hz tone on
+// the right channel, so the encoders see realistic spectral content.
+uint32_t pcm_sample_rate;
+uint8_t pcm_bits_per_sample;
+uint64_t pcm_position;
+
+// Encoded output, from the fake enqueue callback
+size_t packets_n;
+size_t packet_bytes_n;
+size_t packet_frames_n;
+size_t packet_max_bytes;
+
+uint32_t bm_read_pcm(uint8_t* p_buf, uint32_t len) {
+  uint32_t bytes_per_sample = pcm_bits_per_sample / 8;
+  uint32_t frames = len / (2 * bytes_per_sample);
+  for (uint32_t i = 0; i < frames; i++, pcm_position++) {
+    double t = (double)pcm_position / pcm_sample_rate;
+    int32_t left = (int32_t)(0x3fffffff * sin(2 * M_PI * 1000 * t));
+    int32_t right = (int32_t)(0x3fffffff * sin(2 * M_PI * 440 * t));
+    // Little endian, most significant bytes of the 32-bit samples
+    for (uint32_t b = 0; b < bytes_per_sample; b++)
+      *p_buf++ = (uint8_t)(left >> (8 * (4 - bytes_per_sample + b)));
+    for (uint32_t b = 0; b < bytes_per_sample; b++)
+      *p_buf++ = (uint8_t)(right >> (8 * (4 - bytes_per_sample + b)));
+  }
+  return len;
+}
+
+bool bm_enqueue_packet(BT_HDR* p_buf, size_t frames_n,
+                       uint32_t /* num_bytes */) {
+  packets_n++;
+  packet_bytes_n += p_buf->len;
+  packet_frames_n += frames_n;
+  if (p_buf->len > packet_max_bytes) packet_max_bytes = p_buf->len;
+  osi_free(p_buf);
+  return true;
+}
+
+// Encode media ticks with the codec configured from the peer capability
+// |peer_codec_info| and the peer MTU |peer_mtu|. A non-zero
+// |codec_specific_1| is applied as a user configuration, as the LDAC
+// quality mode is.
+void bm_encode(State& state, const uint8_t* peer_codec_info, uint16_t peer_mtu,
+               int64_t codec_specific_1 = 0) {
+  A2dpCodecs codecs(std::vector<btav_a2dp_codec_config_t>{});
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+  if (!codecs.init() ||
+      !codecs.setCodecConfig(peer_codec_info, true /* is_capability */,
+                             codec_info, true /* select_current_codec */)) {
+    state.SkipWithError("unsupported codec configuration");
+    return;
+  }
+  A2dpCodecConfig* codec_config = codecs.getCurrentCodecConfig();
+
+  tA2DP_ENCODER_INIT_PEER_PARAMS peer_params;
+  peer_params.is_peer_edr = true;
+  peer_params.peer_supports_3mbps = true;
+  peer_params.peer_mtu = peer_mtu;
+
+  if (codec_config != nullptr && codec_specific_1 != 0) {
+    btav_a2dp_codec_config_t user_config = codec_config->getCodecConfig();
+    user_config.codec_specific_1 = codec_specific_1;
+    bool restart_input, restart_output, config_updated;
+    if (!codecs.setCodecUserConfig(user_config, &peer_params, peer_codec_info,
+                                   codec_info, &restart_input,
+                                   &restart_output, &config_updated)) {
+      state.SkipWithError("unsupported codec user configuration");
+      return;
+    }
+    codec_config = codecs.getCurrentCodecConfig();
+  }
+  const tA2DP_ENCODER_INTERFACE* encoder =
+      A2DP_GetEncoderInterface(codec_info);
+  if (codec_config == nullptr || encoder == nullptr) {
+    state.SkipWithError("no encoder for the codec configuration");
+    return;
+  }
+
+  pcm_sample_rate = A2DP_GetTrackSampleRate(codec_info);
+  pcm_bits_per_sample = codec_config->getAudioBitsPerSample();
+  pcm_position = 0;
+  packets_n = 0;
+  packet_bytes_n = 0;
+  packet_frames_n = 0;
+  packet_max_bytes = 0;
+
+  encoder->encoder_init(&peer_params, codec_config, bm_read_pcm,
+                        bm_enqueue_packet);
+  encoder->feeding_reset();
+  uint64_t interval_us = encoder->get_encoder_interval_ms() * 1000;
+  uint64_t timestamp_us = interval_us;
+
+  for (auto _ : state) {
+    encoder->send_frames(timestamp_us);
+    timestamp_us += interval_us;
+  }
+
+  encoder->encoder_cleanup();
+
+  state.counters["tick_ms"] = interval_us / 1000;
+  state.counters["packets"] = Counter(packets_n, Counter::kIsRate);
+  if (packets_n != 0) {
+    state.counters["bytes_per_packet"] = (double)packet_bytes_n / packets_n;
+    state.counters["max_bytes_per_packet"] = packet_max_bytes;
+    state.counters["frames_per_packet"] = (double)packet_frames_n / packets_n;
+  }
+  if (state.iterations() != 0 && interval_us != 0) {
+    state.counters["bitrate_kbps"] = (double)packet_bytes_n * 8 * 1000 /
+                                     (state.iterations() * interval_us);
+  }
+}
+
+uint8_t bm_sbc_sample_freq(int64_t sample_rate) {
+  return sample_rate == 48000 ? A2DP_SBC_IE_SAMP_FREQ_48
+                              : A2DP_SBC_IE_SAMP_FREQ_44;
+}
+
+}  // namespace
+
+// Arguments: sample rate, maximum bitpool, peer MTU
+static void BM_EncodeSbc(State& state) {
+  const uint8_t peer_codec_info[AVDT_CODEC_SIZE] = {
+      A2DP_SBC_INFO_LEN,
+      AVDT_MEDIA_TYPE_AUDIO << 4,
+      A2DP_MEDIA_CT_SBC,
+      (uint8_t)(bm_sbc_sample_freq(state.range(0)) | A2DP_SBC_IE_CH_MD_JOINT),
+      A2DP_SBC_IE_BLOCKS_16 | A2DP_SBC_IE_SUBBAND_8 | A2DP_SBC_IE_ALLOC_MD_L,
+      A2DP_SBC_IE_MIN_BITPOOL,
+      (uint8_t)state.range(1)};
+  bm_encode(state, peer_codec_info, (uint16_t)state.range(2));
+}
+BENCHMARK(BM_EncodeSbc)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({44100, 53, 895})
+    ->Args({44100, 53, 663})
+    ->Args({44100, 35, 895})
+    ->Args({48000, 51, 895})
+    ->Args({48000, 51, 663})
+    ->Args({48000, 33, 895});
+
+// Arguments: sample rate, bitrate, peer MTU
+static void BM_EncodeAac(State& state) {
+  uint16_t sample_freq = state.range(0) == 48000
+                             ? A2DP_AAC_SAMPLING_FREQ_48000
+                             : A2DP_AAC_SAMPLING_FREQ_44100;
+  uint32_t bit_rate = (uint32_t)state.range(1);
+  const uint8_t peer_codec_info[AVDT_CODEC_SIZE] = {
+      A2DP_AAC_CODEC_LEN,
+      AVDT_MEDIA_TYPE_AUDIO << 4,
+      A2DP_MEDIA_CT_AAC,
+      A2DP_AAC_OBJECT_TYPE_MPEG2_LC,
+      (uint8_t)(sample_freq & 0xff),
+      (uint8_t)((sample_freq >> 8) | A2DP_AAC_CHANNEL_MODE_STEREO),
+      (uint8_t)(A2DP_AAC_VARIABLE_BIT_RATE_DISABLED | (bit_rate >> 16)),
+      (uint8_t)(bit_rate >> 8),
+      (uint8_t)bit_rate};
+  bm_encode(state, peer_codec_info, (uint16_t)state.range(2));
+}
+BENCHMARK(BM_EncodeAac)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({44100, 320000, 895})
+    ->Args({44100, 256000, 663})
+    ->Args({44100, 128000, 663})
+    ->Args({48000, 320000, 895})
+    ->Args({48000, 256000, 663});
+
+// Arguments: sample rate, peer MTU
+static void BM_EncodeAptx(State& state) {
+  if (!A2DP_VendorLoadEncoderAptx()) {
+    state.SkipWithError("aptX encoder library not available");
+    return;
+  }
+  const uint8_t peer_codec_info[AVDT_CODEC_SIZE] = {
+      A2DP_APTX_CODEC_LEN,
+      AVDT_MEDIA_TYPE_AUDIO << 4,
+      A2DP_MEDIA_CT_NON_A2DP,
+      (uint8_t)(A2DP_APTX_VENDOR_ID & 0xff),
+      (uint8_t)((A2DP_APTX_VENDOR_ID >> 8) & 0xff),
+      (uint8_t)((A2DP_APTX_VENDOR_ID >> 16) & 0xff),
+      (uint8_t)((A2DP_APTX_VENDOR_ID >> 24) & 0xff),
+      (uint8_t)(A2DP_APTX_CODEC_ID_BLUETOOTH & 0xff),
+      (uint8_t)(A2DP_APTX_CODEC_ID_BLUETOOTH >> 8),
+      (uint8_t)((state.range(0) == 48000 ? A2DP_APTX_SAMPLERATE_48000
+                                         : A2DP_APTX_SAMPLERATE_44100) |
+                A2DP_APTX_CHANNELS_STEREO)};
+  bm_encode(state, peer_codec_info, (uint16_t)state.range(1));
+}
+BENCHMARK(BM_EncodeAptx)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({44100, 895})
+    ->Args({48000, 895})
+    ->Args({48000, 663});
+
+// Arguments: sample rate, peer MTU
+static void BM_EncodeAptxHd(State& state) {
+  if (!A2DP_VendorLoadEncoderAptxHd()) {
+    state.SkipWithError("aptX-HD encoder library not available");
+    return;
+  }
+  const uint8_t peer_codec_info[AVDT_CODEC_SIZE] = {
+      A2DP_APTX_HD_CODEC_LEN,
+      AVDT_MEDIA_TYPE_AUDIO << 4,
+      A2DP_MEDIA_CT_NON_A2DP,
+      (uint8_t)(A2DP_APTX_HD_VENDOR_ID & 0xff),
+      (uint8_t)((A2DP_APTX_HD_VENDOR_ID >> 8) & 0xff),
+      (uint8_t)((A2DP_APTX_HD_VENDOR_ID >> 16) & 0xff),
+      (uint8_t)((A2DP_APTX_HD_VENDOR_ID >> 24) & 0xff),
+      (uint8_t)(A2DP_APTX_HD_CODEC_ID_BLUETOOTH & 0xff),
+      (uint8_t)(A2DP_APTX_HD_CODEC_ID_BLUETOOTH >> 8),
+      (uint8_t)((state.range(0) == 48000 ? A2DP_APTX_HD_SAMPLERATE_48000
+                                         : A2DP_APTX_HD_SAMPLERATE_44100) |
+                A2DP_APTX_HD_CHANNELS_STEREO),
+      A2DP_APTX_HD_ACL_SPRINT_RESERVED0,
+      A2DP_APTX_HD_ACL_SPRINT_RESERVED1,
+      A2DP_APTX_HD_ACL_SPRINT_RESERVED2,
+      A2DP_APTX_HD_ACL_SPRINT_RESERVED3};
+  bm_encode(state, peer_codec_info, (uint16_t)state.range(1));
+}
+BENCHMARK(BM_EncodeAptxHd)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({44100, 895})
+    ->Args({48000, 895})
+    ->Args({48000, 663});
+
+// Arguments: sample rate, quality mode, peer MTU
+static void BM_EncodeLdac(State& state) {
+  if (!A2DP_VendorLoadEncoderLdac()) {
+    state.SkipWithError("LDAC encoder library not available");
+    return;
+  }
+  const uint8_t peer_codec_info[AVDT_CODEC_SIZE] = {
+      A2DP_LDAC_CODEC_LEN,
+      AVDT_MEDIA_TYPE_AUDIO << 4,
+      A2DP_MEDIA_CT_NON_A2DP,
+      (uint8_t)(A2DP_LDAC_VENDOR_ID & 0xff),
+      (uint8_t)((A2DP_LDAC_VENDOR_ID >> 8) & 0xff),
+      (uint8_t)((A2DP_LDAC_VENDOR_ID >> 16) & 0xff),
+      (uint8_t)((A2DP_LDAC_VENDOR_ID >> 24) & 0xff),
+      (uint8_t)(A2DP_LDAC_CODEC_ID & 0xff),
+      (uint8_t)(A2DP_LDAC_CODEC_ID >> 8),
+      (uint8_t)(state.range(0) == 96000 ? A2DP_LDAC_SAMPLING_FREQ_96000
+                : state.range(0) == 48000 ? A2DP_LDAC_SAMPLING_FREQ_48000
+                                          : A2DP_LDAC_SAMPLING_FREQ_44100),
+      A2DP_LDAC_CHANNEL_MODE_STEREO};
+  // The quality mode is the last digit of codec_specific_1, e.g. 1000 for
+  // A2DP_LDAC_QUALITY_HIGH
+  bm_encode(state, peer_codec_info, (uint16_t)state.range(2),
+            1000 + state.range(1));
+}
+BENCHMARK(BM_EncodeLdac)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({48000, A2DP_LDAC_QUALITY_HIGH, 895})
+    ->Args({48000, A2DP_LDAC_QUALITY_MID, 895})
+    ->Args({48000, A2DP_LDAC_QUALITY_LOW, 663})
+    ->Args({96000, A2DP_LDAC_QUALITY_HIGH, 895})
+    ->Args({44100, A2DP_LDAC_QUALITY_MID, 895});
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "btm_int.h"
+#include "osi/include/allocator.h"
+#include "osi/include/list.h"
+
+using ::benchmark::State;
+
+// Number of bonded devices in the security record list.
+#define NUM_DEVICES BTM_SEC_MAX_DEVICE_RECORDS
+
+static RawAddress device_address(int i) {
+  RawAddress addr;
+  // Public address, so lookup misses never run RPA resolution
+  addr.address[0] = 0x00;
+  addr.address[1] = 0x1b;
+  addr.address[2] = 0xdc;
+  addr.address[3] = (uint8_t)(i >> 16);
+  addr.address[4] = (uint8_t)(i >> 8);
+  addr.address[5] = (uint8_t)i;
+  return addr;
+}
+
+class BM_BtmDev : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    benchmark::Fixture::SetUp(st);
+    btm_cb.sec_dev_rec = list_new(osi_free);
+    btm_sec_dev_index_reset();
+    for (int i = 0; i < NUM_DEVICES; i++) {
+      tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+      p_dev_rec->bd_addr = device_address(i);
+      p_dev_rec->hci_handle = (uint16_t)i;
+      p_dev_rec->ble_hci_handle = (uint16_t)(NUM_DEVICES + i);
+      p_dev_rec->sec_flags |= BTM_SEC_LINK_KEY_KNOWN;
+      addresses_.push_back(p_dev_rec->bd_addr);
+    }
+  }
+
+  void TearDown(State& st) override {
+    list_free(btm_cb.sec_dev_rec);
+    btm_cb.sec_dev_rec = nullptr;
+    btm_sec_dev_index_reset();
+    addresses_.clear();
+    benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<RawAddress> addresses_;
+};
+
+BENCHMARK_F(BM_BtmDev, find_dev_by_address)(State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev(addresses_[i]));
+    i = (i + 1) % NUM_DEVICES;
+  }
+};
+
+BENCHMARK_F(BM_BtmDev, find_dev_by_handle)(State& state) {
+  uint16_t handle = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev_by_handle(handle));
+    handle = (handle + 1) % (2 * NUM_DEVICES);
+  }
+};
+
+BENCHMARK_F(BM_BtmDev, find_unknown_dev)(State& state) {
+  RawAddress unknown = device_address(NUM_DEVICES + 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev(unknown));
+  }
+};
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -257,13 +257,24 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
+  /* an address resolved before only needs to be checked against that IRK */
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_dev_index_find_rpa(random_bda);
+  if (p_dev_rec != nullptr &&
+      !btm_ble_match_random_bda(p_dev_rec, (void*)&random_bda)) {
+    BTM_TRACE_EVENT("%s:  resolved from index", __func__);
+    return p_dev_rec;
+  }
+
   /* start to resolve random address */
   /* check for next security record */
 
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
                                 (void*)&random_bda);
-  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
-  if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  p_dev_rec = nullptr;
+  if (n != nullptr) {
+    p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    btm_sec_dev_index_add_rpa(random_bda, p_dev_rec);
+  }
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
@@ -277,22 +288,32 @@ tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
 tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr(const RawAddress& bd_addr,
                                                 uint8_t addr_type) {
 #if (BLE_PRIVACY_SPT == TRUE)
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
-       node = list_next(node)) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
-    if (p_dev_rec->ble.identity_addr == bd_addr) {
-      if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
-          (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
-        BTM_TRACE_WARNING(
-            "%s find pseudo->random match with diff addr type: %d vs %d",
-            __func__, p_dev_rec->ble.identity_addr_type, addr_type);
-
-      /* found the match */
-      return p_dev_rec;
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_dev_index_find_identity(bd_addr);
+  if (p_dev_rec == NULL || p_dev_rec->ble.identity_addr != bd_addr) {
+    p_dev_rec = NULL;
+
+    list_node_t* end = list_end(btm_cb.sec_dev_rec);
+    for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+         node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      if (p_rec->ble.identity_addr == bd_addr) {
+        p_dev_rec = p_rec;
+        btm_sec_dev_index_add_identity(bd_addr, p_dev_rec);
+        break;
+      }
     }
   }
+
+  if (p_dev_rec != NULL) {
+    if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
+        (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
+      BTM_TRACE_WARNING(
+          "%s find pseudo->random match with diff addr type: %d vs %d",
+          __func__, p_dev_rec->ble.identity_addr_type, addr_type);
+
+    /* found the match */
+    return p_dev_rec;
+  }
 #endif
 
   return NULL;
@@ -61,6 +61,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unordered_map>
 
 #include "bt_common.h"
 #include "bt_types.h"
@@ -72,6 +73,129 @@
 #include "hcimsgs.h"
 #include "l2c_api.h"
 
+/* Lookup index of the security device records.
+ *
+ * The records are owned by btm_cb.sec_dev_rec. The maps below remember the
+ * record a key was last found in, so the frequent lookups on HCI events need
+ * not walk the list (and, for resolvable private addresses, run AES against
+ * every IRK). The keyed fields are updated in place all over btm, so every hit
+ * is verified against the record before it is returned, and a miss falls back
+ * to the list walk. A record is dropped from the index before it is freed.
+ */
+static std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> btm_dev_addr_index;
+static std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*> btm_dev_handle_index;
+static std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> btm_dev_rpa_index;
+static std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> btm_dev_identity_index;
+
+/* Resolved private addresses rotate, bound the memory they can take */
+#define BTM_DEV_RPA_INDEX_MAX (2 * BTM_SEC_MAX_DEVICE_RECORDS)
+
+template <typename K>
+static tBTM_SEC_DEV_REC* btm_dev_index_get(
+    const std::unordered_map<K, tBTM_SEC_DEV_REC*>& index, const K& key) {
+  auto it = index.find(key);
+  return (it == index.end()) ? NULL : it->second;
+}
+
+template <typename K>
+static void btm_dev_index_erase_rec(
+    std::unordered_map<K, tBTM_SEC_DEV_REC*>& index,
+    tBTM_SEC_DEV_REC* p_dev_rec) {
+  for (auto it = index.begin(); it != index.end();) {
+    if (it->second == p_dev_rec)
+      it = index.erase(it);
+    else
+      ++it;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_reset
+ *
+ * Description      Drop all entries of the security record index. Called
+ *                  when the record list is (re)created.
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_reset(void) {
+  btm_dev_addr_index.clear();
+  btm_dev_handle_index.clear();
+  btm_dev_rpa_index.clear();
+  btm_dev_identity_index.clear();
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_remove_dev_rec
+ *
+ * Description      Remove a record from the index and free it.
+ *
+ ******************************************************************************/
+static void btm_sec_remove_dev_rec(tBTM_SEC_DEV_REC* p_dev_rec) {
+  btm_dev_index_erase_rec(btm_dev_addr_index, p_dev_rec);
+  btm_dev_index_erase_rec(btm_dev_handle_index, p_dev_rec);
+  btm_dev_index_erase_rec(btm_dev_rpa_index, p_dev_rec);
+  btm_dev_index_erase_rec(btm_dev_identity_index, p_dev_rec);
+  list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_find_rpa
+ *
+ * Description      Look up the record a resolvable private address was last
+ *                  resolved to. The caller must verify the record still
+ *                  resolves the address.
+ *
+ * Returns          Pointer to the record or NULL
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_sec_dev_index_find_rpa(const RawAddress& rpa) {
+  return btm_dev_index_get(btm_dev_rpa_index, rpa);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_add_rpa
+ *
+ * Description      Remember the record a resolvable private address resolved
+ *                  to.
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_add_rpa(const RawAddress& rpa,
+                               tBTM_SEC_DEV_REC* p_dev_rec) {
+  if (btm_dev_rpa_index.size() >= BTM_DEV_RPA_INDEX_MAX)
+    btm_dev_rpa_index.clear();
+  btm_dev_rpa_index[rpa] = p_dev_rec;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_find_identity
+ *
+ * Description      Look up the record last found with an LE identity
+ *                  address. The caller must verify the record still has it.
+ *
+ * Returns          Pointer to the record or NULL
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_sec_dev_index_find_identity(
+    const RawAddress& identity_addr) {
+  return btm_dev_index_get(btm_dev_identity_index, identity_addr);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_add_identity
+ *
+ * Description      Remember the record found with an LE identity address.
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_add_identity(const RawAddress& identity_addr,
+                                    tBTM_SEC_DEV_REC* p_dev_rec) {
+  btm_dev_identity_index[identity_addr] = p_dev_rec;
+}
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddDevice
@@ -343,7 +467,7 @@ void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
 
   /* Clear out any saved BLE keys */
   btm_sec_clear_ble_keys(p_dev_rec);
-  list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_sec_remove_dev_rec(p_dev_rec);
 }
 
 /*******************************************************************************
@@ -415,9 +539,17 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_dev_index_get(btm_dev_handle_index, handle);
+  if (p_dev_rec && !is_handle_equal(p_dev_rec, &handle)) return p_dev_rec;
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n) {
+    p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    btm_dev_handle_index[handle] = p_dev_rec;
+    return p_dev_rec;
+  }
 
+  btm_dev_handle_index.erase(handle);
   return NULL;
 }
 
@@ -445,11 +577,33 @@ bool is_address_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
+  if (bd_addr == RawAddress::kEmpty) return NULL;
+
+  /* The public or pseudo address the record was last found with */
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_dev_index_get(btm_dev_addr_index, bd_addr);
+  if (p_dev_rec && (p_dev_rec->bd_addr == bd_addr ||
+                    p_dev_rec->ble.pseudo_addr == bd_addr))
+    return p_dev_rec;
+
+  /* A private address resolved before, only check that one IRK */
+  p_dev_rec = btm_dev_index_get(btm_dev_rpa_index, bd_addr);
+  if (p_dev_rec && btm_ble_addr_resolvable(bd_addr, p_dev_rec))
+    return p_dev_rec;
+
   list_node_t* n =
       list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n == NULL) {
+    btm_dev_addr_index.erase(bd_addr);
+    return NULL;
+  }
 
-  return NULL;
+  p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr)
+    btm_dev_addr_index[bd_addr] = p_dev_rec;
+  else
+    btm_sec_dev_index_add_rpa(bd_addr, p_dev_rec);
+
+  return p_dev_rec;
 }
 
 /*******************************************************************************
@@ -492,7 +646,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       p_target_rec->bond_type = temp_rec.bond_type;
 
       /* remove the combined record */
-      list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+      btm_sec_remove_dev_rec(p_dev_rec);
       //p_dev_rec gets freed in list_remove, we should not  access it further
       continue;
     }
@@ -504,12 +658,34 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
         p_target_rec->device_type |= p_dev_rec->device_type;
 
         /* remove the combined record */
-        list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+        btm_sec_remove_dev_rec(p_dev_rec);
       }
     }
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_find_or_load_dev
+ *
+ * Description      Look for the record in the device database for the record
+ *                  with specified BD address. A bonded device the application
+ *                  manager has not loaded yet is loaded with the registered
+ *                  device load callback.
+ *
+ * Returns          Pointer to the record or NULL
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_find_or_load_dev(const RawAddress& bd_addr) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bd_addr);
+  if (p_dev_rec == NULL && btm_cb.p_dev_load_callback != NULL &&
+      bd_addr != RawAddress::kEmpty &&
+      (*btm_cb.p_dev_load_callback)(bd_addr)) {
+    p_dev_rec = btm_find_dev(bd_addr);
+  }
+  return p_dev_rec;
+}
+
 /*******************************************************************************
  *
  * Function         btm_find_or_alloc_dev
@@ -523,7 +699,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
 tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr) {
   tBTM_SEC_DEV_REC* p_dev_rec;
   BTM_TRACE_EVENT("btm_find_or_alloc_dev");
-  p_dev_rec = btm_find_dev(bd_addr);
+  p_dev_rec = btm_find_or_load_dev(bd_addr);
   if (p_dev_rec == NULL) {
     /* Allocate a new device record or reuse the oldest one */
     p_dev_rec = btm_sec_alloc_dev(bd_addr);
@@ -593,7 +769,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
 
   if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
     p_dev_rec = btm_find_oldest_dev_rec();
-    list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+    btm_sec_remove_dev_rec(p_dev_rec);
   }
 
   p_dev_rec =
@@ -216,12 +216,21 @@ extern tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void);
 extern tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr);
 extern void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
+extern tBTM_SEC_DEV_REC* btm_find_or_load_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle);
 extern tBTM_BOND_TYPE btm_get_bond_type_dev(const RawAddress& bd_addr);
 extern bool btm_set_bond_type_dev(const RawAddress& bd_addr,
                                   tBTM_BOND_TYPE bond_type);
 extern bool btm_is_sm4_dev(const RawAddress&  bd_addr);
+extern void btm_sec_dev_index_reset(void);
+extern tBTM_SEC_DEV_REC* btm_sec_dev_index_find_rpa(const RawAddress& rpa);
+extern void btm_sec_dev_index_add_rpa(const RawAddress& rpa,
+                                      tBTM_SEC_DEV_REC* p_dev_rec);
+extern tBTM_SEC_DEV_REC* btm_sec_dev_index_find_identity(
+    const RawAddress& identity_addr);
+extern void btm_sec_dev_index_add_identity(const RawAddress& identity_addr,
+                                           tBTM_SEC_DEV_REC* p_dev_rec);
 
 /* Internal functions provided by btm_sec.cc
  *********************************************
@@ -860,6 +860,7 @@ typedef struct {
 
 #define BTM_SEC_MAX_RMT_NAME_CALLBACKS 2
   tBTM_RMT_NAME_CALLBACK* p_rmt_name_callback[BTM_SEC_MAX_RMT_NAME_CALLBACKS];
+  tBTM_SEC_DEV_LOAD_CALLBACK* p_dev_load_callback;
 
   tBTM_SEC_DEV_REC* p_collided_dev_rec;
   alarm_t* sec_collision_timer;
@@ -84,6 +84,7 @@ void btm_init(void) {
 #endif
 
   btm_cb.sec_dev_rec = list_new(osi_free);
+  btm_sec_dev_index_reset();
 
   btm_dev_init(); /* Device Manager Structures & HCI_Reset */
 }
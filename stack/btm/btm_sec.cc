@@ -273,6 +273,23 @@ bool BTM_SecRegisterLinkKeyNotificationCallback(
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterDevLoadCallback
+ *
+ * Description      Application manager calls this function to load the bonded
+ *                  devices on demand: the callback is called when a
+ *                  connection, a link key request or a new record needs a
+ *                  device not found in the security database. Plain lookups
+ *                  don't call it. NULL unregisters it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_SecRegisterDevLoadCallback(tBTM_SEC_DEV_LOAD_CALLBACK* p_callback) {
+  btm_cb.p_dev_load_callback = p_callback;
+}
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddRmtNameNotifyCallback
@@ -4417,7 +4434,7 @@ static void btm_sec_connect_after_reject_timeout(UNUSED_ATTR void* data) {
  ******************************************************************************/
 void btm_sec_connected(const RawAddress& bda, uint16_t handle, uint8_t status,
                        uint8_t enc_mode) {
-  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bda);
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_load_dev(bda);
   uint8_t res;
   bool is_pairing_device = false;
   tACL_CONN* p_acl_cb;
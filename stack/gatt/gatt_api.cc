@@ -23,9 +23,11 @@
  ******************************************************************************/
 #include "bt_target.h"
 
+#include <algorithm>
 #include <base/strings/string_number_conversions.h>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 #include "bt_common.h"
 #include "btm_int.h"
 #include "device/include/controller.h"
@@ -458,6 +460,8 @@ tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
  * Function         GATTS_HandleValueNotification
  *
  * Description      This function sends a handle value notification to a client.
+ *                  While the link is congested, the notification is queued
+ *                  behind the ones of GATTS_HandleValueNotificationMulti().
  *
  * Parameter        conn_id: connection identifier.
  *                  attr_handle: Attribute handle of this handle value
@@ -465,7 +469,8 @@ tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
  *                  val_len: Length of the indicated attribute value.
  *                  p_val: Pointer to the indicated attribute value data.
  *
- * Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+ * Returns          GATT_SUCCESS if sucessfully sent, GATT_CONGESTED if sent
+ *                  or queued on a congested link; otherwise error code.
  *
  ******************************************************************************/
 tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
@@ -499,12 +504,106 @@ tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
   BT_HDR* p_buf =
       attp_build_sr_msg(*p_tcb, GATT_HANDLE_VALUE_NOTIF, &gatt_sr_msg);
   if (p_buf != NULL) {
-    cmd_sent = attp_send_sr_msg(*p_tcb, p_buf);
+    cmd_sent = gatt_send_notif(*p_tcb, p_buf);
   } else
     cmd_sent = GATT_NO_RESOURCES;
   return cmd_sent;
 }
 
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueNotificationMulti
+ *
+ * Description      This function sends the same handle value notification to
+ *                  several clients. The PDU is built once for each distinct
+ *                  MTU. While a link is congested, its notifications are
+ *                  queued, up to GATT_MAX_PENDING_NOTIF; the oldest ones are
+ *                  dropped beyond that.
+ *
+ * Parameter        num_conn: number of connections.
+ *                  conn_ids: connection identifiers, of the same application.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               notification.
+ *                  val_len: Length of the notified attribute value.
+ *                  p_val: Pointer to the notified attribute value data.
+ *                  p_status: if not NULL, receives the status of each
+ *                            connection, as GATTS_HandleValueNotification().
+ *                            GATT_CONGESTED is returned for queued
+ *                            notifications.
+ *
+ * Returns          GATT_SUCCESS if the notification is sent or queued on all
+ *                  the connections; otherwise the first error code.
+ *
+ ******************************************************************************/
+tGATT_STATUS GATTS_HandleValueNotificationMulti(
+    uint8_t num_conn, const uint16_t* conn_ids, uint16_t attr_handle,
+    uint16_t val_len, uint8_t* p_val, tGATT_STATUS* p_status) {
+  /* PDU built for one value length, and number of links still to send it */
+  struct NotifPdu {
+    uint16_t len;
+    uint8_t users;
+    BT_HDR* p_buf;
+  };
+  std::vector<NotifPdu> pdus;
+  std::vector<tGATT_TCB*> tcbs(num_conn, nullptr);
+  tGATT_STATUS ret = GATT_SUCCESS;
+
+  VLOG(1) << __func__ << " num_conn=" << +num_conn
+          << " handle=" << loghex(attr_handle);
+
+  if (!GATT_HANDLE_IS_VALID(attr_handle)) return GATT_ILLEGAL_PARAMETER;
+
+  /* The PDU only depends on the link through the MTU: count the links
+   * sending each distinct truncated value */
+  for (uint8_t i = 0; i < num_conn; i++) {
+    tGATT_REG* p_reg = gatt_get_regcb(GATT_GET_GATT_IF(conn_ids[i]));
+    tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_ids[i]));
+    if (p_reg == NULL || p_tcb == NULL || p_tcb->payload_size < 3) {
+      LOG(ERROR) << __func__ << " Unknown conn_id: " << loghex(conn_ids[i]);
+      if (p_status) p_status[i] = (tGATT_STATUS)GATT_INVALID_CONN_ID;
+      if (ret == GATT_SUCCESS) ret = (tGATT_STATUS)GATT_INVALID_CONN_ID;
+      continue;
+    }
+    tcbs[i] = p_tcb;
+
+    uint16_t len = std::min<uint16_t>(val_len, p_tcb->payload_size - 3);
+    auto pdu = std::find_if(pdus.begin(), pdus.end(),
+                            [len](const NotifPdu& p) { return p.len == len; });
+    if (pdu == pdus.end())
+      pdus.push_back({len, 1, attp_build_value_cmd(
+                                  p_tcb->payload_size, GATT_HANDLE_VALUE_NOTIF,
+                                  attr_handle, 0, len, p_val)});
+    else
+      pdu->users++;
+  }
+
+  for (uint8_t i = 0; i < num_conn; i++) {
+    tGATT_TCB* p_tcb = tcbs[i];
+    if (p_tcb == NULL) continue;
+
+    uint16_t len = std::min<uint16_t>(val_len, p_tcb->payload_size - 3);
+    auto pdu = std::find_if(pdus.begin(), pdus.end(),
+                            [len](const NotifPdu& p) { return p.len == len; });
+
+    /* L2CAP writes its headers into the buffer and frees it: every link but
+     * the last one gets a copy of the PDU */
+    BT_HDR* p_buf = pdu->p_buf;
+    if (--pdu->users != 0) {
+      size_t size = sizeof(BT_HDR) + p_buf->offset + p_buf->len;
+      p_buf = (BT_HDR*)osi_malloc(size);
+      memcpy(p_buf, pdu->p_buf, size);
+    }
+
+    tGATT_STATUS status = gatt_send_notif(*p_tcb, p_buf);
+    if (p_status) p_status[i] = status;
+    if (status != GATT_SUCCESS && status != GATT_CONGESTED &&
+        ret == GATT_SUCCESS)
+      ret = status;
+  }
+
+  return ret;
+}
+
 /*******************************************************************************
  *
  * Function         GATTS_SendRsp
@@ -888,6 +987,63 @@ tGATT_STATUS GATTC_SendHandleValueConfirm(uint16_t conn_id, uint16_t handle) {
   return ret;
 }
 
+/*******************************************************************************
+ *
+ * Function         GATTC_SubscribeNotification
+ *
+ * Description      This function subscribes a client application to the
+ *                  handle value notifications of an attribute of a peer
+ *                  device. Once an application has subscribed to a
+ *                  notification, it only receives the notifications it
+ *                  subscribed to. Indications are not filtered.
+ *
+ * Parameters       gatt_if: application interface.
+ *                  bd_addr: peer device address.
+ *                  handle: attribute value handle.
+ *
+ * Returns          true if the application is subscribed.
+ *
+ ******************************************************************************/
+bool GATTC_SubscribeNotification(tGATT_IF gatt_if, const RawAddress& bd_addr,
+                                 uint16_t handle) {
+  tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
+  if (p_reg == NULL || !GATT_HANDLE_IS_VALID(handle)) {
+    LOG(ERROR) << __func__ << " invalid gatt_if=" << +gatt_if
+               << " or handle=" << loghex(handle);
+    return false;
+  }
+
+  VLOG(1) << __func__ << " gatt_if=" << +gatt_if << " " << bd_addr
+          << " handle=" << loghex(handle);
+  p_reg->notif_indexed = true;
+  gatt_cb.notif_index[bd_addr][handle] |= GATT_IF_TO_NOTIF_MASK(gatt_if);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTC_UnsubscribeNotification
+ *
+ * Description      This function unsubscribes a client application from the
+ *                  handle value notifications of an attribute of a peer
+ *                  device.
+ *
+ * Parameters       gatt_if: application interface.
+ *                  bd_addr: peer device address.
+ *                  handle: attribute value handle, 0 for all the attributes.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void GATTC_UnsubscribeNotification(tGATT_IF gatt_if, const RawAddress& bd_addr,
+                                   uint16_t handle) {
+  VLOG(1) << __func__ << " gatt_if=" << +gatt_if << " " << bd_addr
+          << " handle=" << loghex(handle);
+  if (gatt_if < 1 || gatt_if > GATT_MAX_APPS) return;
+
+  gatt_notif_index_remove(gatt_if, &bd_addr, handle);
+}
+
 /******************************************************************************/
 /*                                                                            */
 /*                  GATT  APIs                                                */
@@ -999,6 +1155,8 @@ void GATT_Deregister(tGATT_IF gatt_if) {
     return;
   }
 
+  gatt_notif_index_remove(gatt_if, NULL, 0);
+
   if(gatt_cb.srv_list_info->empty()) {
     VLOG(1) << __func__ << "srv list info is empty";
     return;
@@ -31,6 +31,7 @@
 #include "l2c_int.h"
 #include "log/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/trace.h"
 
 #define GATT_WRITE_LONG_HDR_SIZE 5 /* 1 opcode + 2 handle + 2 offset */
 #define GATT_READ_CHAR_VALUE_HDL (GATT_READ_CHAR_VALUE | 0x80)
@@ -613,12 +614,12 @@ void gatt_process_prep_write_rsp(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
  ******************************************************************************/
 void gatt_process_notification(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
                                uint8_t* p_data) {
-  tGATT_VALUE value;
   tGATT_REG* p_reg;
   uint16_t conn_id;
   tGATT_STATUS encrypt_status;
   uint8_t* p = p_data;
   uint8_t i;
+  uint32_t subscribers = 0;
   uint8_t event = (op_code == GATT_HANDLE_VALUE_NOTIF)
                       ? GATTC_OPTYPE_NOTIFICATION
                       : GATTC_OPTYPE_INDICATION;
@@ -630,7 +631,12 @@ void gatt_process_notification(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
     return;
   }
 
-  memset(&value, 0, sizeof(value));
+  /* the value is built once, all the applications get the same copy */
+  tGATT_CL_COMPLETE gatt_cl_complete;
+  tGATT_VALUE& value = gatt_cl_complete.att_value;
+  value.conn_id = 0;
+  value.offset = 0;
+  value.auth_req = GATT_AUTH_REQ_NONE;
   STREAM_TO_UINT16(value.handle, p);
   value.len = len - 2;
   memcpy(value.value, p, value.len);
@@ -653,37 +659,37 @@ void gatt_process_notification(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
                  << " (will reset ind_count)";
     }
     tcb.ind_count = 0;
-  }
-
-  /* should notify all registered client with the handle value
-     notificaion/indication
-     Note: need to do the indication count and start timer first then do
-     callback
-   */
 
-  for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
-    if (p_reg->in_use && p_reg->app_cb.p_cmpl_cb &&
-        (event == GATTC_OPTYPE_INDICATION))
-      tcb.ind_count++;
-  }
+    /* should notify all registered client with the handle value
+       indication
+       Note: need to do the indication count and start timer first then do
+       callback
+     */
+    for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
+      if (p_reg->in_use && p_reg->app_cb.p_cmpl_cb) tcb.ind_count++;
+    }
 
-  if (event == GATTC_OPTYPE_INDICATION) {
     /* start a timer for app confirmation */
     if (tcb.ind_count > 0)
       gatt_start_ind_ack_timer(tcb);
     else /* no app to indicate, or invalid handle */
       attp_send_cl_msg(tcb, nullptr, GATT_HANDLE_VALUE_CONF, NULL);
+  } else {
+    /* notifications only go to the applications that subscribed to them,
+       or that don't use the subscription index */
+    subscribers = gatt_get_notif_subscribers(tcb.peer_bda, value.handle);
   }
 
   encrypt_status = gatt_get_link_encrypt_status(tcb);
-  tGATT_CL_COMPLETE gatt_cl_complete;
-  gatt_cl_complete.att_value = value;
   for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
-    if (p_reg->in_use && p_reg->app_cb.p_cmpl_cb) {
-      conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, p_reg->gatt_if);
-      (*p_reg->app_cb.p_cmpl_cb)(conn_id, event, encrypt_status,
-                                 &gatt_cl_complete);
-    }
+    if (!p_reg->in_use || !p_reg->app_cb.p_cmpl_cb) continue;
+    if (event == GATTC_OPTYPE_NOTIFICATION && p_reg->notif_indexed &&
+        !(subscribers & GATT_IF_TO_NOTIF_MASK(p_reg->gatt_if)))
+      continue;
+
+    conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, p_reg->gatt_if);
+    (*p_reg->app_cb.p_cmpl_cb)(conn_id, event, encrypt_status,
+                               &gatt_cl_complete);
   }
 }
 
@@ -1086,7 +1092,9 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint8_t op_code,
       return;
     }
 
+    OSI_TRACE_BEGIN("gatt_process_notification");
     gatt_process_notification(tcb, op_code, len, p_data);
+    OSI_TRACE_END("gatt_process_notification");
     return;
   }
 
@@ -1121,6 +1129,7 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint8_t op_code,
         tcb.payload_size);
     gatt_end_operation(p_clcb, GATT_ERROR, NULL);
   } else {
+    OSI_TRACE_BEGIN("gatt_process_rsp");
     switch (op_code) {
       case GATT_RSP_ERROR:
         gatt_process_error_rsp(tcb, p_clcb, op_code, len, p_data);
@@ -1166,6 +1175,7 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint8_t op_code,
         LOG(ERROR) << __func__ << ": Unknown opcode = " << std::hex << op_code;
         break;
     }
+    OSI_TRACE_END("gatt_process_rsp");
   }
 
   gatt_cl_send_next_cmd_inq(tcb);
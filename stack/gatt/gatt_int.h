@@ -28,7 +28,9 @@
 
 #include <base/strings/stringprintf.h>
 #include <string.h>
+#include <deque>
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -193,8 +195,16 @@ typedef struct {
   tGATT_IF gatt_if; /* one based */
   bool in_use;
   uint8_t listening; /* if adv for all has been enabled */
+  bool notif_indexed; /* notifications delivered by subscription only */
 } tGATT_REG;
 
+/* Mask of a client application in the notification subscription index */
+#define GATT_IF_TO_NOTIF_MASK(gatt_if) ((uint32_t)1 << ((gatt_if)-1))
+
+/* Notification subscription index of a peer device: value handle to the mask
+ * of the subscribed client applications */
+typedef std::unordered_map<uint16_t, uint32_t> tGATT_NOTIF_INDEX;
+
 struct tGATT_CLCB;
 
 /* command queue for each connection */
@@ -218,7 +228,9 @@ typedef struct {
   BT_HDR* p_rsp_msg;
   uint32_t trans_id;
   tGATT_READ_MULTI multi_req;
-  fixed_queue_t* multi_rsp_q;
+  BT_HDR* p_multi_rsp;      /* read multiple response being built */
+  uint8_t multi_rsp_cnt;    /* values received for the read multiple */
+  uint8_t multi_rsp_status; /* first error found in the values received */
   uint16_t handle;
   uint8_t op_code;
   uint8_t status;
@@ -292,6 +304,13 @@ typedef struct {
   std::queue<tGATT_CMD_Q> cl_cmd_q;
   alarm_t* ind_ack_timer; /* local app confirm to indication timer */
 
+  /* batched notifications: sent when the link is not congested */
+  bool congested;
+  std::deque<BT_HDR*> pending_notif_q;
+  uint32_t notif_sent;     /* notifications given to L2CAP */
+  uint32_t notif_deferred; /* notifications queued on congestion */
+  uint32_t notif_dropped;  /* queued notifications dropped */
+
   bool in_use;
   uint8_t tcb_idx;
 } tGATT_TCB;
@@ -367,6 +386,7 @@ typedef struct {
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
   tGATT_CLCB clcb[GATT_CL_MAX_LCB]; /* connection link control block*/
+  std::unordered_map<RawAddress, tGATT_NOTIF_INDEX> notif_index;
   uint16_t def_mtu_size;
 
 #if (GATT_CONFORMANCE_TESTING == TRUE)
@@ -424,6 +444,9 @@ extern tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
                                      uint8_t op_code, tGATT_CL_MSG* p_msg);
 extern BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
                                  tGATT_SR_MSG* p_msg);
+extern BT_HDR* attp_build_value_cmd(uint16_t payload_size, uint8_t op_code,
+                                    uint16_t handle, uint16_t offset,
+                                    uint16_t len, uint8_t* p_data);
 extern tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, BT_HDR* p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, BT_HDR* p_toL2CAP);
 
@@ -459,6 +482,9 @@ extern bool gatt_find_the_connected_bda(uint8_t start_idx, RawAddress& bda,
 extern void gatt_set_srv_chg(void);
 extern void gatt_delete_dev_from_srv_chg_clt_list(const RawAddress& bd_addr);
 extern void gatt_add_pending_ind(tGATT_TCB* p_tcb, tGATT_VALUE* p_ind);
+extern tGATT_STATUS gatt_send_notif(tGATT_TCB& tcb, BT_HDR* p_buf);
+extern void gatt_send_pending_notif(tGATT_TCB& tcb);
+extern void gatt_free_pending_notif(tGATT_TCB* p_tcb);
 extern void gatt_free_srvc_db_buffer_app_id(const bluetooth::Uuid& app_id);
 extern bool gatt_cl_send_next_cmd_inq(tGATT_TCB& tcb);
 
@@ -480,6 +506,9 @@ extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
                                             tGATTS_RSP* p_msg);
+extern bool gatt_sr_add_read_multi_rsp(tGATT_SR_CMD* p_cmd,
+                                       tGATT_STATUS status, tGATTS_RSP* p_msg,
+                                       uint16_t mtu);
 extern void gatt_server_handle_client_req(tGATT_TCB& p_tcb, uint8_t op_code,
                                           uint16_t len, uint8_t* p_data);
 extern void gatt_sr_send_req_callback(uint16_t conn_id, uint32_t trans_id,
@@ -492,6 +521,10 @@ extern void gatt_notify_phy_updated(uint8_t status, uint16_t handle,
 /*   */
 
 extern tGATT_REG* gatt_get_regcb(tGATT_IF gatt_if);
+extern uint32_t gatt_get_notif_subscribers(const RawAddress& bda,
+                                           uint16_t handle);
+extern void gatt_notif_index_remove(tGATT_IF gatt_if, const RawAddress* p_bda,
+                                    uint16_t handle);
 extern bool gatt_is_clcb_allocated(uint16_t conn_id);
 extern tGATT_CLCB* gatt_clcb_alloc(uint16_t conn_id);
 extern void gatt_clcb_dealloc(tGATT_CLCB* p_clcb);
@@ -167,14 +167,15 @@ void gatt_free(void) {
     fixed_queue_free(gatt_cb.tcb[i].pending_ind_q, NULL);
     gatt_cb.tcb[i].pending_ind_q = NULL;
 
+    gatt_free_pending_notif(&gatt_cb.tcb[i]);
+
     alarm_free(gatt_cb.tcb[i].conf_timer);
     gatt_cb.tcb[i].conf_timer = NULL;
 
     alarm_free(gatt_cb.tcb[i].ind_ack_timer);
     gatt_cb.tcb[i].ind_ack_timer = NULL;
 
-    fixed_queue_free(gatt_cb.tcb[i].sr_cmd.multi_rsp_q, NULL);
-    gatt_cb.tcb[i].sr_cmd.multi_rsp_q = NULL;
+    osi_free_and_reset((void**)&gatt_cb.tcb[i].sr_cmd.p_multi_rsp);
   }
 
   if (gatt_cb.hdl_list_info != nullptr) {
@@ -515,9 +516,12 @@ static void gatt_channel_congestion(tGATT_TCB* p_tcb, bool congested) {
   tGATT_REG* p_reg = NULL;
   uint16_t conn_id;
 
+  if (p_tcb != NULL) p_tcb->congested = congested;
+
   /* if uncongested, check to see if there is any more pending data */
   if (p_tcb != NULL && !congested) {
     gatt_cl_send_next_cmd_inq(*p_tcb);
+    gatt_send_pending_notif(*p_tcb);
   }
   /* notifying all applications for the connection up event */
   for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
@@ -25,6 +25,7 @@
 #include "bt_target.h"
 #include "bt_utils.h"
 #include "osi/include/osi.h"
+#include "osi/include/trace.h"
 
 #include <log/log.h>
 #include <string.h>
@@ -97,123 +98,77 @@ void gatt_dequeue_sr_cmd(tGATT_TCB& tcb) {
     LOG(ERROR) << "free tcb.sr_cmd.p_rsp_msg = " << tcb.sr_cmd.p_rsp_msg;
   osi_free_and_reset((void**)&tcb.sr_cmd.p_rsp_msg);
 
-  while (!fixed_queue_is_empty(tcb.sr_cmd.multi_rsp_q))
-    osi_free(fixed_queue_try_dequeue(tcb.sr_cmd.multi_rsp_q));
-  fixed_queue_free(tcb.sr_cmd.multi_rsp_q, NULL);
+  osi_free_and_reset((void**)&tcb.sr_cmd.p_multi_rsp);
   memset(&tcb.sr_cmd, 0, sizeof(tGATT_SR_CMD));
 }
 
 /*******************************************************************************
  *
- * Function         process_read_multi_rsp
+ * Function         gatt_sr_add_read_multi_rsp
  *
- * Description      This function check the read multiple response.
+ * Description      This function adds a value read by an application to the
+ *                  Read Multiple response. The response PDU is built in place
+ *                  as the values come, in the order of the handles requested.
  *
- * Returns          bool    if all replies have been received
+ * Returns          true if all the values are received or on error, false
+ *                  if still waiting for values.
  *
  ******************************************************************************/
-static bool process_read_multi_rsp(tGATT_SR_CMD* p_cmd, tGATT_STATUS status,
-                                   tGATTS_RSP* p_msg, uint16_t mtu) {
-  uint16_t ii, total_len, len;
-  uint8_t* p;
-  bool is_overflow = false;
-
+bool gatt_sr_add_read_multi_rsp(tGATT_SR_CMD* p_cmd, tGATT_STATUS status,
+                                tGATTS_RSP* p_msg, uint16_t mtu) {
   VLOG(1) << StringPrintf("%s status=%d mtu=%d", __func__, status, mtu);
 
-  if (p_cmd->multi_rsp_q == NULL)
-    p_cmd->multi_rsp_q = fixed_queue_new(SIZE_MAX);
-
-  /* Enqueue the response */
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(tGATTS_RSP));
-  memcpy((void*)p_buf, (const void*)p_msg, sizeof(tGATTS_RSP));
-  fixed_queue_enqueue(p_cmd->multi_rsp_q, p_buf);
-
   p_cmd->status = status;
-  if (status == GATT_SUCCESS) {
-    VLOG(1) << "Multi read count=" << fixed_queue_length(p_cmd->multi_rsp_q)
-            << " num_hdls=" << p_cmd->multi_req.num_handles;
-    /* Wait till we get all the responses */
-    if (fixed_queue_length(p_cmd->multi_rsp_q) ==
-        p_cmd->multi_req.num_handles) {
-      len = sizeof(BT_HDR) + L2CAP_MIN_OFFSET + mtu;
-      p_buf = (BT_HDR*)osi_calloc(len);
-      p_buf->offset = L2CAP_MIN_OFFSET;
-      p = (uint8_t*)(p_buf + 1) + p_buf->offset;
-
-      /* First byte in the response is the opcode */
-      *p++ = GATT_RSP_READ_MULTI;
-      p_buf->len = 1;
-
-      /* Now walk through the buffers puting the data into the response in order
-       */
-      list_t* list = NULL;
-      const list_node_t* node = NULL;
-      if (!fixed_queue_is_empty(p_cmd->multi_rsp_q))
-        list = fixed_queue_get_list(p_cmd->multi_rsp_q);
-      for (ii = 0; ii < p_cmd->multi_req.num_handles; ii++) {
-        tGATTS_RSP* p_rsp = NULL;
-
-        if (list != NULL) {
-          if (ii == 0)
-            node = list_begin(list);
-          else
-            node = list_next(node);
-          if (node != list_end(list)) p_rsp = (tGATTS_RSP*)list_node(node);
-        }
-
-        if (p_rsp != NULL) {
-          total_len = (p_buf->len + p_rsp->attr_value.len);
-
-          if (total_len > mtu) {
-            /* just send the partial response for the overflow case */
-            len = p_rsp->attr_value.len - (total_len - mtu);
-            is_overflow = true;
-            VLOG(1) << StringPrintf(
-                "multi read overflow available len=%d val_len=%d", len,
-                p_rsp->attr_value.len);
-          } else {
-            len = p_rsp->attr_value.len;
-          }
-
-          if (p_rsp->attr_value.handle == p_cmd->multi_req.handles[ii]) {
-            memcpy(p, p_rsp->attr_value.value, len);
-            if (!is_overflow) p += len;
-            p_buf->len += len;
-          } else {
-            p_cmd->status = GATT_NOT_FOUND;
-            break;
-          }
-
-          if (is_overflow) break;
-
-        } else {
-          p_cmd->status = GATT_NOT_FOUND;
-          break;
-        }
-
-      } /* loop through all handles*/
+  /* any handle read exception occurs, return error */
+  if (status != GATT_SUCCESS) return true;
+
+  BT_HDR* p_buf = p_cmd->p_multi_rsp;
+  if (p_buf == NULL) {
+    p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + mtu);
+    p_buf->offset = L2CAP_MIN_OFFSET;
+    /* First byte in the response is the opcode */
+    *((uint8_t*)(p_buf + 1) + p_buf->offset) = GATT_RSP_READ_MULTI;
+    p_buf->len = 1;
+    p_cmd->p_multi_rsp = p_buf;
+    p_cmd->multi_rsp_status = GATT_SUCCESS;
+  }
 
-      /* Sanity check on the buffer length */
-      if (p_buf->len == 0) {
-        LOG(ERROR) << __func__ << " nothing found!!";
-        p_cmd->status = GATT_NOT_FOUND;
-        osi_free(p_buf);
-        VLOG(1) << __func__ << "osi_free(p_buf)";
-      } else if (p_cmd->p_rsp_msg != NULL) {
-        osi_free(p_buf);
-      } else {
-        p_cmd->p_rsp_msg = p_buf;
+  uint8_t ii = p_cmd->multi_rsp_cnt++;
+  /* once the response is full, the values left are not checked */
+  if (p_cmd->multi_rsp_status == GATT_SUCCESS && p_buf->len < mtu) {
+    if (ii >= p_cmd->multi_req.num_handles ||
+        p_msg->attr_value.handle != p_cmd->multi_req.handles[ii]) {
+      p_cmd->multi_rsp_status = GATT_NOT_FOUND;
+    } else {
+      uint16_t len = p_msg->attr_value.len;
+      if (p_buf->len + len > mtu) {
+        /* just send the partial response for the overflow case */
+        len = mtu - p_buf->len;
+        VLOG(1) << StringPrintf(
+            "multi read overflow available len=%d val_len=%d", len,
+            p_msg->attr_value.len);
       }
-
-      return (true);
+      memcpy((uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len,
+             p_msg->attr_value.value, len);
+      p_buf->len += len;
     }
-  } else /* any handle read exception occurs, return error */
-  {
-    return (true);
   }
 
-  /* If here, still waiting */
-  return (false);
+  VLOG(1) << "Multi read count=" << +p_cmd->multi_rsp_cnt
+          << " num_hdls=" << p_cmd->multi_req.num_handles;
+  /* Wait till we get all the responses */
+  if (p_cmd->multi_rsp_cnt < p_cmd->multi_req.num_handles) return false;
+
+  p_cmd->p_multi_rsp = NULL;
+  if (p_cmd->multi_rsp_status != GATT_SUCCESS) {
+    p_cmd->status = p_cmd->multi_rsp_status;
+    osi_free(p_buf);
+  } else if (p_cmd->p_rsp_msg != NULL) {
+    osi_free(p_buf);
+  } else {
+    p_cmd->p_rsp_msg = p_buf;
+  }
+  return true;
 }
 
 /*******************************************************************************
@@ -238,7 +193,8 @@ tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
 
   if (op_code == GATT_REQ_READ_MULTI) {
     /* If no error and still waiting, just return */
-    if (!process_read_multi_rsp(&tcb.sr_cmd, status, p_msg, tcb.payload_size))
+    if (!gatt_sr_add_read_multi_rsp(&tcb.sr_cmd, status, p_msg,
+                                    tcb.payload_size))
       return (GATT_SUCCESS);
   } else {
     if (op_code == GATT_REQ_PREPARE_WRITE && status == GATT_SUCCESS)
@@ -410,10 +366,11 @@ void gatt_process_read_multi_req(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
     trans_id =
         gatt_sr_enqueue_cmd(tcb, op_code, tcb.sr_cmd.multi_req.handles[0]);
     if (trans_id != 0) {
-      gatt_sr_reset_cback_cnt(tcb); /* read multiple use multi_rsp_q's count*/
+      gatt_sr_reset_cback_cnt(tcb); /* read multiple use multi_rsp_cnt */
 
+      /* one buffer for the values read from the database */
+      tGATTS_RSP* p_msg = (tGATTS_RSP*)osi_malloc(sizeof(tGATTS_RSP));
       for (ll = 0; ll < tcb.sr_cmd.multi_req.num_handles; ll++) {
-        tGATTS_RSP* p_msg = (tGATTS_RSP*)osi_calloc(sizeof(tGATTS_RSP));
         handle = tcb.sr_cmd.multi_req.handles[ll];
         auto it = gatt_sr_find_i_rcb_by_handle(handle);
 
@@ -427,9 +384,8 @@ void gatt_process_read_multi_req(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
           gatt_sr_process_app_rsp(tcb, it->gatt_if, trans_id, op_code,
                                   GATT_SUCCESS, p_msg);
         }
-        /* either not using or done using the buffer, release it now */
-        osi_free(p_msg);
       }
+      osi_free(p_msg);
     } else
       err = GATT_NO_RESOURCES;
   }
@@ -1205,6 +1161,7 @@ void gatt_server_handle_client_req(tGATT_TCB& tcb, uint8_t op_code,
     }
     /* otherwise, ignore the pkt */
   } else {
+    OSI_TRACE_BEGIN("gatt_process_req");
     switch (op_code) {
       case GATT_REQ_READ_BY_GRP_TYPE: /* discover primary services */
       case GATT_REQ_FIND_TYPE_VALUE:  /* discover service by UUID */
@@ -1249,5 +1206,6 @@ void gatt_server_handle_client_req(tGATT_TCB& tcb, uint8_t op_code,
       default:
         break;
     }
+    OSI_TRACE_END("gatt_process_req");
   }
 }
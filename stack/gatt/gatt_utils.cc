@@ -157,6 +157,81 @@ void gatt_set_srv_chg(void) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         gatt_send_notif
+ *
+ * Description      Send a handle value notification PDU, or queue it while
+ *                  the link is congested. When the queue is full, the oldest
+ *                  queued notification is dropped.
+ *
+ * Returns          GATT_SUCCESS if sent, GATT_CONGESTED if sent or queued on
+ *                  a congested link, otherwise error code.
+ *
+ ******************************************************************************/
+tGATT_STATUS gatt_send_notif(tGATT_TCB& tcb, BT_HDR* p_buf) {
+  if (tcb.congested || !tcb.pending_notif_q.empty()) {
+    tcb.pending_notif_q.push_back(p_buf);
+    tcb.notif_deferred++;
+    if (tcb.pending_notif_q.size() > GATT_MAX_PENDING_NOTIF) {
+      osi_free(tcb.pending_notif_q.front());
+      tcb.pending_notif_q.pop_front();
+      tcb.notif_dropped++;
+    }
+    return GATT_CONGESTED;
+  }
+
+  tGATT_STATUS status = attp_send_sr_msg(tcb, p_buf);
+  if (status == GATT_SUCCESS || status == GATT_CONGESTED) tcb.notif_sent++;
+  if (status == GATT_CONGESTED) tcb.congested = true;
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_send_pending_notif
+ *
+ * Description      Send the queued notifications until the link is
+ *                  congested again.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void gatt_send_pending_notif(tGATT_TCB& tcb) {
+  while (!tcb.congested && !tcb.pending_notif_q.empty()) {
+    BT_HDR* p_buf = tcb.pending_notif_q.front();
+    tcb.pending_notif_q.pop_front();
+
+    tGATT_STATUS status = attp_send_sr_msg(tcb, p_buf);
+    if (status == GATT_SUCCESS || status == GATT_CONGESTED) tcb.notif_sent++;
+    if (status == GATT_CONGESTED) tcb.congested = true;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_free_pending_notif
+ *
+ * Description      Free all the queued notifications
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void gatt_free_pending_notif(tGATT_TCB* p_tcb) {
+  if (p_tcb->notif_sent || p_tcb->notif_deferred) {
+    VLOG(1) << __func__ << " " << p_tcb->peer_bda
+            << " notifications sent=" << p_tcb->notif_sent
+            << " deferred=" << p_tcb->notif_deferred
+            << " dropped=" << p_tcb->notif_dropped
+            << " pending=" << p_tcb->pending_notif_q.size();
+  }
+
+  while (!p_tcb->pending_notif_q.empty()) {
+    osi_free(p_tcb->pending_notif_q.front());
+    p_tcb->pending_notif_q.pop_front();
+  }
+}
+
 /** Add a pending indication */
 void gatt_add_pending_ind(tGATT_TCB* p_tcb, tGATT_VALUE* p_ind) {
   VLOG(1) << __func__ << "enqueue a pending indication";
@@ -864,6 +939,67 @@ tGATT_REG* gatt_get_regcb(tGATT_IF gatt_if) {
   return p_reg;
 }
 
+/*******************************************************************************
+ *
+ * Function         gatt_get_notif_subscribers
+ *
+ * Description      The function returns the mask of the client applications
+ *                  subscribed to the notifications of |handle| from |bda|.
+ *
+ * Returns          mask of GATT_IF_TO_NOTIF_MASK(), 0 if none
+ *
+ ******************************************************************************/
+uint32_t gatt_get_notif_subscribers(const RawAddress& bda, uint16_t handle) {
+  auto peer = gatt_cb.notif_index.find(bda);
+  if (peer == gatt_cb.notif_index.end()) return 0;
+
+  auto sub = peer->second.find(handle);
+  return (sub == peer->second.end()) ? 0 : sub->second;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_notif_index_remove
+ *
+ * Description      The function removes subscriptions of client application
+ *                  |gatt_if| from the notification index: the subscription to
+ *                  |handle| of |*p_bda|, all the subscriptions to |*p_bda| if
+ *                  |handle| is 0, all the subscriptions if |p_bda| is NULL.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_notif_index_remove(tGATT_IF gatt_if, const RawAddress* p_bda,
+                             uint16_t handle) {
+  uint32_t mask = GATT_IF_TO_NOTIF_MASK(gatt_if);
+
+  for (auto peer = gatt_cb.notif_index.begin();
+       peer != gatt_cb.notif_index.end();) {
+    if (p_bda != NULL && peer->first != *p_bda) {
+      ++peer;
+      continue;
+    }
+
+    tGATT_NOTIF_INDEX& index = peer->second;
+    for (auto sub = index.begin(); sub != index.end();) {
+      if (handle != 0 && sub->first != handle) {
+        ++sub;
+        continue;
+      }
+      sub->second &= ~mask;
+      if (sub->second == 0)
+        sub = index.erase(sub);
+      else
+        ++sub;
+    }
+
+    if (index.empty())
+      peer = gatt_cb.notif_index.erase(peer);
+    else
+      ++peer;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         gatt_is_clcb_allocated
@@ -1191,7 +1327,8 @@ void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status, void* p_data) {
   VLOG(1) << __func__
           << StringPrintf(" status=%d op=%d subtype=%d", status,
                           p_clcb->operation, p_clcb->op_subtype);
-  memset(&cb_data.att_value, 0, sizeof(tGATT_VALUE));
+  /* the value bytes are only valid up to |len|, they are not cleared */
+  memset(&cb_data.att_value, 0, offsetof(tGATT_VALUE, value));
 
   if (p_cmpl_cb != NULL && p_clcb->operation != 0) {
     if (p_clcb->operation == GATTC_OPTYPE_READ) {
@@ -1203,7 +1340,6 @@ void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status, void* p_data) {
     }
 
     if (p_clcb->operation == GATTC_OPTYPE_WRITE) {
-      memset(&cb_data.att_value, 0, sizeof(tGATT_VALUE));
       cb_data.handle = cb_data.att_value.handle = p_clcb->s_handle;
       if (p_clcb->op_subtype == GATT_WRITE_PREPARE) {
         if (p_data) {
@@ -1269,8 +1405,8 @@ void gatt_cleanup_upon_disc(const RawAddress& bda, uint16_t reason,
   alarm_free(p_tcb->conf_timer);
   p_tcb->conf_timer = NULL;
   gatt_free_pending_ind(p_tcb);
-  fixed_queue_free(p_tcb->sr_cmd.multi_rsp_q, NULL);
-  p_tcb->sr_cmd.multi_rsp_q = NULL;
+  gatt_free_pending_notif(p_tcb);
+  osi_free_and_reset((void**)&p_tcb->sr_cmd.p_multi_rsp);
 
   for (uint8_t i = 0; i < GATT_MAX_APPS; i++) {
     tGATT_REG* p_reg = &gatt_cb.cl_rcb[i];
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+//
+// A2DP source pacing, shared by the software encoders.
+//
+// The encoders are driven by the periodic media timer. At each tick, the
+// pacing engine computes from the monotonic tick timestamp how much PCM data
+// became due since the previous tick. The computation is exact: the sub-byte
+// remainder is carried over to the next tick, so the long-run rate matches
+// the PCM rate whatever the timer jitter. The encoders then take the due data
+// in frames or in packets; what can't be sent yet stays pending.
+//
+
+#ifndef A2DP_PACING_H
+#define A2DP_PACING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t pcm_bytes_per_sec; /* PCM input rate */
+  uint32_t interval_us;       /* nominal media timer period */
+  uint32_t max_pending_bytes; /* catch-up limit, 0 if none */
+
+  uint64_t last_us;   /* timestamp of the previous tick, 0 before the first */
+  uint64_t remainder; /* due bytes not yet counted, scaled by 1e6 */
+  uint32_t counter;   /* PCM bytes due and not sent yet */
+
+  /* Statistics */
+  uint64_t total_due_bytes;     /* PCM bytes that became due */
+  uint64_t total_dropped_bytes; /* due PCM bytes dropped by catch-up limits */
+  uint32_t ticks;               /* media timer ticks */
+  uint32_t late_ticks;          /* ticks more than half a period late */
+  uint32_t max_tick_us;         /* longest time between two ticks */
+} tA2DP_PACING;
+
+// Initialize |pacing| for a PCM input of |pcm_bytes_per_sec| bytes per
+// second and a media timer period of |interval_us| microseconds. At most
+// |max_pending_bytes| are kept pending between ticks, the rest is dropped;
+// 0 disables the limit.
+void a2dp_pacing_init(tA2DP_PACING* pacing, uint32_t pcm_bytes_per_sec,
+                      uint32_t interval_us, uint32_t max_pending_bytes);
+
+// Drop the pending PCM data, e.g. when the audio path is flushed. The next
+// tick accounts for one nominal period.
+void a2dp_pacing_flush(tA2DP_PACING* pacing);
+
+// Account for a media timer tick at |now_us| (monotonic clock). The first
+// tick after init or flush accounts for one nominal period.
+// Returns the number of PCM bytes pending.
+uint32_t a2dp_pacing_tick(tA2DP_PACING* pacing, uint64_t now_us);
+
+// Take |bytes| pending PCM bytes. Returns false, and takes nothing, if fewer
+// are pending.
+bool a2dp_pacing_consume(tA2DP_PACING* pacing, uint32_t bytes);
+
+// Return |bytes| taken but not sent, e.g. on a PCM read underflow, so they
+// are sent at the next tick.
+void a2dp_pacing_refund(tA2DP_PACING* pacing, uint32_t bytes);
+
+// Take the whole frames of |pcm_bytes_per_frame| bytes that are pending and
+// split them into |*num_of_iterations| packets of |*num_of_frames| frames:
+//  - With |frames_per_packet| 0, all the frames go in one packet.
+//  - Otherwise full packets of |frames_per_packet| frames are sent; frames
+//    that don't fill a packet stay pending, unless no packet is full.
+// At most |max_frames| frames and |max_iterations| packets are sent per tick;
+// the frames above those limits are dropped.
+// Returns the number of frames that were pending before the split.
+uint32_t a2dp_pacing_get_num_frame_iteration(
+    tA2DP_PACING* pacing, uint32_t pcm_bytes_per_frame,
+    uint8_t frames_per_packet, uint8_t max_frames, uint8_t max_iterations,
+    uint8_t* num_of_iterations, uint8_t* num_of_frames);
+
+// Dump the pacing statistics of |pacing| to the file descriptor |fd|.
+void a2dp_pacing_debug_dump(const tA2DP_PACING* pacing, int fd);
+
+#endif  // A2DP_PACING_H
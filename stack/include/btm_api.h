@@ -1303,6 +1303,22 @@ extern bool BTM_SecRegister(const tBTM_APPL_INFO* p_cb_info);
 extern bool BTM_SecRegisterLinkKeyNotificationCallback(
     tBTM_LINK_KEY_CALLBACK* p_callback);
 
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterDevLoadCallback
+ *
+ * Description      Application manager calls this function to load the bonded
+ *                  devices on demand: the callback is called when a
+ *                  connection, a link key request or a new record needs a
+ *                  device not found in the security database. Plain lookups
+ *                  don't call it. NULL unregisters it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_SecRegisterDevLoadCallback(
+    tBTM_SEC_DEV_LOAD_CALLBACK* p_callback);
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddRmtNameNotifyCallback
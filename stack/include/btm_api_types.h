@@ -1396,6 +1396,12 @@ typedef uint8_t(tBTM_LINK_KEY_CALLBACK)(const RawAddress& bd_addr,
                                         tBTM_BD_NAME bd_name,
                                         const LinkKey& key, uint8_t key_type);
 
+/* Load a bonded device not in the security database yet. Parameters are
+ *              BD Address of remote
+ * Returns true if the device was added with BTM_SecAddDevice.
+*/
+typedef bool(tBTM_SEC_DEV_LOAD_CALLBACK)(const RawAddress& bd_addr);
+
 /* Remote Name Resolved.  Parameters are
  *              BD Address of remote
  *              BD Name of remote
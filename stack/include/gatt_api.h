@@ -772,6 +772,35 @@ extern tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
                                                   uint16_t val_len,
                                                   uint8_t* p_val);
 
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueNotificationMulti
+ *
+ * Description      This function sends the same handle value notification to
+ *                  several clients. The PDU is built once for each distinct
+ *                  MTU. While a link is congested, its notifications are
+ *                  queued, up to GATT_MAX_PENDING_NOTIF; the oldest ones are
+ *                  dropped beyond that.
+ *
+ * Parameter        num_conn: number of connections.
+ *                  conn_ids: connection identifiers, of the same application.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               notification.
+ *                  val_len: Length of the notified attribute value.
+ *                  p_val: Pointer to the notified attribute value data.
+ *                  p_status: if not NULL, receives the status of each
+ *                            connection, as GATTS_HandleValueNotification().
+ *                            GATT_CONGESTED is returned for queued
+ *                            notifications.
+ *
+ * Returns          GATT_SUCCESS if the notification is sent or queued on all
+ *                  the connections; otherwise the first error code.
+ *
+ ******************************************************************************/
+extern tGATT_STATUS GATTS_HandleValueNotificationMulti(
+    uint8_t num_conn, const uint16_t* conn_ids, uint16_t attr_handle,
+    uint16_t val_len, uint8_t* p_val, tGATT_STATUS* p_status);
+
 /*******************************************************************************
  *
  * Function         GATTS_SendRsp
@@ -896,6 +925,46 @@ extern tGATT_STATUS GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
 extern tGATT_STATUS GATTC_SendHandleValueConfirm(uint16_t conn_id,
                                                  uint16_t handle);
 
+/*******************************************************************************
+ *
+ * Function         GATTC_SubscribeNotification
+ *
+ * Description      This function subscribes a client application to the
+ *                  handle value notifications of an attribute of a peer
+ *                  device. Once an application has subscribed to a
+ *                  notification, it only receives the notifications it
+ *                  subscribed to. Indications are not filtered.
+ *
+ * Parameters       gatt_if: application interface.
+ *                  bd_addr: peer device address.
+ *                  handle: attribute value handle.
+ *
+ * Returns          true if the application is subscribed.
+ *
+ ******************************************************************************/
+extern bool GATTC_SubscribeNotification(tGATT_IF gatt_if,
+                                        const RawAddress& bd_addr,
+                                        uint16_t handle);
+
+/*******************************************************************************
+ *
+ * Function         GATTC_UnsubscribeNotification
+ *
+ * Description      This function unsubscribes a client application from the
+ *                  handle value notifications of an attribute of a peer
+ *                  device.
+ *
+ * Parameters       gatt_if: application interface.
+ *                  bd_addr: peer device address.
+ *                  handle: attribute value handle, 0 for all the attributes.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void GATTC_UnsubscribeNotification(tGATT_IF gatt_if,
+                                          const RawAddress& bd_addr,
+                                          uint16_t handle);
+
 /*******************************************************************************
  *
  * Function         GATT_SetIdleTimeout
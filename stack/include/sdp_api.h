@@ -658,6 +658,17 @@ uint16_t SDP_GetDiRecord(uint8_t getRecordIndex,
                          tSDP_DI_GET_RECORD* device_info,
                          tSDP_DISCOVERY_DB* p_db);
 
+/*******************************************************************************
+ *
+ * Function         SDP_CacheDump
+ *
+ * Description      This function dumps the discovery cache statistics.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_CacheDump(int fd);
+
 /*******************************************************************************
  *
  * Function         SDP_SetTraceLevel
@@ -42,6 +42,7 @@
 #include "l2c_int.h"
 #include "l2cdefs.h"
 #include "osi/include/osi.h"
+#include "osi/include/trace.h"
 #include "device/include/device_iot_config.h"
 #include "btif/include/btif_av.h"
 
@@ -1198,6 +1199,8 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
   uint16_t xmit_window, acl_data_size;
   const controller_t* controller = controller_get_interface();
 
+  OSI_TRACE_BEGIN("l2c_link_send_to_lower");
+
   if ((p_buf->len <= controller->get_acl_packet_size_classic() &&
        (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
       ((p_lcb->transport == BT_TRANSPORT_LE) &&
@@ -1283,8 +1286,15 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
   }
 #endif
 
+  if (p_lcb->transport == BT_TRANSPORT_LE) {
+    OSI_TRACE_COUNTER("l2cap le xmit window", l2cb.controller_le_xmit_window);
+  } else {
+    OSI_TRACE_COUNTER("l2cap xmit window", l2cb.controller_xmit_window);
+  }
+
   if (p_cbi) l2cu_tx_complete(p_cbi);
 
+  OSI_TRACE_END("l2c_link_send_to_lower");
   return true;
 }
 
@@ -104,7 +104,8 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
       p_lcb->ucd_out_sec_pending_q = fixed_queue_new(SIZE_MAX);
       p_lcb->ucd_in_sec_pending_q = fixed_queue_new(SIZE_MAX);
 #endif
-      p_lcb->link_xmit_data_q = list_new(NULL);
+      p_lcb->link_xmit_data_q =
+          list_new_pooled(NULL, L2CAP_LINK_XMIT_DATA_Q_POOL_SIZE);
       return (p_lcb);
     }
   }
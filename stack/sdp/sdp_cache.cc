@@ -0,0 +1,477 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  this file contains the cache of ServiceSearchAttribute results of bonded
+ *  peers. The raw attribute lists returned by a peer are persisted in the
+ *  peer's section of the btif config, keyed by a signature of the UUID and
+ *  attribute filters of the request, so a later identical request can be
+ *  answered without setting up an L2CAP channel to the peer.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "bt_common.h"
+#include "bt_target.h"
+#include "btif/include/btif_config.h"
+#include "btu.h"
+#include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+
+using bluetooth::Uuid;
+
+/* Property selecting the cache mode: "off", "local" or "refresh" */
+#define SDP_CACHE_MODE_PROPERTY "persist.bluetooth.sdp_cache.mode"
+
+/* Size of the discovery database used for background refreshes */
+#define SDP_CACHE_REFRESH_DB_SIZE 8000
+
+/* Each entry is stored as signature (4), length (2) and the attribute list */
+#define SDP_CACHE_ENTRY_HDR_LEN 6
+
+typedef enum {
+  SDP_CACHE_MODE_OFF,
+  SDP_CACHE_MODE_LOCAL,   /* answer hits from the cache only */
+  SDP_CACHE_MODE_REFRESH, /* answer hits, then re-query the peer */
+} tSDP_CACHE_MODE;
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t stores;
+  uint32_t refreshes;
+  uint32_t invalidations;
+} tSDP_CACHE_STATS;
+
+static tSDP_CACHE_MODE sdp_cache_mode = SDP_CACHE_MODE_OFF;
+static tSDP_CACHE_STATS sdp_cache_stats;
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_init
+ *
+ * Description      This function reads the configured cache mode and resets
+ *                  the cache statistics.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_cache_init(void) {
+  char mode[PROPERTY_VALUE_MAX] = {0};
+
+  osi_property_get(SDP_CACHE_MODE_PROPERTY, mode, "off");
+  if (!strcmp(mode, "local"))
+    sdp_cache_mode = SDP_CACHE_MODE_LOCAL;
+  else if (!strcmp(mode, "refresh"))
+    sdp_cache_mode = SDP_CACHE_MODE_REFRESH;
+  else
+    sdp_cache_mode = SDP_CACHE_MODE_OFF;
+
+  memset(&sdp_cache_stats, 0, sizeof(sdp_cache_stats));
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_signature
+ *
+ * Description      This function computes the signature (FNV-1a) of the
+ *                  filters of a discovery database. Requests with the same
+ *                  signature receive the same response from a peer.
+ *
+ * Returns          the signature
+ *
+ ******************************************************************************/
+static uint32_t sdp_cache_signature(tSDP_DISCOVERY_DB* p_db) {
+  uint32_t hash = 2166136261u;
+  uint16_t xx;
+
+#define SDP_CACHE_HASH_BYTE(b) hash = (hash ^ (uint8_t)(b)) * 16777619u
+
+  SDP_CACHE_HASH_BYTE(p_db->num_uuid_filters);
+  for (xx = 0; xx < p_db->num_uuid_filters; xx++) {
+    const Uuid::UUID128Bit uuid = p_db->uuid_filters[xx].To128BitBE();
+    for (uint8_t byte : uuid) SDP_CACHE_HASH_BYTE(byte);
+  }
+
+  SDP_CACHE_HASH_BYTE(p_db->num_attr_filters);
+  for (xx = 0; xx < p_db->num_attr_filters; xx++) {
+    SDP_CACHE_HASH_BYTE(p_db->attr_filters[xx] >> 8);
+    SDP_CACHE_HASH_BYTE(p_db->attr_filters[xx]);
+  }
+
+#undef SDP_CACHE_HASH_BYTE
+  return hash;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_is_bonded
+ *
+ * Description      Only results of bonded peers are cached, so the entries
+ *                  are removed together with the bond.
+ *
+ * Returns          true if the peer has a stored link key
+ *
+ ******************************************************************************/
+static bool sdp_cache_is_bonded(const RawAddress& bd_addr) {
+  return btif_config_exist(bd_addr.ToString().c_str(), "LinkKey");
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_read
+ *
+ * Description      This function reads the cached entries of a peer into a
+ *                  buffer of at least SDP_MAX_LIST_BYTE_COUNT bytes.
+ *
+ * Returns          the number of bytes read, 0 if the peer has no entries
+ *
+ ******************************************************************************/
+static size_t sdp_cache_read(const RawAddress& bd_addr, uint8_t* p_buf) {
+  std::string bdstr = bd_addr.ToString();
+  size_t len = btif_config_get_bin_length(bdstr.c_str(), SDP_CACHE_CONFIG_KEY);
+
+  if (len == 0 || len > SDP_MAX_LIST_BYTE_COUNT) return 0;
+  if (!btif_config_get_bin(bdstr.c_str(), SDP_CACHE_CONFIG_KEY, p_buf, &len))
+    return 0;
+
+  /* Make sure the entries cover the buffer exactly before using them */
+  uint8_t* p = p_buf;
+  uint8_t* p_end = p_buf + len;
+  uint16_t entry_len;
+  while (p + SDP_CACHE_ENTRY_HDR_LEN <= p_end) {
+    p += 4;
+    STREAM_TO_UINT16(entry_len, p);
+    p += entry_len;
+  }
+  if (p != p_end) {
+    SDP_TRACE_WARNING("%s: dropping corrupt entries of %s", __func__,
+                      bdstr.c_str());
+    return 0;
+  }
+  return len;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_find
+ *
+ * Description      This function finds the entry with a given signature in
+ *                  the entries read by sdp_cache_read.
+ *
+ * Returns          pointer to the entry header, or NULL if not found
+ *
+ ******************************************************************************/
+static uint8_t* sdp_cache_find(uint8_t* p_buf, size_t len, uint32_t sig) {
+  uint8_t* p = p_buf;
+  uint8_t* p_end = p_buf + len;
+  uint32_t entry_sig;
+  uint16_t entry_len;
+
+  while (p + SDP_CACHE_ENTRY_HDR_LEN <= p_end) {
+    uint8_t* p_entry = p;
+    STREAM_TO_UINT32(entry_sig, p);
+    STREAM_TO_UINT16(entry_len, p);
+    if (p + entry_len > p_end) return NULL;
+    if (entry_sig == sig) return p_entry;
+    p += entry_len;
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_remove_entry
+ *
+ * Description      This function removes an entry found by sdp_cache_find.
+ *
+ * Returns          the remaining number of bytes
+ *
+ ******************************************************************************/
+static size_t sdp_cache_remove_entry(uint8_t* p_buf, size_t len,
+                                     uint8_t* p_entry) {
+  uint8_t* p = p_entry + 4;
+  uint16_t entry_len;
+  size_t entry_size;
+
+  STREAM_TO_UINT16(entry_len, p);
+  entry_size = SDP_CACHE_ENTRY_HDR_LEN + entry_len;
+  memmove(p_entry, p_entry + entry_size,
+          len - (size_t)(p_entry - p_buf) - entry_size);
+  return len - entry_size;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_write
+ *
+ * Description      This function persists the entries of a peer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_write(const RawAddress& bd_addr, uint8_t* p_buf,
+                            size_t len) {
+  std::string bdstr = bd_addr.ToString();
+
+  if (len == 0)
+    btif_config_remove(bdstr.c_str(), SDP_CACHE_CONFIG_KEY);
+  else
+    btif_config_set_bin(bdstr.c_str(), SDP_CACHE_CONFIG_KEY, p_buf, len);
+  btif_config_save();
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_has_records
+ *
+ * Description      This function checks that an attribute list response, a
+ *                  data element sequence of attribute lists, holds at least
+ *                  one record.
+ *
+ * Returns          true if the sequence is not empty
+ *
+ ******************************************************************************/
+static bool sdp_cache_has_records(uint8_t* p, uint16_t len) {
+  uint8_t* p_end = p + len;
+  uint8_t type;
+  uint32_t seq_len;
+
+  if (len == 0) return false;
+
+  type = *p++;
+  if ((type >> 3) != DATA_ELE_SEQ_DESC_TYPE) return false;
+
+  p = sdpu_get_len_from_type(p, p_end, type, &seq_len);
+  return (p != NULL && seq_len > 0);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_store
+ *
+ * Description      This function stores the complete attribute list received
+ *                  for a ServiceSearchAttribute request of a bonded peer. A
+ *                  response without records invalidates the peer's entries
+ *                  instead. An older entry for the same request is replaced,
+ *                  and the oldest entries are dropped when the peer's entries
+ *                  would exceed SDP_MAX_LIST_BYTE_COUNT.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_cache_store(tCONN_CB* p_ccb) {
+  uint32_t sig;
+  size_t len;
+  uint8_t* p_buf;
+  uint8_t* p_entry;
+  uint8_t* p;
+
+  if (sdp_cache_mode == SDP_CACHE_MODE_OFF || !p_ccb->is_attr_search) return;
+  if (!sdp_cache_is_bonded(p_ccb->device_address)) return;
+
+  /* No matching records: the peer's records may have changed */
+  if (!sdp_cache_has_records(p_ccb->rsp_list, p_ccb->list_len)) {
+    sdp_cache_invalidate(p_ccb->device_address);
+    return;
+  }
+  if (p_ccb->list_len + SDP_CACHE_ENTRY_HDR_LEN > SDP_MAX_LIST_BYTE_COUNT)
+    return;
+
+  sig = sdp_cache_signature(p_ccb->p_db);
+  p_buf = (uint8_t*)osi_malloc(SDP_MAX_LIST_BYTE_COUNT);
+  len = sdp_cache_read(p_ccb->device_address, p_buf);
+
+  p_entry = sdp_cache_find(p_buf, len, sig);
+  if (p_entry) len = sdp_cache_remove_entry(p_buf, len, p_entry);
+
+  while (len + SDP_CACHE_ENTRY_HDR_LEN + p_ccb->list_len >
+         SDP_MAX_LIST_BYTE_COUNT)
+    len = sdp_cache_remove_entry(p_buf, len, p_buf);
+
+  p = p_buf + len;
+  UINT32_TO_STREAM(p, sig);
+  UINT16_TO_STREAM(p, p_ccb->list_len);
+  ARRAY_TO_STREAM(p, p_ccb->rsp_list, p_ccb->list_len);
+
+  sdp_cache_write(p_ccb->device_address, p_buf, (size_t)(p - p_buf));
+  osi_free(p_buf);
+
+  sdp_cache_stats.stores++;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_invalidate
+ *
+ * Description      This function drops all cached results of a peer. It is
+ *                  called when a live discovery of the peer fails or finds no
+ *                  matching records, since its records may have changed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_cache_invalidate(const RawAddress& bd_addr) {
+  if (!btif_config_exist(bd_addr.ToString().c_str(), SDP_CACHE_CONFIG_KEY))
+    return;
+
+  SDP_TRACE_DEBUG("%s: %s", __func__, bd_addr.ToString().c_str());
+  sdp_cache_write(bd_addr, NULL, 0);
+  sdp_cache_stats.invalidations++;
+}
+
+static void sdp_cache_refresh_cmpl(uint16_t result, void* user_data) {
+  SDP_TRACE_DEBUG("%s: result %d", __func__, result);
+  osi_free(user_data);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_start_refresh
+ *
+ * Description      This function re-runs a request answered from the cache
+ *                  against the peer, with a private discovery database, so
+ *                  the entry is brought up to date for the next request.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_start_refresh(const RawAddress& bd_addr,
+                                    tSDP_DISCOVERY_DB* p_db) {
+  tSDP_DISCOVERY_DB* p_refresh_db =
+      (tSDP_DISCOVERY_DB*)osi_malloc(SDP_CACHE_REFRESH_DB_SIZE);
+  tCONN_CB* p_ccb;
+
+  SDP_InitDiscoveryDb(p_refresh_db, SDP_CACHE_REFRESH_DB_SIZE,
+                      p_db->num_uuid_filters, p_db->uuid_filters,
+                      p_db->num_attr_filters, p_db->attr_filters);
+
+  p_ccb = sdp_conn_originate(bd_addr);
+  if (!p_ccb) {
+    osi_free(p_refresh_db);
+    return;
+  }
+
+  p_ccb->disc_state = SDP_DISC_WAIT_CONN;
+  p_ccb->p_db = p_refresh_db;
+  p_ccb->p_cb2 = sdp_cache_refresh_cmpl;
+  p_ccb->user_data = p_refresh_db;
+  p_ccb->is_attr_search = true;
+
+  sdp_cache_stats.refreshes++;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_lookup
+ *
+ * Description      This function tries to answer a ServiceSearchAttribute
+ *                  request from the cache. On a hit the cached attribute list
+ *                  is loaded into the caller's database and the completion
+ *                  callback is posted, as if the peer had answered. Only
+ *                  empty databases without a raw data buffer are served.
+ *
+ * Returns          true if the request was answered from the cache
+ *
+ ******************************************************************************/
+bool sdp_cache_lookup(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                      tSDP_DISC_CMPL_CB* p_cb, tSDP_DISC_CMPL_CB2* p_cb2,
+                      void* user_data) {
+  uint8_t* p_buf;
+  uint8_t* p_entry;
+  uint8_t* p;
+  uint16_t entry_len;
+  size_t len;
+  bool loaded = false;
+  uint32_t mem_free = p_db->mem_free;
+  uint8_t* p_free_mem = p_db->p_free_mem;
+
+  if (sdp_cache_mode == SDP_CACHE_MODE_OFF) return false;
+  if (p_db->p_first_rec != NULL) return false;
+#if (SDP_RAW_DATA_INCLUDED == TRUE)
+  if (p_db->raw_data != NULL) return false;
+#endif
+  if (!sdp_cache_is_bonded(bd_addr)) return false;
+
+  p_buf = (uint8_t*)osi_malloc(SDP_MAX_LIST_BYTE_COUNT);
+  len = sdp_cache_read(bd_addr, p_buf);
+  p_entry = sdp_cache_find(p_buf, len, sdp_cache_signature(p_db));
+  if (p_entry) {
+    p = p_entry + 4;
+    STREAM_TO_UINT16(entry_len, p);
+    loaded = sdp_disc_load_attr_lists(p_db, bd_addr, p, entry_len) &&
+             p_db->p_first_rec != NULL;
+  }
+  osi_free(p_buf);
+
+  if (!loaded) {
+    /* Drop the records of a partial load, the live search fills the db */
+    p_db->p_first_rec = NULL;
+    p_db->mem_free = mem_free;
+    p_db->p_free_mem = p_free_mem;
+    sdp_cache_stats.misses++;
+    return false;
+  }
+
+  sdp_cache_stats.hits++;
+  SDP_TRACE_DEBUG("%s: served %s from cache", __func__,
+                  bd_addr.ToString().c_str());
+
+  if (p_cb)
+    get_message_loop()->task_runner()->PostTask(
+        FROM_HERE, base::Bind(p_cb, (uint16_t)SDP_SUCCESS));
+  else if (p_cb2)
+    get_message_loop()->task_runner()->PostTask(
+        FROM_HERE, base::Bind(p_cb2, (uint16_t)SDP_SUCCESS, user_data));
+
+  if (sdp_cache_mode == SDP_CACHE_MODE_REFRESH)
+    sdp_cache_start_refresh(bd_addr, p_db);
+
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_CacheDump
+ *
+ * Description      This function dumps the discovery cache statistics.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_CacheDump(int fd) {
+  uint32_t lookups = sdp_cache_stats.hits + sdp_cache_stats.misses;
+
+  dprintf(fd, "\nSDP discovery cache:\n");
+  dprintf(fd, "  mode: %s\n",
+          sdp_cache_mode == SDP_CACHE_MODE_LOCAL
+              ? "local"
+              : sdp_cache_mode == SDP_CACHE_MODE_REFRESH ? "refresh" : "off");
+  dprintf(fd, "  hits: %u misses: %u hit rate: %u%%\n", sdp_cache_stats.hits,
+          sdp_cache_stats.misses,
+          lookups ? (sdp_cache_stats.hits * 100) / lookups : 0);
+  dprintf(fd, "  stores: %u refreshes: %u invalidations: %u\n",
+          sdp_cache_stats.stores, sdp_cache_stats.refreshes,
+          sdp_cache_stats.invalidations);
+}
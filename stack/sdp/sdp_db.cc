@@ -72,6 +72,8 @@
 #include "sdp_api.h"
 #include "sdpint.h"
 
+using bluetooth::Uuid;
+
 #if (SDP_SERVER_ENABLED == TRUE)
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
@@ -79,6 +81,150 @@
 static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
                              uint16_t his_len, int nest_level);
 
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_add_uuid
+ *
+ * Description      This function adds a UUID to the UUID index of a record.
+ *                  UUIDs with an invalid length can never match a search and
+ *                  are not indexed.
+ *
+ * Returns          false if the index is full, else true
+ *
+ ******************************************************************************/
+static bool sdp_db_index_add_uuid(tSDP_RECORD* p_rec, uint8_t* p_uuid,
+                                  uint32_t len) {
+  uint8_t uuid128[Uuid::kNumBytes128];
+  uint16_t xx;
+
+  if (!sdpu_uuid_to_128(p_uuid, len, uuid128)) return (true);
+
+  for (xx = 0; xx < p_rec->num_uuids; xx++) {
+    if (memcmp(p_rec->uuid_index[xx], uuid128, Uuid::kNumBytes128) == 0)
+      return (true);
+  }
+
+  if (p_rec->num_uuids >= SDP_MAX_REC_UUIDS) return (false);
+
+  memcpy(p_rec->uuid_index[p_rec->num_uuids++], uuid128, Uuid::kNumBytes128);
+  return (true);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_seq
+ *
+ * Description      This function adds every UUID of a data element sequence
+ *                  to the UUID index of a record. It descends into nested
+ *                  sequences to the same depth as find_uuid_in_seq.
+ *
+ * Returns          false if the index is full, else true
+ *
+ ******************************************************************************/
+static bool sdp_db_index_seq(tSDP_RECORD* p_rec, uint8_t* p, uint32_t seq_len,
+                             int nest_level) {
+  uint8_t* p_end = p + seq_len;
+  uint8_t type;
+  uint32_t len;
+
+  if (nest_level > 3) return (true);
+
+  while (p < p_end) {
+    type = *p++;
+    p = sdpu_get_len_from_type(p, p_end, type, &len);
+    if (p == NULL || (p + len) > p_end) break;
+
+    type = type >> 3;
+    if (type == UUID_DESC_TYPE) {
+      if (!sdp_db_index_add_uuid(p_rec, p, len)) return (false);
+    } else if (type == DATA_ELE_SEQ_DESC_TYPE) {
+      if (!sdp_db_index_seq(p_rec, p, len, nest_level + 1)) return (false);
+    }
+    p = p + len;
+  }
+  return (true);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_build_uuid_index
+ *
+ * Description      This function (re)builds the UUID index of a record, so
+ *                  service searches need not parse the attribute values of
+ *                  the record on every request. The index is invalidated
+ *                  whenever an attribute is added to or deleted from the
+ *                  record.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_build_uuid_index(tSDP_RECORD* p_rec) {
+  tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
+  uint16_t xx;
+  bool fits = true;
+
+  p_rec->num_uuids = 0;
+  for (xx = 0; xx < p_rec->num_attributes && fits; xx++, p_attr++) {
+    if (p_attr->type == UUID_DESC_TYPE) {
+      fits = sdp_db_index_add_uuid(p_rec, p_attr->value_ptr, p_attr->len);
+    } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+      fits = sdp_db_index_seq(p_rec, p_attr->value_ptr, p_attr->len, 0);
+    }
+  }
+
+  if (fits) {
+    p_rec->uuid_index_state = SDP_UUID_INDEX_VALID;
+  } else {
+    SDP_TRACE_DEBUG("%s: handle 0x%x has more than %d UUIDs, not indexed",
+                    __func__, p_rec->record_handle, SDP_MAX_REC_UUIDS);
+    p_rec->num_uuids = 0;
+    p_rec->uuid_index_state = SDP_UUID_INDEX_OVERFLOW;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_rec_has_uuid
+ *
+ * Description      This function checks whether a record contains a UUID,
+ *                  either as a UUID attribute or inside a data element
+ *                  sequence attribute.
+ *
+ * Returns          true if found, else false
+ *
+ ******************************************************************************/
+static bool sdp_db_rec_has_uuid(tSDP_RECORD* p_rec, tUID_ENT* p_uid,
+                                uint8_t* p_uuid128) {
+  tSDP_ATTRIBUTE* p_attr;
+  uint16_t xx;
+
+  if (p_rec->uuid_index_state == SDP_UUID_INDEX_STALE)
+    sdp_db_build_uuid_index(p_rec);
+
+  if (p_rec->uuid_index_state == SDP_UUID_INDEX_VALID) {
+    for (xx = 0; xx < p_rec->num_uuids; xx++) {
+      if (memcmp(p_rec->uuid_index[xx], p_uuid128, Uuid::kNumBytes128) == 0)
+        return (true);
+    }
+    return (false);
+  }
+
+  /* Too many UUIDs to index, walk the attributes */
+  p_attr = &p_rec->attribute[0];
+  for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
+    if (p_attr->type == UUID_DESC_TYPE) {
+      if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
+                                   &p_uid->value[0], p_uid->len))
+        return (true);
+    } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+      if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len, &p_uid->value[0],
+                           p_uid->len, 0))
+        return (true);
+    }
+  }
+  return (false);
+}
+
 /*******************************************************************************
  *
  * Function         sdp_db_service_search
@@ -91,10 +237,19 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
-  uint16_t xx, yy;
-  tSDP_ATTRIBUTE* p_attr;
+  uint16_t yy;
+  uint8_t uuids128[MAX_UUIDS_PER_SEQ][Uuid::kNumBytes128];
   tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
 
+  /* Normalize the searched UUIDs once, so records can be matched against
+   * their UUID index with a plain compare. A UUID with an invalid length
+   * can never match, hence neither can any record. */
+  for (yy = 0; yy < p_seq->num_uids; yy++) {
+    if (!sdpu_uuid_to_128(&p_seq->uuid_entry[yy].value[0],
+                          p_seq->uuid_entry[yy].len, uuids128[yy]))
+      return (NULL);
+  }
+
   /* If NULL, start at the beginning, else start at the first specified record
    */
   if (!p_rec)
@@ -106,22 +261,9 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
   /* the record contains all the passed UUIDs in it.                */
   for (; p_rec < p_end; p_rec++) {
     for (yy = 0; yy < p_seq->num_uids; yy++) {
-      p_attr = &p_rec->attribute[0];
-      for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
-        if (p_attr->type == UUID_DESC_TYPE) {
-          if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
-                                       &p_seq->uuid_entry[yy].value[0],
-                                       p_seq->uuid_entry[yy].len))
-            break;
-        } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
-          if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len,
-                               &p_seq->uuid_entry[yy].value[0],
-                               p_seq->uuid_entry[yy].len, 0))
-            break;
-        }
-      }
       /* If any UUID was not found,  on to the next record */
-      if (xx == p_rec->num_attributes) break;
+      if (!sdp_db_rec_has_uuid(p_rec, &p_seq->uuid_entry[yy], uuids128[yy]))
+        break;
     }
 
     /* If every UUID was found in the record, return the record */
@@ -183,11 +325,21 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
  ******************************************************************************/
 tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
   tSDP_RECORD* p_rec;
-  tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
+  int lo = 0;
+  int hi = (int)sdp_cb.server_db.num_records - 1;
 
-  /* Look through the records for the caller's handle */
-  for (p_rec = &sdp_cb.server_db.record[0]; p_rec < p_end; p_rec++) {
+  /* Handles are allocated in increasing order and deleting a record keeps
+   * the remaining ones in place, so the records are sorted by handle */
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    p_rec = &sdp_cb.server_db.record[mid];
     if (p_rec->record_handle == handle) return (p_rec);
+
+    if (p_rec->record_handle < handle)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
   }
 
   /* Record with that handle not found. */
@@ -209,12 +361,23 @@ tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
 tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec, uint16_t start_attr,
                                         uint16_t end_attr) {
   tSDP_ATTRIBUTE* p_at;
-  uint16_t xx;
+  uint16_t lo = 0;
+  uint16_t hi = p_rec->num_attributes;
+
+  /* Note that the attributes in a record are assumed to be in sorted order.
+   * Find the first attribute with an id not below start_attr. */
+  while (lo < hi) {
+    uint16_t mid = lo + (hi - lo) / 2;
+
+    if (p_rec->attribute[mid].id < start_attr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
 
-  /* Note that the attributes in a record are assumed to be in sorted order */
-  for (xx = 0, p_at = &p_rec->attribute[0]; xx < p_rec->num_attributes;
-       xx++, p_at++) {
-    if ((p_at->id >= start_attr) && (p_at->id <= end_attr)) return (p_at);
+  if (lo < p_rec->num_attributes) {
+    p_at = &p_rec->attribute[lo];
+    if (p_at->id <= end_attr) return (p_at);
   }
 
   /* No matching attribute found */
@@ -516,6 +679,7 @@ bool SDP_AddAttributeToRecord (tSDP_RECORD *p_rec, uint16_t attr_id,
       return (false);
     }
     p_rec->num_attributes++;
+    p_rec->uuid_index_state = SDP_UUID_INDEX_STALE;
     return (true);
 }
 
@@ -1013,6 +1177,7 @@ bool SDP_DeleteAttributeFromRecord (tSDP_RECORD* p_rec, uint16_t attr_id)
 
       /* Found it. Shift everything up one */
       p_rec->num_attributes--;
+      p_rec->uuid_index_state = SDP_UUID_INDEX_STALE;
 
       for (yy = xx; yy < p_rec->num_attributes; yy++, p_attr++) {
         *p_attr = *(p_attr + 1);
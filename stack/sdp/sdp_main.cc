@@ -86,6 +86,8 @@ void sdp_init(void) {
   sdp_cb.max_attr_list_size = SDP_MTU_SIZE - 16;
   sdp_cb.max_recs_per_search = SDP_MAX_DISC_SERVER_RECS;
 
+  sdp_cache_init();
+
 #if (SDP_SERVER_ENABLED == TRUE)
   /* Register with Security Manager for the specific security level */
   if (!BTM_SetSecurityLevel(false, SDP_SERVICE_NAME, BTM_SEC_SERVICE_SDP_SERVER,
@@ -610,6 +612,11 @@ void sdp_disconnect(tCONN_CB* p_ccb, uint16_t reason) {
 
 #endif
 
+  /* A failed search may mean the peer's records changed, drop its cache */
+  if (p_ccb->is_attr_search && (p_ccb->con_flags & SDP_FLAGS_IS_ORIG) &&
+      (reason != SDP_SUCCESS) && (reason != SDP_CANCEL))
+    sdp_cache_invalidate(p_ccb->device_address);
+
   SDP_TRACE_EVENT("SDP - disconnect  CID: 0x%x", p_ccb->connection_id);
 
   /* Check if we have a connection ID */
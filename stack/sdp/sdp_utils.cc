@@ -651,6 +651,29 @@ bool sdpu_is_base_uuid(uint8_t* p_uuid) {
   return (true);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdpu_uuid_to_128
+ *
+ * Description      This function expands a 2, 4 or 16 byte BE UUID to its
+ *                  128-bit form, so UUIDs can be compared with a memcmp.
+ *
+ * Returns          true if the length was valid, else false
+ *
+ ******************************************************************************/
+bool sdpu_uuid_to_128(uint8_t* p_uuid, uint32_t len, uint8_t* p_uuid128) {
+  if (len == Uuid::kNumBytes128) {
+    memcpy(p_uuid128, p_uuid, Uuid::kNumBytes128);
+    return true;
+  }
+
+  if ((len != 2) && (len != 4)) return false;
+
+  memcpy(p_uuid128, sdp_base_uuid, Uuid::kNumBytes128);
+  memcpy(p_uuid128 + 4 - len, p_uuid, (size_t)len);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         sdpu_compare_uuid_arrays
@@ -123,6 +123,14 @@ typedef struct {
   uint16_t num_attributes;
   tSDP_ATTRIBUTE attribute[SDP_MAX_REC_ATTR];
   uint8_t attr_pad[SDP_MAX_PAD_LEN];
+
+#define SDP_UUID_INDEX_STALE 0    /* index must be rebuilt before use */
+#define SDP_UUID_INDEX_VALID 1    /* uuid_index holds every UUID in record */
+#define SDP_UUID_INDEX_OVERFLOW 2 /* too many UUIDs, search attributes */
+  uint8_t uuid_index_state;
+  uint16_t num_uuids; /* Number of entries in uuid_index */
+  uint8_t uuid_index[SDP_MAX_REC_UUIDS]
+                    [bluetooth::Uuid::kNumBytes128]; /* 128-bit form */
 } tSDP_RECORD;
 
 /* Define the SDP database */
@@ -273,6 +281,8 @@ extern uint8_t* sdpu_get_len_from_type(uint8_t* p, uint8_t* p_end, uint8_t type,
 extern bool sdpu_is_base_uuid(uint8_t* p_uuid);
 extern bool sdpu_compare_uuid_arrays(uint8_t* p_uuid1, uint32_t len1,
                                      uint8_t* p_uuid2, uint16_t len2);
+extern bool sdpu_uuid_to_128(uint8_t* p_uuid, uint32_t len,
+                             uint8_t* p_uuid128);
 extern bool sdpu_compare_uuid_with_attr(const bluetooth::Uuid& uuid,
                                         tSDP_DISC_ATTR* p_attr);
 
@@ -319,6 +329,18 @@ extern bool sdp_dev_blacklisted_for_avrcp15 (RawAddress addr);
  */
 extern void sdp_disc_connected(tCONN_CB* p_ccb);
 extern void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern bool sdp_disc_load_attr_lists(tSDP_DISCOVERY_DB* p_db,
+                                     const RawAddress& bd_addr, uint8_t* p,
+                                     uint16_t len);
+
+/* Functions provided by sdp_cache.cc
+ */
+extern void sdp_cache_init(void);
+extern bool sdp_cache_lookup(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                             tSDP_DISC_CMPL_CB* p_cb,
+                             tSDP_DISC_CMPL_CB2* p_cb2, void* user_data);
+extern void sdp_cache_store(tCONN_CB* p_ccb);
+extern void sdp_cache_invalidate(const RawAddress& bd_addr);
 
 extern void update_pce_entry_after_cancelling_bonding(RawAddress remote_addr);
 extern void check_and_store_pce_profile_version(tSDP_DISC_REC* p_sdp_rec);
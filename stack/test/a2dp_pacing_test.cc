@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "stack/include/a2dp_pacing.h"
+
+namespace {
+
+// 44.1 kHz, 16 bits, stereo
+constexpr uint32_t kPcmBytesPerSec = 44100 * 2 * 2;
+constexpr uint32_t kIntervalUs = 20000;
+// SBC frame of 16 blocks of 8 subbands
+constexpr uint32_t kPcmBytesPerFrame = 16 * 8 * 2 * 2;
+constexpr uint64_t kStartUs = 1000000;
+
+}  // namespace
+
+class StackA2dpPacingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    a2dp_pacing_init(&pacing_, kPcmBytesPerSec, kIntervalUs, 0);
+  }
+
+  // Run a tick at |now_us| and return the number of frames sent
+  uint32_t Tick(uint64_t now_us, uint8_t frames_per_packet = 0) {
+    uint8_t noi = 0;
+    uint8_t nof = 0;
+    a2dp_pacing_tick(&pacing_, now_us);
+    a2dp_pacing_get_num_frame_iteration(&pacing_, kPcmBytesPerFrame,
+                                        frames_per_packet, 15, 3, &noi, &nof);
+    return noi * nof;
+  }
+
+  tA2DP_PACING pacing_;
+};
+
+TEST_F(StackA2dpPacingTest, test_first_tick_is_one_interval) {
+  EXPECT_EQ(kPcmBytesPerSec / 50, a2dp_pacing_tick(&pacing_, kStartUs));
+  EXPECT_EQ(1u, pacing_.ticks);
+}
+
+TEST_F(StackA2dpPacingTest, test_nominal_ticks_no_drift) {
+  // One hour of media ticks
+  uint64_t frames = 0;
+  uint64_t now_us = kStartUs;
+  for (int i = 0; i < 3600 * 50; i++, now_us += kIntervalUs) {
+    frames += Tick(now_us);
+  }
+  uint64_t expected_bytes = (uint64_t)kPcmBytesPerSec * 3600;
+  EXPECT_EQ(expected_bytes, pacing_.total_due_bytes);
+  EXPECT_EQ(expected_bytes / kPcmBytesPerFrame, frames);
+  EXPECT_EQ(0u, pacing_.late_ticks);
+}
+
+TEST_F(StackA2dpPacingTest, test_jittery_ticks_no_drift) {
+  // Ticks phase-locked to the nominal period but delayed by up to 8 ms
+  uint64_t frames = 0;
+  uint32_t seed = 1;
+  uint64_t now_us = 0;
+  for (int i = 0; i < 3600 * 50; i++) {
+    seed = seed * 1103515245 + 12345;
+    now_us = kStartUs + (uint64_t)i * kIntervalUs + (seed >> 16) % 8000;
+    frames += Tick(now_us);
+  }
+  // All the media time elapsed since the first tick has been accounted for,
+  // up to the last partial frame
+  uint64_t elapsed_us = now_us - kStartUs + kIntervalUs;
+  uint64_t expected_frames =
+      elapsed_us * kPcmBytesPerSec / 1000000 / kPcmBytesPerFrame;
+  EXPECT_LE(frames, expected_frames);
+  EXPECT_GE(frames + 1, expected_frames);
+  EXPECT_EQ(0u, pacing_.total_dropped_bytes);
+}
+
+TEST_F(StackA2dpPacingTest, test_full_packets_leftover_pending) {
+  // 20 ms is 6.89 frames: without a full packet, all the frames are sent
+  EXPECT_EQ(6u, Tick(kStartUs, 7));
+  // A burst after a late tick is sent in full packets
+  EXPECT_EQ(14u, Tick(kStartUs + 2 * kIntervalUs, 7));
+  EXPECT_LT(pacing_.counter, kPcmBytesPerFrame);
+  // 30 ms is 11 frames: the 4 frames left wait for the next tick
+  EXPECT_EQ(7u, Tick(kStartUs + 2 * kIntervalUs + 30000, 7));
+  EXPECT_EQ(4u, pacing_.counter / kPcmBytesPerFrame);
+}
+
+TEST_F(StackA2dpPacingTest, test_frame_limit_drops_frames) {
+  // 200 ms late: 34 frames are due, only 15 are sent
+  Tick(kStartUs);
+  EXPECT_EQ(15u, Tick(kStartUs + 10 * kIntervalUs));
+  EXPECT_LT(pacing_.counter, kPcmBytesPerFrame);
+  EXPECT_GT(pacing_.total_dropped_bytes, 0u);
+  EXPECT_EQ(1u, pacing_.late_ticks);
+  EXPECT_EQ(10 * kIntervalUs, pacing_.max_tick_us);
+}
+
+TEST_F(StackA2dpPacingTest, test_iteration_limit_drops_packets) {
+  uint8_t noi = 0;
+  uint8_t nof = 0;
+  a2dp_pacing_refund(&pacing_, 10 * kPcmBytesPerFrame);
+  a2dp_pacing_get_num_frame_iteration(&pacing_, kPcmBytesPerFrame, 2, 15, 3,
+                                      &noi, &nof);
+  EXPECT_EQ(3, noi);
+  EXPECT_EQ(2, nof);
+  EXPECT_EQ(0u, pacing_.counter);
+  EXPECT_EQ(4 * kPcmBytesPerFrame, pacing_.total_dropped_bytes);
+}
+
+TEST_F(StackA2dpPacingTest, test_max_pending_bytes) {
+  uint32_t bytes_per_tick = kPcmBytesPerSec / 50;
+  a2dp_pacing_init(&pacing_, kPcmBytesPerSec, kIntervalUs, 4 * bytes_per_tick);
+  a2dp_pacing_tick(&pacing_, kStartUs);
+  EXPECT_EQ(4 * bytes_per_tick,
+            a2dp_pacing_tick(&pacing_, kStartUs + 10 * kIntervalUs));
+  EXPECT_EQ(7 * bytes_per_tick, pacing_.total_dropped_bytes);
+}
+
+TEST_F(StackA2dpPacingTest, test_consume_and_refund) {
+  uint32_t pending = a2dp_pacing_tick(&pacing_, kStartUs);
+  EXPECT_FALSE(a2dp_pacing_consume(&pacing_, pending + 1));
+  EXPECT_EQ(pending, pacing_.counter);
+  EXPECT_TRUE(a2dp_pacing_consume(&pacing_, pending));
+  EXPECT_EQ(0u, pacing_.counter);
+  // A PCM underflow returns the data, sent at the next tick
+  a2dp_pacing_refund(&pacing_, 100);
+  EXPECT_EQ(pending + 100, a2dp_pacing_tick(&pacing_, kStartUs + kIntervalUs));
+}
+
+TEST_F(StackA2dpPacingTest, test_flush) {
+  Tick(kStartUs);
+  a2dp_pacing_refund(&pacing_, 1000);
+  a2dp_pacing_flush(&pacing_);
+  EXPECT_EQ(0u, pacing_.counter);
+  // The next tick counts one interval, whatever the time since the last one
+  EXPECT_EQ(kPcmBytesPerSec / 50, a2dp_pacing_tick(&pacing_, 5 * kStartUs));
+  EXPECT_EQ(0u, pacing_.late_ticks);
+}
@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <string.h>
+
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "btm_int.h"
+#include "device/include/controller.h"
+#include "osi/include/allocator.h"
+#include "osi/include/list.h"
+
+tBTM_CB btm_cb;
+
+// Bonded devices the fake application manager has not added to the stack
+static std::set<RawAddress> pending_devices;
+static int load_calls;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+void vnd_LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+size_t strlcpy(char* dst, const char* src, size_t siz) {
+  size_t len = strlen(src);
+  if (siz > 0) {
+    size_t n = len < siz - 1 ? len : siz - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+tBTM_INQ_INFO* BTM_InqDbRead(const RawAddress& p_bda) { return NULL; }
+uint16_t BTM_GetHCIConnHandle(const RawAddress& remote_bda,
+                              tBT_TRANSPORT transport) {
+  return 0xFFFF;
+}
+bool BTM_IsAclConnectionUp(const RawAddress& remote_bda,
+                           tBT_TRANSPORT transport) {
+  return false;
+}
+void btm_sec_clear_ble_keys(tBTM_SEC_DEV_REC* p_dev_rec) {}
+tBTM_STATUS BTM_DeleteStoredLinkKey(const RawAddress* bd_addr,
+                                    tBTM_CMPL_CB* p_cb) {
+  return BTM_SUCCESS;
+}
+bool btm_ble_addr_resolvable(const RawAddress& rpa,
+                             tBTM_SEC_DEV_REC* p_dev_rec) {
+  return false;
+}
+const controller_t* controller_get_interface() { return NULL; }
+bool btm_is_sco_active_by_bdaddr(const RawAddress& remote_bda) {
+  return false;
+}
+
+namespace {
+
+const RawAddress kBondedAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kOtherAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+const LinkKey kLinkKey = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+                          0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+
+bool load_device(const RawAddress& bd_addr) {
+  load_calls++;
+  if (pending_devices.erase(bd_addr) == 0) return false;
+
+  LinkKey link_key = kLinkKey;
+  uint32_t trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE] = {0};
+  return BTM_SecAddDevice(bd_addr, NULL, NULL, NULL, trusted_mask, &link_key,
+                          BTM_LKEY_TYPE_AUTH_COMB, 0, 0);
+}
+
+class BtmDevLoadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&btm_cb, 0, sizeof(btm_cb));
+    btm_cb.sec_dev_rec = list_new(osi_free);
+    btm_sec_dev_index_reset();
+    pending_devices = {kBondedAddress};
+    load_calls = 0;
+    btm_cb.p_dev_load_callback = load_device;
+  }
+
+  void TearDown() override {
+    btm_sec_dev_index_reset();
+    list_free(btm_cb.sec_dev_rec);
+  }
+};
+
+}  // namespace
+
+TEST_F(BtmDevLoadTest, test_find_dev_does_not_load) {
+  EXPECT_EQ(NULL, btm_find_dev(kBondedAddress));
+  EXPECT_EQ(0, load_calls);
+  EXPECT_EQ(1u, pending_devices.size());
+  EXPECT_EQ(0u, list_length(btm_cb.sec_dev_rec));
+}
+
+TEST_F(BtmDevLoadTest, test_find_or_load_dev_loads_bonded_device) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_load_dev(kBondedAddress);
+  ASSERT_NE(nullptr, p_dev_rec);
+  EXPECT_EQ(1, load_calls);
+  EXPECT_EQ(kBondedAddress, p_dev_rec->bd_addr);
+  EXPECT_TRUE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_EQ(kLinkKey, p_dev_rec->link_key);
+
+  // Once loaded, plain lookups find the record and nothing is loaded again
+  EXPECT_EQ(p_dev_rec, btm_find_dev(kBondedAddress));
+  EXPECT_EQ(p_dev_rec, btm_find_or_load_dev(kBondedAddress));
+  EXPECT_EQ(1, load_calls);
+}
+
+TEST_F(BtmDevLoadTest, test_find_or_alloc_dev_loads_bonded_device) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_alloc_dev(kBondedAddress);
+  ASSERT_NE(nullptr, p_dev_rec);
+  EXPECT_EQ(1, load_calls);
+  EXPECT_TRUE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_EQ(1u, list_length(btm_cb.sec_dev_rec));
+}
+
+TEST_F(BtmDevLoadTest, test_find_or_alloc_dev_unknown_device) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_alloc_dev(kOtherAddress);
+  ASSERT_NE(nullptr, p_dev_rec);
+  EXPECT_EQ(1, load_calls);
+  EXPECT_EQ(kOtherAddress, p_dev_rec->bd_addr);
+  EXPECT_FALSE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_EQ(1u, pending_devices.size());
+}
+
+TEST_F(BtmDevLoadTest, test_find_or_load_dev_unknown_device) {
+  EXPECT_EQ(NULL, btm_find_or_load_dev(kOtherAddress));
+  EXPECT_EQ(1, load_calls);
+  EXPECT_EQ(0u, list_length(btm_cb.sec_dev_rec));
+}
+
+TEST_F(BtmDevLoadTest, test_no_callback_registered) {
+  btm_cb.p_dev_load_callback = NULL;
+  EXPECT_EQ(NULL, btm_find_or_load_dev(kBondedAddress));
+  EXPECT_EQ(0, load_calls);
+  EXPECT_EQ(1u, pending_devices.size());
+}
@@ -0,0 +1,308 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <string.h>
+
+#include <map>
+#include <queue>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "btm_ble_int.h"
+#include "device/include/controller.h"
+#include "stack/gatt/connection_manager.h"
+#include "stack/gatt/gatt_int.h"
+#include "stack/include/gatt_api.h"
+#include "stack/include/l2c_api.h"
+#include "stack/include/sdp_api.h"
+
+tGATT_CB gatt_cb;
+
+// Notifications given to L2CAP, as the value bytes, by peer
+static std::map<RawAddress, std::vector<std::vector<uint8_t>>> sent;
+// Peers whose L2CAP channel reports congestion
+static std::set<RawAddress> congested_peers;
+
+uint16_t L2CA_SendFixedChnlData(uint16_t fixed_cid, const RawAddress& rem_bda,
+                                BT_HDR* p_buf) {
+  uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  // Skip the opcode and the attribute handle
+  sent[rem_bda].emplace_back(p + 3, p + p_buf->len);
+  osi_free(p_buf);
+  return congested_peers.count(rem_bda) ? L2CAP_DW_CONGESTED
+                                        : L2CAP_DW_SUCCESS;
+}
+
+uint8_t L2CA_DataWrite(uint16_t cid, BT_HDR* p_data) {
+  osi_free(p_data);
+  return L2CAP_DW_FAILED;
+}
+bool L2CA_SetIdleTimeout(uint16_t cid, uint16_t timeout, bool is_global) {
+  return true;
+}
+bool L2CA_SetFixedChannelTout(const RawAddress& rem_bda, uint16_t fixed_cid,
+                              uint16_t idle_tout) {
+  return true;
+}
+bool L2CA_SetIdleTimeoutByBdAddr(const RawAddress& bd_addr, uint16_t timeout,
+                                 tBT_TRANSPORT transport) {
+  return true;
+}
+
+uint32_t SDP_CreateRecord(void) { return 0; }
+bool SDP_DeleteRecord(uint32_t handle) { return true; }
+bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
+                      uint32_t attr_len, uint8_t* p_val) {
+  return true;
+}
+bool SDP_AddProtocolList(uint32_t handle, uint16_t num_elem,
+                         tSDP_PROTOCOL_ELEM* p_elem_list) {
+  return true;
+}
+bool SDP_AddUuidSequence(uint32_t handle, uint16_t attr_id, uint16_t num_uuids,
+                         uint16_t* p_uuids) {
+  return true;
+}
+bool SDP_AddServiceClassIdList(uint32_t handle, uint16_t num_services,
+                               uint16_t* p_service_uuids) {
+  return true;
+}
+
+bool BTM_GetSecurityFlagsByTransport(const RawAddress& bd_addr,
+                                     uint8_t* p_sec_flags,
+                                     tBT_TRANSPORT transport) {
+  return false;
+}
+bool BTM_BackgroundConnectAddressKnown(const RawAddress& address) {
+  return false;
+}
+uint8_t btm_ble_read_sec_key_size(const RawAddress& bd_addr) { return 0; }
+const controller_t* controller_get_interface() { return NULL; }
+
+bool gatt_disconnect(tGATT_TCB* p_tcb) { return true; }
+bool gatt_act_connect(tGATT_REG* p_reg, const RawAddress& bd_addr,
+                      tBT_TRANSPORT transport, int8_t initiating_phys) {
+  return false;
+}
+void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {}
+tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB* p_tcb) { return GATT_CH_OPEN; }
+void gatt_init_srv_chg(void) {}
+void gatt_proc_srv_chg(void) {}
+void gatt_act_discovery(tGATT_CLCB* p_clcb) {}
+void gatt_security_check_start(tGATT_CLCB* p_clcb) {}
+void gatt_dequeue_sr_cmd(tGATT_TCB& tcb) {}
+void gatt_send_queue_write_cancel(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
+                                  tGATT_EXEC_FLAG flag) {}
+tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
+                                     uint32_t trans_id, uint8_t op_code,
+                                     tGATT_STATUS status, tGATTS_RSP* p_msg) {
+  return GATT_SUCCESS;
+}
+void gatt_update_app_use_link_flag(tGATT_IF gatt_if, tGATT_TCB* p_tcb,
+                                   bool is_add, bool check_acl_link) {}
+bool gatt_is_app_holding_link(tGATT_IF gatt_if, tGATT_TCB* p_tcb) {
+  return false;
+}
+void gatts_init_service_db(tGATT_SVC_DB& db, const bluetooth::Uuid& service,
+                           bool is_pri, uint16_t s_hdl, uint16_t num_handle) {}
+uint16_t gatts_add_included_service(tGATT_SVC_DB& db, uint16_t s_handle,
+                                    uint16_t e_handle,
+                                    const bluetooth::Uuid& service) {
+  return 0;
+}
+uint16_t gatts_add_characteristic(tGATT_SVC_DB& db, tGATT_PERM perm,
+                                  tGATT_CHAR_PROP property,
+                                  const bluetooth::Uuid& char_uuid) {
+  return 0;
+}
+uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
+                              const bluetooth::Uuid& dscp_uuid) {
+  return 0;
+}
+bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db) { return NULL; }
+void gatts_proc_srv_chg_ind_ack(tGATT_TCB tcb) {}
+
+namespace connection_manager {
+bool background_connect_add(tAPP_ID app_id, const RawAddress& address) {
+  return false;
+}
+bool background_connect_remove(tAPP_ID app_id, const RawAddress& address) {
+  return false;
+}
+bool remove_unconditional(const RawAddress& address) { return false; }
+bool direct_connect_remove(tAPP_ID app_id, const RawAddress& address) {
+  return false;
+}
+void on_app_deregistered(tAPP_ID app_id) {}
+}  // namespace connection_manager
+
+namespace {
+
+const tGATT_IF kGattIf = 1;
+const uint16_t kHandle = 0x0010;
+const RawAddress kPeers[] = {
+    RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x01}),
+    RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x02}),
+    RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x03}),
+};
+const int kNumPeers = sizeof(kPeers) / sizeof(kPeers[0]);
+
+class GattNotifTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sent.clear();
+    congested_peers.clear();
+
+    gatt_cb.cl_rcb[kGattIf - 1].in_use = true;
+    gatt_cb.cl_rcb[kGattIf - 1].gatt_if = kGattIf;
+    for (int i = 0; i < kNumPeers; i++) {
+      tGATT_TCB& tcb = gatt_cb.tcb[i];
+      tcb.in_use = true;
+      tcb.tcb_idx = i;
+      tcb.peer_bda = kPeers[i];
+      tcb.transport = BT_TRANSPORT_LE;
+      tcb.att_lcid = L2CAP_ATT_CID;
+      tcb.payload_size = GATT_DEF_BLE_MTU_SIZE;
+      tcb.congested = false;
+      conn_ids_[i] = GATT_CREATE_CONN_ID(i, kGattIf);
+    }
+  }
+
+  void TearDown() override {
+    for (int i = 0; i < kNumPeers; i++) {
+      gatt_free_pending_notif(&gatt_cb.tcb[i]);
+      gatt_cb.tcb[i].notif_sent = 0;
+      gatt_cb.tcb[i].notif_deferred = 0;
+      gatt_cb.tcb[i].notif_dropped = 0;
+      gatt_cb.tcb[i].in_use = false;
+    }
+    gatt_cb.cl_rcb[kGattIf - 1].in_use = false;
+  }
+
+  // What the congestion callback of L2CAP does once the link drains
+  void Uncongest(int i) {
+    congested_peers.erase(kPeers[i]);
+    gatt_cb.tcb[i].congested = false;
+    gatt_send_pending_notif(gatt_cb.tcb[i]);
+  }
+
+  uint16_t conn_ids_[kNumPeers];
+};
+
+}  // namespace
+
+TEST_F(GattNotifTest, test_multi_fans_out) {
+  uint8_t value[] = {0x01, 0x02, 0x03};
+  tGATT_STATUS status[kNumPeers];
+  EXPECT_EQ(GATT_SUCCESS,
+            GATTS_HandleValueNotificationMulti(kNumPeers, conn_ids_, kHandle,
+                                               sizeof(value), value, status));
+
+  for (int i = 0; i < kNumPeers; i++) {
+    EXPECT_EQ(GATT_SUCCESS, status[i]);
+    ASSERT_EQ(1u, sent[kPeers[i]].size());
+    EXPECT_EQ(std::vector<uint8_t>(value, value + sizeof(value)),
+              sent[kPeers[i]][0]);
+  }
+}
+
+TEST_F(GattNotifTest, test_multi_truncates_per_mtu) {
+  gatt_cb.tcb[1].payload_size = 5;
+  uint8_t value[] = {0x01, 0x02, 0x03, 0x04};
+  EXPECT_EQ(GATT_SUCCESS,
+            GATTS_HandleValueNotificationMulti(kNumPeers, conn_ids_, kHandle,
+                                               sizeof(value), value, NULL));
+
+  EXPECT_EQ(4u, sent[kPeers[0]][0].size());
+  EXPECT_EQ(std::vector<uint8_t>({0x01, 0x02}), sent[kPeers[1]][0]);
+  EXPECT_EQ(4u, sent[kPeers[2]][0].size());
+}
+
+TEST_F(GattNotifTest, test_multi_reports_invalid_conn) {
+  uint16_t conn_ids[] = {conn_ids_[0], GATT_CREATE_CONN_ID(5, kGattIf)};
+  uint8_t value[] = {0x01};
+  tGATT_STATUS status[2];
+  EXPECT_EQ((tGATT_STATUS)GATT_INVALID_CONN_ID,
+            GATTS_HandleValueNotificationMulti(2, conn_ids, kHandle,
+                                               sizeof(value), value, status));
+  EXPECT_EQ(GATT_SUCCESS, status[0]);
+  EXPECT_EQ((tGATT_STATUS)GATT_INVALID_CONN_ID, status[1]);
+  EXPECT_EQ(1u, sent[kPeers[0]].size());
+}
+
+TEST_F(GattNotifTest, test_congested_link_queues_and_drains) {
+  congested_peers.insert(kPeers[1]);
+
+  // The first notification is accepted by L2CAP and congests the link, the
+  // next ones are queued
+  for (uint8_t v = 0; v < 3; v++) {
+    tGATT_STATUS status[kNumPeers];
+    GATTS_HandleValueNotificationMulti(kNumPeers, conn_ids_, kHandle, 1, &v,
+                                       status);
+    EXPECT_EQ(GATT_SUCCESS, status[0]);
+    EXPECT_EQ(GATT_CONGESTED, status[1]);
+    EXPECT_EQ(GATT_SUCCESS, status[2]);
+  }
+  EXPECT_EQ(3u, sent[kPeers[0]].size());
+  EXPECT_EQ(1u, sent[kPeers[1]].size());
+  EXPECT_EQ(2u, gatt_cb.tcb[1].pending_notif_q.size());
+
+  Uncongest(1);
+  EXPECT_TRUE(gatt_cb.tcb[1].pending_notif_q.empty());
+  ASSERT_EQ(3u, sent[kPeers[1]].size());
+  for (uint8_t v = 0; v < 3; v++)
+    EXPECT_EQ(std::vector<uint8_t>({v}), sent[kPeers[1]][v]);
+  EXPECT_EQ(3u, gatt_cb.tcb[1].notif_sent);
+  EXPECT_EQ(2u, gatt_cb.tcb[1].notif_deferred);
+}
+
+TEST_F(GattNotifTest, test_single_notification_keeps_order) {
+  congested_peers.insert(kPeers[0]);
+  for (uint8_t v = 0; v < 2; v++)
+    GATTS_HandleValueNotificationMulti(1, conn_ids_, kHandle, 1, &v, NULL);
+
+  // Queued behind the notification of the batched API, not sent ahead of it
+  uint8_t v = 2;
+  EXPECT_EQ(GATT_CONGESTED,
+            GATTS_HandleValueNotification(conn_ids_[0], kHandle, 1, &v));
+  EXPECT_EQ(1u, sent[kPeers[0]].size());
+  EXPECT_EQ(2u, gatt_cb.tcb[0].pending_notif_q.size());
+
+  Uncongest(0);
+  ASSERT_EQ(3u, sent[kPeers[0]].size());
+  for (uint8_t i = 0; i < 3; i++)
+    EXPECT_EQ(std::vector<uint8_t>({i}), sent[kPeers[0]][i]);
+}
+
+TEST_F(GattNotifTest, test_queue_drops_oldest) {
+  congested_peers.insert(kPeers[0]);
+  for (int i = 0; i < GATT_MAX_PENDING_NOTIF + 2; i++) {
+    uint8_t v = (uint8_t)i;
+    GATTS_HandleValueNotification(conn_ids_[0], kHandle, 1, &v);
+  }
+  EXPECT_EQ((size_t)GATT_MAX_PENDING_NOTIF,
+            gatt_cb.tcb[0].pending_notif_q.size());
+  EXPECT_EQ(1u, gatt_cb.tcb[0].notif_dropped);
+
+  Uncongest(0);
+  ASSERT_EQ((size_t)GATT_MAX_PENDING_NOTIF + 1, sent[kPeers[0]].size());
+  // The first one went out before the congestion, the second one was dropped
+  EXPECT_EQ(std::vector<uint8_t>({0}), sent[kPeers[0]][0]);
+  EXPECT_EQ(std::vector<uint8_t>({2}), sent[kPeers[0]][1]);
+}
@@ -0,0 +1,267 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <stdarg.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "btif/include/btif_config.h"
+#include "btu.h"
+#include "osi/include/properties.h"
+#include "stack/include/sdp_api.h"
+#include "stack/sdp/sdpint.h"
+
+using bluetooth::Uuid;
+
+tSDP_CB sdp_cb;
+
+// The btif config, as section -> key -> value
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>>
+    config;
+static std::string cache_mode;
+// Attribute list last loaded into a discovery database
+static std::vector<uint8_t> loaded_list;
+static bool load_result;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+void vnd_LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+int osi_property_get(const char* key, char* value, const char* default_value) {
+  std::string result = cache_mode.empty() ? default_value : cache_mode;
+  snprintf(value, PROPERTY_VALUE_MAX, "%s", result.c_str());
+  return result.size();
+}
+
+bool btif_config_exist(const char* section, const char* key) {
+  return config.count(section) && config[section].count(key);
+}
+
+size_t btif_config_get_bin_length(const char* section, const char* key) {
+  if (!btif_config_exist(section, key)) return 0;
+  return config[section][key].size();
+}
+
+bool btif_config_get_bin(const char* section, const char* key, uint8_t* value,
+                         size_t* length) {
+  if (!btif_config_exist(section, key)) return false;
+  const std::vector<uint8_t>& data = config[section][key];
+  if (*length < data.size()) return false;
+  memcpy(value, data.data(), data.size());
+  *length = data.size();
+  return true;
+}
+
+bool btif_config_set_bin(const char* section, const char* key,
+                         const uint8_t* value, size_t length) {
+  config[section][key].assign(value, value + length);
+  return true;
+}
+
+bool btif_config_remove(const char* section, const char* key) {
+  if (!btif_config_exist(section, key)) return false;
+  config[section].erase(key);
+  return true;
+}
+
+void btif_config_save(void) {}
+
+// Responses of the tests use sequences with a one byte length only
+uint8_t* sdpu_get_len_from_type(uint8_t* p, uint8_t* p_end, uint8_t type,
+                                uint32_t* p_len) {
+  if ((type & 7) != SIZE_IN_NEXT_BYTE || p >= p_end) return NULL;
+  *p_len = *p++;
+  return p;
+}
+
+bool sdp_disc_load_attr_lists(tSDP_DISCOVERY_DB* p_db,
+                              const RawAddress& bd_addr, uint8_t* p,
+                              uint16_t len) {
+  loaded_list.assign(p, p + len);
+  // A partial load leaves records behind
+  p_db->p_first_rec = (tSDP_DISC_REC*)p_db->p_free_mem;
+  return load_result;
+}
+
+bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
+                         uint16_t num_uuid, const Uuid* p_uuid_list,
+                         uint16_t num_attr, uint16_t* p_attr_list) {
+  return false;
+}
+
+tCONN_CB* sdp_conn_originate(const RawAddress& p_bd_addr) { return NULL; }
+
+base::MessageLoop* get_message_loop() { return NULL; }
+
+namespace {
+
+const RawAddress kBondedAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kOtherAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+
+// One record holding attribute 0x0001
+uint8_t kRecordList[] = {0x35, 0x08, 0x35, 0x06, 0x09,
+                         0x00, 0x01, 0x19, 0x11, 0x0b};
+uint8_t kOtherRecordList[] = {0x35, 0x08, 0x35, 0x06, 0x09,
+                              0x00, 0x01, 0x19, 0x11, 0x0a};
+uint8_t kEmptyList[] = {0x35, 0x00};
+
+class SdpCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    config.clear();
+    config[kBondedAddress.ToString()]["LinkKey"] = {0x00};
+    cache_mode = "local";
+    loaded_list.clear();
+    load_result = true;
+    sdp_cache_init();
+  }
+
+  // Initialize |db_| for a search of |uuid|
+  void InitDb(uint16_t uuid) {
+    memset(&db_, 0, sizeof(db_));
+    db_.num_uuid_filters = 1;
+    db_.uuid_filters[0] = Uuid::From16Bit(uuid);
+    db_.num_attr_filters = 1;
+    db_.attr_filters[0] = 0x0001;
+    db_.mem_free = sizeof(db_mem_);
+    db_.p_free_mem = db_mem_;
+  }
+
+  // Store |list| as the response of the search of |db_| by |bd_addr|
+  void Store(const RawAddress& bd_addr, uint8_t* list, uint16_t len) {
+    tCONN_CB ccb;
+    memset(&ccb, 0, sizeof(ccb));
+    ccb.device_address = bd_addr;
+    ccb.is_attr_search = true;
+    ccb.p_db = &db_;
+    ccb.rsp_list = list;
+    ccb.list_len = len;
+    sdp_cache_store(&ccb);
+  }
+
+  bool Lookup(const RawAddress& bd_addr) {
+    return sdp_cache_lookup(bd_addr, &db_, NULL, NULL, NULL);
+  }
+
+  tSDP_DISCOVERY_DB db_;
+  uint8_t db_mem_[64];
+};
+
+}  // namespace
+
+TEST_F(SdpCacheTest, test_store_then_lookup) {
+  InitDb(0x110b);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  InitDb(0x110b);
+  EXPECT_TRUE(Lookup(kBondedAddress));
+  EXPECT_EQ(std::vector<uint8_t>(kRecordList,
+                                 kRecordList + sizeof(kRecordList)),
+            loaded_list);
+}
+
+TEST_F(SdpCacheTest, test_lookup_matches_filters) {
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  InitDb(0x110a);
+  Store(kBondedAddress, kOtherRecordList, sizeof(kOtherRecordList));
+
+  InitDb(0x110b);
+  EXPECT_TRUE(Lookup(kBondedAddress));
+  EXPECT_EQ(kRecordList[9], loaded_list[9]);
+  InitDb(0x110a);
+  EXPECT_TRUE(Lookup(kBondedAddress));
+  EXPECT_EQ(kOtherRecordList[9], loaded_list[9]);
+  InitDb(0x1108);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+}
+
+TEST_F(SdpCacheTest, test_store_replaces_entry) {
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  Store(kBondedAddress, kOtherRecordList, sizeof(kOtherRecordList));
+
+  EXPECT_EQ(6 + sizeof(kOtherRecordList),
+            btif_config_get_bin_length(kBondedAddress.ToString().c_str(),
+                                       SDP_CACHE_CONFIG_KEY));
+  InitDb(0x110b);
+  EXPECT_TRUE(Lookup(kBondedAddress));
+  EXPECT_EQ(kOtherRecordList[9], loaded_list[9]);
+}
+
+TEST_F(SdpCacheTest, test_unbonded_peer_not_cached) {
+  InitDb(0x110b);
+  Store(kOtherAddress, kRecordList, sizeof(kRecordList));
+  EXPECT_FALSE(btif_config_exist(kOtherAddress.ToString().c_str(),
+                                 SDP_CACHE_CONFIG_KEY));
+  EXPECT_FALSE(Lookup(kOtherAddress));
+}
+
+TEST_F(SdpCacheTest, test_disabled) {
+  cache_mode = "off";
+  sdp_cache_init();
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  EXPECT_FALSE(btif_config_exist(kBondedAddress.ToString().c_str(),
+                                 SDP_CACHE_CONFIG_KEY));
+  EXPECT_FALSE(Lookup(kBondedAddress));
+}
+
+TEST_F(SdpCacheTest, test_invalidate) {
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  sdp_cache_invalidate(kBondedAddress);
+
+  EXPECT_FALSE(btif_config_exist(kBondedAddress.ToString().c_str(),
+                                 SDP_CACHE_CONFIG_KEY));
+  InitDb(0x110b);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+}
+
+TEST_F(SdpCacheTest, test_empty_response_invalidates) {
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+  InitDb(0x110a);
+  Store(kBondedAddress, kEmptyList, sizeof(kEmptyList));
+
+  InitDb(0x110b);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+}
+
+TEST_F(SdpCacheTest, test_partial_load_is_a_miss) {
+  InitDb(0x110b);
+  Store(kBondedAddress, kRecordList, sizeof(kRecordList));
+
+  load_result = false;
+  InitDb(0x110b);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+  // The records of the partial load were dropped
+  EXPECT_EQ(NULL, db_.p_first_rec);
+  EXPECT_EQ(db_mem_, db_.p_free_mem);
+}
+
+TEST_F(SdpCacheTest, test_corrupt_entries_ignored) {
+  config[kBondedAddress.ToString()][SDP_CACHE_CONFIG_KEY] = {0x01, 0x02, 0x03,
+                                                             0x04, 0x00, 0x10};
+  InitDb(0x110b);
+  EXPECT_FALSE(Lookup(kBondedAddress));
+}
@@ -9,6 +9,14 @@
 
 known_benchmarks=(
   bluetooth_benchmark_thread_performance
+  bluetooth_benchmark_btm_dev_qti
+  bluetooth_benchmark_a2dp_encoder_qti
+  bluetooth_benchmark_gatt_sr_qti
+  bluetooth_benchmark_g722_encoder_qti
+  bluetooth_benchmark_btif_context_switch_qti
+  bluetooth_benchmark_interop_index_qti
+  bluetooth_benchmark_allocation_tracker_qti
+  bluetooth_benchmark_list_qti
 )
 
 usage() {
@@ -45,6 +45,10 @@ typedef enum {
 #define UIPC_REG_CBACK 2
 #define UIPC_REG_REMOVE_ACTIVE_READSET 3
 #define UIPC_SET_READ_POLL_TMO 4
+/* param: tUIPC_AUDIO_RING*, ownership moves to UIPC; NULL detaches the ring */
+#define UIPC_SET_AUDIO_RING 5
+/* param: tUIPC_AUDIO_RING_STATS*, returns false if no ring is attached */
+#define UIPC_GET_AUDIO_RING_STATS 6
 
 typedef void(tUIPC_RCV_CBACK)(
     tUIPC_CH_ID ch_id,
@@ -100,6 +104,19 @@ void UIPC_Close(tUIPC_CH_ID ch_id);
 bool UIPC_Send(tUIPC_CH_ID ch_id, uint16_t msg_evt, const uint8_t* p_buf,
                uint16_t msglen);
 
+/*******************************************************************************
+ *
+ * Function         UIPC_SendFd
+ *
+ * Description      Called to transmit a message along with a file descriptor
+ *                  over UIPC. The peer receives a duplicate of |fd|.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+bool UIPC_SendFd(tUIPC_CH_ID ch_id, int fd, const uint8_t* p_buf,
+                 uint16_t msglen);
+
 /*******************************************************************************
  *
  * Function         UIPC_Read
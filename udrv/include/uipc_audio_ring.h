@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      uipc_audio_ring.h
+ *
+ *  Description:   Single producer / single consumer PCM ring in shared
+ *                 memory, used as an alternative to the UIPC audio socket.
+ *                 The audio HAL is the producer and the Bluetooth stack the
+ *                 consumer. The consumer only wakes a blocked producer once
+ *                 the ring has drained to its low-water mark.
+ *
+ *****************************************************************************/
+
+#ifndef UIPC_AUDIO_RING_H
+#define UIPC_AUDIO_RING_H
+
+#include <stdint.h>
+
+typedef struct uipc_audio_ring_t tUIPC_AUDIO_RING;
+
+/* Counters kept in the shared ring, all in bytes unless noted */
+typedef struct {
+  uint32_t size;           /* capacity of the ring */
+  uint32_t fill;           /* bytes currently buffered */
+  uint32_t max_fill;       /* highest fill level seen by the consumer */
+  uint64_t total_written;  /* total bytes written by the producer */
+  uint64_t total_read;     /* total bytes read by the consumer */
+  uint32_t num_reads;      /* number of consumer reads */
+  uint32_t underruns;      /* reads that found less data than requested */
+  uint32_t producer_waits; /* writes that had to wait for space */
+  uint32_t wakeups;        /* wakeups of the producer by the consumer */
+  uint32_t timeouts;       /* producer waits that timed out */
+  uint64_t fill_sum;       /* sum of the fill levels seen by reads */
+} tUIPC_AUDIO_RING_STATS;
+
+/*******************************************************************************
+ *
+ * Function         uipc_audio_ring_create
+ *
+ * Description      Allocate a ring of at least |size| bytes in an anonymous
+ *                  shared memory file. |size| is rounded up to a power of
+ *                  two.
+ *
+ * Returns          the ring, or NULL on failure
+ *
+ ******************************************************************************/
+tUIPC_AUDIO_RING* uipc_audio_ring_create(uint32_t size);
+
+/*******************************************************************************
+ *
+ * Function         uipc_audio_ring_attach
+ *
+ * Description      Map a ring created by the peer process. Takes ownership
+ *                  of |fd|, also on failure.
+ *
+ * Returns          the ring, or NULL if |fd| doesn't hold a valid ring
+ *
+ ******************************************************************************/
+tUIPC_AUDIO_RING* uipc_audio_ring_attach(int fd);
+
+/*******************************************************************************
+ *
+ * Function         uipc_audio_ring_free
+ *
+ * Description      Unmap the ring and close its file descriptor.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void uipc_audio_ring_free(tUIPC_AUDIO_RING* ring);
+
+/* Return the file descriptor to pass to the peer process */
+int uipc_audio_ring_fd(const tUIPC_AUDIO_RING* ring);
+
+/* Mark the ring closed; wakes up a waiting producer and makes further writes
+ * fail. Either side may close it. */
+void uipc_audio_ring_close(tUIPC_AUDIO_RING* ring);
+
+/* Return true once either side closed the ring */
+bool uipc_audio_ring_is_closed(const tUIPC_AUDIO_RING* ring);
+
+/*******************************************************************************
+ *
+ * Function         uipc_audio_ring_write
+ *
+ * Description      Producer side. Copy |len| bytes into the ring, waiting up
+ *                  to |timeout_ms| in total for the consumer to make room.
+ *
+ * Returns          number of bytes written, less than |len| on timeout or if
+ *                  the ring was closed
+ *
+ ******************************************************************************/
+uint32_t uipc_audio_ring_write(tUIPC_AUDIO_RING* ring, const uint8_t* p_buf,
+                               uint32_t len, int timeout_ms);
+
+/*******************************************************************************
+ *
+ * Function         uipc_audio_ring_read
+ *
+ * Description      Consumer side. Copy up to |len| buffered bytes out of the
+ *                  ring without blocking.
+ *
+ * Returns          number of bytes read
+ *
+ ******************************************************************************/
+uint32_t uipc_audio_ring_read(tUIPC_AUDIO_RING* ring, uint8_t* p_buf,
+                              uint32_t len);
+
+/* Consumer side. Drop all buffered data. */
+void uipc_audio_ring_flush(tUIPC_AUDIO_RING* ring);
+
+/* Copy the ring counters into |p_stats| */
+void uipc_audio_ring_get_stats(const tUIPC_AUDIO_RING* ring,
+                               tUIPC_AUDIO_RING_STATS* p_stats);
+
+#endif /* UIPC_AUDIO_RING_H */
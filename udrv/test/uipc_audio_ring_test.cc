@@ -0,0 +1,231 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "uipc_audio_ring.h"
+
+namespace {
+
+// Fill |buf| with a pattern that continues from byte number |start|
+void fill_pattern(uint8_t* buf, uint32_t len, uint64_t start) {
+  for (uint32_t i = 0; i < len; i++) buf[i] = (uint8_t)((start + i) * 7 + 3);
+}
+
+// Returns the index of the first byte of |buf| not matching the pattern, or
+// |len|
+uint32_t check_pattern(const uint8_t* buf, uint32_t len, uint64_t start) {
+  for (uint32_t i = 0; i < len; i++)
+    if (buf[i] != (uint8_t)((start + i) * 7 + 3)) return i;
+  return len;
+}
+
+}  // namespace
+
+TEST(UipcAudioRingTest, test_create_rounds_size) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(1000);
+  ASSERT_NE(nullptr, ring);
+
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(1024u, stats.size);
+  EXPECT_EQ(0u, stats.fill);
+  uipc_audio_ring_free(ring);
+
+  ring = uipc_audio_ring_create(1);
+  ASSERT_NE(nullptr, ring);
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(64u, stats.size);
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_read_empty) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(64);
+  ASSERT_NE(nullptr, ring);
+
+  uint8_t buf[16];
+  EXPECT_EQ(0u, uipc_audio_ring_read(ring, buf, sizeof(buf)));
+
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(1u, stats.num_reads);
+  EXPECT_EQ(1u, stats.underruns);
+  EXPECT_EQ(0u, stats.total_read);
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_write_full) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(64);
+  ASSERT_NE(nullptr, ring);
+
+  uint8_t buf[100];
+  fill_pattern(buf, sizeof(buf), 0);
+  EXPECT_EQ(64u, uipc_audio_ring_write(ring, buf, sizeof(buf), 10));
+
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(64u, stats.fill);
+  EXPECT_EQ(1u, stats.timeouts);
+  EXPECT_EQ(64u, stats.total_written);
+
+  // Nothing fits until the consumer makes room
+  EXPECT_EQ(0u, uipc_audio_ring_write(ring, buf, 1, 0));
+
+  uint8_t out[64];
+  EXPECT_EQ(64u, uipc_audio_ring_read(ring, out, sizeof(out)));
+  EXPECT_EQ(64u, check_pattern(out, sizeof(out), 0));
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(0u, stats.fill);
+  EXPECT_EQ(64u, stats.max_fill);
+  EXPECT_EQ(0u, stats.underruns);
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_wraparound) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(64);
+  ASSERT_NE(nullptr, ring);
+
+  // Chunk sizes that don't divide the ring size so the copies straddle the
+  // end of the buffer at varying offsets
+  uint64_t written = 0;
+  uint64_t read = 0;
+  uint8_t buf[64];
+  for (int i = 0; i < 200; i++) {
+    uint32_t len = 1 + (i * 13) % 50;
+    fill_pattern(buf, len, written);
+    ASSERT_EQ(len, uipc_audio_ring_write(ring, buf, len, 0));
+    written += len;
+
+    uint32_t n = uipc_audio_ring_read(ring, buf, len);
+    ASSERT_EQ(len, n);
+    ASSERT_EQ(n, check_pattern(buf, n, read));
+    read += n;
+  }
+
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(written, stats.total_written);
+  EXPECT_EQ(read, stats.total_read);
+  EXPECT_EQ(0u, stats.fill);
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_flush) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(64);
+  ASSERT_NE(nullptr, ring);
+
+  uint8_t buf[32];
+  fill_pattern(buf, sizeof(buf), 0);
+  EXPECT_EQ(32u, uipc_audio_ring_write(ring, buf, sizeof(buf), 0));
+  uipc_audio_ring_flush(ring);
+  EXPECT_EQ(0u, uipc_audio_ring_read(ring, buf, sizeof(buf)));
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_close_stops_writes) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(64);
+  ASSERT_NE(nullptr, ring);
+  EXPECT_FALSE(uipc_audio_ring_is_closed(ring));
+
+  uipc_audio_ring_close(ring);
+  EXPECT_TRUE(uipc_audio_ring_is_closed(ring));
+
+  uint8_t buf[16] = {0};
+  EXPECT_EQ(0u, uipc_audio_ring_write(ring, buf, sizeof(buf), 100));
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_attach_shares_data) {
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(256);
+  ASSERT_NE(nullptr, ring);
+  tUIPC_AUDIO_RING* peer =
+      uipc_audio_ring_attach(dup(uipc_audio_ring_fd(ring)));
+  ASSERT_NE(nullptr, peer);
+
+  uint8_t buf[100];
+  fill_pattern(buf, sizeof(buf), 0);
+  EXPECT_EQ(100u, uipc_audio_ring_write(peer, buf, sizeof(buf), 0));
+
+  uint8_t out[100];
+  EXPECT_EQ(100u, uipc_audio_ring_read(ring, out, sizeof(out)));
+  EXPECT_EQ(100u, check_pattern(out, sizeof(out), 0));
+
+  uipc_audio_ring_close(ring);
+  EXPECT_TRUE(uipc_audio_ring_is_closed(peer));
+
+  uipc_audio_ring_free(peer);
+  uipc_audio_ring_free(ring);
+}
+
+TEST(UipcAudioRingTest, test_attach_rejects_invalid_fd) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  close(fds[1]);
+  EXPECT_EQ(nullptr, uipc_audio_ring_attach(fds[0]));
+}
+
+TEST(UipcAudioRingTest, test_producer_consumer_threads) {
+  const uint64_t kTotal = 1 << 20;
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_create(4096);
+  ASSERT_NE(nullptr, ring);
+
+  // The producer blocks whenever the ring is full, so it must be woken by
+  // the consumer for the transfer to complete
+  std::thread producer([ring, kTotal]() {
+    uint8_t buf[1000];
+    uint64_t written = 0;
+    while (written < kTotal) {
+      uint32_t len = sizeof(buf);
+      if (kTotal - written < len) len = kTotal - written;
+      fill_pattern(buf, len, written);
+      uint32_t n = uipc_audio_ring_write(ring, buf, len, 5000);
+      if (n < len) {
+        uipc_audio_ring_close(ring);
+        return;
+      }
+      written += n;
+    }
+  });
+
+  uint64_t read = 0;
+  uint32_t mismatch = 0;
+  uint8_t buf[700];
+  while (read < kTotal) {
+    uint32_t n = uipc_audio_ring_read(ring, buf, sizeof(buf));
+    if (check_pattern(buf, n, read) != n) mismatch++;
+    read += n;
+    if (n == 0) {
+      if (uipc_audio_ring_is_closed(ring)) break;
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  EXPECT_EQ(0u, mismatch);
+  tUIPC_AUDIO_RING_STATS stats;
+  uipc_audio_ring_get_stats(ring, &stats);
+  EXPECT_EQ(kTotal, stats.total_written);
+  EXPECT_EQ(kTotal, stats.total_read);
+  EXPECT_EQ(0u, stats.timeouts);
+  uipc_audio_ring_free(ring);
+}
@@ -55,6 +55,7 @@
 #include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
 #include "uipc.h"
+#include "uipc_audio_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -91,6 +92,7 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  tUIPC_AUDIO_RING* ring; /* shared memory data path, replaces reads from fd */
 } tUIPC_CHAN;
 
 typedef struct {
@@ -247,6 +249,7 @@ static int uipc_main_init(void) {
     p->fd = UIPC_DISCONNECTED;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->ring = NULL;
   }
 
   return 0;
@@ -433,11 +436,27 @@ static void uipc_flush_locked(tUIPC_CH_ID ch_id) {
       break;
 
     case UIPC_CH_ID_AV_AUDIO:
+      if (uipc_main.ch[ch_id].ring)
+        uipc_audio_ring_flush(uipc_main.ch[ch_id].ring);
       uipc_flush_ch_locked(UIPC_CH_ID_AV_AUDIO);
       break;
   }
 }
 
+static void uipc_set_ring_locked(tUIPC_CH_ID ch_id, tUIPC_AUDIO_RING* ring) {
+  tUIPC_AUDIO_RING* old_ring = uipc_main.ch[ch_id].ring;
+  if (old_ring == ring) return;
+
+  if (old_ring) {
+    BTIF_TRACE_EVENT("DETACH AUDIO RING FROM CH %d", ch_id);
+    /* let a producer blocked on the old ring give up right away */
+    uipc_audio_ring_close(old_ring);
+    uipc_audio_ring_free(old_ring);
+  }
+
+  uipc_main.ch[ch_id].ring = ring;
+}
+
 static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
   int wakeup = 0;
 
@@ -461,6 +480,8 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
     wakeup = 1;
   }
 
+  uipc_set_ring_locked(ch_id, NULL);
+
   /* notify this connection is closed */
   if (uipc_main.ch[ch_id].cback)
     uipc_main.ch[ch_id].cback(ch_id, UIPC_CLOSE_EVT);
@@ -658,6 +679,93 @@ bool UIPC_Send(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t msg_evt,
   return false;
 }
 
+/*******************************************************************************
+ **
+ ** Function         UIPC_SendFd
+ **
+ ** Description      Called to transmit a message along with a file descriptor
+ **                  over UIPC.
+ **
+ ** Returns          true in case of success, false in case of failure.
+ **
+ ******************************************************************************/
+bool UIPC_SendFd(tUIPC_CH_ID ch_id, int fd, const uint8_t* p_buf,
+                 uint16_t msglen) {
+  BTIF_TRACE_DEBUG("UIPC_SendFd : ch_id:%d fd %d, %d bytes", ch_id, fd,
+                   msglen);
+
+  if (ch_id >= UIPC_CH_NUM || msglen == 0) return false;
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t*>(p_buf);
+  iov.iov_len = msglen;
+
+  char control[CMSG_SPACE(sizeof(int))];
+  memset(control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(uipc_main.ch[ch_id].fd, &msg, MSG_NOSIGNAL));
+  if (ret != msglen) {
+    BTIF_TRACE_ERROR("failed to send fd (%s)", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+ **
+ ** Function         uipc_read_ring
+ **
+ ** Description      UIPC_Read() for a channel with an attached audio ring.
+ **                  The data socket is only polled when the ring runs dry, to
+ **                  notice a producer that went away.
+ **
+ ** Returns          return the number of bytes read.
+ **
+ ******************************************************************************/
+static uint32_t uipc_read_ring(tUIPC_CH_ID ch_id, uint8_t* p_buf,
+                               uint32_t len) {
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+  tUIPC_AUDIO_RING* ring = uipc_main.ch[ch_id].ring;
+  if (!ring) return 0;
+
+  uint32_t n_read = uipc_audio_ring_read(ring, p_buf, len);
+  if (n_read == len) return n_read;
+
+  bool detached = uipc_audio_ring_is_closed(ring);
+  if (!detached && uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED) {
+    struct pollfd pfd;
+    pfd.fd = uipc_main.ch[ch_id].fd;
+    pfd.events = POLLHUP;
+    int poll_ret;
+    OSI_NO_INTR(poll_ret = poll(&pfd, 1, 0));
+    detached = (poll_ret > 0) && (pfd.revents & (POLLHUP | POLLNVAL));
+  }
+
+  if (detached) {
+    BTIF_TRACE_WARNING("UIPC_Read : audio ring detached remotely");
+    uipc_close_locked(ch_id);
+  }
+
+  return n_read;
+}
+
 /*******************************************************************************
  **
  ** Function         UIPC_Read
@@ -679,6 +787,8 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
     return 0;
   }
 
+  if (uipc_main.ch[ch_id].ring) return uipc_read_ring(ch_id, p_buf, len);
+
   if (fd == UIPC_DISCONNECTED) {
     BTIF_TRACE_ERROR("UIPC_Read : channel %d closed", ch_id);
     return 0;
@@ -779,6 +889,20 @@ extern bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param) {
                        uipc_main.ch[ch_id].read_poll_tmo_ms);
       break;
 
+    case UIPC_SET_AUDIO_RING:
+      if (ch_id >= UIPC_CH_NUM) {
+        uipc_audio_ring_free((tUIPC_AUDIO_RING*)param);
+        break;
+      }
+      uipc_set_ring_locked(ch_id, (tUIPC_AUDIO_RING*)param);
+      return true;
+
+    case UIPC_GET_AUDIO_RING_STATS:
+      if (ch_id >= UIPC_CH_NUM || !uipc_main.ch[ch_id].ring) break;
+      uipc_audio_ring_get_stats(uipc_main.ch[ch_id].ring,
+                                (tUIPC_AUDIO_RING_STATS*)param);
+      return true;
+
     default:
       BTIF_TRACE_EVENT("UIPC_Ioctl : request not handled (%d)", request);
       break;
@@ -0,0 +1,363 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      uipc_audio_ring.cc
+ *
+ *  Description:   Shared memory SPSC PCM ring for the A2DP and hearing aid
+ *                 audio paths
+ *
+ *****************************************************************************/
+
+#define LOG_TAG "bt_uipc_ring"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "uipc_audio_ring.h"
+
+/*****************************************************************************
+ *  Constants & Macros
+ *****************************************************************************/
+
+#define UIPC_AUDIO_RING_MAGIC 0x52414254 /* "TBAR" */
+#define UIPC_AUDIO_RING_MAX_SIZE (1 << 20)
+
+/* The producer is woken up once the ring drained to this fraction of its
+ * size, so it refills in large chunks instead of on every read */
+#define UIPC_AUDIO_RING_LOW_WATER_DIV 2
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+/*****************************************************************************
+ *  Local type definitions
+ *****************************************************************************/
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "ring indices must be lock free to be shared between processes");
+
+/* Layout of the shared memory. Write and read positions are free running and
+ * live on separate cache lines; the data area follows the header. */
+typedef struct {
+  uint32_t magic;
+  uint32_t size;
+  uint32_t low_water;
+  std::atomic<uint32_t> closed;
+  /* futex the producer waits on, bumped for every wakeup */
+  std::atomic<uint32_t> wake_seq;
+
+  /* producer owned */
+  alignas(64) std::atomic<uint32_t> write_pos;
+  std::atomic<uint32_t> producer_waiting;
+  uint64_t total_written;
+  uint32_t producer_waits;
+  uint32_t timeouts;
+
+  /* consumer owned */
+  alignas(64) std::atomic<uint32_t> read_pos;
+  uint32_t max_fill;
+  uint64_t total_read;
+  uint64_t fill_sum;
+  uint32_t num_reads;
+  uint32_t underruns;
+  uint32_t wakeups;
+} tUIPC_AUDIO_RING_SHM;
+
+#define UIPC_AUDIO_RING_HDR_SIZE \
+  ((sizeof(tUIPC_AUDIO_RING_SHM) + 63) & ~(size_t)63)
+
+struct uipc_audio_ring_t {
+  int fd;
+  size_t map_len;
+  tUIPC_AUDIO_RING_SHM* shm;
+  uint8_t* data;
+};
+
+/*****************************************************************************
+ *   Helper functions
+ *****************************************************************************/
+
+static int uipc_audio_ring_futex(std::atomic<uint32_t>* addr, int op,
+                                 uint32_t val, const struct timespec* p_ts) {
+  /* not FUTEX_PRIVATE_FLAG, the word is shared with another process */
+  return syscall(__NR_futex, reinterpret_cast<uint32_t*>(addr), op, val, p_ts,
+                 NULL, 0);
+}
+
+static uint64_t uipc_audio_ring_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static tUIPC_AUDIO_RING* uipc_audio_ring_map(int fd, size_t map_len) {
+  void* p_map =
+      mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p_map == MAP_FAILED) {
+    LOG_ERROR(LOG_TAG, "%s: mmap failed: %s", __func__, strerror(errno));
+    return NULL;
+  }
+
+  tUIPC_AUDIO_RING* ring =
+      (tUIPC_AUDIO_RING*)osi_calloc(sizeof(tUIPC_AUDIO_RING));
+  ring->fd = fd;
+  ring->map_len = map_len;
+  ring->shm = (tUIPC_AUDIO_RING_SHM*)p_map;
+  ring->data = (uint8_t*)p_map + UIPC_AUDIO_RING_HDR_SIZE;
+  return ring;
+}
+
+/*****************************************************************************
+ *   Ring management
+ *****************************************************************************/
+
+tUIPC_AUDIO_RING* uipc_audio_ring_create(uint32_t size) {
+  uint32_t ring_size = 64;
+  while (ring_size < size && ring_size < UIPC_AUDIO_RING_MAX_SIZE)
+    ring_size <<= 1;
+
+  int fd = syscall(__NR_memfd_create, "bt_audio_ring",
+                   MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s: memfd_create failed: %s", __func__,
+              strerror(errno));
+    return NULL;
+  }
+
+  size_t map_len = UIPC_AUDIO_RING_HDR_SIZE + ring_size;
+  if (ftruncate(fd, map_len) < 0) {
+    LOG_ERROR(LOG_TAG, "%s: ftruncate failed: %s", __func__, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  /* the peer must not be able to resize the mapping under us */
+  if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) < 0)
+    LOG_WARN(LOG_TAG, "%s: can't seal ring: %s", __func__, strerror(errno));
+
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_map(fd, map_len);
+  if (!ring) {
+    close(fd);
+    return NULL;
+  }
+
+  tUIPC_AUDIO_RING_SHM* shm = new (ring->shm) tUIPC_AUDIO_RING_SHM();
+  shm->size = ring_size;
+  shm->low_water = ring_size / UIPC_AUDIO_RING_LOW_WATER_DIV;
+  shm->magic = UIPC_AUDIO_RING_MAGIC;
+
+  LOG_INFO(LOG_TAG, "%s: created %u byte ring (fd %d)", __func__, ring_size,
+           fd);
+  return ring;
+}
+
+tUIPC_AUDIO_RING* uipc_audio_ring_attach(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)UIPC_AUDIO_RING_HDR_SIZE) {
+    LOG_ERROR(LOG_TAG, "%s: invalid ring fd %d", __func__, fd);
+    close(fd);
+    return NULL;
+  }
+
+  tUIPC_AUDIO_RING* ring = uipc_audio_ring_map(fd, st.st_size);
+  if (!ring) {
+    close(fd);
+    return NULL;
+  }
+
+  const tUIPC_AUDIO_RING_SHM* shm = ring->shm;
+  if (shm->magic != UIPC_AUDIO_RING_MAGIC || shm->size == 0 ||
+      (shm->size & (shm->size - 1)) != 0 ||
+      (size_t)st.st_size != UIPC_AUDIO_RING_HDR_SIZE + shm->size) {
+    LOG_ERROR(LOG_TAG, "%s: malformed ring (fd %d)", __func__, fd);
+    uipc_audio_ring_free(ring);
+    return NULL;
+  }
+
+  return ring;
+}
+
+void uipc_audio_ring_free(tUIPC_AUDIO_RING* ring) {
+  if (!ring) return;
+
+  munmap(ring->shm, ring->map_len);
+  close(ring->fd);
+  osi_free(ring);
+}
+
+int uipc_audio_ring_fd(const tUIPC_AUDIO_RING* ring) { return ring->fd; }
+
+static void uipc_audio_ring_wake(tUIPC_AUDIO_RING_SHM* shm) {
+  shm->wake_seq.fetch_add(1);
+  uipc_audio_ring_futex(&shm->wake_seq, FUTEX_WAKE, 1, NULL);
+}
+
+void uipc_audio_ring_close(tUIPC_AUDIO_RING* ring) {
+  ring->shm->closed.store(1);
+
+  /* kick a producer waiting for room, it rechecks the closed flag */
+  uipc_audio_ring_wake(ring->shm);
+}
+
+bool uipc_audio_ring_is_closed(const tUIPC_AUDIO_RING* ring) {
+  return ring->shm->closed.load() != 0;
+}
+
+/*****************************************************************************
+ *   Data path
+ *****************************************************************************/
+
+uint32_t uipc_audio_ring_write(tUIPC_AUDIO_RING* ring, const uint8_t* p_buf,
+                               uint32_t len, int timeout_ms) {
+  tUIPC_AUDIO_RING_SHM* shm = ring->shm;
+  const uint32_t size = shm->size;
+  uint64_t deadline_ms = uipc_audio_ring_now_ms() + timeout_ms;
+  uint32_t written = 0;
+
+  while (written < len && !shm->closed.load(std::memory_order_relaxed)) {
+    uint32_t w = shm->write_pos.load(std::memory_order_relaxed);
+    uint32_t r = shm->read_pos.load(std::memory_order_acquire);
+    uint32_t space = size - (w - r);
+
+    if (space == 0) {
+      uint64_t now_ms = uipc_audio_ring_now_ms();
+      if (now_ms >= deadline_ms) {
+        shm->timeouts++;
+        break;
+      }
+
+      /* announce the wait, then recheck so a read that raced with us can't
+       * be missed */
+      uint32_t seq = shm->wake_seq.load();
+      shm->producer_waiting.store(1);
+      if (shm->read_pos.load() == r && !shm->closed.load()) {
+        uint64_t wait_ms = deadline_ms - now_ms;
+        struct timespec ts;
+        ts.tv_sec = wait_ms / 1000;
+        ts.tv_nsec = (wait_ms % 1000) * 1000000;
+        shm->producer_waits++;
+        uipc_audio_ring_futex(&shm->wake_seq, FUTEX_WAIT, seq, &ts);
+      }
+      shm->producer_waiting.store(0);
+      continue;
+    }
+
+    uint32_t n = len - written;
+    if (n > space) n = space;
+
+    uint32_t offset = w & (size - 1);
+    uint32_t first = size - offset;
+    if (first > n) first = n;
+    memcpy(ring->data + offset, p_buf + written, first);
+    memcpy(ring->data, p_buf + written + first, n - first);
+
+    shm->write_pos.store(w + n, std::memory_order_release);
+    shm->total_written += n;
+    written += n;
+  }
+
+  return written;
+}
+
+uint32_t uipc_audio_ring_read(tUIPC_AUDIO_RING* ring, uint8_t* p_buf,
+                              uint32_t len) {
+  tUIPC_AUDIO_RING_SHM* shm = ring->shm;
+  const uint32_t size = shm->size;
+
+  uint32_t r = shm->read_pos.load(std::memory_order_relaxed);
+  uint32_t w = shm->write_pos.load(std::memory_order_acquire);
+  uint32_t fill = w - r;
+  if (fill > size) {
+    /* the producer corrupted its write position; resync */
+    LOG_ERROR(LOG_TAG, "%s: invalid ring state w=%u r=%u", __func__, w, r);
+    shm->read_pos.store(w);
+    return 0;
+  }
+
+  shm->num_reads++;
+  shm->fill_sum += fill;
+  if (fill > shm->max_fill) shm->max_fill = fill;
+
+  uint32_t n = (fill < len) ? fill : len;
+  if (n < len) shm->underruns++;
+
+  uint32_t offset = r & (size - 1);
+  uint32_t first = size - offset;
+  if (first > n) first = n;
+  memcpy(p_buf, ring->data + offset, first);
+  memcpy(p_buf + first, ring->data, n - first);
+
+  shm->read_pos.store(r + n);
+  shm->total_read += n;
+
+  /* only a drained ring is worth a wakeup, see UIPC_AUDIO_RING_LOW_WATER_DIV */
+  if (n > 0 && fill - n <= shm->low_water && shm->producer_waiting.load()) {
+    shm->wakeups++;
+    uipc_audio_ring_wake(shm);
+  }
+
+  return n;
+}
+
+void uipc_audio_ring_flush(tUIPC_AUDIO_RING* ring) {
+  tUIPC_AUDIO_RING_SHM* shm = ring->shm;
+  uint32_t w = shm->write_pos.load(std::memory_order_acquire);
+  shm->read_pos.store(w);
+  if (shm->producer_waiting.load()) uipc_audio_ring_wake(shm);
+}
+
+void uipc_audio_ring_get_stats(const tUIPC_AUDIO_RING* ring,
+                               tUIPC_AUDIO_RING_STATS* p_stats) {
+  const tUIPC_AUDIO_RING_SHM* shm = ring->shm;
+
+  memset(p_stats, 0, sizeof(*p_stats));
+  p_stats->size = shm->size;
+  p_stats->fill = shm->write_pos.load() - shm->read_pos.load();
+  p_stats->max_fill = shm->max_fill;
+  p_stats->total_written = shm->total_written;
+  p_stats->total_read = shm->total_read;
+  p_stats->num_reads = shm->num_reads;
+  p_stats->underruns = shm->underruns;
+  p_stats->producer_waits = shm->producer_waits;
+  p_stats->wakeups = shm->wakeups;
+  p_stats->timeouts = shm->timeouts;
+  p_stats->fill_sum = shm->fill_sum;
+}